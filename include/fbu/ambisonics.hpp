@@ -0,0 +1,547 @@
+#ifndef FBU_AMBISONICS_HPP_INCLUDED
+#define FBU_AMBISONICS_HPP_INCLUDED
+
+/**
+ @file ambisonics.hpp
+ @author François Becker
+
+MIT License
+
+Copyright (c) 2018 François Becker
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "fbu/constexpr_math.hpp"
+#include "fbu/sad.hpp"
+#include "fbu/simd.hpp"
+#include "fbu/spherical_conversions.hpp"
+#include "fbu/vector3.hpp"
+#include "fbu/vector3_array.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+/*
+ Real spherical harmonics up to order 7, in the ACN channel order and without
+ the Condon-Shortley phase (AmbiX), and the encoding and decoding block
+ kernels of Ambisonics.
+ The harmonics are evaluated from the Cartesian coordinates of the directions
+ by recurrences, without trigonometry: (1 - z^2)^(m/2) cos(m azimuth) and
+ sin(m azimuth) are the real and imaginary parts of (x + i y)^m, and the
+ associated Legendre functions over (1 - z^2)^(m/2) are polynomials of z.
+ */
+
+namespace fbu
+{
+    /// the highest order of the spherical harmonics
+    constexpr int kMaxAmbisonicOrder = 7;
+
+    enum class AmbisonicNormalization
+    {
+        sn3d,   ///< Schmidt semi-normalized, the largest value of each harmonic is 1
+        n3d     ///< orthonormal over the sphere, to 4 pi
+    };
+
+    /**
+     The number of harmonics up to pOrder.
+     */
+    constexpr int ambisonicNumChannels(int pOrder)
+    {
+        return (pOrder + 1) * (pOrder + 1);
+    }
+
+    /**
+     The ACN index of the harmonic of degree l and order m, -l <= m <= l.
+     */
+    constexpr int ambisonicChannel(int l, int m)
+    {
+        return l * l + l + m;
+    }
+
+    namespace detail
+    {
+        namespace sh
+        {
+            constexpr int iabs(int n)
+            {
+                return n < 0 ? -n : n;
+            }
+
+            constexpr int degree(int pChannel, int l = 0)
+            {
+                return ambisonicNumChannels(l) > pChannel ? l : degree(pChannel, l + 1);
+            }
+
+            constexpr int order(int pChannel)
+            {
+                return pChannel - ambisonicChannel(degree(pChannel), 0);
+            }
+
+            // a! / b!, a <= b
+            constexpr double factorialRatio(int a, int b)
+            {
+                return b <= a ? 1. : factorialRatio(a, b - 1) / (double)b;
+            }
+
+            constexpr double doubleFactorial(int n)
+            {
+                return n <= 1 ? 1. : (double)n * doubleFactorial(n - 2);
+            }
+
+            // the pairs (l, m), m <= l, at l (l + 1) / 2 + m
+            constexpr int pairDegree(int pPair, int l = 0)
+            {
+                return (l + 1) * (l + 2) / 2 > pPair ? l : pairDegree(pPair, l + 1);
+            }
+
+            constexpr int pairOrder(int pPair)
+            {
+                return pPair - pairDegree(pPair) * (pairDegree(pPair) + 1) / 2;
+            }
+
+            constexpr double sn3d(int l, int m)
+            {
+                return cx::sqrt((m == 0 ? 1. : 2.) * factorialRatio(l - iabs(m), l + iabs(m)));
+            }
+
+            struct Sn3dGenerator
+            {
+                static constexpr double value(int c)
+                {
+                    return sn3d(degree(c), order(c));
+                }
+            };
+
+            struct N3dGenerator
+            {
+                static constexpr double value(int c)
+                {
+                    return sn3d(degree(c), order(c)) * cx::sqrt(2. * degree(c) + 1.);
+                }
+            };
+
+            // Q(l, m) = a z Q(l - 1, m) - b Q(l - 2, m), from Q(m, m) = (2m - 1)!!
+            // and Q(m - 1, m) = 0
+            struct LegendreAGenerator
+            {
+                static constexpr double value(int p)
+                {
+                    return pairDegree(p) == pairOrder(p) ? 0. : (2. * pairDegree(p) - 1.) / (double)(pairDegree(p) - pairOrder(p));
+                }
+            };
+
+            struct LegendreBGenerator
+            {
+                static constexpr double value(int p)
+                {
+                    return pairDegree(p) == pairOrder(p) ? 0. : (double)(pairDegree(p) + pairOrder(p) - 1) / (double)(pairDegree(p) - pairOrder(p));
+                }
+            };
+
+            struct LegendreStartGenerator
+            {
+                static constexpr double value(int m)
+                {
+                    return doubleFactorial(2 * m - 1);
+                }
+            };
+
+            constexpr int kNumChannels = ambisonicNumChannels(kMaxAmbisonicOrder);
+            constexpr int kNumPairs = (kMaxAmbisonicOrder + 1) * (kMaxAmbisonicOrder + 2) / 2;
+
+            constexpr cx::Table<double, kNumChannels> kSn3d = cx::makeTable<double, kNumChannels, Sn3dGenerator>();
+            constexpr cx::Table<double, kNumChannels> kN3d = cx::makeTable<double, kNumChannels, N3dGenerator>();
+            constexpr cx::Table<double, kNumPairs> kLegendreA = cx::makeTable<double, kNumPairs, LegendreAGenerator>();
+            constexpr cx::Table<double, kNumPairs> kLegendreB = cx::makeTable<double, kNumPairs, LegendreBGenerator>();
+            constexpr cx::Table<double, kMaxAmbisonicOrder + 1> kLegendreStart
+                = cx::makeTable<double, kMaxAmbisonicOrder + 1, LegendreStartGenerator>();
+
+            inline const double* scales(AmbisonicNormalization pNormalization)
+            {
+                return pNormalization == AmbisonicNormalization::sn3d ? kSn3d.data() : kN3d.data();
+            }
+
+            template <typename V> V broadcast(double s);
+            template <> inline float broadcast<float>(double s) { return (float)s; }
+            template <> inline double broadcast<double>(double s) { return s; }
+            template <> inline simd::vfloat broadcast<simd::vfloat>(double s) { return simd::set1((float)s); }
+
+            /**
+             The harmonics of the unit vector (x, y, z) up to pOrder, through
+             pStore(channel, value), V being a scalar or a simd::vfloat.
+             */
+            template <typename V, class Store>
+            inline void evaluate(V x, V y, V z, int pOrder, const double* pScales, Store pStore)
+            {
+                V lCos = broadcast<V>(1.);
+                V lSin = broadcast<V>(0.);
+                for (int m = 0 ; m <= pOrder ; ++m)
+                {
+                    V lPrevious = broadcast<V>(0.);
+                    V lLegendre = broadcast<V>(kLegendreStart[m]);
+                    for (int l = m ; l <= pOrder ; ++l)
+                    {
+                        if (l != m)
+                        {
+                            const int lPair = l * (l + 1) / 2 + m;
+                            const V lNext = broadcast<V>(kLegendreA[lPair]) * z * lLegendre - broadcast<V>(kLegendreB[lPair]) * lPrevious;
+                            lPrevious = lLegendre;
+                            lLegendre = lNext;
+                        }
+                        const int c = ambisonicChannel(l, m);
+                        pStore(c, broadcast<V>(pScales[c]) * lLegendre * lCos);
+                        if (m != 0)
+                        {
+                            const int lSinChannel = ambisonicChannel(l, -m);
+                            pStore(lSinChannel, broadcast<V>(pScales[lSinChannel]) * lLegendre * lSin);
+                        }
+                    }
+                    const V lNextCos = x * lCos - y * lSin;
+                    lSin = x * lSin + y * lCos;
+                    lCos = lNextCos;
+                }
+            }
+
+            /**
+             pOut = sum of pGains[i] * pIn[i], the gains going linearly from
+             pGains to pTargets over the block (the last sample at pTargets).
+             */
+            inline void mix(const float* pGains, const float* pTargets, size_t pNumIn,
+                            const float* const* pIn, float* pOut, SampleCount pNumSamples)
+            {
+                using namespace fbu::simd;
+                const size_t lNumSamples = (size_t)pNumSamples;
+                std::fill(pOut, pOut + lNumSamples, 0.f);
+                const float lInvNumSamples = 1.f / (float)std::max<SampleCount>(pNumSamples, 1);
+                for (size_t i = 0 ; i != pNumIn ; ++i)
+                {
+                    const float lGain = pGains[i];
+                    const float lStep = (pTargets[i] - lGain) * lInvNumSamples;
+                    if (lGain == 0.f && lStep == 0.f)
+                    {
+                        continue;
+                    }
+                    const float* lIn = pIn[i];
+                    size_t n = 0;
+                    if (lStep == 0.f)
+                    {
+                        const vfloat g = set1(lGain);
+                        for ( ; n + (size_t)kFloatLanes <= lNumSamples ; n += (size_t)kFloatLanes)
+                        {
+                            store(pOut + n, mulAdd(g, load(lIn + n), load(pOut + n)));
+                        }
+                    }
+                    else
+                    {
+                        // the gain of sample n is lGain + (n + 1) lStep
+                        const float lRamp[kFloatLanes] = {1.f, 2.f, 3.f, 4.f};
+                        vfloat g = mulAdd(load(lRamp), set1(lStep), set1(lGain));
+                        const vfloat lVectorStep = set1((float)kFloatLanes * lStep);
+                        for ( ; n + (size_t)kFloatLanes <= lNumSamples ; n += (size_t)kFloatLanes)
+                        {
+                            store(pOut + n, mulAdd(g, load(lIn + n), load(pOut + n)));
+                            g += lVectorStep;
+                        }
+                    }
+                    for ( ; n != lNumSamples ; ++n)
+                    {
+                        pOut[n] += (lGain + (float)(n + 1) * lStep) * lIn[n];
+                    }
+                }
+            }
+        }
+    }
+
+    //==============================================================================
+    /**
+     The spherical harmonics of pDirection up to pOrder, in pOut[0] to
+     pOut[ambisonicNumChannels(pOrder) - 1]. In SN3D, the first order is
+     (W, Y, Z, X) = (1, y, z, x) for a unit vector (x, y, z). pDirection need
+     not be normalized, zero being the front.
+     */
+    template <typename T>
+    inline void sphericalHarmonics(const Vector3<T>& pDirection, int pOrder, T* pOut,
+                                   AmbisonicNormalization pNormalization = AmbisonicNormalization::sn3d)
+    {
+        assert(0 <= pOrder && pOrder <= kMaxAmbisonicOrder);
+        const Vector3<T> d = pDirection.normalizedWithDefault(Vector3<T>::cartesian((T)1, (T)0, (T)0));
+        detail::sh::evaluate<T>(d.mX, d.mY, d.mZ, pOrder, detail::sh::scales(pNormalization), [pOut](int c, T pValue)
+        {
+            pOut[c] = pValue;
+        });
+    }
+
+    template <typename T>
+    inline void sphericalHarmonics(const AE<T>& pDirection, int pOrder, T* pOut,
+                                   AmbisonicNormalization pNormalization = AmbisonicNormalization::sn3d)
+    {
+        sphericalHarmonics(Vector3<T>::fromAE(pDirection), pOrder, pOut, pNormalization);
+    }
+
+    /**
+     The spherical harmonics of the unit vectors pDirections up to pOrder,
+     vectorized over the directions: harmonic c of direction i at
+     pOut[c * pStride + i]. pStride is at least pDirections.paddedSize(), and
+     the padding gets values too.
+     */
+    inline void sphericalHarmonics(const Vector3Array<float>& pDirections, int pOrder, float* pOut, size_t pStride,
+                                   AmbisonicNormalization pNormalization = AmbisonicNormalization::sn3d)
+    {
+        using namespace fbu::simd;
+        assert(0 <= pOrder && pOrder <= kMaxAmbisonicOrder);
+        assert(pStride >= pDirections.paddedSize());
+        const double* lScales = detail::sh::scales(pNormalization);
+        for (size_t u = 0 ; u != pDirections.paddedSize() ; u += (size_t)kFloatLanes)
+        {
+            float* lOut = pOut + u;
+            detail::sh::evaluate<vfloat>(load(pDirections.x() + u), load(pDirections.y() + u), load(pDirections.z() + u),
+                                         pOrder, lScales, [lOut, pStride](int c, vfloat pValues)
+            {
+                store(lOut + (size_t)c * pStride, pValues);
+            });
+        }
+    }
+
+    //==============================================================================
+    /**
+     @class AmbisonicEncoder
+     @brief Encodes mono sources to the Ambisonic channels.
+
+     The gains of the sources are computed by setDirections() and ramped
+     linearly over the next block, so that moving sources do not click. The
+     buffers are allocated at construction: setDirections() and process() do
+     not allocate.
+     */
+    class AmbisonicEncoder
+    {
+    public:
+        AmbisonicEncoder(int pOrder, size_t pMaxNumSources,
+                         AmbisonicNormalization pNormalization = AmbisonicNormalization::sn3d)
+        : mOrder(pOrder)
+        , mNormalization(pNormalization)
+        , mDirections(pMaxNumSources)
+        , mStride(mDirections.paddedSize())
+        , mGains(mStride * (size_t)ambisonicNumChannels(pOrder), 0.f)
+        , mTargets(mGains)
+        {
+            assert(0 <= pOrder && pOrder <= kMaxAmbisonicOrder);
+            mDirections.clear();
+        }
+
+        int getOrder() const
+        {
+            return mOrder;
+        }
+
+        int getNumChannels() const
+        {
+            return ambisonicNumChannels(mOrder);
+        }
+
+        size_t getMaxNumSources() const
+        {
+            return mStride;
+        }
+
+        size_t getNumSources() const
+        {
+            return mDirections.size();
+        }
+
+        /**
+         The directions of the sources, from the first block or after reset()
+         without a ramp. They need not be normalized, zero being the front.
+         */
+        void setDirections(const Vector3Array<float>& pDirections)
+        {
+            assert(pDirections.size() <= mStride);
+            mDirections.resize(pDirections.size());
+            std::copy(pDirections.x(), pDirections.x() + mDirections.paddedSize(), mDirections.x());
+            std::copy(pDirections.y(), pDirections.y() + mDirections.paddedSize(), mDirections.y());
+            std::copy(pDirections.z(), pDirections.z() + mDirections.paddedSize(), mDirections.z());
+            updateTargets();
+        }
+
+        /**
+         The same from azimuths and elevations, in radians.
+         */
+        void setDirections(const float* pAzimuths, const float* pElevations, size_t pNumSources,
+                           SphericalPrecision pPrecision = SphericalPrecision::high)
+        {
+            assert(pNumSources <= mStride);
+            aeToVector3(pAzimuths, pElevations, pNumSources, mDirections, pPrecision);
+            updateTargets();
+        }
+
+        /**
+         The gain of source pSource to channel pChannel at the end of the next
+         block.
+         */
+        float getGain(int pChannel, size_t pSource) const
+        {
+            return mTargets[(size_t)pChannel * mStride + pSource];
+        }
+
+        /**
+         The next setDirections() applies without a ramp.
+         */
+        void reset()
+        {
+            mHasGains = false;
+        }
+
+        /**
+         Encode a block.
+         @param pSources getNumSources() input pointers.
+         @param pChannels getNumChannels() output pointers, which are
+                          overwritten, and not the inputs.
+         */
+        void process(const float* const* pSources, float* const* pChannels, SampleCount pNumSamples)
+        {
+            for (int c = 0 ; c != getNumChannels() ; ++c)
+            {
+                const size_t lRow = (size_t)c * mStride;
+                detail::sh::mix(mGains.data() + lRow, mTargets.data() + lRow, mDirections.size(),
+                                pSources, pChannels[c], pNumSamples);
+            }
+            mGains = mTargets;
+        }
+
+    private:
+        void updateTargets()
+        {
+            mDirections.normalizeWithDefault(Vector3f::cartesian(1.f, 0.f, 0.f));
+            sphericalHarmonics(mDirections, mOrder, mTargets.data(), mStride, mNormalization);
+            if (! mHasGains)
+            {
+                mGains = mTargets;
+                mHasGains = true;
+            }
+        }
+
+        int mOrder;
+        AmbisonicNormalization mNormalization;
+        Vector3Array<float> mDirections;
+        size_t mStride;
+        std::vector<float> mGains;      ///< channel by channel, mStride per channel
+        std::vector<float> mTargets;    ///< the same, at the end of the next block
+        bool mHasGains = false;
+    };
+
+    //==============================================================================
+    /**
+     @class AmbisonicDecoder
+     @brief Decodes the Ambisonic channels to speakers with a matrix.
+
+     The matrix is set by setMatrix() or computed for a layout by
+     setSpeakers(). The buffers are allocated by these, process() does not
+     allocate.
+     */
+    class AmbisonicDecoder
+    {
+    public:
+        explicit AmbisonicDecoder(int pOrder, AmbisonicNormalization pNormalization = AmbisonicNormalization::sn3d)
+        : mOrder(pOrder)
+        , mNormalization(pNormalization)
+        {
+            assert(0 <= pOrder && pOrder <= kMaxAmbisonicOrder);
+        }
+
+        int getOrder() const
+        {
+            return mOrder;
+        }
+
+        int getNumChannels() const
+        {
+            return ambisonicNumChannels(mOrder);
+        }
+
+        size_t getNumSpeakers() const
+        {
+            return mNumSpeakers;
+        }
+
+        /**
+         The decoding matrix, row by row: pMatrix[s * getNumChannels() + c] is
+         the gain of channel c to speaker s.
+         */
+        void setMatrix(const float* pMatrix, size_t pNumSpeakers)
+        {
+            mNumSpeakers = pNumSpeakers;
+            mMatrix.assign(pMatrix, pMatrix + pNumSpeakers * (size_t)getNumChannels());
+        }
+
+        /**
+         The sampling (basic) decoder of the layout pSpeakers: the harmonics of
+         each speaker over the number of speakers, in N3D. Meant for the
+         layouts which sample the sphere about evenly.
+         */
+        void setSpeakers(const std::vector<Vector3f>& pSpeakers)
+        {
+            const size_t lNumChannels = (size_t)getNumChannels();
+            mNumSpeakers = pSpeakers.size();
+            mMatrix.resize(mNumSpeakers * lNumChannels);
+            for (size_t s = 0 ; s != mNumSpeakers ; ++s)
+            {
+                float* lRow = mMatrix.data() + s * lNumChannels;
+                sphericalHarmonics(pSpeakers[s], mOrder, lRow, AmbisonicNormalization::n3d);
+                for (size_t c = 0 ; c != lNumChannels ; ++c)
+                {
+                    // N3D = SN3D sqrt(2l + 1) on the input side
+                    const double lInputScale = mNormalization == AmbisonicNormalization::n3d
+                                               ? 1. : detail::sh::kN3d[(int)c] / detail::sh::kSn3d[(int)c];
+                    lRow[c] *= (float)(lInputScale / (double)mNumSpeakers);
+                }
+            }
+        }
+
+        float getGain(size_t pSpeaker, int pChannel) const
+        {
+            return mMatrix[pSpeaker * (size_t)getNumChannels() + (size_t)pChannel];
+        }
+
+        /**
+         Decode a block.
+         @param pChannels getNumChannels() input pointers.
+         @param pSpeakers getNumSpeakers() output pointers, which are
+                          overwritten, and not the inputs.
+         */
+        void process(const float* const* pChannels, float* const* pSpeakers, SampleCount pNumSamples) const
+        {
+            const size_t lNumChannels = (size_t)getNumChannels();
+            for (size_t s = 0 ; s != mNumSpeakers ; ++s)
+            {
+                const float* lRow = mMatrix.data() + s * lNumChannels;
+                detail::sh::mix(lRow, lRow, lNumChannels, pChannels, pSpeakers[s], pNumSamples);
+            }
+        }
+
+    private:
+        int mOrder;
+        AmbisonicNormalization mNormalization;
+        size_t mNumSpeakers = 0;
+        std::vector<float> mMatrix;
+    };
+}
+
+#endif
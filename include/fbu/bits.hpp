@@ -0,0 +1,318 @@
+#ifndef FBU_BITS_HPP_INCLUDED
+#define FBU_BITS_HPP_INCLUDED
+
+/**
+ @file bits.hpp
+ @author François Becker
+
+MIT License
+
+Copyright (c) 2018 François Becker
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "fbu/simd.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define FBU_BITS_USE_BUILTINS 1
+#else
+#define FBU_BITS_USE_BUILTINS 0
+#endif
+
+/*
+ Bit manipulation on 32 and 64-bit unsigned integers, constexpr. GCC and
+ Clang get the compiler builtins (lzcnt/tzcnt/popcnt when the target has
+ them), the other compilers a portable constexpr version. Unlike the
+ builtins, clz and ctz are defined for 0: they return the width. The
+ arguments are uint32_t or uint64_t, so that the width is explicit.
+ */
+
+namespace fbu
+{
+namespace bits
+{
+    namespace detail
+    {
+        template <typename T>
+        constexpr int clzPortable(T x, int n)
+        {
+            return (x >> (sizeof(T) * 8 - 1)) != 0 ? n : clzPortable<T>((T)(x << 1), n + 1);
+        }
+
+        template <typename T>
+        constexpr int ctzPortable(T x, int n)
+        {
+            return (x & 1u) != 0 ? n : ctzPortable<T>((T)(x >> 1), n + 1);
+        }
+
+        // SWAR: sums of 2, 4, then 8 bits, gathered in the top byte by a multiply
+        constexpr uint32_t popcountPairs(uint32_t x)
+        {
+            return x - ((x >> 1) & 0x55555555u);
+        }
+
+        constexpr uint32_t popcountNibbles(uint32_t x)
+        {
+            return (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+        }
+
+        constexpr int popcountPortable(uint32_t x)
+        {
+            return (int)((((popcountNibbles(popcountPairs(x)) + (popcountNibbles(popcountPairs(x)) >> 4)) & 0x0f0f0f0fu)
+                          * 0x01010101u) >> 24);
+        }
+
+        // swap the adjacent groups of pBits bits
+        constexpr uint32_t swapGroups(uint32_t x, int pBits, uint32_t pMask)
+        {
+            return ((x >> pBits) & pMask) | ((x & pMask) << pBits);
+        }
+    }
+
+    //==============================================================================
+    /**
+     Number of leading zero bits; the width for 0.
+     */
+    constexpr int clz(uint32_t x)
+    {
+#if FBU_BITS_USE_BUILTINS
+        return x == 0 ? 32 : __builtin_clz(x);
+#else
+        return x == 0 ? 32 : detail::clzPortable<uint32_t>(x, 0);
+#endif
+    }
+
+    constexpr int clz(uint64_t x)
+    {
+#if FBU_BITS_USE_BUILTINS
+        return x == 0 ? 64 : __builtin_clzll(x);
+#else
+        return x == 0 ? 64 : detail::clzPortable<uint64_t>(x, 0);
+#endif
+    }
+
+    /**
+     Number of trailing zero bits; the width for 0.
+     */
+    constexpr int ctz(uint32_t x)
+    {
+#if FBU_BITS_USE_BUILTINS
+        return x == 0 ? 32 : __builtin_ctz(x);
+#else
+        return x == 0 ? 32 : detail::ctzPortable<uint32_t>(x, 0);
+#endif
+    }
+
+    constexpr int ctz(uint64_t x)
+    {
+#if FBU_BITS_USE_BUILTINS
+        return x == 0 ? 64 : __builtin_ctzll(x);
+#else
+        return x == 0 ? 64 : detail::ctzPortable<uint64_t>(x, 0);
+#endif
+    }
+
+    constexpr int popcount(uint32_t x)
+    {
+#if FBU_BITS_USE_BUILTINS
+        return __builtin_popcount(x);
+#else
+        return detail::popcountPortable(x);
+#endif
+    }
+
+    constexpr int popcount(uint64_t x)
+    {
+#if FBU_BITS_USE_BUILTINS
+        return __builtin_popcountll(x);
+#else
+        return detail::popcountPortable((uint32_t)x) + detail::popcountPortable((uint32_t)(x >> 32));
+#endif
+    }
+
+    //==============================================================================
+    constexpr bool isPowerOf2(uint32_t x)
+    {
+        return x != 0 && (x & (x - 1)) == 0;
+    }
+
+    constexpr bool isPowerOf2(uint64_t x)
+    {
+        return x != 0 && (x & (x - 1)) == 0;
+    }
+
+    /**
+     floor(log2(x)), -1 for 0.
+     */
+    constexpr int log2floor(uint32_t x)
+    {
+        return 31 - clz(x);
+    }
+
+    constexpr int log2floor(uint64_t x)
+    {
+        return 63 - clz(x);
+    }
+
+    /**
+     ceil(log2(x)), 0 for 0 and 1.
+     */
+    constexpr int log2ceil(uint32_t x)
+    {
+        return x <= 1 ? 0 : 32 - clz(x - 1);
+    }
+
+    constexpr int log2ceil(uint64_t x)
+    {
+        return x <= 1 ? 0 : 64 - clz(x - 1);
+    }
+
+    /**
+     The smallest power of 2 >= x, 1 for 0; 0 when it does not fit, i.e.
+     above 2^31 (resp. 2^63).
+     */
+    constexpr uint32_t nextPowerOf2(uint32_t x)
+    {
+        return x > 0x80000000u ? 0u : (uint32_t)1 << log2ceil(x);
+    }
+
+    constexpr uint64_t nextPowerOf2(uint64_t x)
+    {
+        return x > 0x8000000000000000ull ? 0u : (uint64_t)1 << log2ceil(x);
+    }
+
+    //==============================================================================
+    /**
+     The bits in reverse order.
+     */
+    constexpr uint32_t bitReverse(uint32_t x)
+    {
+#if defined(__clang__)
+        return __builtin_bitreverse32(x);
+#else
+        return detail::swapGroups(detail::swapGroups(detail::swapGroups(detail::swapGroups(
+                   (x >> 16) | (x << 16), 8, 0x00ff00ffu), 4, 0x0f0f0f0fu), 2, 0x33333333u), 1, 0x55555555u);
+#endif
+    }
+
+    constexpr uint64_t bitReverse(uint64_t x)
+    {
+        return ((uint64_t)bitReverse((uint32_t)x) << 32) | bitReverse((uint32_t)(x >> 32));
+    }
+
+    /**
+     The pNumBits low bits of x in reverse order, pNumBits in [0, 32].
+     */
+    constexpr uint32_t bitReverse(uint32_t x, int pNumBits)
+    {
+        return pNumBits == 0 ? 0u : bitReverse(x) >> (32 - pNumBits);
+    }
+
+    //==============================================================================
+    /**
+     pOut[i] = bitReverse(i, pOrder) for i in [0, 2^pOrder), four indices
+     per vector.
+     */
+    inline void bitReverseIndices(uint32_t* pOut, int pOrder)
+    {
+        using namespace fbu::simd;
+        const uint32_t lSize = (uint32_t)1 << pOrder;
+        uint32_t i = 0;
+        if (pOrder >= 2)
+        {
+            const int32_t lFirstIndices[kFloatLanes] = {0, 1, 2, 3};
+            vint lIndices = loadInt(lFirstIndices);
+            const vint lStep = set1Int(kFloatLanes);
+            const vint lMask1 = set1Int(0x55555555), lMask2 = set1Int(0x33333333);
+            const vint lMask4 = set1Int(0x0f0f0f0f), lMask8 = set1Int(0x00ff00ff);
+            for ( ; i + (uint32_t)kFloatLanes <= lSize ; i += (uint32_t)kFloatLanes)
+            {
+                vint x = shiftRightLogical<16>(lIndices) | shiftLeft<16>(lIndices);
+                x = (shiftRightLogical<8>(x) & lMask8) | shiftLeft<8>(x & lMask8);
+                x = (shiftRightLogical<4>(x) & lMask4) | shiftLeft<4>(x & lMask4);
+                x = (shiftRightLogical<2>(x) & lMask2) | shiftLeft<2>(x & lMask2);
+                x = (shiftRightLogical<1>(x) & lMask1) | shiftLeft<1>(x & lMask1);
+                storeInt(reinterpret_cast<int32_t*>(pOut + i), shiftRightLogical(x, 32 - pOrder));
+                lIndices = lIndices + lStep;
+            }
+        }
+        for ( ; i != lSize ; ++i)
+        {
+            pOut[i] = bitReverse(i, pOrder);
+        }
+    }
+
+    /**
+     Bit-reversal permutation in place, e.g. the reordering of a radix-2
+     FFT, with the indices of bitReverseIndices().
+     */
+    template <typename T>
+    inline void bitReversePermute(T* pData, const uint32_t* pReversedIndices, size_t pSize)
+    {
+        for (size_t i = 0 ; i != pSize ; ++i)
+        {
+            const size_t j = (size_t)pReversedIndices[i];
+            if (i < j)
+            {
+                std::swap(pData[i], pData[j]);
+            }
+        }
+    }
+
+    /**
+     Out of place: pOut[i] = pIn[bitReverse(i, pOrder)], the indices being
+     computed on the fly. The writes are sequential.
+     */
+    template <typename T>
+    inline void bitReversePermute(const T* pIn, T* pOut, int pOrder)
+    {
+        const size_t lSize = (size_t)1 << pOrder;
+        const size_t lBlockSize = 256;
+        uint32_t lIndices[lBlockSize];
+        if (lSize <= lBlockSize)
+        {
+            bitReverseIndices(lIndices, pOrder);
+            for (size_t i = 0 ; i != lSize ; ++i)
+            {
+                pOut[i] = pIn[lIndices[i]];
+            }
+            return;
+        }
+        // the reversal of i = high * 256 + low is reverse(low) << (order - 8) | reverse(high)
+        bitReverseIndices(lIndices, 8);
+        const int lHighBits = pOrder - 8;
+        for (size_t lHigh = 0 ; lHigh != (lSize >> 8) ; ++lHigh)
+        {
+            const size_t lReversedHigh = (size_t)bitReverse((uint32_t)lHigh, lHighBits);
+            T* lOut = pOut + (lHigh << 8);
+            for (size_t lLow = 0 ; lLow != lBlockSize ; ++lLow)
+            {
+                lOut[lLow] = pIn[((size_t)lIndices[lLow] << lHighBits) | lReversedHigh];
+            }
+        }
+    }
+}
+}
+
+#endif
@@ -29,8 +29,10 @@ SOFTWARE.
 */
 
 #include "fbu/math_utils.hpp"
+#include "fbu/simd.hpp"
 
 #include <cmath>
+#include <limits>
 
 template<typename T>
 struct Complex
@@ -81,13 +83,20 @@ struct Complex
         return re * a.re + im * a.im;
     }
     
+    /**
+     Magnitude-weighted sum: S / sqrt(|S|) with S = |a| a + |b| b, i.e. the
+     power sum of the magnitudes when the phases are aligned.
+     Associative, see vectHypot() for N sources.
+     */
     static Complex<T> hypot(Complex<T> pFirst, Complex<T> pSecond)
     {
-        // TODO: validate mathematically
-        Complex<T> lFirstWithSqr = pFirst * pFirst.mag();
-        Complex<T> lSecondWithSqr = pSecond * pSecond.mag();
+        // |h| = sqrt(|S|), so |h| h = S: folding keeps summing the |x| x of
+        // the operands, hence the associativity, and aligned phases give
+        // |h|^2 = |a|^2 + |b|^2, the power sum
+        Complex<T> lFirstWithSqr = pFirst * std::sqrt(pFirst.sqrmag());
+        Complex<T> lSecondWithSqr = pSecond * std::sqrt(pSecond.sqrmag());
         Complex<T> lSqrSum = lFirstWithSqr + lSecondWithSqr;
-        T lSqrSumMag = lSqrSum.mag();
+        T lSqrSumMag = std::sqrt(lSqrSum.sqrmag());
         if (lSqrSumMag != (T)0)
         {
             return ((T)1 / std::sqrt(lSqrSumMag)) * lSqrSum;
@@ -127,7 +136,7 @@ struct Complex
     
     Complex<T>& operator/=(const T& s)
     {
-        float sinv = ((T)1) / s;
+        T sinv = ((T)1) / s;
         re *= sinv;
         im *= sinv;
         return *this;
@@ -135,9 +144,7 @@ struct Complex
     
     Complex<T>& operator/=(const Complex<T>& a)
     {
-        Complex<T> ainv = a.inverse();
-        *this = *this * ainv;
-        *this = *this * ainv;
+        *this = *this / a;
         return *this;
     }
     
@@ -235,6 +242,191 @@ void vectProductSC_I(T pS, Complex<T>* pInOut, size_t pSize)
     }
 }
 
+/**
+ pOut = pNum * conj(pDen) / (|pDen|² + pEpsilon), element-wise.
+ pEpsilon is the Tikhonov regularization, it avoids the blow-up of the bins
+ where the denominator vanishes. pOut may be pNum or pDen.
+ */
+template<typename T>
+void vectDivideRegularized(const Complex<T>* pNum, const Complex<T>* pDen, Complex<T>* pOut, size_t pSize, T pEpsilon)
+{
+    for (size_t u = 0 ; u != pSize ; ++u)
+    {
+        const Complex<T> a = pNum[u];
+        const Complex<T> b = pDen[u];
+        const T lInv = (T)1 / (b.sqrmag() + pEpsilon);
+        pOut[u] = {(a.re * b.re + a.im * b.im) * lInv,
+                   (a.im * b.re - a.re * b.im) * lInv};
+    }
+}
+
+/**
+ Float version: 4 bins per iteration, the reciprocal of |pDen|² + pEpsilon
+ is computed once per bin with simd::rcp(), the hardware estimate refined by
+ Newton-Raphson: relative error below 2^-21, the subnormal values included,
+ for the values below 2^126 (above, whose reciprocal is subnormal, it gives 0).
+ The products by the numerator round as in the scalar version, which also
+ handles the last size % 4 bins.
+ */
+template<>
+inline void vectDivideRegularized<float>(const Complex<float>* pNum, const Complex<float>* pDen, Complex<float>* pOut, size_t pSize, float pEpsilon)
+{
+    using namespace fbu::simd;
+    const size_t lNumPerIteration = (size_t)kFloatLanes;
+    const float* lNum = &pNum[0].re;
+    const float* lDen = &pDen[0].re;
+    float* lOut = &pOut[0].re;
+    const vfloat lEpsilon = set1(pEpsilon);
+    const vfloat lMinNormal = set1(std::numeric_limits<float>::min());
+    const vfloat lScale = set1(16777216.f);
+    size_t u = 0;
+    for ( ; u + lNumPerIteration <= pSize ; u += lNumPerIteration)
+    {
+        vfloat ar, ai, br, bi;
+        deinterleave(load(lNum + 2 * u), load(lNum + 2 * u + kFloatLanes), ar, ai);
+        deinterleave(load(lDen + 2 * u), load(lDen + 2 * u + kFloatLanes), br, bi);
+        // the estimate flushes the denormals to 0: they are scaled by 2^24
+        const vfloat lSqrMag = br * br + bi * bi + lEpsilon;
+        const vmask lDenormal = lSqrMag < lMinNormal;
+        vfloat lInv = rcp(select(lDenormal, lSqrMag * lScale, lSqrMag));
+        lInv = select(lDenormal, lInv * lScale, lInv);
+        vfloat lFirst, lSecond;
+        interleave((ar * br + ai * bi) * lInv, (ai * br - ar * bi) * lInv, lFirst, lSecond);
+        store(lOut + 2 * u, lFirst);
+        store(lOut + 2 * u + kFloatLanes, lSecond);
+    }
+    for ( ; u != pSize ; ++u)
+    {
+        const Complex<float> a = pNum[u];
+        const Complex<float> b = pDen[u];
+        const float lInv = 1.f / (b.sqrmag() + pEpsilon);
+        pOut[u] = {(a.re * b.re + a.im * b.im) * lInv,
+                   (a.im * b.re - a.re * b.im) * lInv};
+    }
+}
+
+/**
+ pOut = pNum / pDen, element-wise. pOut may be pNum or pDen.
+ */
+template<typename T>
+void vectDivide(const Complex<T>* pNum, const Complex<T>* pDen, Complex<T>* pOut, size_t pSize)
+{
+    vectDivideRegularized(pNum, pDen, pOut, pSize, (T)0);
+}
+
+//==============================================================================
+/**
+ Precision of the square roots in vectHypot(), float only. The errors are
+ measured for up to 32 sources, relative to sqrt(Σ |x_i|^2): when the
+ sources cancel out, the relative error on the (small) result is larger.
+ The estimates pay off where sqrt is slow (NEON, older x86): on recent x86,
+ exact is usually as fast, measure with the benchmark in test_complex.cpp.
+ */
+enum class HypotPrecision
+{
+    exact,      ///< sqrt instructions, max error 1e-6
+    fast,       ///< hardware rsqrt estimate + Newton-Raphson, max error 2e-6
+    coarse      ///< hardware rsqrt estimate only, max error 2e-3
+};
+
+/**
+ Magnitude-weighted sum of pNumSources spectra, bin per bin, in one pass:
+ pOut = S / sqrt(|S|) with S = Σ |x_i| x_i, the N-source generalization of
+ Complex<T>::hypot(). pOut may be one of the sources.
+ @param pPrecision Ignored for other types than float, where it is exact.
+ */
+template<typename T>
+void vectHypot(const Complex<T>* const* pSources, size_t pNumSources, Complex<T>* pOut, size_t pSize,
+               HypotPrecision pPrecision = HypotPrecision::exact)
+{
+    (void)pPrecision;
+    for (size_t u = 0 ; u != pSize ; ++u)
+    {
+        Complex<T> lSum = {(T)0, (T)0};
+        for (size_t s = 0 ; s != pNumSources ; ++s)
+        {
+            const Complex<T> x = pSources[s][u];
+            lSum += std::sqrt(x.sqrmag()) * x;
+        }
+        T lSumMag = std::sqrt(lSum.sqrmag());
+        pOut[u] = (lSumMag != (T)0) ? ((T)1 / std::sqrt(lSumMag)) * lSum : Complex<T>({(T)0, (T)0});
+    }
+}
+
+namespace fbu
+{
+namespace detail
+{
+    template <HypotPrecision P>
+    inline void vectHypotFloat(const Complex<float>* const* pSources, size_t pNumSources, Complex<float>* pOut, size_t pSize)
+    {
+        using namespace fbu::simd;
+        // sqrt(x) and 1/sqrt(x), 0 for x == 0
+        auto lSqrt = [](vfloat x) -> vfloat {
+            return P == HypotPrecision::exact ? sqrt(x)
+                 : P == HypotPrecision::fast  ? select(x > zero(), x * rsqrt(x), zero())
+                 :                              select(x > zero(), x * rsqrtEstimate(x), zero());
+        };
+        auto lRsqrt = [](vfloat x) -> vfloat {
+            return P == HypotPrecision::exact ? set1(1.f) / sqrt(x)
+                 : P == HypotPrecision::fast  ? rsqrt(x)
+                 :                              rsqrtEstimate(x);
+        };
+        const size_t lNumPerIteration = (size_t)kFloatLanes;
+        size_t u = 0;
+        for ( ; u + lNumPerIteration <= pSize ; u += lNumPerIteration)
+        {
+            vfloat lSumRe = zero();
+            vfloat lSumIm = zero();
+            for (size_t s = 0 ; s != pNumSources ; ++s)
+            {
+                const float* lSource = &pSources[s][u].re;
+                vfloat lRe, lIm;
+                deinterleave(load(lSource), load(lSource + kFloatLanes), lRe, lIm);
+                vfloat lMag = lSqrt(lRe * lRe + lIm * lIm);
+                lSumRe += lMag * lRe;
+                lSumIm += lMag * lIm;
+            }
+            vfloat lSumMag = lSqrt(lSumRe * lSumRe + lSumIm * lSumIm);
+            vfloat lScale = select(lSumMag > zero(), lRsqrt(lSumMag), zero());
+            vfloat lFirst, lSecond;
+            interleave(lScale * lSumRe, lScale * lSumIm, lFirst, lSecond);
+            store(&pOut[u].re, lFirst);
+            store(&pOut[u].re + kFloatLanes, lSecond);
+        }
+        for ( ; u != pSize ; ++u)
+        {
+            Complex<float> lSum = {0.f, 0.f};
+            for (size_t s = 0 ; s != pNumSources ; ++s)
+            {
+                const Complex<float> x = pSources[s][u];
+                lSum += std::sqrt(x.sqrmag()) * x;
+            }
+            float lSumMag = std::sqrt(lSum.sqrmag());
+            pOut[u] = (lSumMag != 0.f) ? (1.f / std::sqrt(lSumMag)) * lSum : Complex<float>({0.f, 0.f});
+        }
+    }
+}
+}
+
+template<>
+inline void vectHypot<float>(const Complex<float>* const* pSources, size_t pNumSources, Complex<float>* pOut, size_t pSize,
+                             HypotPrecision pPrecision)
+{
+    switch (pPrecision)
+    {
+        case HypotPrecision::exact:
+            fbu::detail::vectHypotFloat<HypotPrecision::exact>(pSources, pNumSources, pOut, pSize);
+            break;
+        case HypotPrecision::fast:
+            fbu::detail::vectHypotFloat<HypotPrecision::fast>(pSources, pNumSources, pOut, pSize);
+            break;
+        case HypotPrecision::coarse:
+            fbu::detail::vectHypotFloat<HypotPrecision::coarse>(pSources, pNumSources, pOut, pSize);
+            break;
+    }
+}
+
 //==============================================================================
 typedef Complex<float> Complexf;
 typedef Complex<double> Complexd;
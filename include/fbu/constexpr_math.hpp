@@ -0,0 +1,309 @@
+#ifndef FBU_CONSTEXPR_MATH_HPP_INCLUDED
+#define FBU_CONSTEXPR_MATH_HPP_INCLUDED
+
+/**
+ @file constexpr_math.hpp
+ @author François Becker
+
+MIT License
+
+Copyright (c) 2018 François Becker
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstddef>
+#include <limits>
+
+/*
+ C++11 constexpr math (single return statement, recursion), for generating
+ tables at compile time. Computed in double, accurate to a few ulps on the
+ documented domains. The functions can also be called at runtime, but are
+ slower than their <cmath> counterparts.
+ */
+
+namespace fbu
+{
+namespace cx
+{
+    constexpr double kPi = 3.14159265358979323846264338327950288;
+
+    constexpr double abs(double x)
+    {
+        return x < 0. ? -x : x;
+    }
+
+    /**
+     Nearest integer value, valid for |x| < 2^62.
+     */
+    constexpr double round(double x)
+    {
+        return x < 0. ? -(double)(long long)(0.5 - x) : (double)(long long)(x + 0.5);
+    }
+
+    //==============================================================================
+    namespace detail
+    {
+        // Σ (-1)^k x^2k / (2k)!, until the terms vanish
+        constexpr double cosSeries(double x2, double pTerm, int k, double pSum)
+        {
+            return (pSum + pTerm == pSum)
+                   ? pSum
+                   : cosSeries(x2, -pTerm * x2 / (double)((2 * k + 1) * (2 * k + 2)), k + 1, pSum + pTerm);
+        }
+
+        // decreasing from above until it stalls
+        constexpr double sqrtNewton(double x, double pEstimate, double pNext)
+        {
+            return (pNext >= pEstimate)
+                   ? pEstimate
+                   : sqrtNewton(x, pNext, 0.5 * (pNext + x / pNext));
+        }
+    }
+
+    /**
+     Cosine, the argument is first reduced to [-π,π].
+     */
+    constexpr double cos(double x)
+    {
+        return detail::cosSeries(  (x - 2. * kPi * round(x / (2. * kPi)))
+                                 * (x - 2. * kPi * round(x / (2. * kPi))), 1., 0, 0.);
+    }
+
+    constexpr double sin(double x)
+    {
+        return cos(x - 0.5 * kPi);
+    }
+
+    constexpr double sqrt(double x)
+    {
+        return x <= 0. ? 0. : detail::sqrtNewton(x, x > 1. ? x : 1., 0.5 * ((x > 1. ? x : 1.) + x / (x > 1. ? x : 1.)));
+    }
+
+    //==============================================================================
+    namespace detail
+    {
+        constexpr double square(double x)
+        {
+            return x * x;
+        }
+    }
+
+    /**
+     x^n for an integer n, by squaring.
+     */
+    constexpr double ipow(double x, int n)
+    {
+        return n < 0 ? 1. / ipow(x, -n)
+             : n == 0 ? 1.
+             : (n % 2 == 1) ? x * ipow(x, n - 1)
+             : detail::square(ipow(x, n / 2));
+    }
+
+    namespace detail
+    {
+        // ln(2) with a high part of 32 bits, so that n ln2Hi is exact
+        constexpr double kLn2Hi = 6.93147180369123816490e-01;
+        constexpr double kLn2Lo = 1.90821492927058770002e-10;
+        constexpr double kLn2 = 0.693147180559945309417232121458176568;
+        constexpr double kLn10 = 2.30258509299404568401799145468436421;
+
+        // Σ x^k / k!, until the terms vanish
+        constexpr double expSeries(double x, double pTerm, int k, double pSum)
+        {
+            return (pSum + pTerm == pSum)
+                   ? pSum
+                   : expSeries(x, pTerm * x / (double)(k + 1), k + 1, pSum + pTerm);
+        }
+
+        // e^x = 2^n e^r, with |r| <= ln(2) / 2
+        constexpr double expReduced(double x, double n)
+        {
+            return expSeries((x - n * kLn2Hi) - n * kLn2Lo, 1., 0, 0.) * ipow(2., (int)n);
+        }
+
+        // x = 2^e m with m in [1, 2), by steps of 2^32 first to bound the recursion
+        constexpr double normalizeMantissa(double x)
+        {
+            return x >= 4294967296. ? normalizeMantissa(x / 4294967296.)
+                 : x < 2.3283064365386963e-10 ? normalizeMantissa(x * 4294967296.)
+                 : x >= 2. ? normalizeMantissa(x / 2.)
+                 : x < 1. ? normalizeMantissa(x * 2.)
+                 : x;
+        }
+
+        constexpr int normalizeExponent(double x, int e)
+        {
+            return x >= 4294967296. ? normalizeExponent(x / 4294967296., e + 32)
+                 : x < 2.3283064365386963e-10 ? normalizeExponent(x * 4294967296., e - 32)
+                 : x >= 2. ? normalizeExponent(x / 2., e + 1)
+                 : x < 1. ? normalizeExponent(x * 2., e - 1)
+                 : e;
+        }
+
+        // Σ s^(2k+1) / (2k+1), until the terms vanish
+        constexpr double atanhSeries(double s2, double pPower, int k, double pSum)
+        {
+            return (pSum + pPower / (double)(2 * k + 1) == pSum)
+                   ? pSum
+                   : atanhSeries(s2, pPower * s2, k + 1, pSum + pPower / (double)(2 * k + 1));
+        }
+
+        // ln(m) = 2 atanh((m - 1) / (m + 1)), m in [1, 2)
+        constexpr double logMantissa(double m)
+        {
+            return 2. * atanhSeries(((m - 1.) / (m + 1.)) * ((m - 1.) / (m + 1.)), (m - 1.) / (m + 1.), 0, 0.);
+        }
+    }
+
+    /**
+     Natural exponential, for |x| < 708 (normal results).
+     */
+    constexpr double exp(double x)
+    {
+        return detail::expReduced(x, round(x / detail::kLn2));
+    }
+
+    /**
+     Natural logarithm of a positive finite x; NaN for x < 0, -inf for 0.
+     */
+    constexpr double log(double x)
+    {
+        return x < 0. ? std::numeric_limits<double>::quiet_NaN()
+             : x == 0. ? -std::numeric_limits<double>::infinity()
+             :   (double)detail::normalizeExponent(x, 0) * detail::kLn2Hi
+               + ((double)detail::normalizeExponent(x, 0) * detail::kLn2Lo + detail::logMantissa(detail::normalizeMantissa(x)));
+    }
+
+    /**
+     Base 2 logarithm, exact for the powers of 2.
+     */
+    constexpr double log2(double x)
+    {
+        return x <= 0. ? log(x)
+             : (double)detail::normalizeExponent(x, 0) + detail::logMantissa(detail::normalizeMantissa(x)) / detail::kLn2;
+    }
+
+    constexpr double log10(double x)
+    {
+        return log(x) / detail::kLn10;
+    }
+
+    /**
+     x^y for x > 0, as exp(y ln(x)); the relative error grows with |y ln(x)|.
+     */
+    constexpr double pow(double x, double y)
+    {
+        return exp(y * log(x));
+    }
+
+    /**
+     10^(dB / 20) and 20 log10(gain).
+     */
+    constexpr double dBToGain(double pDB)
+    {
+        return exp(pDB * (detail::kLn10 / 20.));
+    }
+
+    constexpr double gainToDB(double pGain)
+    {
+        return (20. / detail::kLn10) * log(pGain);
+    }
+
+    //==============================================================================
+    template <int... Is>
+    struct IndexSequence {};
+
+    namespace detail
+    {
+        template <class First, class Second>
+        struct ConcatIndexSequences;
+
+        template <int... Is, int... Js>
+        struct ConcatIndexSequences< IndexSequence<Is...>, IndexSequence<Js...> >
+        {
+            typedef IndexSequence<Is..., (int)sizeof...(Is) + Js...> type;
+        };
+    }
+
+    // halves recursively, so that the instantiation depth is log2(N) and
+    // tables of thousands of values stay within the compiler limits
+    template <int N>
+    struct MakeIndexSequence
+    : detail::ConcatIndexSequences< typename MakeIndexSequence<N / 2>::type,
+                                    typename MakeIndexSequence<N - N / 2>::type > {};
+
+    template <>
+    struct MakeIndexSequence<0>
+    {
+        typedef IndexSequence<> type;
+    };
+
+    template <>
+    struct MakeIndexSequence<1>
+    {
+        typedef IndexSequence<0> type;
+    };
+
+    /**
+     A fixed-size table usable in constant expressions.
+     */
+    template <typename T, int N>
+    struct Table
+    {
+        alignas(32) T mValues[N];
+
+        constexpr T operator[](int i) const
+        {
+            return mValues[i];
+        }
+
+        static constexpr int size()
+        {
+            return N;
+        }
+
+        const T* data() const
+        {
+            return mValues;
+        }
+    };
+
+    namespace detail
+    {
+        template <typename T, int N, class Generator, int... Is>
+        constexpr Table<T, N> makeTable(IndexSequence<Is...>)
+        {
+            return Table<T, N>{{ (T)Generator::value(Is)... }};
+        }
+    }
+
+    /**
+     Table of N values Generator::value(i), i in [0, N), where value() is a
+     constexpr static function.
+     */
+    template <typename T, int N, class Generator>
+    constexpr Table<T, N> makeTable()
+    {
+        return detail::makeTable<T, N, Generator>(typename MakeIndexSequence<N>::type());
+    }
+}
+}
+
+#endif
@@ -0,0 +1,337 @@
+#ifndef FBU_DIRECTION_INDEX_HPP_INCLUDED
+#define FBU_DIRECTION_INDEX_HPP_INCLUDED
+
+/**
+ @file direction_index.hpp
+ @author François Becker
+
+MIT License
+
+Copyright (c) 2018 François Becker
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "fbu/vector3.hpp"
+#include "fbu/vector3_array.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace fbu
+{
+    //==============================================================================
+    /**
+     @class DirectionIndex
+     @brief The nearest of a static set of directions, e.g. of the measured HRTFs
+     or the speakers.
+
+     The directions are normalized and kept in a k-d tree: as the angle between
+     unit vectors grows with the distance between them, the nearest direction
+     is the nearest point on the unit sphere. The queries take directions that
+     need not be normalized, and return the indices of the directions in the
+     set given to build().
+     */
+    template <typename T>
+    class DirectionIndex
+    {
+    public:
+        /// the ranges of at most kLeafSize directions are scanned linearly
+        static constexpr size_t kLeafSize = 8;
+
+        DirectionIndex() = default;
+
+        explicit DirectionIndex(const std::vector< Vector3<T> >& pDirections)
+        {
+            build(pDirections);
+        }
+
+        /**
+         The directions must not be zero.
+         */
+        void build(const std::vector< Vector3<T> >& pDirections)
+        {
+            mNodes.resize(pDirections.size());
+            for (size_t i = 0 ; i != pDirections.size() ; ++i)
+            {
+                assert(! pDirections[i].isZero());
+                mNodes[i].mDirection = pDirections[i].normalized();
+                mNodes[i].mIndex = i;
+                mNodes[i].mAxis = 0;
+            }
+            build(0, mNodes.size());
+        }
+
+        size_t size() const
+        {
+            return mNodes.size();
+        }
+
+        bool empty() const
+        {
+            return mNodes.empty();
+        }
+
+        /**
+         The index of the nearest direction. The index must not be empty.
+         */
+        size_t nearest(const Vector3<T>& pDirection) const
+        {
+            assert(! empty());
+            Candidate lBest = {std::numeric_limits<T>::infinity(), 0};
+            findNearest(pDirection.normalizedWithDefault(front()), 0, mNodes.size(), lBest);
+            return lBest.mIndex;
+        }
+
+        size_t nearest(const AE<T>& pDirection) const
+        {
+            return nearest(Vector3<T>::fromAE(pDirection));
+        }
+
+        /**
+         The indices of the pK nearest directions, the nearest first, in pOut
+         which is resized to at most pK.
+         */
+        void nearest(const Vector3<T>& pDirection, size_t pK, std::vector<size_t>& pOut) const
+        {
+            std::vector<Candidate> lCandidates;
+            lCandidates.reserve(pK + 1);
+            if (pK != 0)
+            {
+                findNearest(pDirection.normalizedWithDefault(front()), 0, mNodes.size(), pK, lCandidates);
+            }
+            std::sort_heap(lCandidates.begin(), lCandidates.end());
+            copyIndices(lCandidates, pOut);
+        }
+
+        /**
+         The indices of the directions within pAngle (rad) of pDirection, the
+         nearest first.
+         */
+        void withinAngle(const Vector3<T>& pDirection, T pAngle, std::vector<size_t>& pOut) const
+        {
+            std::vector<Candidate> lCandidates;
+            if (pAngle >= (T)0)
+            {
+                // the chord of pAngle, squared, with a margin for the rounding
+                const T lChord = (T)2 * std::sin((T)0.5 * std::min(pAngle, (T)M_PI));
+                const T lMaxSqrDistance = lChord * lChord * ((T)1 + (T)4 * std::numeric_limits<T>::epsilon());
+                findWithin(pDirection.normalizedWithDefault(front()), 0, mNodes.size(), lMaxSqrDistance, lCandidates);
+            }
+            std::sort(lCandidates.begin(), lCandidates.end());
+            copyIndices(lCandidates, pOut);
+        }
+
+        /**
+         pOut[i] = nearest(pDirections[i]), pOut holding pDirections.size()
+         values.
+         */
+        void nearest(const Vector3Array<T>& pDirections, size_t* pOut) const
+        {
+            for (size_t i = 0 ; i != pDirections.size() ; ++i)
+            {
+                pOut[i] = nearest(pDirections[i]);
+            }
+        }
+
+    private:
+        struct Node
+        {
+            Vector3<T> mDirection;
+            size_t mIndex;      ///< in the set given to build()
+            uint8_t mAxis;      ///< of the split at this node, 0 to 2 for X to Z
+        };
+
+        struct Candidate
+        {
+            T mSqrDistance;
+            size_t mIndex;
+
+            bool operator<(const Candidate& pOther) const
+            {
+                return mSqrDistance < pOther.mSqrDistance
+                    || (mSqrDistance == pOther.mSqrDistance && mIndex < pOther.mIndex);
+            }
+        };
+
+        // for the zero directions of the queries
+        static Vector3<T> front()
+        {
+            return Vector3<T>::cartesian((T)1, (T)0, (T)0);
+        }
+
+        static T coordinate(const Vector3<T>& pVect, uint8_t pAxis)
+        {
+            return pAxis == 0 ? pVect.mX : (pAxis == 1 ? pVect.mY : pVect.mZ);
+        }
+
+        static T sqrDistance(const Vector3<T>& pA, const Vector3<T>& pB)
+        {
+            return (pA - pB).sqrLength();
+        }
+
+        static void copyIndices(const std::vector<Candidate>& pCandidates, std::vector<size_t>& pOut)
+        {
+            pOut.resize(pCandidates.size());
+            for (size_t i = 0 ; i != pCandidates.size() ; ++i)
+            {
+                pOut[i] = pCandidates[i].mIndex;
+            }
+        }
+
+        // the node of [pBegin, pEnd) is its middle, split along the axis of
+        // the largest extent
+        void build(size_t pBegin, size_t pEnd)
+        {
+            if (pEnd - pBegin <= kLeafSize)
+            {
+                return;
+            }
+            Vector3<T> lMin = mNodes[pBegin].mDirection;
+            Vector3<T> lMax = lMin;
+            for (size_t i = pBegin + 1 ; i != pEnd ; ++i)
+            {
+                const Vector3<T>& v = mNodes[i].mDirection;
+                lMin = Vector3<T>::cartesian(std::min(lMin.mX, v.mX), std::min(lMin.mY, v.mY), std::min(lMin.mZ, v.mZ));
+                lMax = Vector3<T>::cartesian(std::max(lMax.mX, v.mX), std::max(lMax.mY, v.mY), std::max(lMax.mZ, v.mZ));
+            }
+            const Vector3<T> lExtent = lMax - lMin;
+            const uint8_t lAxis = (lExtent.mX >= lExtent.mY && lExtent.mX >= lExtent.mZ) ? 0 : (lExtent.mY >= lExtent.mZ ? 1 : 2);
+            const size_t lMiddle = pBegin + (pEnd - pBegin) / 2;
+            std::nth_element(mNodes.begin() + (ptrdiff_t)pBegin, mNodes.begin() + (ptrdiff_t)lMiddle, mNodes.begin() + (ptrdiff_t)pEnd,
+                             [lAxis](const Node& pA, const Node& pB)
+                             {
+                                 return coordinate(pA.mDirection, lAxis) < coordinate(pB.mDirection, lAxis);
+                             });
+            mNodes[lMiddle].mAxis = lAxis;
+            build(pBegin, lMiddle);
+            build(lMiddle + 1, pEnd);
+        }
+
+        void findNearest(const Vector3<T>& pDirection, size_t pBegin, size_t pEnd, Candidate& pBest) const
+        {
+            if (pEnd - pBegin <= kLeafSize)
+            {
+                for (size_t u = pBegin ; u != pEnd ; ++u)
+                {
+                    const Candidate lCandidate = {sqrDistance(mNodes[u].mDirection, pDirection), mNodes[u].mIndex};
+                    if (lCandidate < pBest)
+                    {
+                        pBest = lCandidate;
+                    }
+                }
+                return;
+            }
+            const size_t lMiddle = pBegin + (pEnd - pBegin) / 2;
+            const Node& lNode = mNodes[lMiddle];
+            const Candidate lCandidate = {sqrDistance(lNode.mDirection, pDirection), lNode.mIndex};
+            if (lCandidate < pBest)
+            {
+                pBest = lCandidate;
+            }
+            const T lOffset = coordinate(pDirection, lNode.mAxis) - coordinate(lNode.mDirection, lNode.mAxis);
+            const bool lNearIsLeft = lOffset < (T)0;
+            findNearest(pDirection, lNearIsLeft ? pBegin : lMiddle + 1, lNearIsLeft ? lMiddle : pEnd, pBest);
+            if (lOffset * lOffset <= pBest.mSqrDistance)
+            {
+                findNearest(pDirection, lNearIsLeft ? lMiddle + 1 : pBegin, lNearIsLeft ? pEnd : lMiddle, pBest);
+            }
+        }
+
+        // pBest is a max-heap of at most pK candidates
+        void findNearest(const Vector3<T>& pDirection, size_t pBegin, size_t pEnd, size_t pK, std::vector<Candidate>& pBest) const
+        {
+            if (pEnd - pBegin <= kLeafSize)
+            {
+                for (size_t u = pBegin ; u != pEnd ; ++u)
+                {
+                    insert({sqrDistance(mNodes[u].mDirection, pDirection), mNodes[u].mIndex}, pK, pBest);
+                }
+                return;
+            }
+            const size_t lMiddle = pBegin + (pEnd - pBegin) / 2;
+            const Node& lNode = mNodes[lMiddle];
+            insert({sqrDistance(lNode.mDirection, pDirection), lNode.mIndex}, pK, pBest);
+            const T lOffset = coordinate(pDirection, lNode.mAxis) - coordinate(lNode.mDirection, lNode.mAxis);
+            const bool lNearIsLeft = lOffset < (T)0;
+            findNearest(pDirection, lNearIsLeft ? pBegin : lMiddle + 1, lNearIsLeft ? lMiddle : pEnd, pK, pBest);
+            if (pBest.size() < pK || lOffset * lOffset <= pBest.front().mSqrDistance)
+            {
+                findNearest(pDirection, lNearIsLeft ? lMiddle + 1 : pBegin, lNearIsLeft ? pEnd : lMiddle, pK, pBest);
+            }
+        }
+
+        static void insert(const Candidate& pCandidate, size_t pK, std::vector<Candidate>& pBest)
+        {
+            if (pBest.size() < pK)
+            {
+                pBest.push_back(pCandidate);
+                std::push_heap(pBest.begin(), pBest.end());
+            }
+            else if (pCandidate < pBest.front())
+            {
+                std::pop_heap(pBest.begin(), pBest.end());
+                pBest.back() = pCandidate;
+                std::push_heap(pBest.begin(), pBest.end());
+            }
+        }
+
+        void findWithin(const Vector3<T>& pDirection, size_t pBegin, size_t pEnd, T pMaxSqrDistance, std::vector<Candidate>& pOut) const
+        {
+            if (pEnd - pBegin <= kLeafSize)
+            {
+                for (size_t u = pBegin ; u != pEnd ; ++u)
+                {
+                    const T lSqrDistance = sqrDistance(mNodes[u].mDirection, pDirection);
+                    if (lSqrDistance <= pMaxSqrDistance)
+                    {
+                        pOut.push_back({lSqrDistance, mNodes[u].mIndex});
+                    }
+                }
+                return;
+            }
+            const size_t lMiddle = pBegin + (pEnd - pBegin) / 2;
+            const Node& lNode = mNodes[lMiddle];
+            const T lSqrDistance = sqrDistance(lNode.mDirection, pDirection);
+            if (lSqrDistance <= pMaxSqrDistance)
+            {
+                pOut.push_back({lSqrDistance, lNode.mIndex});
+            }
+            const T lOffset = coordinate(pDirection, lNode.mAxis) - coordinate(lNode.mDirection, lNode.mAxis);
+            if (lOffset <= (T)0 || lOffset * lOffset <= pMaxSqrDistance)
+            {
+                findWithin(pDirection, pBegin, lMiddle, pMaxSqrDistance, pOut);
+            }
+            if (lOffset >= (T)0 || lOffset * lOffset <= pMaxSqrDistance)
+            {
+                findWithin(pDirection, lMiddle + 1, pEnd, pMaxSqrDistance, pOut);
+            }
+        }
+
+        std::vector<Node> mNodes; ///< the k-d tree
+    };
+}
+
+#endif // FBU_DIRECTION_INDEX_HPP_INCLUDED
@@ -0,0 +1,314 @@
+#ifndef FBU_DOPPLER_HPP_INCLUDED
+#define FBU_DOPPLER_HPP_INCLUDED
+
+/**
+ @file doppler.hpp
+ @author François Becker
+
+MIT License
+
+Copyright (c) 2018 François Becker
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "fbu/bits.hpp"
+#include "fbu/sad.hpp"
+#include "fbu/simd.hpp"
+#include "fbu/vector3.hpp"
+#include "fbu/vector3_array.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ The propagation from moving sources to a listener: per block, the distance
+ gains and the propagation delays of all the sources at the start and at the
+ end of the block give linear ramps, which FractionalDelayLine applies to
+ the signals of the sources. The delay ramps make the Doppler effect.
+ */
+
+namespace fbu
+{
+    /**
+     The propagation parameters.
+     */
+    struct PropagationSettings
+    {
+        float mSampleRate = 48000.f;
+        float mSpeedOfSound = 343.f;        ///< in the units of the positions per second
+        float mReferenceDistance = 1.f;     ///< the gain is 1 up to this distance
+        float mRolloff = 1.f;               ///< 0 for no attenuation
+        float mMaxDelay = 48000.f;          ///< samples, the delays are clamped to it
+    };
+
+    /**
+     The gain and delay ramps of the sources over a block: the value at
+     sample n of the block is start + n * step, and the start of the next
+     block is start + numSamples * step.
+     */
+    struct PropagationRamps
+    {
+        float* mGains;
+        float* mGainSteps;
+        float* mDelays;         ///< samples
+        float* mDelaySteps;
+    };
+
+    namespace detail
+    {
+        inline simd::vfloat distance(const Vector3Array<float>& pSources, size_t u, const Vector3f& pListener)
+        {
+            using namespace fbu::simd;
+            const vfloat x = load(pSources.x() + u) - set1(pListener.mX);
+            const vfloat y = load(pSources.y() + u) - set1(pListener.mY);
+            const vfloat z = load(pSources.z() + u) - set1(pListener.mZ);
+            return sqrt(mulAdd(x, x, mulAdd(y, y, z * z)));
+        }
+    }
+
+    /**
+     The scalar propagation gain at the distance pDistance: the inverse
+     distance clamped model, ref / (ref + rolloff (max(d, ref) - ref)).
+     */
+    inline float propagationGain(float pDistance, const PropagationSettings& pSettings)
+    {
+        const float lReference = pSettings.mReferenceDistance;
+        return lReference / (lReference + pSettings.mRolloff * (std::max(pDistance, lReference) - lReference));
+    }
+
+    /**
+     The scalar propagation delay at the distance pDistance, in samples.
+     */
+    inline float propagationDelay(float pDistance, const PropagationSettings& pSettings)
+    {
+        return std::min(pDistance * (pSettings.mSampleRate / pSettings.mSpeedOfSound), pSettings.mMaxDelay);
+    }
+
+    /**
+     The gain and delay ramps over a block of pNumSamples of the sources at
+     pSourcesStart at the start of the block and pSourcesEnd at its end, for
+     a listener moving from pListenerStart to pListenerEnd, vectorized over
+     the sources. The arrays of pRamps hold pSourcesStart.size() values.
+     */
+    inline void computePropagation(const Vector3Array<float>& pSourcesStart, const Vector3Array<float>& pSourcesEnd,
+                                   const Vector3f& pListenerStart, const Vector3f& pListenerEnd,
+                                   const PropagationSettings& pSettings, SampleCount pNumSamples,
+                                   const PropagationRamps& pRamps)
+    {
+        using namespace fbu::simd;
+        assert(pSourcesStart.size() == pSourcesEnd.size());
+        assert(pNumSamples > 0);
+        const vfloat lReference = set1(pSettings.mReferenceDistance);
+        const vfloat lRolloff = set1(pSettings.mRolloff);
+        const vfloat lSamplesPerUnit = set1(pSettings.mSampleRate / pSettings.mSpeedOfSound);
+        const vfloat lMaxDelay = set1(pSettings.mMaxDelay);
+        const vfloat lInvNumSamples = set1(1.f / (float)pNumSamples);
+        const size_t lSize = pSourcesStart.size();
+        for (size_t u = 0 ; u < lSize ; u += (size_t)kFloatLanes)
+        {
+            const vfloat lDistanceStart = detail::distance(pSourcesStart, u, pListenerStart);
+            const vfloat lDistanceEnd = detail::distance(pSourcesEnd, u, pListenerEnd);
+            const vfloat lGainStart = lReference / mulAdd(lRolloff, max(lDistanceStart, lReference) - lReference, lReference);
+            const vfloat lGainEnd = lReference / mulAdd(lRolloff, max(lDistanceEnd, lReference) - lReference, lReference);
+            const vfloat lDelayStart = min(lDistanceStart * lSamplesPerUnit, lMaxDelay);
+            const vfloat lDelayEnd = min(lDistanceEnd * lSamplesPerUnit, lMaxDelay);
+            const vfloat lOutputs[] = {lGainStart, (lGainEnd - lGainStart) * lInvNumSamples,
+                                       lDelayStart, (lDelayEnd - lDelayStart) * lInvNumSamples};
+            float* const lArrays[] = {pRamps.mGains, pRamps.mGainSteps, pRamps.mDelays, pRamps.mDelaySteps};
+            for (size_t k = 0 ; k != 4 ; ++k)
+            {
+                if (u + (size_t)kFloatLanes <= lSize)
+                {
+                    store(lArrays[k] + u, lOutputs[k]);
+                }
+                else
+                {
+                    float lTail[kFloatLanes];
+                    store(lTail, lOutputs[k]);
+                    std::copy(lTail, lTail + (lSize - u), lArrays[k] + u);
+                }
+            }
+        }
+    }
+
+    //==============================================================================
+    /**
+     The interpolations of FractionalDelayLine.
+     */
+    enum class FractionalDelay
+    {
+        linear,     ///< 2 taps, delays from 0
+        lagrange,   ///< 3rd order Lagrange, 4 taps, delays from 1
+        thiran      ///< 1st order Thiran allpass, flat magnitude, delays from 0.5, for slowly varying delays: its state clicks slightly when the integer tap moves
+    };
+
+    /**
+     @class FractionalDelayLine
+     @brief A delay line read at fractional delays, ramped over the blocks.
+
+     Each block is written, then read with a delay and a gain ramp, such as
+     the ones of computePropagation(): output sample n is the input at n -
+     delay(n), times gain(n). The delays are clamped to the range of the
+     interpolation and to the maximum delay. The buffer is a power of 2
+     long, so that the taps wrap with a mask: the reading loops have no
+     branches. Nothing allocates after the construction.
+     */
+    class FractionalDelayLine
+    {
+    public:
+        FractionalDelayLine(float pMaxDelay, SampleCount pMaxBlockSize)
+        : mMaxDelay(pMaxDelay)
+        , mMaxBlockSize(pMaxBlockSize)
+        , mBuffer(bits::nextPowerOf2((uint32_t)pMaxDelay + (uint32_t)pMaxBlockSize + 4u), 0.f)
+        , mMask(mBuffer.size() - 1)
+        {
+        }
+
+        float getMaxDelay() const
+        {
+            return mMaxDelay;
+        }
+
+        void reset()
+        {
+            std::fill(mBuffer.begin(), mBuffer.end(), 0.f);
+            mAllpassOutput = 0.f;
+        }
+
+        /**
+         Append a block of at most the maximum block size.
+         */
+        void write(const float* pIn, SampleCount pNumSamples)
+        {
+            assert(pNumSamples <= mMaxBlockSize);
+            const size_t lFirst = std::min((size_t)pNumSamples, mBuffer.size() - mWritePosition);
+            std::copy(pIn, pIn + lFirst, mBuffer.begin() + (ptrdiff_t)mWritePosition);
+            std::copy(pIn + lFirst, pIn + pNumSamples, mBuffer.begin());
+            mBlockStart = mWritePosition;
+            mWritePosition = (mWritePosition + pNumSamples) & mMask;
+        }
+
+        /**
+         Read the last block written, of pNumSamples, with the delay
+         pDelay + n pDelayStep and the gain pGain + n pGainStep at sample n.
+         */
+        void read(float* pOut, SampleCount pNumSamples, float pDelay, float pDelayStep, float pGain, float pGainStep,
+                  FractionalDelay pInterpolation)
+        {
+            switch (pInterpolation)
+            {
+                case FractionalDelay::linear:
+                    readLinear(pOut, pNumSamples, pDelay, pDelayStep, pGain, pGainStep);
+                    break;
+                case FractionalDelay::lagrange:
+                    readLagrange(pOut, pNumSamples, pDelay, pDelayStep, pGain, pGainStep);
+                    break;
+                case FractionalDelay::thiran:
+                    readThiran(pOut, pNumSamples, pDelay, pDelayStep, pGain, pGainStep);
+                    break;
+            }
+        }
+
+        /**
+         The same with the ramps of source pSource.
+         */
+        void read(float* pOut, SampleCount pNumSamples, const PropagationRamps& pRamps, size_t pSource,
+                  FractionalDelay pInterpolation)
+        {
+            read(pOut, pNumSamples, pRamps.mDelays[pSource], pRamps.mDelaySteps[pSource],
+                 pRamps.mGains[pSource], pRamps.mGainSteps[pSource], pInterpolation);
+        }
+
+    private:
+        // the delay of sample n in [pMin, mMaxDelay]
+        float delayAt(float pDelay, float pDelayStep, SampleCount n, float pMin) const
+        {
+            return std::min(std::max(pDelay + (float)n * pDelayStep, pMin), mMaxDelay);
+        }
+
+        // the index of the sample pIndex samples before the input sample n
+        size_t tap(SampleCount n, size_t pIndex) const
+        {
+            return (mBlockStart + n - pIndex) & mMask;
+        }
+
+        void readLinear(float* pOut, SampleCount pNumSamples, float pDelay, float pDelayStep, float pGain, float pGainStep) const
+        {
+            for (SampleCount n = 0 ; n != pNumSamples ; ++n)
+            {
+                const float d = delayAt(pDelay, pDelayStep, n, 0.f);
+                const size_t i = (size_t)d;
+                const float f = d - (float)i;
+                const float x0 = mBuffer[tap(n, i)];
+                const float x1 = mBuffer[tap(n, i + 1)];
+                pOut[n] = (pGain + (float)n * pGainStep) * (x0 + f * (x1 - x0));
+            }
+        }
+
+        void readLagrange(float* pOut, SampleCount pNumSamples, float pDelay, float pDelayStep, float pGain, float pGainStep) const
+        {
+            for (SampleCount n = 0 ; n != pNumSamples ; ++n)
+            {
+                const float d = delayAt(pDelay, pDelayStep, n, 1.f);
+                const size_t i = (size_t)d;
+                const float f = d - (float)i;
+                // the taps at the delays i - 1 to i + 2
+                const float fp1 = f + 1.f, fm1 = f - 1.f, fm2 = f - 2.f;
+                const float h0 = -f * fm1 * fm2 * (1.f / 6.f);
+                const float h1 = fp1 * fm1 * fm2 * 0.5f;
+                const float h2 = -fp1 * f * fm2 * 0.5f;
+                const float h3 = fp1 * f * fm1 * (1.f / 6.f);
+                const float y = h0 * mBuffer[tap(n, i - 1)] + h1 * mBuffer[tap(n, i)]
+                              + h2 * mBuffer[tap(n, i + 1)] + h3 * mBuffer[tap(n, i + 2)];
+                pOut[n] = (pGain + (float)n * pGainStep) * y;
+            }
+        }
+
+        // y[n] = a x[n - i] + x[n - i - 1] - a y[n - 1], the fractional part
+        // in [0.5, 1.5) and a = (1 - fraction) / (1 + fraction)
+        void readThiran(float* pOut, SampleCount pNumSamples, float pDelay, float pDelayStep, float pGain, float pGainStep)
+        {
+            float y = mAllpassOutput;
+            for (SampleCount n = 0 ; n != pNumSamples ; ++n)
+            {
+                const float d = delayAt(pDelay, pDelayStep, n, 0.5f);
+                const size_t i = (size_t)(d - 0.5f);
+                const float f = d - (float)i;
+                const float a = (1.f - f) / (1.f + f);
+                y = a * (mBuffer[tap(n, i)] - y) + mBuffer[tap(n, i + 1)];
+                pOut[n] = (pGain + (float)n * pGainStep) * y;
+            }
+            mAllpassOutput = y;
+        }
+
+        float mMaxDelay;
+        SampleCount mMaxBlockSize;
+        std::vector<float> mBuffer;
+        size_t mMask;
+        size_t mWritePosition = 0;
+        size_t mBlockStart = 0;
+        float mAllpassOutput = 0.f;
+    };
+}
+
+#endif
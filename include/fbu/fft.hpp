@@ -0,0 +1,119 @@
+#ifndef FBU_FFT_HPP_INCLUDED
+#define FBU_FFT_HPP_INCLUDED
+
+/**
+ @file fft.hpp
+ @author François Becker
+
+MIT License
+
+Copyright (c) 2018 François Becker
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "fbu/bits.hpp"
+#include "fbu/complex.hpp"
+#include "fbu/spectral_tables.hpp"
+
+#include <algorithm>
+#include <vector>
+#include <cassert>
+#include <cstdint>
+
+namespace fbu
+{
+    /**
+     @class Fft
+     @brief In-place radix-2 complex FFT of size 2^order.
+            The tables are set up at construction, the twiddle factors being
+            shared through the SpectralTableCache. perform() does not allocate.
+     */
+    template <typename T>
+    class Fft
+    {
+    public:
+        /**
+         Constructor.
+         @param pOrder The FFT size is 2^pOrder.
+         */
+        explicit Fft(int pOrder)
+        : mOrder(pOrder)
+        , mSize(1 << pOrder)
+        , mTwiddles(SpectralTableCache::getInstance().getTwiddles<T>(std::max(mSize, 2)))
+        , mBitReversed((size_t)mSize)
+        {
+            assert(pOrder >= 0 && pOrder < 31);
+            bits::bitReverseIndices(mBitReversed.data(), mOrder);
+        }
+
+        int getOrder() const
+        {
+            return mOrder;
+        }
+
+        int getSize() const
+        {
+            return mSize;
+        }
+
+        /**
+         Transform pInOut (getSize() elements) in place.
+         The forward transform is unnormalized, the inverse transform is scaled
+         by 1/N so that forward followed by inverse is the identity.
+         */
+        void perform(Complex<T>* pInOut, bool pInverse = false) const
+        {
+            bits::bitReversePermute(pInOut, mBitReversed.data(), (size_t)mSize);
+
+            for (int lHalf = 1, lStride = mSize / 2 ; lHalf < mSize ; lHalf *= 2, lStride /= 2)
+            {
+                for (int lStart = 0 ; lStart < mSize ; lStart += 2 * lHalf)
+                {
+                    for (int k = 0 ; k != lHalf ; ++k)
+                    {
+                        Complex<T> w = (*mTwiddles)[(size_t)(k * lStride)];
+                        if (pInverse)
+                        {
+                            w.im = -w.im;
+                        }
+                        Complex<T>& a = pInOut[lStart + k];
+                        Complex<T>& b = pInOut[lStart + k + lHalf];
+                        Complex<T> lProduct = w * b;
+                        b = a - lProduct;
+                        a += lProduct;
+                    }
+                }
+            }
+
+            if (pInverse)
+            {
+                vectProductSC_I((T)1 / (T)mSize, pInOut, (size_t)mSize);
+            }
+        }
+
+    private:
+        int mOrder;
+        int mSize;
+        std::shared_ptr< const SpectralTableCache::Twiddles<T> > mTwiddles;
+        std::vector<uint32_t>                                     mBitReversed;
+    };
+}
+
+#endif
@@ -0,0 +1,270 @@
+#ifndef FBU_LOOKUP_TABLE_HPP_INCLUDED
+#define FBU_LOOKUP_TABLE_HPP_INCLUDED
+
+/**
+ @file lookup_table.hpp
+ @author François Becker
+
+MIT License
+
+Copyright (c) 2018 François Becker
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "fbu/constexpr_math.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace fbu
+{
+    /**
+     N + 1 samples of a curve over [min, max], computed at compile time with
+     makeLookupTable(), and interpolated at runtime. The lookup is a multiply,
+     a truncation and a lerp: well worth it against std::pow or std::log10,
+     not against a couple of multiplications.
+     */
+    template <typename T, int N>
+    struct LookupTable
+    {
+        static_assert(N > 0, "at least one interval");
+
+        cx::Table<T, N + 1> mValues;
+        T mMin;
+        T mStepsPerUnit;    ///< N / (max - min)
+
+        constexpr T operator[](int i) const
+        {
+            return mValues[i];
+        }
+
+        static constexpr int size()
+        {
+            return N + 1;
+        }
+
+        /**
+         Linear interpolation, x clamped to [min, max]; NaN gives the first value.
+         */
+        T lookupLinear(T x) const
+        {
+            T lPosition = (x - mMin) * mStepsPerUnit;
+            lPosition = lPosition > (T)0 ? lPosition : (T)0;
+            lPosition = lPosition < (T)N ? lPosition : (T)N;
+            return interpolate(lPosition);
+        }
+
+        /**
+         Nearest sample, x clamped to [min, max].
+         */
+        T lookupNearest(T x) const
+        {
+            T lPosition = (x - mMin) * mStepsPerUnit + (T)0.5;
+            lPosition = lPosition > (T)0 ? lPosition : (T)0;
+            lPosition = lPosition < (T)N ? lPosition : (T)N;
+            return mValues.mValues[(int)lPosition];
+        }
+
+        /**
+         Linear interpolation of a periodic curve of period max - min, whose
+         last sample equals the first one. x must be finite.
+         */
+        T lookupPeriodic(T x) const
+        {
+            const T lPosition = (x - mMin) * mStepsPerUnit;
+            // floor, then the index modulo N
+            long long lFloor = (long long)lPosition;
+            lFloor -= lPosition < (T)lFloor ? 1 : 0;
+            const T lFraction = lPosition - (T)lFloor;
+            int i = (int)(lFloor % N);
+            i += i < 0 ? N : 0;
+            return mValues.mValues[i] + lFraction * (mValues.mValues[i + 1] - mValues.mValues[i]);
+        }
+
+    private:
+        // pPosition in [0, N]
+        T interpolate(T pPosition) const
+        {
+            int i = (int)pPosition;
+            i = i < N ? i : N - 1;
+            const T lFraction = pPosition - (T)i;
+            return mValues.mValues[i] + lFraction * (mValues.mValues[i + 1] - mValues.mValues[i]);
+        }
+    };
+
+    namespace detail
+    {
+        template <class Curve, int N>
+        struct CurveSampler
+        {
+            static constexpr double value(int i)
+            {
+                return Curve::value(Curve::min() + (Curve::max() - Curve::min()) * (double)i / (double)N);
+            }
+        };
+    }
+
+    /**
+     Table of the N + 1 samples of Curve over [Curve::min(), Curve::max()],
+     where min(), max() and value(double) are constexpr static functions,
+     e.g. using the fbu::cx math:
+
+         struct MeterSkew
+         {
+             static constexpr double min() { return 0.; }
+             static constexpr double max() { return 1.; }
+             static constexpr double value(double x) { return cx::ipow(x, 4); }
+         };
+         constexpr LookupTable<float, 64> kSkew = makeLookupTable<float, 64, MeterSkew>();
+     */
+    template <typename T, int N, class Curve>
+    constexpr LookupTable<T, N> makeLookupTable()
+    {
+        return LookupTable<T, N>{ cx::makeTable< T, N + 1, detail::CurveSampler<Curve, N> >(),
+                                  (T)Curve::min(),
+                                  (T)((double)N / (Curve::max() - Curve::min())) };
+    }
+}
+
+//==============================================================================
+/*
+ Table-based versions of the math_utils.hpp conversions, for the UI and
+ metering code that calls them per value rather than per array (see
+ math_vect.hpp for the arrays).
+ */
+namespace mu
+{
+    namespace detail
+    {
+        // 2^f, f in [0, 1]
+        struct Exp2FractionCurve
+        {
+            static constexpr double min() { return 0.; }
+            static constexpr double max() { return 1.; }
+            static constexpr double value(double f) { return fbu::cx::exp(f * 0.693147180559945309417232121458176568); }
+        };
+
+        // log2(m), m in [1, 2]
+        struct Log2MantissaCurve
+        {
+            static constexpr double min() { return 1.; }
+            static constexpr double max() { return 2.; }
+            static constexpr double value(double m) { return fbu::cx::log2(m); }
+        };
+
+        struct SineCurve
+        {
+            static constexpr double min() { return 0.; }
+            static constexpr double max() { return 2. * fbu::cx::kPi; }
+            static constexpr double value(double x) { return fbu::cx::sin(x); }
+        };
+
+        inline const fbu::LookupTable<float, 256>& exp2FractionTable()
+        {
+            static constexpr fbu::LookupTable<float, 256> kTable = fbu::makeLookupTable<float, 256, Exp2FractionCurve>();
+            return kTable;
+        }
+
+        inline const fbu::LookupTable<float, 256>& log2MantissaTable()
+        {
+            static constexpr fbu::LookupTable<float, 256> kTable = fbu::makeLookupTable<float, 256, Log2MantissaCurve>();
+            return kTable;
+        }
+
+        inline const fbu::LookupTable<float, 1024>& sineTable()
+        {
+            static constexpr fbu::LookupTable<float, 1024> kTable = fbu::makeLookupTable<float, 1024, SineCurve>();
+            return kTable;
+        }
+    }
+
+    //==============================================================================
+    /**
+     20 log10(gain): the exponent bits, plus the interpolated log2 of the
+     mantissa. Max absolute error 2e-5 dB, plus the float rounding of the
+     result. Gains that are not >= FLT_MIN (0, negative, denormal, NaN) give
+     -inf, +inf gives +inf.
+     */
+    inline float lookupGainToDB(float pGain)
+    {
+        if (! (pGain >= FLT_MIN))
+        {
+            return -std::numeric_limits<float>::infinity();
+        }
+        if (pGain > FLT_MAX)
+        {
+            return pGain;
+        }
+        uint32_t lBits;
+        std::memcpy(&lBits, &pGain, sizeof(lBits));
+        const int lExponent = (int)(lBits >> 23) - 127;
+        lBits = (lBits & 0x007fffffu) | 0x3f800000u;
+        float lMantissa;
+        std::memcpy(&lMantissa, &lBits, sizeof(lMantissa));
+        // 20 log10(2)
+        return 6.02059991f * ((float)lExponent + detail::log2MantissaTable().lookupLinear(lMantissa));
+    }
+
+    /**
+     10^(dB / 20), as 2^n times the interpolated 2^f. Max relative error
+     3e-6 for |dB| <= 200; the rounding of the scaled argument grows with
+     |dB|. Results below FLT_MIN flush to 0, above FLT_MAX give +inf.
+     */
+    inline float lookupDBToGain(float pDB)
+    {
+        // log2(10) / 20
+        const float x = pDB * 0.166096404744f;
+        if (! (x >= -126.f))
+        {
+            return x == x ? 0.f : x;
+        }
+        if (x >= 128.f)
+        {
+            return std::numeric_limits<float>::infinity();
+        }
+        // floor, without the libm call
+        int n = (int)x;
+        n -= x < (float)n ? 1 : 0;
+        const uint32_t lBits = (uint32_t)(n + 127) << 23;
+        float lPowerOf2;
+        std::memcpy(&lPowerOf2, &lBits, sizeof(lPowerOf2));
+        return lPowerOf2 * detail::exp2FractionTable().lookupLinear(x - (float)n);
+    }
+
+    /**
+     Sine and cosine from a 1024-interval table. Max absolute error 5e-6
+     for |x| <= 2π; the float argument loses precision further, 2e-5 for
+     |x| <= 100.
+     */
+    inline float lookupSin(float x)
+    {
+        return detail::sineTable().lookupPeriodic(x);
+    }
+
+    inline float lookupCos(float x)
+    {
+        return detail::sineTable().lookupPeriodic(x + 1.57079632679f);
+    }
+}
+
+#endif
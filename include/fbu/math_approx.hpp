@@ -0,0 +1,399 @@
+#ifndef FBU_MATH_APPROX_HPP_INCLUDED
+#define FBU_MATH_APPROX_HPP_INCLUDED
+
+/**
+ @file math_approx.hpp
+ @author François Becker
+
+MIT License
+
+Copyright (c) 2018 François Becker
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "fbu/math_vect.hpp"
+#include "fbu/simd.hpp"
+
+/*
+ Float approximations of the elementary functions, with their own range
+ reduction, unlike the fastSin7... family of math_utils.hpp which is only
+ valid on [-π,π]. Each function comes for fbu::simd::vfloat and for float;
+ the scalar version runs the vector code on one lane, so that both give the
+ same results. The accuracy is a template parameter:
+    float s = mu::approx::sin<mu::Accuracy::medium>(x);
+ The max errors are documented per function and verified by
+ test_math_approx.cpp over the whole domain.
+ */
+
+namespace mu
+{
+namespace approx
+{
+    using fbu::simd::vfloat;
+    using fbu::simd::vint;
+    using fbu::simd::vmask;
+
+    namespace detail
+    {
+        using mu::detail::horner;
+
+        constexpr float kPi = 3.14159265358979323846f;
+        constexpr float kHalfPi = 1.57079632679489661923f;
+
+        // sin(r) = r + r^3 P(r^2) on [-π/4, π/4], minimax on the absolute error
+        template <Accuracy A> struct SinPolynomial;
+        template <> struct SinPolynomial<Accuracy::coarse>
+        {
+            static vfloat evaluate(vfloat r2) { return horner(r2, -0.162259127f); } // 3.2e-4
+        };
+        template <> struct SinPolynomial<Accuracy::medium>
+        {
+            static vfloat evaluate(vfloat r2) { return horner(r2, -0.166628338f, 0.00815299231f); } // 9.4e-7
+        };
+        template <> struct SinPolynomial<Accuracy::high>
+        {
+            static vfloat evaluate(vfloat r2) { return horner(r2, -0.166666507f, 0.00833197866f, -0.000194956361f); } // 1.8e-9
+        };
+
+        // cos(r) = 1 + r^2 P(r^2) on [-π/4, π/4]
+        template <Accuracy A> struct CosPolynomial;
+        template <> struct CosPolynomial<Accuracy::coarse>
+        {
+            static vfloat evaluate(vfloat r2) { return horner(r2, -0.499776308f, 0.0404889386f); } // 1.2e-5
+        };
+        template <> struct CosPolynomial<Accuracy::medium>
+        {
+            static vfloat evaluate(vfloat r2) { return horner(r2, -0.499998948f, 0.0416562948f, -0.00135978252f); } // 3.2e-8
+        };
+        template <> struct CosPolynomial<Accuracy::high>
+        {
+            static vfloat evaluate(vfloat r2) // 5.4e-11
+            {
+                return horner(r2, -0.499999997f, 0.0416666233f, -0.00138867638f, 2.43904548e-05f);
+            }
+        };
+
+        // atan(a) = a + a^3 P(a^2) on [0, 1]
+        template <Accuracy A> struct AtanPolynomial;
+        template <> struct AtanPolynomial<Accuracy::coarse>
+        {
+            static vfloat evaluate(vfloat a2) { return horner(a2, -0.326238194f, 0.15531615f, -0.043812915f); } // 1.3e-4
+        };
+        template <> struct AtanPolynomial<Accuracy::medium>
+        {
+            static vfloat evaluate(vfloat a2) // 3.4e-7
+            {
+                return horner(a2, -0.333253947f, 0.198618555f, -0.133987986f, 0.0821677438f, -0.035519868f,
+                              0.00737400173f);
+            }
+        };
+        template <> struct AtanPolynomial<Accuracy::high>
+        {
+            static vfloat evaluate(vfloat a2) // 7.4e-9
+            {
+                return horner(a2, -0.333329871f, 0.199903966f, -0.141859763f, 0.105739382f, -0.0736672236f,
+                              0.0411220784f, -0.0151326821f, 0.0026222831f);
+            }
+        };
+
+        // asin(z) = z + z^3 P(z^2) on [0, 1/2], minimax on the relative error
+        template <Accuracy A> struct AsinPolynomial;
+        template <> struct AsinPolynomial<Accuracy::coarse>
+        {
+            static vfloat evaluate(vfloat z2) { return horner(z2, 0.165057761f, 0.0942986718f); } // 3.8e-5
+        };
+        template <> struct AsinPolynomial<Accuracy::medium>
+        {
+            static vfloat evaluate(vfloat z2) { return horner(z2, 0.166801249f, 0.071899929f, 0.0641069349f); } // 1.7e-6
+        };
+        template <> struct AsinPolynomial<Accuracy::high>
+        {
+            static vfloat evaluate(vfloat z2) // 4.9e-9
+            {
+                return horner(z2, 0.166667525f, 0.0749529776f, 0.0454703625f, 0.0241795772f, 0.0421662081f);
+            }
+        };
+
+        // x = n π/2 + r, r in [-π/4, π/4]; π/2 is split in 3 parts, the first
+        // two of 8 bits, so that n π/2 is subtracted exactly for |n| < 2^16
+        inline vfloat reduceQuarterTurns(vfloat x, vint& n)
+        {
+            using namespace fbu::simd;
+            n = toIntRound(x * set1(0.636619772f));
+            const vfloat q = toFloat(n);
+            vfloat r = mulAdd(q, set1(-1.5703125f), x);
+            r = mulAdd(q, set1(-4.82559204e-4f), r);
+            return mulAdd(q, set1(-1.26759085e-6f), r);
+        }
+
+        // sin and cos of r in [-π/4, π/4]
+        template <Accuracy A>
+        inline void sinCosReduced(vfloat r, vfloat& pSin, vfloat& pCos)
+        {
+            using namespace fbu::simd;
+            const vfloat r2 = r * r;
+            pSin = mulAdd(r * r2, SinPolynomial<A>::evaluate(r2), r);
+            pCos = mulAdd(r2, CosPolynomial<A>::evaluate(r2), set1(1.f));
+        }
+
+        // flip the sign where bit 1 of n is set
+        inline vfloat flipSignOnBit1(vfloat a, vint n)
+        {
+            using namespace fbu::simd;
+            return asFloat(asInt(a) ^ shiftLeft<30>(n & set1Int(2)));
+        }
+
+        // NaN for infinite and NaN arguments, which the reduction does not handle
+        inline vfloat nanIfNotFinite(vfloat pResult, vfloat x)
+        {
+            using namespace fbu::simd;
+            const vfloat lZeroIfFinite = x - x;
+            return select(lZeroIfFinite == zero(), pResult, lZeroIfFinite);
+        }
+
+        // atan(a) for a in [0, 1]
+        template <Accuracy A>
+        inline vfloat atanUnit(vfloat a)
+        {
+            using namespace fbu::simd;
+            const vfloat a2 = a * a;
+            return mulAdd(a * a2, AtanPolynomial<A>::evaluate(a2), a);
+        }
+
+        // asin(z) for z in [0, 1/2]
+        template <Accuracy A>
+        inline vfloat asinHalf(vfloat z)
+        {
+            using namespace fbu::simd;
+            const vfloat z2 = z * z;
+            return mulAdd(z * z2, AsinPolynomial<A>::evaluate(z2), z);
+        }
+
+        inline vmask signBit(vfloat a)
+        {
+            using namespace fbu::simd;
+            return set1Int(0) > asInt(a);
+        }
+    }
+
+    //==============================================================================
+    /**
+     Sine and cosine, computed together. Max absolute error, for |x| <= 65536:
+     4e-4 (coarse), 1.5e-6 (medium), 1e-7 (high). The error grows with |x|
+     beyond, and the results are meaningless for |x| >= 2^31.
+     */
+    template <Accuracy A = Accuracy::high>
+    inline void sincos(vfloat x, vfloat& pSin, vfloat& pCos)
+    {
+        using namespace fbu::simd;
+        vint n;
+        const vfloat r = detail::reduceQuarterTurns(x, n);
+        vfloat s, c;
+        detail::sinCosReduced<A>(r, s, c);
+        // quadrants 1 and 3 swap sin and cos
+        const vmask lSwap = (n & set1Int(1)) == set1Int(1);
+        pSin = detail::nanIfNotFinite(detail::flipSignOnBit1(select(lSwap, c, s), n), x);
+        pCos = detail::nanIfNotFinite(detail::flipSignOnBit1(select(lSwap, s, c), n + set1Int(1)), x);
+    }
+
+    /**
+     Sine, see sincos() for the accuracy.
+     */
+    template <Accuracy A = Accuracy::high>
+    inline vfloat sin(vfloat x)
+    {
+        vfloat s, c;
+        sincos<A>(x, s, c);
+        return s;
+    }
+
+    /**
+     Cosine, see sincos() for the accuracy.
+     */
+    template <Accuracy A = Accuracy::high>
+    inline vfloat cos(vfloat x)
+    {
+        vfloat s, c;
+        sincos<A>(x, s, c);
+        return c;
+    }
+
+    /**
+     Tangent. Max relative error on (-π/2, π/2): 7e-4 (coarse), 3e-6
+     (medium), 3e-7 (high). Beyond, the error relative to max(1, |tan x|)
+     stays below 7e-4 (coarse) and 4e-6 for |x| <= 65536, away from the poles
+     (|tan x| <= 1000).
+     */
+    template <Accuracy A = Accuracy::high>
+    inline vfloat tan(vfloat x)
+    {
+        using namespace fbu::simd;
+        vint n;
+        const vfloat r = detail::reduceQuarterTurns(x, n);
+        vfloat s, c;
+        detail::sinCosReduced<A>(r, s, c);
+        // -cos / sin in quadrants 1 and 3
+        const vmask lOdd = (n & set1Int(1)) == set1Int(1);
+        const vfloat t = select(lOdd, c, s) / select(lOdd, -s, c);
+        return detail::nanIfNotFinite(t, x);
+    }
+
+    /**
+     Arctangent, in [-π/2, π/2]. Max absolute error: 1.5e-4 (coarse), 5e-7
+     (medium), 2e-7 (high).
+     */
+    template <Accuracy A = Accuracy::high>
+    inline vfloat atan(vfloat x)
+    {
+        using namespace fbu::simd;
+        // atan(x) = π/2 - atan(1/x)
+        const vfloat lAbs = abs(x);
+        const vmask lInverted = lAbs > set1(1.f);
+        const vfloat a = select(lInverted, set1(1.f) / lAbs, lAbs);
+        const vfloat r = detail::atanUnit<A>(a);
+        return copySign(select(lInverted, set1(detail::kHalfPi) - r, r), x);
+    }
+
+    /**
+     Angle of (x, y), in [-π, π], with the signed zeros of std::atan2. Max
+     absolute error: 1.5e-4 (coarse), 7e-7 (medium), 3e-7 (high). NaN when
+     both arguments are infinite.
+     */
+    template <Accuracy A = Accuracy::high>
+    inline vfloat atan2(vfloat y, vfloat x)
+    {
+        using namespace fbu::simd;
+        const vfloat lAbsX = abs(x);
+        const vfloat lAbsY = abs(y);
+        const vfloat lMax = max(lAbsX, lAbsY);
+        // 0 / 0 -> 0
+        const vfloat a = select(lMax == zero(), zero(), min(lAbsX, lAbsY) / lMax);
+        vfloat r = detail::atanUnit<A>(a);
+        r = select(lAbsY > lAbsX, set1(detail::kHalfPi) - r, r);
+        r = select(detail::signBit(x), set1(detail::kPi) - r, r);
+        r = copySign(r, y);
+        // NaN in, NaN out
+        return select((x == x) & (y == y), r, x + y);
+    }
+
+    /**
+     Arcsine, in [-π/2, π/2], NaN out of [-1, 1]. Max absolute error: 5e-5
+     (coarse), 2.5e-6 (medium), 2e-7 (high).
+     */
+    template <Accuracy A = Accuracy::high>
+    inline vfloat asin(vfloat x)
+    {
+        using namespace fbu::simd;
+        // asin(x) = π/2 - 2 asin(sqrt((1 - x) / 2)) for x > 1/2
+        const vfloat lAbs = abs(x);
+        const vmask lBig = lAbs > set1(0.5f);
+        const vfloat z = select(lBig, sqrt((set1(1.f) - lAbs) * set1(0.5f)), lAbs);
+        const vfloat p = detail::asinHalf<A>(z);
+        return copySign(select(lBig, mulAdd(set1(-2.f), p, set1(detail::kHalfPi)), p), x);
+    }
+
+    /**
+     Arccosine, in [0, π], NaN out of [-1, 1]. Max absolute error: 5e-5
+     (coarse), 2.5e-6 (medium), 3.5e-7 (high).
+     */
+    template <Accuracy A = Accuracy::high>
+    inline vfloat acos(vfloat x)
+    {
+        using namespace fbu::simd;
+        // acos(x) = 2 asin(sqrt((1 - x) / 2)) for x > 1/2, π - that for x < -1/2
+        const vfloat lAbs = abs(x);
+        const vmask lBig = lAbs > set1(0.5f);
+        const vfloat z = select(lBig, sqrt((set1(1.f) - lAbs) * set1(0.5f)), x);
+        const vfloat p = detail::asinHalf<A>(z);
+        const vfloat lBigResult = select(x < zero(), mulAdd(set1(-2.f), p, set1(detail::kPi)), p + p);
+        return select(lBig, lBigResult, set1(detail::kHalfPi) - p);
+    }
+
+    /**
+     Natural exponential. Max relative error on the normal results: 2e-3
+     (coarse), 3e-6 (medium), 2.5e-7 (high); overflows to +inf and underflows
+     through the denormals to 0 like std::exp.
+     */
+    template <Accuracy A = Accuracy::high>
+    inline vfloat exp(vfloat x)
+    {
+        using namespace fbu::simd;
+        // x = n ln(2) + r, e^x = 2^n 2^(r / ln(2)), with ln(2) split in 2 parts
+        // so that n ln(2) is subtracted exactly
+        const vfloat lClamped = min(max(x, set1(-105.f)), set1(90.f));
+        const vint n = toIntRound(lClamped * set1(1.44269504f));
+        const vfloat q = toFloat(n);
+        vfloat r = mulAdd(q, set1(-0.693359375f), lClamped);
+        r = mulAdd(q, set1(2.12194440e-4f), r);
+        const vfloat f = r * set1(1.44269504f);
+        const vfloat p = mulAdd(f, mu::detail::Exp2Polynomial<A>::evaluate(f), set1(1.f));
+        return select(x == x, mu::detail::scaleByPowerOf2(p, n), x);
+    }
+
+    /**
+     Hyperbolic tangent, for saturation curves. Max absolute error: 1e-3
+     (coarse), 2e-6 (medium), 2e-7 (high).
+     */
+    template <Accuracy A = Accuracy::high>
+    inline vfloat tanh(vfloat x)
+    {
+        using namespace fbu::simd;
+        // 1 - 2 / (e^2|x| + 1), which goes to 1 when e^2|x| overflows
+        const vfloat e = exp<A>(abs(x) + abs(x));
+        const vfloat t = set1(1.f) - set1(2.f) / (e + set1(1.f));
+        return copySign(t, x);
+    }
+
+    //==============================================================================
+    // Scalar versions
+
+    template <Accuracy A = Accuracy::high>
+    inline void sincos(float x, float& pSin, float& pCos)
+    {
+        vfloat s, c;
+        sincos<A>(fbu::simd::set1(x), s, c);
+        pSin = fbu::simd::first(s);
+        pCos = fbu::simd::first(c);
+    }
+
+#define FBU_APPROX_SCALAR_1(NAME) \
+    template <Accuracy A = Accuracy::high> \
+    inline float NAME(float x) { return fbu::simd::first(NAME<A>(fbu::simd::set1(x))); }
+
+    FBU_APPROX_SCALAR_1(sin)
+    FBU_APPROX_SCALAR_1(cos)
+    FBU_APPROX_SCALAR_1(tan)
+    FBU_APPROX_SCALAR_1(atan)
+    FBU_APPROX_SCALAR_1(asin)
+    FBU_APPROX_SCALAR_1(acos)
+    FBU_APPROX_SCALAR_1(exp)
+    FBU_APPROX_SCALAR_1(tanh)
+
+#undef FBU_APPROX_SCALAR_1
+
+    template <Accuracy A = Accuracy::high>
+    inline float atan2(float y, float x)
+    {
+        return fbu::simd::first(atan2<A>(fbu::simd::set1(y), fbu::simd::set1(x)));
+    }
+}
+}
+
+#endif
@@ -34,20 +34,47 @@ SOFTWARE.
 #include <cstdint>
 #endif
 
-// standard float
+// standard float, unless the C library already provides them (glibc does
+// with _GNU_SOURCE, with the same values)
+#ifndef M_Ef
 #define M_Ef        (static_cast<float>(M_E))
+#endif
+#ifndef M_LOG2Ef
 #define M_LOG2Ef    (static_cast<float>(M_LOG2E))
+#endif
+#ifndef M_LOG10Ef
 #define M_LOG10Ef   (static_cast<float>(M_LOG10E))
+#endif
+#ifndef M_LN2f
 #define M_LN2f      (static_cast<float>(M_LN2))
+#endif
+#ifndef M_LN10f
 #define M_LN10f     (static_cast<float>(M_LN10))
+#endif
+#ifndef M_PIf
 #define M_PIf       (static_cast<float>(M_PI))
+#endif
+#ifndef M_PI_2f
 #define M_PI_2f     (static_cast<float>(M_PI_2))
+#endif
+#ifndef M_PI_4f
 #define M_PI_4f     (static_cast<float>(M_PI_4))
+#endif
+#ifndef M_1_PIf
 #define M_1_PIf     (static_cast<float>(M_1_PI))
+#endif
+#ifndef M_2_PIf
 #define M_2_PIf     (static_cast<float>(M_2_PI))
+#endif
+#ifndef M_2_SQRTPIf
 #define M_2_SQRTPIf (static_cast<float>(M_2_SQRTPI))
+#endif
+#ifndef M_SQRT2f
 #define M_SQRT2f    (static_cast<float>(M_SQRT2))
+#endif
+#ifndef M_SQRT1_2f
 #define M_SQRT1_2f  (static_cast<float>(M_SQRT1_2))
+#endif
 
 // custom-defined double
 #define M_SQRT3            1.7320508075688772935274463415058724
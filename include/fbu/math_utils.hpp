@@ -28,11 +28,15 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include "fbu/bits.hpp"
 #include "fbu/math_float_constants.hpp"
+#include "fbu/simd.hpp"
 
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <cassert>
+#include <type_traits>
 
 #define DEG2RAD (M_PI / 180.)
 #define DEG2RADf (M_PIf / 180.f)
@@ -49,47 +53,48 @@ static_assert(false)
 namespace mu
 {
     //==============================================================================
+    /**
+     1/sqrt(x), within an ulp. Compilers only turn it into the hardware
+     estimate under -ffast-math: mu::rsqrt() and mu::vectRsqrt() of
+     math_vect.hpp are the fast versions, with a selectable accuracy.
+     */
     template <typename T>
     T finvsqrt(T x)
     {
         //assert(x >= (T)0); // caller is responsible for checking that
-        return (T)1 / std::sqrt(x); // the compiler is expected to detect and optimize this,
-                                    // but /!\ that may not actually happen 
+        return (T)1 / std::sqrt(x);
     }
     
-#if 0
+    //==============================================================================
     /**
-     @copyright public domain
+     a * b + c, fused when the target has a fast fma (e.g. with -mfma), the
+     scalar counterpart of fbu::simd::mulAdd(). Without one, std::fma() would
+     be a slow software emulation. Other types, e.g. the integers of
+     Vector3<int>, are never fused.
      */
-    template <>
-    inline float finvsqrt<float>(float number)
+    template <typename T>
+    inline T mulAdd(T a, T b, T c)
     {
-        float x2 = number * 0.5f;
-        float y = number;
-        uint32_t i = *(uint32_t*)&y;
-        i = 0x5f375a86 - (i >> 1);
-        y = *(float*) &i;
-        y = y * (1.5f - (x2 * y * y));
-        return y;
+        return a * b + c;
     }
     
-    /**
-     @copyright public domain
-     */
-    template <>
-    inline double finvsqrt<double>(double number)
-    {
-        uint64_t i;
-        double x2, y;
-        x2 = number * 0.5;
-        y = number;
-        i = *(uint64_t*) &y;
-        i = 0x5fe6eb50c7b537a9 - (i >> 1);
-        y = *(double*) &i;
-        y = y * (1.5 - (x2 * y * y));
-        return y;
+    inline float mulAdd(float a, float b, float c)
+    {
+#ifdef FP_FAST_FMAF
+        return std::fma(a, b, c);
+#else
+        return a * b + c;
+#endif
     }
+    
+    inline double mulAdd(double a, double b, double c)
+    {
+#ifdef FP_FAST_FMA
+        return std::fma(a, b, c);
+#else
+        return a * b + c;
 #endif
+    }
     
     //==============================================================================
     /**
@@ -100,6 +105,11 @@ namespace mu
         return ((pAngle > - M_PIf) && (pAngle <= M_PIf));
     }
     
+    inline bool isDomainAngle(double pAngle)
+    {
+        return ((pAngle > - M_PI) && (pAngle <= M_PI));
+    }
+    
     //==============================================================================
     /**
      Check if an angle is in (-π,π)
@@ -127,9 +137,24 @@ namespace mu
         return pAngle;
     }
     
+    inline double domainAngleSimple(double pAngle)
+    {
+        if (pAngle > M_PI)
+        {
+            pAngle -= 2. * M_PI;
+        }
+        else if (pAngle <= - M_PI)
+        {
+            pAngle += 2. * M_PI;
+        }
+        assert(isDomainAngle(pAngle));
+        return pAngle;
+    }
+    
     //==============================================================================
     /**
-     Get an angle in )-π,π)
+     Get an angle in )-π,π). vectDomainAngle() of math_vect.hpp is the array
+     version.
      */
     inline float domainAngle(float pAngle)
     {
@@ -142,6 +167,36 @@ namespace mu
         return lAngle;
     }
     
+    inline double domainAngle(double pAngle)
+    {
+        double lAngle = std::remainder(pAngle, 2. * M_PI);
+        if (lAngle <= -M_PI)
+        {
+            lAngle += 2. * M_PI;
+        }
+        assert(isDomainAngle(lAngle));
+        return lAngle;
+    }
+    
+    //==============================================================================
+    /**
+     The signed shortest rotation from pFrom to pTo, in )-π,π)
+     */
+    template <typename T>
+    T angleDifference(T pFrom, T pTo)
+    {
+        return domainAngle(pTo - pFrom);
+    }
+    
+    /**
+     From pFrom (t = 0) to pTo (t = 1) along the shortest arc, in )-π,π)
+     */
+    template <typename T>
+    T interpolateAngle(T pFrom, T pTo, T t)
+    {
+        return domainAngle(pFrom + t * angleDifference(pFrom, pTo));
+    }
+    
     //==============================================================================
     template <typename T>
     void limitRange(T& value, T low, T high)
@@ -182,38 +237,42 @@ namespace mu
     }
     
     //==============================================================================
+    /**
+     The smallest power of 2 >= n, 0 for 0. See fbu/bits.hpp for the 64-bit
+     and constexpr versions.
+     */
     inline int nextPowerOf2(int n)
     {
-        --n;
-        n |= n >> 1;
-        n |= n >> 2;
-        n |= n >> 4;
-        n |= n >> 8;
-        n |= n >> 16;
-        return n + 1;
+        return n == 0 ? 0 : (int)fbu::bits::nextPowerOf2((uint32_t)n);
     }
     
     //==============================================================================
+    /**
+     The order of the smallest FFT that holds pNumSamples, 0 for
+     pNumSamples <= 1, negative ones included.
+     */
     inline int fftOrderFor(int pNumSamples)
     {
-        unsigned int v = (unsigned int)nextPowerOf2(pNumSamples);  // find the number of trailing zeros in 32-bit v
-        constexpr const int MultiplyDeBruijnBitPosition[32] =
+        if (pNumSamples <= 1)
         {
-            0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
-            31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
-        };
-        return MultiplyDeBruijnBitPosition[((uint32_t)((v/* & -v*/) * 0x077CB531U)) >> 27];
+            return 0;
+        }
+        return fbu::bits::log2ceil((uint32_t)pNumSamples);
     }
     
     //==============================================================================
     inline bool isPowerOf2(unsigned int x)
     {
-        return ((x != 0) && ((x & (~x + 1)) == x));
+        return fbu::bits::isPowerOf2((uint32_t)x);
     }
     
     //==============================================================================
+    /**
+     10^(dB / 20). std::pow is not constexpr: fbu::cx::dBToGain() is the
+     compile-time version, for tables.
+     */
     template<typename T>
-    constexpr T dBToGain(T pDB)
+    inline T dBToGain(T pDB)
     {
         return std::pow((T)10, pDB / (T)20);
     }
@@ -264,7 +323,7 @@ namespace mu
         
         val = ((-1.0f/3) * t.f + 2) * t.f - 2.0f/3;
         
-        return (val + log_2);
+        return (val + (float)log_2);
     }
     
     /**
@@ -302,7 +361,7 @@ namespace mu
     {
         union {double d; int i[2];} u;
         u.d = val + 6755399441055744.;
-#ifdef __LITTLE_ENDIAN__
+#if defined(__LITTLE_ENDIAN__) || defined(_WIN32) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
         return (int)u.i[0];
 #else
         return (int)u.i[1];
@@ -421,23 +480,35 @@ namespace mu
         return !lCarry * lResultMod;
 #endif
     }
+
+    inline int16_t saturating_add(int16_t pA, int16_t pB)
+    {
+        int32_t lResult = (int32_t)pA + (int32_t)pB;
+        return (int16_t)(lResult > 32767 ? 32767 : (lResult < -32768 ? -32768 : lResult));
+    }
+
+    inline int16_t saturating_subtract(int16_t pA, int16_t pB)
+    {
+        int32_t lResult = (int32_t)pA - (int32_t)pB;
+        return (int16_t)(lResult > 32767 ? 32767 : (lResult < -32768 ? -32768 : lResult));
+    }
     
     //=============================================================================
     /**
-     Sum of two decibel values
+     Sum of two decibel values, saturated at 255
      */
     inline uint8_t fast_dBSum0_2(uint8_t pA, uint8_t pB)
     {
         float lDiff = std::abs((float)pA - (float)pB);
         float lDelta = 54.8697f / (19.2149f + lDiff * (0.686395f + lDiff));
-        return (uint8_t)(std::max(pA, pB) + mu::fastRoundToInt(lDelta));
+        return saturating_add(std::max(pA, pB), (uint8_t)mu::fastRoundToInt(lDelta));
     }
     
     inline uint8_t fast_dBSum0_5(uint8_t pA, uint8_t pB)
     {
         float lDiff = std::abs((float)pA - (float)pB);
         float lDelta = 3.01055f / (1.f + lDiff * (0.166853f + lDiff * (0.0170169f + lDiff * (0.00188077f + lDiff * (- 0.000011882f + 0.0000114037f * lDiff)))));
-        return (uint8_t)(std::max(pA, pB) + mu::fastRoundToInt(lDelta));
+        return saturating_add(std::max(pA, pB), (uint8_t)mu::fastRoundToInt(lDelta));
     }
     
     inline uint8_t approx_dBSum(uint8_t pA, uint8_t pB)
@@ -447,59 +518,184 @@ namespace mu
     }
     
     //==============================================================================
+    /**
+     Replace the infinite and NaN samples with zeros.
+     @return The number of replaced samples.
+     */
     template <typename T>
-    void boundsSafeGuard(T* pChannel, int pNumSamples)
+    int boundsSafeGuard(T* pChannel, int pNumSamples)
     {
+        int lNumReplaced = 0;
         for (int i = 0 ; i != pNumSamples ; ++i)
         {
             if (! std::isfinite(pChannel[i]))
             {
                 pChannel[i] = (T)0;
+                ++lNumReplaced;
             }
         }
+        return lNumReplaced;
     }
-    
+
     //==============================================================================
+    /**
+     Replace the denormal, infinite and NaN samples with zeros. The zeros are
+     kept as they are, including their sign.
+     @return The number of replaced samples.
+     */
     template <typename T>
-    void manualFTZ(T* pChannel, int pNumSamples)
+    int manualFTZ(T* pChannel, int pNumSamples)
     {
+        int lNumReplaced = 0;
         for (int i = 0 ; i != pNumSamples ; ++i)
         {
-            if (! std::isnormal(pChannel[i]))
+            if (! std::isnormal(pChannel[i]) && pChannel[i] != (T)0)
             {
                 pChannel[i] = (T)0;
+                ++lNumReplaced;
+            }
+        }
+        return lNumReplaced;
+    }
+
+    namespace detail
+    {
+        // tests on the bits of floats, so that a whole vector is checked at once
+        struct NonFiniteBits
+        {
+            static bool test(uint32_t pBits)
+            {
+                return (pBits & 0x7f800000u) == 0x7f800000u;
+            }
+
+            static fbu::simd::vmask test(fbu::simd::vint pBits)
+            {
+                using namespace fbu::simd;
+                const vint lExponentMask = set1Int(0x7f800000);
+                return (pBits & lExponentMask) == lExponentMask;
+            }
+        };
+
+        struct NonNormalNonZeroBits
+        {
+            static bool test(uint32_t pBits)
+            {
+                const uint32_t lExponent = pBits & 0x7f800000u;
+                return lExponent == 0x7f800000u || (lExponent == 0u && (pBits & 0x007fffffu) != 0u);
+            }
+
+            static fbu::simd::vmask test(fbu::simd::vint pBits)
+            {
+                using namespace fbu::simd;
+                const vint lExponentMask = set1Int(0x7f800000);
+                const vint lExponent = pBits & lExponentMask;
+                return (lExponent == lExponentMask)
+                       | ((lExponent == set1Int(0)) & ~((pBits & set1Int(0x007fffff)) == set1Int(0)));
+            }
+        };
+
+        /*
+         The clean blocks, by far the most common, are only read: the samples
+         are tested 4 vectors at a time, with one branch and no store.
+         */
+        template <class Test>
+        int replaceWithZeros(float* pChannel, int pNumSamples)
+        {
+            using namespace fbu::simd;
+            const int L = kFloatLanes;
+            const int lNumPerIteration = 4 * L;
+            int lNumReplaced = 0;
+            int i = 0;
+            for ( ; i + lNumPerIteration <= pNumSamples ; i += lNumPerIteration)
+            {
+                const vmask lBad = Test::test(asInt(load(pChannel + i)))
+                                 | Test::test(asInt(load(pChannel + i + L)))
+                                 | Test::test(asInt(load(pChannel + i + 2 * L)))
+                                 | Test::test(asInt(load(pChannel + i + 3 * L)));
+                if (any(lBad))
+                {
+                    for (int j = i ; j != i + lNumPerIteration ; j += L)
+                    {
+                        const vfloat x = load(pChannel + j);
+                        const vmask lBadLanes = Test::test(asInt(x));
+                        store(pChannel + j, select(lBadLanes, zero(), x));
+                        const int lBits = moveMask(lBadLanes);
+                        for (int b = 0 ; b != L ; ++b)
+                        {
+                            lNumReplaced += (lBits >> b) & 1;
+                        }
+                    }
+                }
+            }
+            for ( ; i != pNumSamples ; ++i)
+            {
+                uint32_t lBits;
+                std::memcpy(&lBits, pChannel + i, sizeof(lBits));
+                if (Test::test(lBits))
+                {
+                    pChannel[i] = 0.f;
+                    ++lNumReplaced;
+                }
             }
+            return lNumReplaced;
         }
     }
 
+    template <>
+    inline int boundsSafeGuard<float>(float* pChannel, int pNumSamples)
+    {
+        return detail::replaceWithZeros<detail::NonFiniteBits>(pChannel, pNumSamples);
+    }
+
+    template <>
+    inline int manualFTZ<float>(float* pChannel, int pNumSamples)
+    {
+        return detail::replaceWithZeros<detail::NonNormalNonZeroBits>(pChannel, pNumSamples);
+    }
+
     //==============================================================================
+    /**
+     Running sum and count. The average is a float for integer values, and
+     of type T for floating point ones. See streaming_stats.hpp for the
+     variance, the extrema, and the moving averages.
+     */
     template <class T = float>
     class CumulAverage
     {
     public:
+        typedef typename std::common_type<T, float>::type Average;
+
         CumulAverage() {}
         void push(T pValue)
         {
             mCumul += pValue;
             ++mCount;
         }
-        float getCount() const
+        /**
+         Add the values pushed to pOther, e.g. computed on another thread.
+         */
+        void merge(const CumulAverage& pOther)
+        {
+            mCumul += pOther.mCumul;
+            mCount += pOther.mCount;
+        }
+        int64_t getCount() const
         {
             return mCount;
         }
-        float get() const
+        Average get() const
         {
             if (mCount != 0)
             {
-                return mCumul / (float)mCount;
+                return (Average)mCumul / (Average)mCount;
             }
             else
             {
-                return 0.f;
+                return (Average)0;
             }
         }
         T mCumul = (T)0.;
-        int mCount = 0;
+        int64_t mCount = 0;
     };
 }
 
@@ -0,0 +1,1011 @@
+#ifndef FBU_MATH_VECT_HPP_INCLUDED
+#define FBU_MATH_VECT_HPP_INCLUDED
+
+/**
+ @file math_vect.hpp
+ @author François Becker
+
+MIT License
+
+Copyright (c) 2018 François Becker
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "fbu/math_utils.hpp"
+#include "fbu/simd.hpp"
+
+#include <cassert>
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+/*
+ Array versions of the logarithm/exponential helpers of math_utils.hpp
+ (fast_log2, fast_gainToDB, dBToGain...) and of finvsqrt, on fbu::simd. They
+ take the whole float range, with the special values of libm: log2(0) =
+ -inf, log2(x < 0) = NaN, exp2 overflows to +inf and underflows through the
+ denormals to 0.
+ And array versions of the 8/16-bit saturating helpers, which give exactly
+ the results of their scalar counterparts.
+ The input and output arrays may be the same.
+ */
+
+namespace mu
+{
+    /**
+     Accuracy tiers of the vectorized approximations, from the cheapest
+     polynomial to the one within a few float ulps.
+     */
+    enum class Accuracy
+    {
+        coarse,
+        medium,
+        high
+    };
+
+    namespace detail
+    {
+        using fbu::simd::vfloat;
+        using fbu::simd::vint;
+        using fbu::simd::vmask;
+
+        // c0 + c1 x + c2 x^2 + ...
+        inline vfloat horner(vfloat, float c0)
+        {
+            return fbu::simd::set1(c0);
+        }
+
+        template <typename... Floats>
+        inline vfloat horner(vfloat x, float c0, Floats... pHigher)
+        {
+            return fbu::simd::mulAdd(horner(x, pHigher...), x, fbu::simd::set1(c0));
+        }
+
+        // log2(1 + f) = f P(f) for f in [sqrt(1/2) - 1, sqrt(2) - 1], minimax on the absolute error
+        template <Accuracy A> struct Log2Polynomial;
+        template <> struct Log2Polynomial<Accuracy::coarse>
+        {
+            static vfloat evaluate(vfloat f)
+            {
+                // 8.5e-4
+                return horner(f, 1.44515207f, -0.754081363f, 0.445070218f);
+            }
+        };
+        template <> struct Log2Polynomial<Accuracy::medium>
+        {
+            static vfloat evaluate(vfloat f)
+            {
+                // 1.5e-5
+                return horner(f, 1.44257801f, -0.720241803f, 0.48668616f, -0.394575362f, 0.252660209f);
+            }
+        };
+        template <> struct Log2Polynomial<Accuracy::high>
+        {
+            static vfloat evaluate(vfloat f)
+            {
+                // 4.8e-8
+                return horner(f, 1.44269477f, -0.721357149f, 0.480939444f, -0.360087215f,
+                                 0.286707468f, -0.250069063f, 0.236890301f, -0.145744316f);
+            }
+        };
+
+        // 2^f = 1 + f P(f) for f in [-1/2, 1/2], minimax on the relative error
+        template <Accuracy A> struct Exp2Polynomial;
+        template <> struct Exp2Polynomial<Accuracy::coarse>
+        {
+            static vfloat evaluate(vfloat f)
+            {
+                // 2.0e-3
+                return horner(f, 0.702941797f, 0.239864024f);
+            }
+        };
+        template <> struct Exp2Polynomial<Accuracy::medium>
+        {
+            static vfloat evaluate(vfloat f)
+            {
+                // 2.8e-6
+                return horner(f, 0.693124193f, 0.240240986f, 0.0559064247f, 0.00958285299f);
+            }
+        };
+        template <> struct Exp2Polynomial<Accuracy::high>
+        {
+            static vfloat evaluate(vfloat f)
+            {
+                // 9.2e-8
+                return horner(f, 0.693146978f, 0.240222421f, 0.0555073374f, 0.00967151265f, 0.00132647271f);
+            }
+        };
+
+        template <Accuracy A>
+        inline vfloat log2(vfloat x)
+        {
+            using namespace fbu::simd;
+            const vfloat lInfinity = asFloat(set1Int(0x7f800000));
+            // denormals are scaled up by 2^23 first
+            const vmask lIsDenormal = x < set1(1.17549435e-38f);
+            const vfloat lScaled = select(lIsDenormal, x * set1(8388608.f), x);
+            const vfloat lExponentOffset = select(lIsDenormal, set1(-23.f), zero());
+            // x = 2^e m, with m in [sqrt(1/2), sqrt(2))
+            const vint i = asInt(lScaled);
+            const vint e = shiftRightArith<23>(i - set1Int(0x3f3504f3));
+            const vfloat f = asFloat(i - shiftLeft<23>(e)) - set1(1.f);
+            vfloat r = mulAdd(f, Log2Polynomial<A>::evaluate(f), toFloat(e) + lExponentOffset);
+            // NaN for x < 0 and x = NaN
+            r = select(x > zero(), r, select(x == zero(), -lInfinity, asFloat(set1Int(0x7fc00000))));
+            return select(x == lInfinity, lInfinity, r);
+        }
+
+        // p 2^n for n in [-252, 254], in two halves so that the result may be
+        // denormal or infinite
+        inline vfloat scaleByPowerOf2(vfloat p, vint n)
+        {
+            using namespace fbu::simd;
+            const vint n1 = shiftRightArith<1>(n);
+            const vint n2 = n - n1;
+            return p * asFloat(shiftLeft<23>(n1 + set1Int(127))) * asFloat(shiftLeft<23>(n2 + set1Int(127)));
+        }
+
+        template <Accuracy A>
+        inline vfloat exp2(vfloat x)
+        {
+            using namespace fbu::simd;
+            // out of [-151, 129] the result is 0 or +inf anyway
+            const vfloat lClamped = min(max(x, set1(-151.f)), set1(129.f));
+            const vint n = toIntRound(lClamped);
+            const vfloat f = lClamped - toFloat(n);
+            const vfloat p = mulAdd(f, Exp2Polynomial<A>::evaluate(f), set1(1.f));
+            return select(x == x, scaleByPowerOf2(p, n), x);
+        }
+
+        template <Accuracy A>
+        struct Log2Op
+        {
+            static vfloat compute(vfloat x) { return log2<A>(x); }
+        };
+
+        template <Accuracy A>
+        struct Exp2Op
+        {
+            static vfloat compute(vfloat x) { return exp2<A>(x); }
+        };
+
+        template <Accuracy A>
+        struct GainToDBOp
+        {
+            // 20 log10(2)
+            static vfloat compute(vfloat x) { return fbu::simd::set1(6.02059991f) * log2<A>(x); }
+        };
+
+        template <Accuracy A>
+        struct DBToGainOp
+        {
+            // log2(10) / 20
+            static vfloat compute(vfloat x) { return exp2<A>(fbu::simd::set1(0.166096404744f) * x); }
+        };
+
+        // Newton-Raphson steps after the hardware estimate: 12 bits on SSE,
+        // 8 bits on NEON which takes one more step
+        template <Accuracy A> struct RsqrtSteps;
+        template <> struct RsqrtSteps<Accuracy::coarse> { static constexpr int kNum = FBU_SIMD_USE_NEON ? 1 : 0; };
+        template <> struct RsqrtSteps<Accuracy::medium> { static constexpr int kNum = FBU_SIMD_USE_NEON ? 2 : 1; };
+        template <> struct RsqrtSteps<Accuracy::high>   { static constexpr int kNum = FBU_SIMD_USE_NEON ? 3 : 2; };
+
+        template <Accuracy A>
+        inline vfloat rsqrt(vfloat x)
+        {
+            using namespace fbu::simd;
+            const vfloat lInfinity = set1(std::numeric_limits<float>::infinity());
+            // the estimates flush the denormals to 0: they are scaled by 2^24
+            const vmask lDenormal = x < set1(FLT_MIN);
+            const vfloat lScaled = select(lDenormal, x * set1(16777216.f), x);
+            const vfloat lHalf = set1(0.5f) * lScaled;
+            vfloat y = rsqrtEstimate(lScaled);
+            for (int i = 0 ; i != RsqrtSteps<A>::kNum ; ++i)
+            {
+                y = y * (set1(1.5f) - lHalf * y * y);
+            }
+            y = select(lDenormal, y * set1(4096.f), y);
+            // where the steps give NaN: 1/sqrt(±0) = ±inf, 1/sqrt(+inf) = 0
+            return select(x == zero(), copySign(lInfinity, x), select(x == lInfinity, zero(), y));
+        }
+
+        template <Accuracy A>
+        struct RsqrtOp
+        {
+            static vfloat compute(vfloat x) { return rsqrt<A>(x); }
+        };
+
+        // the tail goes through the same vector code, so that all the values
+        // of an array get the same approximation
+        template <class Op>
+        inline void apply(const float* pIn, float* pOut, size_t pSize)
+        {
+            using namespace fbu::simd;
+            const size_t lNumPerIteration = (size_t)kFloatLanes;
+            size_t u = 0;
+            for ( ; u + lNumPerIteration <= pSize ; u += lNumPerIteration)
+            {
+                store(pOut + u, Op::compute(load(pIn + u)));
+            }
+            if (u != pSize)
+            {
+                float lTail[kFloatLanes] = {};
+                const size_t lNumLeft = pSize - u;
+                for (size_t k = 0 ; k < lNumLeft ; ++k)
+                {
+                    lTail[k] = pIn[u + k];
+                }
+                store(lTail, Op::compute(load(lTail)));
+                for (size_t k = 0 ; k < lNumLeft ; ++k)
+                {
+                    pOut[u + k] = lTail[k];
+                }
+            }
+        }
+
+        template <template <Accuracy> class Op>
+        inline void apply(const float* pIn, float* pOut, size_t pSize, Accuracy pAccuracy)
+        {
+            switch (pAccuracy)
+            {
+                case Accuracy::coarse:
+                    apply< Op<Accuracy::coarse> >(pIn, pOut, pSize);
+                    break;
+                case Accuracy::medium:
+                    apply< Op<Accuracy::medium> >(pIn, pOut, pSize);
+                    break;
+                case Accuracy::high:
+                    apply< Op<Accuracy::high> >(pIn, pOut, pSize);
+                    break;
+            }
+        }
+    }
+
+    namespace detail
+    {
+        template <typename T>
+        struct SaturatingAddOp
+        {
+            template <class V>
+            static V compute(V a, V b) { return fbu::simd::addSaturate(a, b); }
+            static T compute(T a, T b) { return saturating_add(a, b); }
+        };
+
+        template <typename T>
+        struct SaturatingSubtractOp
+        {
+            template <class V>
+            static V compute(V a, V b) { return fbu::simd::subSaturate(a, b); }
+            static T compute(T a, T b) { return saturating_subtract(a, b); }
+        };
+
+        template <class Op, typename T>
+        inline void applySmallInt(const T* pA, const T* pB, T* pOut, size_t pSize)
+        {
+            using namespace fbu::simd;
+            // 16 bytes per vector
+            const size_t lNumPerIteration = (size_t)kUint8Lanes / sizeof(T);
+            size_t u = 0;
+            for ( ; u + lNumPerIteration <= pSize ; u += lNumPerIteration)
+            {
+                store(pOut + u, Op::compute(load(pA + u), load(pB + u)));
+            }
+            for ( ; u != pSize ; ++u)
+            {
+                pOut[u] = Op::compute(pA[u], pB[u]);
+            }
+        }
+
+        /*
+         The correction of a dB sum, the 256-entry table delta(|a - b|), is a
+         non-increasing staircase: it is stored as its thresholds
+         t_v = #{d : delta(d) >= v}, so that delta(d) = #{v : d < t_v} is a
+         couple of saturated compares per vector, where SSE2 has no byte
+         shuffle to index a table. The thresholds are constants, so that the
+         first call from the audio thread neither allocates nor takes the
+         guard of a static: both sums round to the same staircase, and the
+         test compares them with the vectors for all the pairs of levels.
+         */
+        template <uint8_t (*Sum)(uint8_t, uint8_t)> struct DBSumStaircase;
+
+        template <>
+        struct DBSumStaircase<&fast_dBSum0_2>
+        {
+            static constexpr size_t kNum = 3;
+
+            static const uint8_t* thresholds()
+            {
+                static const uint8_t kThresholds[kNum] = {10, 4, 2};
+                return kThresholds;
+            }
+        };
+
+        template <>
+        struct DBSumStaircase<&fast_dBSum0_5> : DBSumStaircase<&fast_dBSum0_2>
+        {
+        };
+
+        template <uint8_t (*Sum)(uint8_t, uint8_t)>
+        inline void dBSum(const uint8_t* pA, const uint8_t* pB, uint8_t* pOut, size_t pSize)
+        {
+            using namespace fbu::simd;
+            typedef DBSumStaircase<Sum> Staircase;
+            const uint8_t* lThresholds = Staircase::thresholds();
+            const vuint8 lZero = set1Uint8(0);
+            const vuint8 lNumLevels = set1Uint8((uint8_t)Staircase::kNum);
+            size_t u = 0;
+            for ( ; u + (size_t)kUint8Lanes <= pSize ; u += (size_t)kUint8Lanes)
+            {
+                const vuint8 a = load(pA + u);
+                const vuint8 b = load(pB + u);
+                const vuint8 lMax = max(a, b);
+                const vuint8 lDifference = lMax - min(a, b);
+                // every threshold <= the difference takes one off, as + 255
+                vuint8 lDelta = lNumLevels;
+                for (size_t i = 0 ; i != Staircase::kNum ; ++i)
+                {
+                    lDelta = lDelta + (subSaturate(set1Uint8(lThresholds[i]), lDifference) == lZero);
+                }
+                store(pOut + u, addSaturate(lMax, lDelta));
+            }
+            for ( ; u != pSize ; ++u)
+            {
+                pOut[u] = Sum(pA[u], pB[u]);
+            }
+        }
+    }
+
+    namespace detail
+    {
+        // the vector type of the element types with SIMD kernels
+        template <typename T>
+        struct Lanes
+        {
+            typedef std::false_type Vectorized;
+        };
+
+        template <>
+        struct Lanes<float>
+        {
+            typedef std::true_type Vectorized;
+            typedef fbu::simd::vfloat V;
+            static const size_t kNum = (size_t)fbu::simd::kFloatLanes;
+            static V load(const float* p) { return fbu::simd::load(p); }
+            static void store(float* p, V a) { fbu::simd::store(p, a); }
+            static V set1(float s) { return fbu::simd::set1(s); }
+        };
+
+        template <>
+        struct Lanes<double>
+        {
+            typedef std::true_type Vectorized;
+            typedef fbu::simd::vdouble V;
+            static const size_t kNum = (size_t)fbu::simd::kDoubleLanes;
+            static V load(const double* p) { return fbu::simd::load(p); }
+            static void store(double* p, V a) { fbu::simd::store(p, a); }
+            static V set1(double s) { return fbu::simd::set1Double(s); }
+        };
+
+        template <>
+        struct Lanes<int32_t>
+        {
+            typedef std::true_type Vectorized;
+            typedef fbu::simd::vint V;
+            static const size_t kNum = (size_t)fbu::simd::kFloatLanes;
+            static V load(const int32_t* p) { return fbu::simd::loadInt(p); }
+            static void store(int32_t* p, V a) { fbu::simd::storeInt(p, a); }
+            static V set1(int32_t s) { return fbu::simd::set1Int(s); }
+        };
+
+        // max(low, x) then min(high, .), in this operand order so that NaN
+        // stays NaN as with limitedRange(), both in the vectors and the tails
+        template <typename T>
+        inline T clampScalar(T x, T pLow, T pHigh)
+        {
+            x = pLow > x ? pLow : x;
+            return pHigh < x ? pHigh : x;
+        }
+
+        template <class V>
+        inline V clampVector(V x, V pLow, V pHigh)
+        {
+            return fbu::simd::min(pHigh, fbu::simd::max(pLow, x));
+        }
+
+        template <typename T>
+        inline void clamp(const T* pIn, T* pOut, size_t pSize, T pLow, T pHigh, std::false_type)
+        {
+            for (size_t u = 0 ; u < pSize ; ++u)
+            {
+                pOut[u] = clampScalar(pIn[u], pLow, pHigh);
+            }
+        }
+
+        template <typename T>
+        inline void clamp(const T* pIn, T* pOut, size_t pSize, T pLow, T pHigh, std::true_type)
+        {
+            typedef Lanes<T> L;
+            const typename L::V lLow = L::set1(pLow);
+            const typename L::V lHigh = L::set1(pHigh);
+            size_t u = 0;
+            for ( ; u + L::kNum <= pSize ; u += L::kNum)
+            {
+                L::store(pOut + u, clampVector(L::load(pIn + u), lLow, lHigh));
+            }
+            clamp(pIn + u, pOut + u, pSize - u, pLow, pHigh, std::false_type());
+        }
+
+        template <typename T>
+        struct AffineMap
+        {
+            AffineMap(T pFromMin, T pFromMax, T pToMin, T pToMax)
+            : mFromMin(pFromMin)
+            , mFromMax(pFromMax)
+            , mToMin(pToMin)
+            , mToMax(pToMax)
+            {
+            }
+
+            T operator()(T x) const
+            {
+                return affineTransform(mFromMin, mFromMax, mToMin, mToMax, x);
+            }
+
+            T mFromMin;
+            T mFromMax;
+            T mToMin;
+            T mToMax;
+        };
+
+        // (x - fromMin) scale + toMin, in the vectors and the tails
+        template <typename T>
+        struct FloatingAffineMap
+        {
+            FloatingAffineMap(T pFromMin, T pFromMax, T pToMin, T pToMax)
+            : mFromMin(pFromMin)
+            , mScale((pToMax - pToMin) / (pFromMax - pFromMin))
+            , mToMin(pToMin)
+            {
+            }
+
+            T operator()(T x) const
+            {
+                return (x - mFromMin) * mScale + mToMin;
+            }
+
+            T mFromMin;
+            T mScale;
+            T mToMin;
+        };
+
+        template <>
+        struct AffineMap<float> : FloatingAffineMap<float>
+        {
+            AffineMap(float pFromMin, float pFromMax, float pToMin, float pToMax)
+            : FloatingAffineMap<float>(pFromMin, pFromMax, pToMin, pToMax) {}
+        };
+
+        template <>
+        struct AffineMap<double> : FloatingAffineMap<double>
+        {
+            AffineMap(double pFromMin, double pFromMax, double pToMin, double pToMax)
+            : FloatingAffineMap<double>(pFromMin, pFromMax, pToMin, pToMax) {}
+        };
+
+        // the same truncated division as affineTransform(), through 64 bits
+
+        template <>
+        struct AffineMap<int32_t>
+        {
+            AffineMap(int32_t pFromMin, int32_t pFromMax, int32_t pToMin, int32_t pToMax)
+            : mFromMin(pFromMin)
+            , mFromRange((int64_t)pFromMax - (int64_t)pFromMin)
+            , mToMin(pToMin)
+            , mToRange((int64_t)pToMax - (int64_t)pToMin)
+            {
+            }
+
+            int32_t operator()(int32_t x) const
+            {
+                return (int32_t)(mToMin + mToRange * ((int64_t)x - mFromMin) / mFromRange);
+            }
+
+            int64_t mFromMin;
+            int64_t mFromRange;
+            int64_t mToMin;
+            int64_t mToRange;
+        };
+
+        template <typename T>
+        inline void affine(const T* pIn, T* pOut, size_t pSize, const AffineMap<T>& pMap,
+                           bool pClamp, T pLow, T pHigh, std::false_type)
+        {
+            for (size_t u = 0 ; u != pSize ; ++u)
+            {
+                const T y = pMap(pIn[u]);
+                pOut[u] = pClamp ? clampScalar(y, pLow, pHigh) : y;
+            }
+        }
+
+        // no SIMD integer division: the int32 map is scalar, only its clamp is vectorized
+        inline void affine(const int32_t* pIn, int32_t* pOut, size_t pSize, const AffineMap<int32_t>& pMap,
+                           bool pClamp, int32_t pLow, int32_t pHigh, std::true_type)
+        {
+            for (size_t u = 0 ; u != pSize ; ++u)
+            {
+                pOut[u] = pMap(pIn[u]);
+            }
+            if (pClamp)
+            {
+                clamp(pOut, pOut, pSize, pLow, pHigh, std::true_type());
+            }
+        }
+
+        template <typename T>
+        inline void affine(const T* pIn, T* pOut, size_t pSize, const AffineMap<T>& pMap,
+                           bool pClamp, T pLow, T pHigh, std::true_type)
+        {
+            typedef Lanes<T> L;
+            const typename L::V lFromMin = L::set1(pMap.mFromMin);
+            const typename L::V lScale = L::set1(pMap.mScale);
+            const typename L::V lToMin = L::set1(pMap.mToMin);
+            const typename L::V lLow = L::set1(pLow);
+            const typename L::V lHigh = L::set1(pHigh);
+            size_t u = 0;
+            if (pClamp)
+            {
+                for ( ; u + L::kNum <= pSize ; u += L::kNum)
+                {
+                    const typename L::V y = (L::load(pIn + u) - lFromMin) * lScale + lToMin;
+                    L::store(pOut + u, clampVector(y, lLow, lHigh));
+                }
+            }
+            else
+            {
+                for ( ; u + L::kNum <= pSize ; u += L::kNum)
+                {
+                    L::store(pOut + u, (L::load(pIn + u) - lFromMin) * lScale + lToMin);
+                }
+            }
+            affine(pIn + u, pOut + u, pSize - u, pMap, pClamp, pLow, pHigh, std::false_type());
+        }
+
+        // 2π in two parts, the high one with half the significant bits, so
+        // that n kHigh and n kLow are exact for |x| < kMaxAngle, n being
+        // round(x / 2π). kRounding is 1.5 2^(digits - 1): adding and
+        // subtracting it rounds to the nearest integer.
+        template <typename T> struct TwoPi;
+
+        template <>
+        struct TwoPi<float>
+        {
+            static constexpr float kHigh = 6.28125f;
+            static constexpr float kLow = 0.001935482025146484375f;
+            static constexpr float kPi = M_PIf;
+            static constexpr float kMaxAngle = 16384.f;
+            static constexpr float kRounding = 12582912.f;
+        };
+
+        template <>
+        struct TwoPi<double>
+        {
+            static constexpr double kHigh = 6.2831852436065673828125;
+            static constexpr double kLow = 6.357301884918342693708837032318115234375e-8;
+            static constexpr double kPi = M_PI;
+            static constexpr double kMaxAngle = 268435456.;
+            static constexpr double kRounding = 6755399441055744.;
+        };
+
+        // domainAngle(), bit for bit. Whether n is off by one or not, x - n 2π
+        // is a multiple of the ulp of 2π or of x with |x| < 4, below 4: it is
+        // exact, as x - n kHigh, and so is the rounding of the last
+        // subtraction. It then goes to )-π,π) as the remainder would.
+        template <typename T>
+        inline typename Lanes<T>::V wrapAngle(typename Lanes<T>::V x)
+        {
+            using namespace fbu::simd;
+            typedef Lanes<T> L;
+            typedef TwoPi<T> C;
+            static_assert(C::kHigh + C::kLow == (T)2 * C::kPi, "2π in two parts");
+            const typename L::V lRounding = L::set1(C::kRounding);
+            const typename L::V lTwoPi = L::set1(C::kHigh + C::kLow);
+            const typename L::V lZero = L::set1((T)0);
+            const typename L::V n = (x * L::set1((T)1 / (C::kHigh + C::kLow)) + lRounding) - lRounding;
+            typename L::V r = (x - n * L::set1(C::kHigh)) - n * L::set1(C::kLow);
+            // the zeros of std::remainder() have the sign of x
+            r = select(r == lZero, x * lZero, r);
+            return select(r > L::set1(C::kPi), r - lTwoPi, select(r <= L::set1(-C::kPi), r + lTwoPi, r));
+        }
+
+        // wrapAngle() when all the lanes are below kMaxAngle
+        template <typename T>
+        inline bool tryWrapAngle(typename Lanes<T>::V& pAngles)
+        {
+            using namespace fbu::simd;
+            typedef Lanes<T> L;
+            if (moveMask(abs(pAngles) < L::set1(TwoPi<T>::kMaxAngle)) != (1 << L::kNum) - 1)
+            {
+                return false;
+            }
+            pAngles = wrapAngle<T>(pAngles);
+            return true;
+        }
+
+        template <typename T>
+        struct DomainAngleOp
+        {
+            bool vector(size_t u, typename Lanes<T>::V& pOut) const
+            {
+                pOut = Lanes<T>::load(mIn + u);
+                return tryWrapAngle<T>(pOut);
+            }
+
+            T scalar(size_t u) const
+            {
+                return domainAngle(mIn[u]);
+            }
+
+            const T* mIn;
+        };
+
+        template <typename T>
+        struct DomainAngleSimpleOp
+        {
+            bool vector(size_t u, typename Lanes<T>::V& pOut) const
+            {
+                using namespace fbu::simd;
+                typedef Lanes<T> L;
+                const typename L::V x = L::load(mIn + u);
+                const typename L::V lPi = L::set1(TwoPi<T>::kPi);
+                const typename L::V lTwoPi = L::set1(TwoPi<T>::kHigh + TwoPi<T>::kLow);
+                pOut = select(x > lPi, x - lTwoPi, select(x <= L::set1(-TwoPi<T>::kPi), x + lTwoPi, x));
+                return true;
+            }
+
+            T scalar(size_t u) const
+            {
+                return domainAngleSimple(mIn[u]);
+            }
+
+            const T* mIn;
+        };
+
+        template <typename T>
+        struct AngleDifferenceOp
+        {
+            bool vector(size_t u, typename Lanes<T>::V& pOut) const
+            {
+                pOut = Lanes<T>::load(mTo + u) - Lanes<T>::load(mFrom + u);
+                return tryWrapAngle<T>(pOut);
+            }
+
+            T scalar(size_t u) const
+            {
+                return angleDifference(mFrom[u], mTo[u]);
+            }
+
+            const T* mFrom;
+            const T* mTo;
+        };
+
+        template <typename T>
+        struct InterpolateAngleOp
+        {
+            bool vector(size_t u, typename Lanes<T>::V& pOut) const
+            {
+                typedef Lanes<T> L;
+                const typename L::V lFrom = L::load(mFrom + u);
+                typename L::V lDifference = L::load(mTo + u) - lFrom;
+                if (! tryWrapAngle<T>(lDifference))
+                {
+                    return false;
+                }
+                pOut = lFrom + L::set1(mT) * lDifference;
+                return tryWrapAngle<T>(pOut);
+            }
+
+            T scalar(size_t u) const
+            {
+                return interpolateAngle(mFrom[u], mTo[u], mT);
+            }
+
+            const T* mFrom;
+            const T* mTo;
+            T mT;
+        };
+
+        // the vectors of Op, or its scalar version for the lanes where it
+        // declines them, and for the tail
+        template <typename T, class Op>
+        inline void applyAngles(T* pOut, size_t pSize, const Op& pOp)
+        {
+            typedef Lanes<T> L;
+            size_t u = 0;
+            for ( ; u + L::kNum <= pSize ; u += L::kNum)
+            {
+                typename L::V lResult;
+                if (pOp.vector(u, lResult))
+                {
+                    L::store(pOut + u, lResult);
+                }
+                else
+                {
+                    for (size_t i = u ; i != u + L::kNum ; ++i)
+                    {
+                        pOut[i] = pOp.scalar(i);
+                    }
+                }
+            }
+            for ( ; u < pSize ; ++u)
+            {
+                pOut[u] = pOp.scalar(u);
+            }
+        }
+    }
+
+    //==============================================================================
+    /**
+     Base 2 logarithm. Max absolute error: 9e-4 (coarse), 2e-5 (medium),
+     2e-7 (high), plus the float rounding of the result.
+     */
+    inline void vectLog2(const float* pIn, float* pOut, size_t pSize, Accuracy pAccuracy = Accuracy::high)
+    {
+        detail::apply<detail::Log2Op>(pIn, pOut, pSize, pAccuracy);
+    }
+
+    /**
+     Base 2 exponential. Max relative error: 2e-3 (coarse), 3e-6 (medium),
+     2e-7 (high), on the normal results; the denormal ones lose precision.
+     */
+    inline void vectExp2(const float* pIn, float* pOut, size_t pSize, Accuracy pAccuracy = Accuracy::high)
+    {
+        detail::apply<detail::Exp2Op>(pIn, pOut, pSize, pAccuracy);
+    }
+
+    /**
+     20 log10(gain), e.g. for meters. Max absolute error: 6e-3 dB (coarse),
+     1e-4 dB (medium), 2e-6 dB (high), plus the float rounding of the result.
+     */
+    inline void vectGainToDB(const float* pGains, float* pDB, size_t pSize, Accuracy pAccuracy = Accuracy::high)
+    {
+        detail::apply<detail::GainToDBOp>(pGains, pDB, pSize, pAccuracy);
+    }
+
+    /**
+     10^(dB / 20). Max relative error, for |dB| <= 200: 2e-3 (coarse),
+     5e-6 (medium), 2e-6 (high); the rounding of the scaled argument grows
+     with |dB|.
+     */
+    inline void vectDBToGain(const float* pDB, float* pGains, size_t pSize, Accuracy pAccuracy = Accuracy::high)
+    {
+        detail::apply<detail::DBToGainOp>(pDB, pGains, pSize, pAccuracy);
+    }
+
+    /**
+     1/sqrt(x), from the hardware estimate refined by Newton-Raphson steps.
+     Max relative error: 4e-4 (coarse, the SSE estimate alone), 5e-7
+     (medium), 2.5e-7 (high), including the denormal inputs. The IEEE
+     1 / std::sqrt(x) of mu::finvsqrt() is within 1 ulp, but much slower
+     unless the compiler turns it into this very approximation.
+     */
+    inline void vectRsqrt(const float* pIn, float* pOut, size_t pSize, Accuracy pAccuracy = Accuracy::high)
+    {
+        detail::apply<detail::RsqrtOp>(pIn, pOut, pSize, pAccuracy);
+    }
+
+    /**
+     The scalar version of vectRsqrt(), e.g. to normalize a Vector3: the
+     same results for the normal x, the others go through finvsqrt().
+     */
+    inline float rsqrt(float x, Accuracy pAccuracy = Accuracy::high)
+    {
+        if (! (x >= FLT_MIN && x <= FLT_MAX))
+        {
+            return finvsqrt(x);
+        }
+        const float lHalf = 0.5f * x;
+        float y = fbu::simd::first(fbu::simd::rsqrtEstimate(fbu::simd::set1(x)));
+        int lNumSteps = detail::RsqrtSteps<Accuracy::high>::kNum;
+        switch (pAccuracy)
+        {
+            case Accuracy::coarse:
+                lNumSteps = detail::RsqrtSteps<Accuracy::coarse>::kNum;
+                break;
+            case Accuracy::medium:
+                lNumSteps = detail::RsqrtSteps<Accuracy::medium>::kNum;
+                break;
+            case Accuracy::high:
+                break;
+        }
+        for (int i = 0 ; i != lNumSteps ; ++i)
+        {
+            y = y * (1.5f - lHalf * y * y);
+        }
+        return y;
+    }
+
+    //==============================================================================
+    /**
+     limitedRange() per element, with SIMD min/max for float, double and
+     int32_t. NaN stays NaN. pLow <= pHigh.
+     */
+    template <typename T>
+    inline void vectLimitedRange(const T* pIn, T* pOut, size_t pSize, T pLow, T pHigh)
+    {
+        assert(pLow <= pHigh);
+        detail::clamp(pIn, pOut, pSize, pLow, pHigh, typename detail::Lanes<T>::Vectorized());
+    }
+
+    /**
+     In place, as limitRange().
+     */
+    template <typename T>
+    inline void vectLimitRange(T* pValues, size_t pSize, T pLow, T pHigh)
+    {
+        vectLimitedRange(pValues, pValues, pSize, pLow, pHigh);
+    }
+
+    /**
+     affineTransform() per element. The floating point versions compute
+     (x - fromMin) * scale + toMin, with the scale divided once, so that
+     the results may differ from the scalar function by an ulp or so. The
+     int32_t version is exact, with 64-bit intermediates.
+     */
+    template <typename T>
+    inline void vectAffineTransform(const T* pIn, T* pOut, size_t pSize, T pFromMin, T pFromMax, T pToMin, T pToMax)
+    {
+        detail::affine(pIn, pOut, pSize, detail::AffineMap<T>(pFromMin, pFromMax, pToMin, pToMax),
+                       false, pToMin, pToMax, typename detail::Lanes<T>::Vectorized());
+    }
+
+    template <typename T>
+    inline void vectAffineTransform(T* pValues, size_t pSize, T pFromMin, T pFromMax, T pToMin, T pToMax)
+    {
+        vectAffineTransform(pValues, pValues, pSize, pFromMin, pFromMax, pToMin, pToMax);
+    }
+
+    /**
+     affineTransformLimited() per element: the result is clamped to the
+     destination range, which may be reversed (pToMin > pToMax).
+     */
+    template <typename T>
+    inline void vectAffineTransformLimited(const T* pIn, T* pOut, size_t pSize, T pFromMin, T pFromMax, T pToMin, T pToMax)
+    {
+        detail::affine(pIn, pOut, pSize, detail::AffineMap<T>(pFromMin, pFromMax, pToMin, pToMax),
+                       true, std::min(pToMin, pToMax), std::max(pToMin, pToMax), typename detail::Lanes<T>::Vectorized());
+    }
+
+    template <typename T>
+    inline void vectAffineTransformLimited(T* pValues, size_t pSize, T pFromMin, T pFromMax, T pToMin, T pToMax)
+    {
+        vectAffineTransformLimited(pValues, pValues, pSize, pFromMin, pFromMax, pToMin, pToMax);
+    }
+
+    //==============================================================================
+    /**
+     domainAngle() per element, in )-π,π), for float and double: the same
+     results bit for bit, ±π and the signs of the zeros included, without
+     branches but for the rare vectors with an angle beyond 16384 (float)
+     or 2^28 (double), which take the scalar path. The angles are finite, as
+     for domainAngle(). pOut may be pIn.
+     */
+    template <typename T>
+    inline void vectDomainAngle(const T* pIn, T* pOut, size_t pSize)
+    {
+        detail::applyAngles(pOut, pSize, detail::DomainAngleOp<T>{pIn});
+    }
+
+    /**
+     domainAngleSimple() per element, for inputs in )-3π,3π), e.g. sums of
+     two angles in )-π,π).
+     */
+    template <typename T>
+    inline void vectDomainAngleSimple(const T* pIn, T* pOut, size_t pSize)
+    {
+        detail::applyAngles(pOut, pSize, detail::DomainAngleSimpleOp<T>{pIn});
+    }
+
+    /**
+     angleDifference() per element: the shortest rotations from pFrom to pTo.
+     */
+    template <typename T>
+    inline void vectAngleDifference(const T* pFrom, const T* pTo, T* pOut, size_t pSize)
+    {
+        detail::applyAngles(pOut, pSize, detail::AngleDifferenceOp<T>{pFrom, pTo});
+    }
+
+    /**
+     interpolateAngle() per element, at the same t.
+     */
+    template <typename T>
+    inline void vectInterpolateAngle(const T* pFrom, const T* pTo, T t, T* pOut, size_t pSize)
+    {
+        detail::applyAngles(pOut, pSize, detail::InterpolateAngleOp<T>{pFrom, pTo, t});
+    }
+
+    /**
+     Whether isDomainAngle() holds for all the elements.
+     */
+    template <typename T>
+    inline bool vectIsDomainAngle(const T* pAngles, size_t pSize)
+    {
+        using namespace fbu::simd;
+        typedef detail::Lanes<T> L;
+        const typename L::V lLow = L::set1(-detail::TwoPi<T>::kPi);
+        const typename L::V lHigh = L::set1(detail::TwoPi<T>::kPi);
+        int lInside = (1 << L::kNum) - 1;
+        size_t u = 0;
+        for ( ; u + L::kNum <= pSize ; u += L::kNum)
+        {
+            const typename L::V x = L::load(pAngles + u);
+            lInside &= moveMask(x > lLow) & moveMask(x <= lHigh);
+        }
+        bool lResult = lInside == (1 << L::kNum) - 1;
+        for ( ; u < pSize ; ++u)
+        {
+            lResult = lResult && isDomainAngle(pAngles[u]);
+        }
+        return lResult;
+    }
+
+    //==============================================================================
+    /**
+     Saturating arithmetics on 8-bit levels and 16-bit samples, as
+     saturating_add() and saturating_subtract() per element.
+     */
+    inline void vectSaturatingAdd(const uint8_t* pA, const uint8_t* pB, uint8_t* pOut, size_t pSize)
+    {
+        detail::applySmallInt< detail::SaturatingAddOp<uint8_t> >(pA, pB, pOut, pSize);
+    }
+
+    inline void vectSaturatingAdd(const int16_t* pA, const int16_t* pB, int16_t* pOut, size_t pSize)
+    {
+        detail::applySmallInt< detail::SaturatingAddOp<int16_t> >(pA, pB, pOut, pSize);
+    }
+
+    inline void vectSaturatingSubtract(const uint8_t* pA, const uint8_t* pB, uint8_t* pOut, size_t pSize)
+    {
+        detail::applySmallInt< detail::SaturatingSubtractOp<uint8_t> >(pA, pB, pOut, pSize);
+    }
+
+    inline void vectSaturatingSubtract(const int16_t* pA, const int16_t* pB, int16_t* pOut, size_t pSize)
+    {
+        detail::applySmallInt< detail::SaturatingSubtractOp<int16_t> >(pA, pB, pOut, pSize);
+    }
+
+    /**
+     Sums of 8-bit dB levels, e.g. to combine spectrogram tiles: exactly
+     fast_dBSum0_2() and fast_dBSum0_5() per element.
+     */
+    inline void vectDBSum0_2(const uint8_t* pA, const uint8_t* pB, uint8_t* pOut, size_t pSize)
+    {
+        detail::dBSum<&fast_dBSum0_2>(pA, pB, pOut, pSize);
+    }
+
+    inline void vectDBSum0_5(const uint8_t* pA, const uint8_t* pB, uint8_t* pOut, size_t pSize)
+    {
+        detail::dBSum<&fast_dBSum0_5>(pA, pB, pOut, pSize);
+    }
+}
+
+#endif
@@ -36,6 +36,8 @@ SOFTWARE.
 
 #include <mutex>
 #include <atomic>
+#include <condition_variable>
+#include <cassert>
 
 namespace fbu
 {
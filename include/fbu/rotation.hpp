@@ -0,0 +1,357 @@
+#ifndef FBU_ROTATION_HPP_INCLUDED
+#define FBU_ROTATION_HPP_INCLUDED
+
+/**
+ @file rotation.hpp
+ @author François Becker
+
+MIT License
+
+Copyright (c) 2018 François Becker
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "fbu/simd.hpp"
+#include "fbu/vector3.hpp"
+#include "fbu/vector3_array.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+/*
+ Rotations of Vector3, AEM and Vector3Array, with the axes of vector3.hpp: X
+ to the front, Y to the left and Z to the top. Yaw is positive to the left as
+ the azimuth, pitch positive to the top as the elevation, and roll positive
+ when the left goes to the top. The three apply in the order roll, pitch, yaw,
+ so that the rotation of yaw, pitch and 0 brings the front to AE(yaw, pitch).
+ */
+
+template <typename T> struct Matrix3;
+template <typename T> struct Quaternion;
+
+//==============================================================================
+/**
+ @brief A rotation as a unit quaternion, to compose and interpolate.
+ */
+template <typename T>
+struct Quaternion
+{
+    T mW;
+    T mX;
+    T mY;
+    T mZ;
+
+    static Quaternion<T> wxyz(T pW, T pX, T pY, T pZ)
+    {
+        Quaternion<T> lResult;
+        lResult.mW = pW;
+        lResult.mX = pX;
+        lResult.mY = pY;
+        lResult.mZ = pZ;
+        return lResult;
+    }
+
+    static Quaternion<T> identity()
+    {
+        return wxyz((T)1, (T)0, (T)0, (T)0);
+    }
+
+    /**
+     The rotation of pAngle around the unit vector pAxis, positive
+     counterclockwise when seen from pAxis.
+     */
+    static Quaternion<T> fromAxisAngle(const Vector3<T>& pAxis, T pAngle)
+    {
+        const T lSin = std::sin((T)0.5 * pAngle);
+        return wxyz(std::cos((T)0.5 * pAngle), lSin * pAxis.mX, lSin * pAxis.mY, lSin * pAxis.mZ);
+    }
+
+    static Quaternion<T> fromYawPitchRoll(T pYaw, T pPitch, T pRoll)
+    {
+        return fromAxisAngle(Vector3<T>::cartesian((T)0, (T)0, (T)1), pYaw)
+             * fromAxisAngle(Vector3<T>::cartesian((T)0, (T)1, (T)0), -pPitch)
+             * fromAxisAngle(Vector3<T>::cartesian((T)1, (T)0, (T)0), pRoll);
+    }
+
+    static Quaternion<T> fromMatrix(const Matrix3<T>& pMatrix);
+
+    T dot(const Quaternion<T>& pOther) const
+    {
+        return mW * pOther.mW + mX * pOther.mX + mY * pOther.mY + mZ * pOther.mZ;
+    }
+
+    /**
+     The inverse rotation.
+     */
+    Quaternion<T> conjugate() const
+    {
+        return wxyz(mW, -mX, -mY, -mZ);
+    }
+
+    Quaternion<T> normalized() const
+    {
+        const T lInvNorm = (T)1 / std::sqrt(dot(*this));
+        return wxyz(lInvNorm * mW, lInvNorm * mX, lInvNorm * mY, lInvNorm * mZ);
+    }
+
+    Vector3<T> rotate(const Vector3<T>& pVect) const
+    {
+        // v + 2 w (u x v) + 2 u x (u x v), u being the vector part
+        const Vector3<T> lU = Vector3<T>::cartesian(mX, mY, mZ);
+        const Vector3<T> lUxV = (T)2 * lU.cross(pVect);
+        return pVect + mW * lUxV + lU.cross(lUxV);
+    }
+
+    AEM<T> rotate(const AEM<T>& pAEM) const
+    {
+        return AEM<T>::fromVector3(rotate(Vector3<T>::fromAEM(pAEM)));
+    }
+};
+
+/**
+ The rotation pB then pA.
+ */
+template <typename T>
+Quaternion<T> operator *(const Quaternion<T>& pA, const Quaternion<T>& pB)
+{
+    return Quaternion<T>::wxyz(pA.mW * pB.mW - pA.mX * pB.mX - pA.mY * pB.mY - pA.mZ * pB.mZ,
+                               pA.mW * pB.mX + pA.mX * pB.mW + pA.mY * pB.mZ - pA.mZ * pB.mY,
+                               pA.mW * pB.mY - pA.mX * pB.mZ + pA.mY * pB.mW + pA.mZ * pB.mX,
+                               pA.mW * pB.mZ + pA.mX * pB.mY - pA.mY * pB.mX + pA.mZ * pB.mW);
+}
+
+/**
+ The spherical linear interpolation from pA (pT = 0) to pB (pT = 1), along
+ the shortest path, at constant angular speed.
+ */
+template <typename T>
+Quaternion<T> slerp(const Quaternion<T>& pA, const Quaternion<T>& pB, T pT)
+{
+    T lCos = pA.dot(pB);
+    T lSignB = (T)1;
+    if (lCos < (T)0)
+    {
+        lCos = -lCos;
+        lSignB = (T)-1;
+    }
+    T lWeightA = (T)1 - pT;
+    T lWeightB = pT;
+    // nlerp when the sine vanishes
+    if (lCos < (T)0.9995)
+    {
+        const T lAngle = std::acos(lCos);
+        const T lInvSin = (T)1 / std::sin(lAngle);
+        lWeightA = std::sin(lWeightA * lAngle) * lInvSin;
+        lWeightB = std::sin(lWeightB * lAngle) * lInvSin;
+    }
+    lWeightB *= lSignB;
+    return Quaternion<T>::wxyz(lWeightA * pA.mW + lWeightB * pB.mW,
+                               lWeightA * pA.mX + lWeightB * pB.mX,
+                               lWeightA * pA.mY + lWeightB * pB.mY,
+                               lWeightA * pA.mZ + lWeightB * pB.mZ).normalized();
+}
+
+typedef Quaternion<float> Quaternionf;
+
+//==============================================================================
+/**
+ @brief A rotation as a 3x3 matrix, to apply to many vectors.
+ */
+template <typename T>
+struct Matrix3
+{
+    T mValues[3][3]; ///< [row][column]
+
+    static Matrix3<T> identity()
+    {
+        return {{{(T)1, (T)0, (T)0}, {(T)0, (T)1, (T)0}, {(T)0, (T)0, (T)1}}};
+    }
+
+    /**
+     pQuaternion must be normalized.
+     */
+    static Matrix3<T> fromQuaternion(const Quaternion<T>& pQuaternion)
+    {
+        const T w = pQuaternion.mW, x = pQuaternion.mX, y = pQuaternion.mY, z = pQuaternion.mZ;
+        return {{{(T)1 - (T)2 * (y * y + z * z), (T)2 * (x * y - w * z), (T)2 * (x * z + w * y)},
+                 {(T)2 * (x * y + w * z), (T)1 - (T)2 * (x * x + z * z), (T)2 * (y * z - w * x)},
+                 {(T)2 * (x * z - w * y), (T)2 * (y * z + w * x), (T)1 - (T)2 * (x * x + y * y)}}};
+    }
+
+    static Matrix3<T> fromYawPitchRoll(T pYaw, T pPitch, T pRoll)
+    {
+        return fromQuaternion(Quaternion<T>::fromYawPitchRoll(pYaw, pPitch, pRoll));
+    }
+
+    /**
+     The inverse rotation.
+     */
+    Matrix3<T> transposed() const
+    {
+        Matrix3<T> lResult;
+        for (int i = 0 ; i != 3 ; ++i)
+        {
+            for (int j = 0 ; j != 3 ; ++j)
+            {
+                lResult.mValues[i][j] = mValues[j][i];
+            }
+        }
+        return lResult;
+    }
+
+    Vector3<T> rotate(const Vector3<T>& pVect) const
+    {
+        return Vector3<T>::cartesian(mValues[0][0] * pVect.mX + mValues[0][1] * pVect.mY + mValues[0][2] * pVect.mZ,
+                                     mValues[1][0] * pVect.mX + mValues[1][1] * pVect.mY + mValues[1][2] * pVect.mZ,
+                                     mValues[2][0] * pVect.mX + mValues[2][1] * pVect.mY + mValues[2][2] * pVect.mZ);
+    }
+
+    AEM<T> rotate(const AEM<T>& pAEM) const
+    {
+        return AEM<T>::fromVector3(rotate(Vector3<T>::fromAEM(pAEM)));
+    }
+};
+
+/**
+ The rotation pB then pA.
+ */
+template <typename T>
+Matrix3<T> operator *(const Matrix3<T>& pA, const Matrix3<T>& pB)
+{
+    Matrix3<T> lResult;
+    for (int i = 0 ; i != 3 ; ++i)
+    {
+        for (int j = 0 ; j != 3 ; ++j)
+        {
+            lResult.mValues[i][j] = pA.mValues[i][0] * pB.mValues[0][j]
+                                  + pA.mValues[i][1] * pB.mValues[1][j]
+                                  + pA.mValues[i][2] * pB.mValues[2][j];
+        }
+    }
+    return lResult;
+}
+
+template <typename T>
+Vector3<T> operator *(const Matrix3<T>& pMatrix, const Vector3<T>& pVect)
+{
+    return pMatrix.rotate(pVect);
+}
+
+typedef Matrix3<float> Matrix3f;
+
+//==============================================================================
+template <typename T>
+Quaternion<T> Quaternion<T>::fromMatrix(const Matrix3<T>& pMatrix)
+{
+    // from the largest of w, x, y and z, for accuracy
+    const T (&m)[3][3] = pMatrix.mValues;
+    const T lTrace = m[0][0] + m[1][1] + m[2][2];
+    Quaternion<T> q;
+    if (lTrace > (T)0)
+    {
+        const T s = (T)2 * std::sqrt((T)1 + lTrace);
+        q = wxyz((T)0.25 * s, (m[2][1] - m[1][2]) / s, (m[0][2] - m[2][0]) / s, (m[1][0] - m[0][1]) / s);
+    }
+    else if (m[0][0] > m[1][1] && m[0][0] > m[2][2])
+    {
+        const T s = (T)2 * std::sqrt((T)1 + m[0][0] - m[1][1] - m[2][2]);
+        q = wxyz((m[2][1] - m[1][2]) / s, (T)0.25 * s, (m[0][1] + m[1][0]) / s, (m[0][2] + m[2][0]) / s);
+    }
+    else if (m[1][1] > m[2][2])
+    {
+        const T s = (T)2 * std::sqrt((T)1 + m[1][1] - m[0][0] - m[2][2]);
+        q = wxyz((m[0][2] - m[2][0]) / s, (m[0][1] + m[1][0]) / s, (T)0.25 * s, (m[1][2] + m[2][1]) / s);
+    }
+    else
+    {
+        const T s = (T)2 * std::sqrt((T)1 + m[2][2] - m[0][0] - m[1][1]);
+        q = wxyz((m[1][0] - m[0][1]) / s, (m[0][2] + m[2][0]) / s, (m[1][2] + m[2][1]) / s, (T)0.25 * s);
+    }
+    return q.normalized();
+}
+
+//==============================================================================
+namespace fbu
+{
+    namespace detail
+    {
+        template <typename T>
+        inline void rotate(const Matrix3<T>& pMatrix, const Vector3Array<T>& pIn, Vector3Array<T>& pOut, std::false_type)
+        {
+            for (size_t i = 0 ; i != pIn.size() ; ++i)
+            {
+                pOut[i] = pMatrix.rotate(pIn[i]);
+            }
+        }
+
+        inline void rotate(const Matrix3<float>& pMatrix, const Vector3Array<float>& pIn, Vector3Array<float>& pOut, std::true_type)
+        {
+            using namespace fbu::simd;
+            vfloat m[3][3];
+            for (int i = 0 ; i != 3 ; ++i)
+            {
+                for (int j = 0 ; j != 3 ; ++j)
+                {
+                    m[i][j] = set1(pMatrix.mValues[i][j]);
+                }
+            }
+            // the padding stays zero
+            for (size_t u = 0 ; u != pIn.paddedSize() ; u += (size_t)kFloatLanes)
+            {
+                const vfloat x = load(pIn.x() + u), y = load(pIn.y() + u), z = load(pIn.z() + u);
+                store(pOut.x() + u, mulAdd(m[0][0], x, mulAdd(m[0][1], y, m[0][2] * z)));
+                store(pOut.y() + u, mulAdd(m[1][0], x, mulAdd(m[1][1], y, m[1][2] * z)));
+                store(pOut.z() + u, mulAdd(m[2][0], x, mulAdd(m[2][1], y, m[2][2] * z)));
+            }
+        }
+    }
+
+    /**
+     pOut[i] = pMatrix.rotate(pIn[i]), pOut being resized. pOut may be pIn.
+     */
+    template <typename T>
+    void rotate(const Matrix3<T>& pMatrix, const Vector3Array<T>& pIn, Vector3Array<T>& pOut)
+    {
+        pOut.resize(pIn.size());
+        detail::rotate(pMatrix, pIn, pOut, typename std::is_same<T, float>::type());
+    }
+
+    /**
+     The rotation of all the elements of pVectors, e.g. the sources by the
+     inverse of the orientation of the head of the listener.
+     */
+    template <typename T>
+    void rotate(const Matrix3<T>& pMatrix, Vector3Array<T>& pVectors)
+    {
+        rotate(pMatrix, pVectors, pVectors);
+    }
+
+    /**
+     As the Matrix3 version, through Matrix3::fromQuaternion().
+     */
+    template <typename T>
+    void rotate(const Quaternion<T>& pQuaternion, Vector3Array<T>& pVectors)
+    {
+        rotate(Matrix3<T>::fromQuaternion(pQuaternion), pVectors, pVectors);
+    }
+}
+
+#endif // FBU_ROTATION_HPP_INCLUDED
@@ -0,0 +1,1121 @@
+#ifndef FBU_SIMD_HPP_INCLUDED
+#define FBU_SIMD_HPP_INCLUDED
+
+/**
+ @file simd.hpp
+ @author François Becker
+
+MIT License
+
+Copyright (c) 2018 François Becker
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ Thin wrappers over the platform float vector registers, so that the array
+ kernels of fb-utils are written once and compiled to SSE2 or NEON.
+ Define FBU_SIMD_DISABLE to force the portable scalar fallback.
+ */
+
+#if defined(FBU_SIMD_DISABLE)
+#define FBU_SIMD_USE_SSE 0
+#define FBU_SIMD_USE_NEON 0
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FBU_SIMD_USE_SSE 1
+#define FBU_SIMD_USE_NEON 0
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define FBU_SIMD_USE_SSE 0
+#define FBU_SIMD_USE_NEON 1
+#else
+#define FBU_SIMD_USE_SSE 0
+#define FBU_SIMD_USE_NEON 0
+#endif
+
+#if FBU_SIMD_USE_SSE
+#include <emmintrin.h>
+#if defined(__FMA__)
+#include <immintrin.h>
+#endif
+#endif
+
+#if FBU_SIMD_USE_NEON
+#include <arm_neon.h>
+#endif
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <vector>
+
+namespace fbu
+{
+namespace simd
+{
+    /// Number of float lanes in a vfloat.
+    constexpr int kFloatLanes = 4;
+    /// Number of lanes in a vuint8, a vint16 and a vdouble, same register width.
+    constexpr int kUint8Lanes = 16;
+    constexpr int kInt16Lanes = 8;
+    constexpr int kDoubleLanes = 2;
+
+#if FBU_SIMD_USE_SSE
+    struct vfloat { __m128  v; };
+    struct vint   { __m128i v; };
+    struct vmask  { __m128  v; }; ///< all bits set in the lanes where true
+    struct vuint8 { __m128i v; };
+    struct vint16 { __m128i v; };
+#elif FBU_SIMD_USE_NEON
+    struct vfloat { float32x4_t v; };
+    struct vint   { int32x4_t   v; };
+    struct vmask  { uint32x4_t  v; };
+    struct vuint8 { uint8x16_t  v; };
+    struct vint16 { int16x8_t   v; };
+#else
+    struct vfloat { float    v[kFloatLanes]; };
+    struct vint   { int32_t  v[kFloatLanes]; };
+    struct vmask  { uint32_t v[kFloatLanes]; };
+    struct vuint8 { uint8_t  v[kUint8Lanes]; };
+    struct vint16 { int16_t  v[kInt16Lanes]; };
+#endif
+
+    // 32-bit NEON has no double lanes
+#if FBU_SIMD_USE_SSE
+#define FBU_SIMD_DOUBLE_USE_SSE 1
+#define FBU_SIMD_DOUBLE_USE_NEON 0
+    struct vdouble { __m128d v; };
+    struct vdmask  { __m128d v; }; ///< all bits set in the lanes where true
+#elif FBU_SIMD_USE_NEON && defined(__aarch64__)
+#define FBU_SIMD_DOUBLE_USE_SSE 0
+#define FBU_SIMD_DOUBLE_USE_NEON 1
+    struct vdouble { float64x2_t v; };
+    struct vdmask  { uint64x2_t  v; };
+#else
+#define FBU_SIMD_DOUBLE_USE_SSE 0
+#define FBU_SIMD_DOUBLE_USE_NEON 0
+    struct vdouble { double   v[kDoubleLanes]; };
+    struct vdmask  { uint64_t v[kDoubleLanes]; };
+#endif
+
+    //==============================================================================
+    // Load, store, broadcast
+
+    inline vfloat load(const float* p)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_loadu_ps(p)};
+#elif FBU_SIMD_USE_NEON
+        return {vld1q_f32(p)};
+#else
+        vfloat r;
+        std::memcpy(r.v, p, sizeof(r.v));
+        return r;
+#endif
+    }
+
+    inline void store(float* p, vfloat a)
+    {
+#if FBU_SIMD_USE_SSE
+        _mm_storeu_ps(p, a.v);
+#elif FBU_SIMD_USE_NEON
+        vst1q_f32(p, a.v);
+#else
+        // per lane: GCC takes a whole-vector memcpy in a loop over the
+        // whole vectors of a smaller array for an overflow (-Warray-bounds)
+        for (int i = 0 ; i != kFloatLanes ; ++i) p[i] = a.v[i];
+#endif
+    }
+
+    inline vint loadInt(const int32_t* p)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))};
+#elif FBU_SIMD_USE_NEON
+        return {vld1q_s32(p)};
+#else
+        vint r;
+        std::memcpy(r.v, p, sizeof(r.v));
+        return r;
+#endif
+    }
+
+    inline void storeInt(int32_t* p, vint a)
+    {
+#if FBU_SIMD_USE_SSE
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a.v);
+#elif FBU_SIMD_USE_NEON
+        vst1q_s32(p, a.v);
+#else
+        std::memcpy(p, a.v, sizeof(a.v));
+#endif
+    }
+
+    inline vfloat set1(float s)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_set1_ps(s)};
+#elif FBU_SIMD_USE_NEON
+        return {vdupq_n_f32(s)};
+#else
+        vfloat r;
+        for (int i = 0 ; i != kFloatLanes ; ++i) r.v[i] = s;
+        return r;
+#endif
+    }
+
+    inline vint set1Int(int32_t s)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_set1_epi32(s)};
+#elif FBU_SIMD_USE_NEON
+        return {vdupq_n_s32(s)};
+#else
+        vint r;
+        for (int i = 0 ; i != kFloatLanes ; ++i) r.v[i] = s;
+        return r;
+#endif
+    }
+
+    inline vfloat zero()
+    {
+        return set1(0.f);
+    }
+
+    //==============================================================================
+    // Float arithmetics
+
+#if FBU_SIMD_USE_SSE
+#define FBU_SIMD_FLOAT_BINOP(OP, SSE, NEON, EXPR) \
+    inline vfloat OP(vfloat a, vfloat b) { return {SSE(a.v, b.v)}; }
+#elif FBU_SIMD_USE_NEON
+#define FBU_SIMD_FLOAT_BINOP(OP, SSE, NEON, EXPR) \
+    inline vfloat OP(vfloat a, vfloat b) { return {NEON(a.v, b.v)}; }
+#else
+#define FBU_SIMD_FLOAT_BINOP(OP, SSE, NEON, EXPR) \
+    inline vfloat OP(vfloat a, vfloat b) \
+    { \
+        vfloat r; \
+        for (int i = 0 ; i != kFloatLanes ; ++i) { float x = a.v[i], y = b.v[i]; r.v[i] = (EXPR); } \
+        return r; \
+    }
+#endif
+
+    FBU_SIMD_FLOAT_BINOP(operator+, _mm_add_ps, vaddq_f32, x + y)
+    FBU_SIMD_FLOAT_BINOP(operator-, _mm_sub_ps, vsubq_f32, x - y)
+    FBU_SIMD_FLOAT_BINOP(operator*, _mm_mul_ps, vmulq_f32, x * y)
+    // the SSE semantics: the second operand when either is NaN
+    FBU_SIMD_FLOAT_BINOP(min, _mm_min_ps, vminq_f32, (x < y) ? x : y)
+    FBU_SIMD_FLOAT_BINOP(max, _mm_max_ps, vmaxq_f32, (x > y) ? x : y)
+
+#undef FBU_SIMD_FLOAT_BINOP
+
+    inline vfloat operator/(vfloat a, vfloat b)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_div_ps(a.v, b.v)};
+#elif FBU_SIMD_USE_NEON && defined(__aarch64__)
+        return {vdivq_f32(a.v, b.v)};
+#else
+        float lA[kFloatLanes], lB[kFloatLanes];
+        store(lA, a);
+        store(lB, b);
+        for (int i = 0 ; i != kFloatLanes ; ++i) lA[i] /= lB[i];
+        return load(lA);
+#endif
+    }
+
+    inline vfloat operator-(vfloat a)
+    {
+        return zero() - a;
+    }
+
+    inline vfloat& operator+=(vfloat& a, vfloat b) { a = a + b; return a; }
+    inline vfloat& operator-=(vfloat& a, vfloat b) { a = a - b; return a; }
+    inline vfloat& operator*=(vfloat& a, vfloat b) { a = a * b; return a; }
+
+    /**
+     a * b + c, fused when the platform has it.
+     */
+    inline vfloat mulAdd(vfloat a, vfloat b, vfloat c)
+    {
+#if FBU_SIMD_USE_SSE && defined(__FMA__)
+        return {_mm_fmadd_ps(a.v, b.v, c.v)};
+#elif FBU_SIMD_USE_NEON && defined(__aarch64__)
+        return {vfmaq_f32(c.v, a.v, b.v)};
+#else
+        return a * b + c;
+#endif
+    }
+
+    inline vfloat sqrt(vfloat a)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_sqrt_ps(a.v)};
+#elif FBU_SIMD_USE_NEON && defined(__aarch64__)
+        return {vsqrtq_f32(a.v)};
+#else
+        float lA[kFloatLanes];
+        store(lA, a);
+        for (int i = 0 ; i != kFloatLanes ; ++i) lA[i] = std::sqrt(lA[i]);
+        return load(lA);
+#endif
+    }
+
+    /**
+     Hardware estimate of 1/a, about 12 bits of precision (8 bits on NEON).
+     */
+    inline vfloat rcpEstimate(vfloat a)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_rcp_ps(a.v)};
+#elif FBU_SIMD_USE_NEON
+        return {vrecpeq_f32(a.v)};
+#else
+        return set1(1.f) / a;
+#endif
+    }
+
+    /**
+     Hardware estimate of 1/sqrt(a), about 12 bits of precision (8 bits on NEON).
+     */
+    inline vfloat rsqrtEstimate(vfloat a)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_rsqrt_ps(a.v)};
+#elif FBU_SIMD_USE_NEON
+        return {vrsqrteq_f32(a.v)};
+#else
+        return set1(1.f) / sqrt(a);
+#endif
+    }
+
+    //==============================================================================
+    // Bit reinterpretation and conversions
+
+    inline vint asInt(vfloat a)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_castps_si128(a.v)};
+#elif FBU_SIMD_USE_NEON
+        return {vreinterpretq_s32_f32(a.v)};
+#else
+        vint r;
+        std::memcpy(r.v, a.v, sizeof(r.v));
+        return r;
+#endif
+    }
+
+    inline vfloat asFloat(vint a)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_castsi128_ps(a.v)};
+#elif FBU_SIMD_USE_NEON
+        return {vreinterpretq_f32_s32(a.v)};
+#else
+        vfloat r;
+        std::memcpy(r.v, a.v, sizeof(r.v));
+        return r;
+#endif
+    }
+
+    /**
+     Convert with round to nearest, valid for |a| < 2^31.
+     */
+    inline vint toIntRound(vfloat a)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_cvtps_epi32(a.v)};
+#elif FBU_SIMD_USE_NEON && defined(__aarch64__)
+        return {vcvtnq_s32_f32(a.v)};
+#elif FBU_SIMD_USE_NEON
+        // add 1.5 * 2^23 to flush the fractional part, only valid for |a| < 2^22
+        const float32x4_t lMagic = vdupq_n_f32(12582912.f);
+        return {vsubq_s32(vreinterpretq_s32_f32(vaddq_f32(a.v, lMagic)), vreinterpretq_s32_f32(lMagic))};
+#else
+        vint r;
+        for (int i = 0 ; i != kFloatLanes ; ++i) r.v[i] = (int32_t)std::nearbyint(a.v[i]);
+        return r;
+#endif
+    }
+
+    /**
+     Convert with truncation toward zero.
+     */
+    inline vint toIntTrunc(vfloat a)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_cvttps_epi32(a.v)};
+#elif FBU_SIMD_USE_NEON
+        return {vcvtq_s32_f32(a.v)};
+#else
+        vint r;
+        for (int i = 0 ; i != kFloatLanes ; ++i) r.v[i] = (int32_t)a.v[i];
+        return r;
+#endif
+    }
+
+    inline vfloat toFloat(vint a)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_cvtepi32_ps(a.v)};
+#elif FBU_SIMD_USE_NEON
+        return {vcvtq_f32_s32(a.v)};
+#else
+        vfloat r;
+        for (int i = 0 ; i != kFloatLanes ; ++i) r.v[i] = (float)a.v[i];
+        return r;
+#endif
+    }
+
+    /**
+     Round to the nearest integer value, valid for |a| < 2^31.
+     */
+    inline vfloat round(vfloat a)
+    {
+        return toFloat(toIntRound(a));
+    }
+
+    //==============================================================================
+    // Integer arithmetics
+
+    inline vint operator+(vint a, vint b)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_add_epi32(a.v, b.v)};
+#elif FBU_SIMD_USE_NEON
+        return {vaddq_s32(a.v, b.v)};
+#else
+        vint r;
+        for (int i = 0 ; i != kFloatLanes ; ++i) r.v[i] = (int32_t)((uint32_t)a.v[i] + (uint32_t)b.v[i]);
+        return r;
+#endif
+    }
+
+    inline vint operator-(vint a, vint b)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_sub_epi32(a.v, b.v)};
+#elif FBU_SIMD_USE_NEON
+        return {vsubq_s32(a.v, b.v)};
+#else
+        vint r;
+        for (int i = 0 ; i != kFloatLanes ; ++i) r.v[i] = (int32_t)((uint32_t)a.v[i] - (uint32_t)b.v[i]);
+        return r;
+#endif
+    }
+
+    inline vint operator&(vint a, vint b)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_and_si128(a.v, b.v)};
+#elif FBU_SIMD_USE_NEON
+        return {vandq_s32(a.v, b.v)};
+#else
+        vint r;
+        for (int i = 0 ; i != kFloatLanes ; ++i) r.v[i] = a.v[i] & b.v[i];
+        return r;
+#endif
+    }
+
+    inline vint operator|(vint a, vint b)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_or_si128(a.v, b.v)};
+#elif FBU_SIMD_USE_NEON
+        return {vorrq_s32(a.v, b.v)};
+#else
+        vint r;
+        for (int i = 0 ; i != kFloatLanes ; ++i) r.v[i] = a.v[i] | b.v[i];
+        return r;
+#endif
+    }
+
+    inline vint operator^(vint a, vint b)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_xor_si128(a.v, b.v)};
+#elif FBU_SIMD_USE_NEON
+        return {veorq_s32(a.v, b.v)};
+#else
+        vint r;
+        for (int i = 0 ; i != kFloatLanes ; ++i) r.v[i] = a.v[i] ^ b.v[i];
+        return r;
+#endif
+    }
+
+    template <int N>
+    inline vint shiftLeft(vint a)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_slli_epi32(a.v, N)};
+#elif FBU_SIMD_USE_NEON
+        return {vshlq_n_s32(a.v, N)};
+#else
+        vint r;
+        for (int i = 0 ; i != kFloatLanes ; ++i) r.v[i] = (int32_t)((uint32_t)a.v[i] << N);
+        return r;
+#endif
+    }
+
+    template <int N>
+    inline vint shiftRightLogical(vint a)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_srli_epi32(a.v, N)};
+#elif FBU_SIMD_USE_NEON
+        return {vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(a.v), N))};
+#else
+        vint r;
+        for (int i = 0 ; i != kFloatLanes ; ++i) r.v[i] = (int32_t)((uint32_t)a.v[i] >> N);
+        return r;
+#endif
+    }
+
+    /**
+     Shift by a count known at runtime only, in [0, 32].
+     */
+    inline vint shiftRightLogical(vint a, int n)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_srl_epi32(a.v, _mm_cvtsi32_si128(n))};
+#elif FBU_SIMD_USE_NEON
+        return {vreinterpretq_s32_u32(vshlq_u32(vreinterpretq_u32_s32(a.v), vdupq_n_s32(-n)))};
+#else
+        vint r;
+        for (int i = 0 ; i != kFloatLanes ; ++i) r.v[i] = n >= 32 ? 0 : (int32_t)((uint32_t)a.v[i] >> n);
+        return r;
+#endif
+    }
+
+    template <int N>
+    inline vint shiftRightArith(vint a)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_srai_epi32(a.v, N)};
+#elif FBU_SIMD_USE_NEON
+        return {vshrq_n_s32(a.v, N)};
+#else
+        vint r;
+        for (int i = 0 ; i != kFloatLanes ; ++i) r.v[i] = a.v[i] >> N;
+        return r;
+#endif
+    }
+
+    //==============================================================================
+    // Comparisons and masks
+
+#if FBU_SIMD_USE_SSE
+#define FBU_SIMD_FLOAT_CMP(OP, SSE, NEON) \
+    inline vmask operator OP(vfloat a, vfloat b) { return {SSE(a.v, b.v)}; }
+#elif FBU_SIMD_USE_NEON
+#define FBU_SIMD_FLOAT_CMP(OP, SSE, NEON) \
+    inline vmask operator OP(vfloat a, vfloat b) { return {NEON(a.v, b.v)}; }
+#else
+#define FBU_SIMD_FLOAT_CMP(OP, SSE, NEON) \
+    inline vmask operator OP(vfloat a, vfloat b) \
+    { \
+        vmask r; \
+        for (int i = 0 ; i != kFloatLanes ; ++i) r.v[i] = (a.v[i] OP b.v[i]) ? 0xFFFFFFFFu : 0u; \
+        return r; \
+    }
+#endif
+
+    FBU_SIMD_FLOAT_CMP(<,  _mm_cmplt_ps, vcltq_f32)
+    FBU_SIMD_FLOAT_CMP(<=, _mm_cmple_ps, vcleq_f32)
+    FBU_SIMD_FLOAT_CMP(>,  _mm_cmpgt_ps, vcgtq_f32)
+    FBU_SIMD_FLOAT_CMP(>=, _mm_cmpge_ps, vcgeq_f32)
+    FBU_SIMD_FLOAT_CMP(==, _mm_cmpeq_ps, vceqq_f32)
+
+#undef FBU_SIMD_FLOAT_CMP
+
+    inline vmask operator==(vint a, vint b)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_castsi128_ps(_mm_cmpeq_epi32(a.v, b.v))};
+#elif FBU_SIMD_USE_NEON
+        return {vceqq_s32(a.v, b.v)};
+#else
+        vmask r;
+        for (int i = 0 ; i != kFloatLanes ; ++i) r.v[i] = (a.v[i] == b.v[i]) ? 0xFFFFFFFFu : 0u;
+        return r;
+#endif
+    }
+
+    inline vmask operator>(vint a, vint b)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_castsi128_ps(_mm_cmpgt_epi32(a.v, b.v))};
+#elif FBU_SIMD_USE_NEON
+        return {vcgtq_s32(a.v, b.v)};
+#else
+        vmask r;
+        for (int i = 0 ; i != kFloatLanes ; ++i) r.v[i] = (a.v[i] > b.v[i]) ? 0xFFFFFFFFu : 0u;
+        return r;
+#endif
+    }
+
+    inline vmask operator&(vmask a, vmask b)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_and_ps(a.v, b.v)};
+#elif FBU_SIMD_USE_NEON
+        return {vandq_u32(a.v, b.v)};
+#else
+        vmask r;
+        for (int i = 0 ; i != kFloatLanes ; ++i) r.v[i] = a.v[i] & b.v[i];
+        return r;
+#endif
+    }
+
+    inline vmask operator|(vmask a, vmask b)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_or_ps(a.v, b.v)};
+#elif FBU_SIMD_USE_NEON
+        return {vorrq_u32(a.v, b.v)};
+#else
+        vmask r;
+        for (int i = 0 ; i != kFloatLanes ; ++i) r.v[i] = a.v[i] | b.v[i];
+        return r;
+#endif
+    }
+
+    inline vmask operator~(vmask a)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_xor_ps(a.v, _mm_castsi128_ps(_mm_set1_epi32(-1)))};
+#elif FBU_SIMD_USE_NEON
+        return {vmvnq_u32(a.v)};
+#else
+        vmask r;
+        for (int i = 0 ; i != kFloatLanes ; ++i) r.v[i] = ~a.v[i];
+        return r;
+#endif
+    }
+
+    /**
+     Per lane: pMask ? pTrue : pFalse
+     */
+    inline vfloat select(vmask pMask, vfloat pTrue, vfloat pFalse)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_or_ps(_mm_and_ps(pMask.v, pTrue.v), _mm_andnot_ps(pMask.v, pFalse.v))};
+#elif FBU_SIMD_USE_NEON
+        return {vbslq_f32(pMask.v, pTrue.v, pFalse.v)};
+#else
+        vfloat r;
+        for (int i = 0 ; i != kFloatLanes ; ++i) r.v[i] = pMask.v[i] ? pTrue.v[i] : pFalse.v[i];
+        return r;
+#endif
+    }
+
+    inline vint select(vmask pMask, vint pTrue, vint pFalse)
+    {
+        return asInt(select(pMask, asFloat(pTrue), asFloat(pFalse)));
+    }
+
+    inline vint min(vint a, vint b)
+    {
+#if FBU_SIMD_USE_SSE && defined(__SSE4_1__)
+        return {_mm_min_epi32(a.v, b.v)};
+#elif FBU_SIMD_USE_NEON
+        return {vminq_s32(a.v, b.v)};
+#else
+        return select(a > b, b, a);
+#endif
+    }
+
+    inline vint max(vint a, vint b)
+    {
+#if FBU_SIMD_USE_SSE && defined(__SSE4_1__)
+        return {_mm_max_epi32(a.v, b.v)};
+#elif FBU_SIMD_USE_NEON
+        return {vmaxq_s32(a.v, b.v)};
+#else
+        return select(a > b, a, b);
+#endif
+    }
+
+    /**
+     One bit per lane, lane 0 in the LSB.
+     */
+    inline int moveMask(vmask pMask)
+    {
+#if FBU_SIMD_USE_SSE
+        return _mm_movemask_ps(pMask.v);
+#elif FBU_SIMD_USE_NEON
+        uint32_t lBits[kFloatLanes];
+        vst1q_u32(lBits, vshrq_n_u32(pMask.v, 31));
+        return (int)(lBits[0] | (lBits[1] << 1) | (lBits[2] << 2) | (lBits[3] << 3));
+#else
+        int lResult = 0;
+        for (int i = 0 ; i != kFloatLanes ; ++i) lResult |= (pMask.v[i] >> 31) << i;
+        return lResult;
+#endif
+    }
+
+    inline bool any(vmask pMask)
+    {
+        return moveMask(pMask) != 0;
+    }
+
+    inline bool all(vmask pMask)
+    {
+        return moveMask(pMask) == (1 << kFloatLanes) - 1;
+    }
+
+    //==============================================================================
+    // Interleaved pairs, e.g. Complex arrays
+
+    /**
+     Split the pairs of a and b (a0 a1 a2 a3, b0 b1 b2 b3) into their first
+     (a0 a2 b0 b2) and second (a1 a3 b1 b3) elements.
+     */
+    inline void deinterleave(vfloat a, vfloat b, vfloat& pFirst, vfloat& pSecond)
+    {
+#if FBU_SIMD_USE_SSE
+        pFirst.v = _mm_shuffle_ps(a.v, b.v, _MM_SHUFFLE(2, 0, 2, 0));
+        pSecond.v = _mm_shuffle_ps(a.v, b.v, _MM_SHUFFLE(3, 1, 3, 1));
+#elif FBU_SIMD_USE_NEON
+        float32x4x2_t lPairs = vuzpq_f32(a.v, b.v);
+        pFirst.v = lPairs.val[0];
+        pSecond.v = lPairs.val[1];
+#else
+        for (int i = 0 ; i != kFloatLanes / 2 ; ++i)
+        {
+            pFirst.v[i] = a.v[2 * i];
+            pSecond.v[i] = a.v[2 * i + 1];
+            pFirst.v[i + kFloatLanes / 2] = b.v[2 * i];
+            pSecond.v[i + kFloatLanes / 2] = b.v[2 * i + 1];
+        }
+#endif
+    }
+
+    /**
+     Inverse of deinterleave().
+     */
+    inline void interleave(vfloat pFirst, vfloat pSecond, vfloat& a, vfloat& b)
+    {
+#if FBU_SIMD_USE_SSE
+        a.v = _mm_unpacklo_ps(pFirst.v, pSecond.v);
+        b.v = _mm_unpackhi_ps(pFirst.v, pSecond.v);
+#elif FBU_SIMD_USE_NEON
+        float32x4x2_t lPairs = vzipq_f32(pFirst.v, pSecond.v);
+        a.v = lPairs.val[0];
+        b.v = lPairs.val[1];
+#else
+        for (int i = 0 ; i != kFloatLanes / 2 ; ++i)
+        {
+            a.v[2 * i] = pFirst.v[i];
+            a.v[2 * i + 1] = pSecond.v[i];
+            b.v[2 * i] = pFirst.v[i + kFloatLanes / 2];
+            b.v[2 * i + 1] = pSecond.v[i + kFloatLanes / 2];
+        }
+#endif
+    }
+
+    /**
+     1/a from the hardware estimate refined by Newton-Raphson steps,
+     relative error below 2^-21 for normal a.
+     */
+    inline vfloat rcp(vfloat a)
+    {
+        vfloat lEstimate = rcpEstimate(a);
+#if FBU_SIMD_USE_NEON
+        lEstimate = lEstimate * (set1(2.f) - a * lEstimate);
+#endif
+        return lEstimate * (set1(2.f) - a * lEstimate);
+    }
+
+    /**
+     1/sqrt(a) from the hardware estimate refined by Newton-Raphson steps,
+     relative error below 2^-21 for normal a > 0.
+     */
+    inline vfloat rsqrt(vfloat a)
+    {
+        const vfloat lHalfA = set1(0.5f) * a;
+        const vfloat lThreeHalves = set1(1.5f);
+        vfloat lEstimate = rsqrtEstimate(a);
+#if FBU_SIMD_USE_NEON
+        lEstimate = lEstimate * (lThreeHalves - lHalfA * lEstimate * lEstimate);
+#endif
+        return lEstimate * (lThreeHalves - lHalfA * lEstimate * lEstimate);
+    }
+
+    //==============================================================================
+    // Doubles, two lanes
+
+    inline vdouble load(const double* p)
+    {
+#if FBU_SIMD_DOUBLE_USE_SSE
+        return {_mm_loadu_pd(p)};
+#elif FBU_SIMD_DOUBLE_USE_NEON
+        return {vld1q_f64(p)};
+#else
+        vdouble r;
+        std::memcpy(r.v, p, sizeof(r.v));
+        return r;
+#endif
+    }
+
+    inline void store(double* p, vdouble a)
+    {
+#if FBU_SIMD_DOUBLE_USE_SSE
+        _mm_storeu_pd(p, a.v);
+#elif FBU_SIMD_DOUBLE_USE_NEON
+        vst1q_f64(p, a.v);
+#else
+        std::memcpy(p, a.v, sizeof(a.v));
+#endif
+    }
+
+    inline vdouble set1Double(double s)
+    {
+#if FBU_SIMD_DOUBLE_USE_SSE
+        return {_mm_set1_pd(s)};
+#elif FBU_SIMD_DOUBLE_USE_NEON
+        return {vdupq_n_f64(s)};
+#else
+        vdouble r;
+        for (int i = 0 ; i != kDoubleLanes ; ++i) r.v[i] = s;
+        return r;
+#endif
+    }
+
+#if FBU_SIMD_DOUBLE_USE_SSE
+#define FBU_SIMD_DOUBLE_BINOP(OP, SSE, NEON, EXPR) \
+    inline vdouble OP(vdouble a, vdouble b) { return {SSE(a.v, b.v)}; }
+#elif FBU_SIMD_DOUBLE_USE_NEON
+#define FBU_SIMD_DOUBLE_BINOP(OP, SSE, NEON, EXPR) \
+    inline vdouble OP(vdouble a, vdouble b) { return {NEON(a.v, b.v)}; }
+#else
+#define FBU_SIMD_DOUBLE_BINOP(OP, SSE, NEON, EXPR) \
+    inline vdouble OP(vdouble a, vdouble b) \
+    { \
+        vdouble r; \
+        for (int i = 0 ; i != kDoubleLanes ; ++i) { double x = a.v[i], y = b.v[i]; r.v[i] = (EXPR); } \
+        return r; \
+    }
+#endif
+
+    FBU_SIMD_DOUBLE_BINOP(operator+, _mm_add_pd, vaddq_f64, x + y)
+    FBU_SIMD_DOUBLE_BINOP(operator-, _mm_sub_pd, vsubq_f64, x - y)
+    FBU_SIMD_DOUBLE_BINOP(operator*, _mm_mul_pd, vmulq_f64, x * y)
+    FBU_SIMD_DOUBLE_BINOP(operator/, _mm_div_pd, vdivq_f64, x / y)
+    FBU_SIMD_DOUBLE_BINOP(min, _mm_min_pd, vminq_f64, (x < y) ? x : y)
+    FBU_SIMD_DOUBLE_BINOP(max, _mm_max_pd, vmaxq_f64, (x > y) ? x : y)
+
+#undef FBU_SIMD_DOUBLE_BINOP
+
+    /**
+     a * b + c, fused when the platform has it.
+     */
+    inline vdouble mulAdd(vdouble a, vdouble b, vdouble c)
+    {
+#if FBU_SIMD_DOUBLE_USE_SSE && defined(__FMA__)
+        return {_mm_fmadd_pd(a.v, b.v, c.v)};
+#elif FBU_SIMD_DOUBLE_USE_NEON
+        return {vfmaq_f64(c.v, a.v, b.v)};
+#else
+        return a * b + c;
+#endif
+    }
+
+#if FBU_SIMD_DOUBLE_USE_SSE
+#define FBU_SIMD_DOUBLE_CMP(OP, SSE, NEON) \
+    inline vdmask operator OP(vdouble a, vdouble b) { return {SSE(a.v, b.v)}; }
+#elif FBU_SIMD_DOUBLE_USE_NEON
+#define FBU_SIMD_DOUBLE_CMP(OP, SSE, NEON) \
+    inline vdmask operator OP(vdouble a, vdouble b) { return {NEON(a.v, b.v)}; }
+#else
+#define FBU_SIMD_DOUBLE_CMP(OP, SSE, NEON) \
+    inline vdmask operator OP(vdouble a, vdouble b) \
+    { \
+        vdmask r; \
+        for (int i = 0 ; i != kDoubleLanes ; ++i) r.v[i] = (a.v[i] OP b.v[i]) ? ~(uint64_t)0 : 0u; \
+        return r; \
+    }
+#endif
+
+    FBU_SIMD_DOUBLE_CMP(<,  _mm_cmplt_pd, vcltq_f64)
+    FBU_SIMD_DOUBLE_CMP(<=, _mm_cmple_pd, vcleq_f64)
+    FBU_SIMD_DOUBLE_CMP(>,  _mm_cmpgt_pd, vcgtq_f64)
+    FBU_SIMD_DOUBLE_CMP(>=, _mm_cmpge_pd, vcgeq_f64)
+    FBU_SIMD_DOUBLE_CMP(==, _mm_cmpeq_pd, vceqq_f64)
+
+#undef FBU_SIMD_DOUBLE_CMP
+
+    /**
+     Per lane: pMask ? pTrue : pFalse
+     */
+    inline vdouble select(vdmask pMask, vdouble pTrue, vdouble pFalse)
+    {
+#if FBU_SIMD_DOUBLE_USE_SSE
+        return {_mm_or_pd(_mm_and_pd(pMask.v, pTrue.v), _mm_andnot_pd(pMask.v, pFalse.v))};
+#elif FBU_SIMD_DOUBLE_USE_NEON
+        return {vbslq_f64(pMask.v, pTrue.v, pFalse.v)};
+#else
+        vdouble r;
+        for (int i = 0 ; i != kDoubleLanes ; ++i) r.v[i] = pMask.v[i] ? pTrue.v[i] : pFalse.v[i];
+        return r;
+#endif
+    }
+
+    /**
+     One bit per lane, lane 0 in the LSB.
+     */
+    inline int moveMask(vdmask pMask)
+    {
+#if FBU_SIMD_DOUBLE_USE_SSE
+        return _mm_movemask_pd(pMask.v);
+#elif FBU_SIMD_DOUBLE_USE_NEON
+        return (int)(vgetq_lane_u64(pMask.v, 0) >> 63) | (int)((vgetq_lane_u64(pMask.v, 1) >> 63) << 1);
+#else
+        int lResult = 0;
+        for (int i = 0 ; i != kDoubleLanes ; ++i) lResult |= (int)(pMask.v[i] >> 63) << i;
+        return lResult;
+#endif
+    }
+
+    inline vdouble abs(vdouble a)
+    {
+#if FBU_SIMD_DOUBLE_USE_SSE
+        return {_mm_andnot_pd(_mm_set1_pd(-0.), a.v)};
+#elif FBU_SIMD_DOUBLE_USE_NEON
+        return {vabsq_f64(a.v)};
+#else
+        vdouble r;
+        for (int i = 0 ; i != kDoubleLanes ; ++i) r.v[i] = std::abs(a.v[i]);
+        return r;
+#endif
+    }
+
+    //==============================================================================
+    // Small integers, e.g. 8-bit level maps and 16-bit samples. The arithmetics
+    // saturate (paddusb/psubusb, paddsw/psubsw, vqadd/vqsub) unless stated.
+
+    inline vuint8 load(const uint8_t* p)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))};
+#elif FBU_SIMD_USE_NEON
+        return {vld1q_u8(p)};
+#else
+        vuint8 r;
+        std::memcpy(r.v, p, sizeof(r.v));
+        return r;
+#endif
+    }
+
+    inline void store(uint8_t* p, vuint8 a)
+    {
+#if FBU_SIMD_USE_SSE
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a.v);
+#elif FBU_SIMD_USE_NEON
+        vst1q_u8(p, a.v);
+#else
+        std::memcpy(p, a.v, sizeof(a.v));
+#endif
+    }
+
+    inline vint16 load(const int16_t* p)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))};
+#elif FBU_SIMD_USE_NEON
+        return {vld1q_s16(p)};
+#else
+        vint16 r;
+        std::memcpy(r.v, p, sizeof(r.v));
+        return r;
+#endif
+    }
+
+    inline void store(int16_t* p, vint16 a)
+    {
+#if FBU_SIMD_USE_SSE
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a.v);
+#elif FBU_SIMD_USE_NEON
+        vst1q_s16(p, a.v);
+#else
+        std::memcpy(p, a.v, sizeof(a.v));
+#endif
+    }
+
+    inline vuint8 set1Uint8(uint8_t s)
+    {
+#if FBU_SIMD_USE_SSE
+        return {_mm_set1_epi8((char)s)};
+#elif FBU_SIMD_USE_NEON
+        return {vdupq_n_u8(s)};
+#else
+        vuint8 r;
+        for (int i = 0 ; i != kUint8Lanes ; ++i) r.v[i] = s;
+        return r;
+#endif
+    }
+
+#if FBU_SIMD_USE_SSE
+#define FBU_SIMD_SMALL_INT_BINOP(TYPE, LANE, LANES, OP, SSE, NEON, EXPR) \
+    inline TYPE OP(TYPE a, TYPE b) { return {SSE(a.v, b.v)}; }
+#elif FBU_SIMD_USE_NEON
+#define FBU_SIMD_SMALL_INT_BINOP(TYPE, LANE, LANES, OP, SSE, NEON, EXPR) \
+    inline TYPE OP(TYPE a, TYPE b) { return {NEON(a.v, b.v)}; }
+#else
+#define FBU_SIMD_SMALL_INT_BINOP(TYPE, LANE, LANES, OP, SSE, NEON, EXPR) \
+    inline TYPE OP(TYPE a, TYPE b) \
+    { \
+        TYPE r; \
+        for (int i = 0 ; i != LANES ; ++i) { int x = a.v[i], y = b.v[i]; r.v[i] = (LANE)(EXPR); } \
+        return r; \
+    }
+#endif
+
+    FBU_SIMD_SMALL_INT_BINOP(vuint8, uint8_t, kUint8Lanes, addSaturate, _mm_adds_epu8, vqaddq_u8, x + y > 255 ? 255 : x + y)
+    FBU_SIMD_SMALL_INT_BINOP(vuint8, uint8_t, kUint8Lanes, subSaturate, _mm_subs_epu8, vqsubq_u8, x - y < 0 ? 0 : x - y)
+    FBU_SIMD_SMALL_INT_BINOP(vuint8, uint8_t, kUint8Lanes, min, _mm_min_epu8, vminq_u8, y < x ? y : x)
+    FBU_SIMD_SMALL_INT_BINOP(vuint8, uint8_t, kUint8Lanes, max, _mm_max_epu8, vmaxq_u8, y > x ? y : x)
+    /// modulo 256
+    FBU_SIMD_SMALL_INT_BINOP(vuint8, uint8_t, kUint8Lanes, operator+, _mm_add_epi8, vaddq_u8, x + y)
+    FBU_SIMD_SMALL_INT_BINOP(vuint8, uint8_t, kUint8Lanes, operator-, _mm_sub_epi8, vsubq_u8, x - y)
+    /// 255 in the lanes where equal, 0 elsewhere
+    FBU_SIMD_SMALL_INT_BINOP(vuint8, uint8_t, kUint8Lanes, operator==, _mm_cmpeq_epi8, vceqq_u8, x == y ? 255 : 0)
+    FBU_SIMD_SMALL_INT_BINOP(vint16, int16_t, kInt16Lanes, addSaturate, _mm_adds_epi16, vqaddq_s16,
+                             x + y > 32767 ? 32767 : (x + y < -32768 ? -32768 : x + y))
+    FBU_SIMD_SMALL_INT_BINOP(vint16, int16_t, kInt16Lanes, subSaturate, _mm_subs_epi16, vqsubq_s16,
+                             x - y > 32767 ? 32767 : (x - y < -32768 ? -32768 : x - y))
+
+#undef FBU_SIMD_SMALL_INT_BINOP
+
+    //==============================================================================
+    // Misc
+
+    inline vfloat abs(vfloat a)
+    {
+        return asFloat(asInt(a) & set1Int(0x7FFFFFFF));
+    }
+
+    /**
+     Magnitude of pMagnitude with the sign of pSign.
+     */
+    inline vfloat copySign(vfloat pMagnitude, vfloat pSign)
+    {
+        return asFloat((asInt(pMagnitude) & set1Int(0x7FFFFFFF))
+                       | (asInt(pSign) & set1Int((int32_t)0x80000000u)));
+    }
+
+    /**
+     The first lane.
+     */
+    inline float first(vfloat a)
+    {
+#if FBU_SIMD_USE_SSE
+        return _mm_cvtss_f32(a.v);
+#elif FBU_SIMD_USE_NEON
+        return vgetq_lane_f32(a.v, 0);
+#else
+        return a.v[0];
+#endif
+    }
+
+    inline float hsum(vfloat a)
+    {
+        float lA[kFloatLanes];
+        store(lA, a);
+        float lSum = 0.f;
+        for (int i = 0 ; i != kFloatLanes ; ++i) lSum += lA[i];
+        return lSum;
+    }
+
+    inline float hmin(vfloat a)
+    {
+        float lA[kFloatLanes];
+        store(lA, a);
+        float lMin = lA[0];
+        for (int i = 1 ; i != kFloatLanes ; ++i) lMin = lA[i] < lMin ? lA[i] : lMin;
+        return lMin;
+    }
+
+    inline float hmax(vfloat a)
+    {
+        float lA[kFloatLanes];
+        store(lA, a);
+        float lMax = lA[0];
+        for (int i = 1 ; i != kFloatLanes ; ++i) lMax = lA[i] > lMax ? lA[i] : lMax;
+        return lMax;
+    }
+
+    //==============================================================================
+    /**
+     @class AlignedAllocator
+     @brief Standard allocator returning memory aligned on Alignment bytes, so
+            that the buffers start on a vector register / cache line boundary.
+     */
+    template <typename T, size_t Alignment = 64>
+    class AlignedAllocator
+    {
+    public:
+        typedef T value_type;
+
+        template <typename U>
+        struct rebind
+        {
+            typedef AlignedAllocator<U, Alignment> other;
+        };
+
+        AlignedAllocator() = default;
+
+        template <typename U>
+        AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+        T* allocate(size_t pNum)
+        {
+            // over-allocate and keep the original pointer right before the aligned block
+            void* lRaw = ::operator new(pNum * sizeof(T) + Alignment + sizeof(void*));
+            uintptr_t lAligned = ((uintptr_t)lRaw + sizeof(void*) + Alignment - 1) & ~(uintptr_t)(Alignment - 1);
+            reinterpret_cast<void**>(lAligned)[-1] = lRaw;
+            return reinterpret_cast<T*>(lAligned);
+        }
+
+        void deallocate(T* p, size_t)
+        {
+            ::operator delete(reinterpret_cast<void**>(p)[-1]);
+        }
+    };
+
+    template <typename T, typename U, size_t Alignment>
+    bool operator==(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&)
+    {
+        return true;
+    }
+
+    template <typename T, typename U, size_t Alignment>
+    bool operator!=(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&)
+    {
+        return false;
+    }
+
+    template <typename T>
+    using AlignedVector = std::vector< T, AlignedAllocator<T> >;
+}
+}
+
+#endif
@@ -26,6 +26,8 @@ SOFTWARE.
 */
 
 #include "fbu/simple_meter.hpp"
+#include "fbu/lookup_table.hpp"
+#include "fbu/math_utils.hpp"
 
 //==============================================================================
 SimpleMeter::SimpleMeter(String pName)
@@ -74,8 +76,9 @@ float SimpleMeter::getPeakAmplitudeAndReset()
 float SimpleMeter::getPeakDBAndReset()
 {
     float lPeak = getPeakAmplitudeAndReset();
-    float lPeakDB = 20.f * std::log10(lPeak);
-    if (lPeakDB < -144.f || !std::isnormal(lPeakDB))
+    float lPeakDB = mu::lookupGainToDB(lPeak);
+    // also catches -inf for a silent block; 0 dB is a valid peak
+    if (! (lPeakDB >= -144.f))
     {
         lPeakDB = -144.f;
     }
@@ -136,7 +139,7 @@ void SimpleMeterComponent::paint (Graphics& g)
     }
     
     float lNormalizedPeakDB = (mPeakDB + 144.f)/144.f;
-    float lSkewed = std::pow(lNormalizedPeakDB, 4.f);
+    float lSkewed = mu::square(mu::square(lNormalizedPeakDB));
     float lHeight = lSkewed * getHeight();
     
 #if 0
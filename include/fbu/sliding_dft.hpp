@@ -0,0 +1,342 @@
+#ifndef FBU_SLIDING_DFT_HPP_INCLUDED
+#define FBU_SLIDING_DFT_HPP_INCLUDED
+
+/**
+ @file sliding_dft.hpp
+ @author François Becker
+
+MIT License
+
+Copyright (c) 2018 François Becker
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "fbu/complex.hpp"
+#include "fbu/sad.hpp"
+#include "fbu/simd.hpp"
+
+#include <vector>
+#include <cassert>
+
+namespace fbu
+{
+    /**
+     Round pNum up to a multiple of the number of SIMD float lanes.
+     */
+    inline int paddedToLanes(int pNum)
+    {
+        return (pNum + simd::kFloatLanes - 1) / simd::kFloatLanes * simd::kFloatLanes;
+    }
+
+    //==============================================================================
+    /**
+     @class SlidingDftBank
+     @brief Tracks a set of DFT bins over a sliding window of N samples, updated
+            every sample in O(1) per bin.
+
+     Each bin k (possibly fractional) follows the damped recursion
+        X[n] = W (X[n-1] + x[n] - W^N x[n-N]),  W = r e^(j 2π k / N)
+     so that X[n] = Σ_{m=0..N-1} W^(m+1) x[n-m]. With r = 1 this is exactly the
+     DFT of the last N samples, but rounding errors accumulate forever; with
+     r slightly below 1 (the default) the errors decay and the window gets a
+     slight exponential taper.
+     The bins are stored as structure of arrays and updated with SIMD.
+     */
+    template <typename T>
+    class SlidingDftBank
+    {
+    public:
+        /**
+         Constructor.
+         @param pWindowSize The sliding window length N.
+         @param pBins The bin indices, frequency = bin * sampleRate / N.
+         @param pNumBins The number of bins.
+         @param pDamping The damping factor r, in (0, 1].
+         */
+        SlidingDftBank(int pWindowSize, const T* pBins, int pNumBins, T pDamping = (T)0.99999)
+        : mWindowSize(pWindowSize)
+        , mNumBins(pNumBins)
+        , mNumPaddedBins(paddedToLanes(pNumBins))
+        , mDelayLine((size_t)pWindowSize, (T)0)
+        , mDelayPosition(0)
+        {
+            assert(pWindowSize > 0);
+            assert(pDamping > (T)0 && pDamping <= (T)1);
+            for (std::vector<T>* lArray : {&mRe, &mIm, &mWRe, &mWIm, &mCombRe, &mCombIm})
+            {
+                lArray->assign((size_t)mNumPaddedBins, (T)0);
+            }
+            double lDampingN = std::pow((double)pDamping, (double)pWindowSize);
+            for (int k = 0 ; k != pNumBins ; ++k)
+            {
+                double lOmega = 2. * M_PI * (double)pBins[k] / (double)pWindowSize;
+                mWRe[(size_t)k] = (T)(pDamping * std::cos(lOmega));
+                mWIm[(size_t)k] = (T)(pDamping * std::sin(lOmega));
+                mCombRe[(size_t)k] = (T)(lDampingN * std::cos(lOmega * pWindowSize));
+                mCombIm[(size_t)k] = (T)(lDampingN * std::sin(lOmega * pWindowSize));
+            }
+        }
+
+        /**
+         Clear the window and the bins.
+         */
+        void reset()
+        {
+            std::fill(mDelayLine.begin(), mDelayLine.end(), (T)0);
+            std::fill(mRe.begin(), mRe.end(), (T)0);
+            std::fill(mIm.begin(), mIm.end(), (T)0);
+            mDelayPosition = 0;
+        }
+
+        /**
+         Push samples, all the bins are updated for every sample.
+         */
+        void process(const T* pIn, SampleCount pNumSamples)
+        {
+            for (SampleCount n = 0 ; n != pNumSamples ; ++n)
+            {
+                T lOldest = mDelayLine[(size_t)mDelayPosition];
+                mDelayLine[(size_t)mDelayPosition] = pIn[n];
+                if (++mDelayPosition == mWindowSize)
+                {
+                    mDelayPosition = 0;
+                }
+                updateBins(pIn[n], lOldest);
+            }
+        }
+
+        int getNumBins() const
+        {
+            return mNumBins;
+        }
+
+        int getWindowSize() const
+        {
+            return mWindowSize;
+        }
+
+        Complex<T> getBin(int pBin) const
+        {
+            assert(pBin >= 0 && pBin < mNumBins);
+            return {mRe[(size_t)pBin], mIm[(size_t)pBin]};
+        }
+
+        T getMagnitude(int pBin) const
+        {
+            return getBin(pBin).mag();
+        }
+
+        void getBins(Complex<T>* pOut) const
+        {
+            for (int k = 0 ; k != mNumBins ; ++k)
+            {
+                pOut[k] = getBin(k);
+            }
+        }
+
+    private:
+        void updateBins(T pNewest, T pOldest)
+        {
+            for (int k = 0 ; k != mNumPaddedBins ; ++k)
+            {
+                size_t u = (size_t)k;
+                T a = mRe[u] + pNewest - mCombRe[u] * pOldest;
+                T b = mIm[u] - mCombIm[u] * pOldest;
+                mRe[u] = mWRe[u] * a - mWIm[u] * b;
+                mIm[u] = mWRe[u] * b + mWIm[u] * a;
+            }
+        }
+
+        int            mWindowSize;
+        int            mNumBins;
+        int            mNumPaddedBins;
+        std::vector<T> mRe, mIm;
+        std::vector<T> mWRe, mWIm;
+        std::vector<T> mCombRe, mCombIm;
+        std::vector<T> mDelayLine;
+        int            mDelayPosition;
+    };
+
+    template <>
+    inline void SlidingDftBank<float>::updateBins(float pNewest, float pOldest)
+    {
+        const simd::vfloat lNewest = simd::set1(pNewest);
+        const simd::vfloat lOldest = simd::set1(pOldest);
+        for (int k = 0 ; k != mNumPaddedBins ; k += simd::kFloatLanes)
+        {
+            size_t u = (size_t)k;
+            simd::vfloat lRe = simd::load(&mRe[u]);
+            simd::vfloat lIm = simd::load(&mIm[u]);
+            simd::vfloat lWRe = simd::load(&mWRe[u]);
+            simd::vfloat lWIm = simd::load(&mWIm[u]);
+            simd::vfloat a = lRe + lNewest - simd::load(&mCombRe[u]) * lOldest;
+            simd::vfloat b = lIm - simd::load(&mCombIm[u]) * lOldest;
+            simd::store(&mRe[u], lWRe * a - lWIm * b);
+            simd::store(&mIm[u], lWRe * b + lWIm * a);
+        }
+    }
+
+    //==============================================================================
+    /**
+     @class GoertzelBank
+     @brief Batched Goertzel detector: measures the power of a set of bins over
+            consecutive blocks of N samples.
+
+     Each bin runs the damped resonator s[n] = x[n] + 2 r cos(ω) s[n-1] - r² s[n-2]
+     and at the end of every block the power
+        |X|² = s1² + r² s2² - 2 r cos(ω) s1 s2
+     is latched and the resonators are cleared. The bins are stored as structure
+     of arrays and updated with SIMD.
+     */
+    template <typename T>
+    class GoertzelBank
+    {
+    public:
+        /**
+         Constructor.
+         @param pBlockSize The detection block length N.
+         @param pBins The bin indices, frequency = bin * sampleRate / N.
+         @param pNumBins The number of bins.
+         @param pDamping The damping factor r, in (0, 1].
+         */
+        GoertzelBank(int pBlockSize, const T* pBins, int pNumBins, T pDamping = (T)1)
+        : mBlockSize(pBlockSize)
+        , mNumBins(pNumBins)
+        , mNumPaddedBins(paddedToLanes(pNumBins))
+        , mDamping(pDamping)
+        , mCount(0)
+        , mNumCompletedBlocks(0)
+        {
+            assert(pBlockSize > 0);
+            assert(pDamping > (T)0 && pDamping <= (T)1);
+            for (std::vector<T>* lArray : {&mS1, &mS2, &mCoeffs, &mPowers})
+            {
+                lArray->assign((size_t)mNumPaddedBins, (T)0);
+            }
+            for (int k = 0 ; k != pNumBins ; ++k)
+            {
+                double lOmega = 2. * M_PI * (double)pBins[k] / (double)pBlockSize;
+                mCoeffs[(size_t)k] = (T)(2. * pDamping * std::cos(lOmega));
+            }
+        }
+
+        void reset()
+        {
+            std::fill(mS1.begin(), mS1.end(), (T)0);
+            std::fill(mS2.begin(), mS2.end(), (T)0);
+            std::fill(mPowers.begin(), mPowers.end(), (T)0);
+            mCount = 0;
+            mNumCompletedBlocks = 0;
+        }
+
+        /**
+         Push samples. The powers are updated each time a block is completed.
+         */
+        void process(const T* pIn, SampleCount pNumSamples)
+        {
+            for (SampleCount n = 0 ; n != pNumSamples ; ++n)
+            {
+                updateBins(pIn[n]);
+                if (++mCount == mBlockSize)
+                {
+                    latchPowers();
+                    mCount = 0;
+                    ++mNumCompletedBlocks;
+                }
+            }
+        }
+
+        /**
+         The power of a bin over the last completed block.
+         */
+        T getPower(int pBin) const
+        {
+            assert(pBin >= 0 && pBin < mNumBins);
+            return mPowers[(size_t)pBin];
+        }
+
+        const T* getPowers() const
+        {
+            return mPowers.data();
+        }
+
+        int getNumCompletedBlocks() const
+        {
+            return mNumCompletedBlocks;
+        }
+
+        int getNumBins() const
+        {
+            return mNumBins;
+        }
+
+    private:
+        void updateBins(T pSample)
+        {
+            const T lDamping2 = mDamping * mDamping;
+            for (int k = 0 ; k != mNumPaddedBins ; ++k)
+            {
+                size_t u = (size_t)k;
+                T s = pSample + mCoeffs[u] * mS1[u] - lDamping2 * mS2[u];
+                mS2[u] = mS1[u];
+                mS1[u] = s;
+            }
+        }
+
+        void latchPowers()
+        {
+            const T lDamping2 = mDamping * mDamping;
+            for (int k = 0 ; k != mNumPaddedBins ; ++k)
+            {
+                size_t u = (size_t)k;
+                mPowers[u] = mS1[u] * mS1[u] + lDamping2 * mS2[u] * mS2[u] - mCoeffs[u] * mS1[u] * mS2[u];
+                mS1[u] = (T)0;
+                mS2[u] = (T)0;
+            }
+        }
+
+        int            mBlockSize;
+        int            mNumBins;
+        int            mNumPaddedBins;
+        T              mDamping;
+        int            mCount;
+        int            mNumCompletedBlocks;
+        std::vector<T> mS1, mS2;
+        std::vector<T> mCoeffs;
+        std::vector<T> mPowers;
+    };
+
+    template <>
+    inline void GoertzelBank<float>::updateBins(float pSample)
+    {
+        const simd::vfloat lSample = simd::set1(pSample);
+        const simd::vfloat lDamping2 = simd::set1(mDamping * mDamping);
+        for (int k = 0 ; k != mNumPaddedBins ; k += simd::kFloatLanes)
+        {
+            size_t u = (size_t)k;
+            simd::vfloat lS1 = simd::load(&mS1[u]);
+            simd::vfloat s = lSample + simd::load(&mCoeffs[u]) * lS1 - lDamping2 * simd::load(&mS2[u]);
+            simd::store(&mS2[u], lS1);
+            simd::store(&mS1[u], s);
+        }
+    }
+}
+
+#endif
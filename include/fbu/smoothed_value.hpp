@@ -0,0 +1,686 @@
+#ifndef FBU_SMOOTHED_VALUE_HPP_INCLUDED
+#define FBU_SMOOTHED_VALUE_HPP_INCLUDED
+
+/**
+ @file smoothed_value.hpp
+ @author François Becker
+
+MIT License
+
+Copyright (c) 2018 François Becker
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "fbu/math_utils.hpp"
+#include "fbu/simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/*
+ Parameter smoothing. A ramp toward the target lasts a known number of steps,
+ after which the value is exactly the target and the smoother is settled: the
+ ramps are then plain fills, and nothing is computed.
+
+ The value after k steps of a ramp is a combination of the current value, the
+ target and a progress, which is either step * k (Linear, Angle) or step^k
+ (Multiplicative, OnePole). The ramps are generated by vectors, and
+ SmoothedValueBank advances many parameters at once, by vectors of parameters.
+ */
+
+namespace fbu
+{
+    namespace smoothing
+    {
+        namespace detail
+        {
+            using namespace fbu::simd;
+
+            /** Progress step * k */
+            struct ArithmeticProgress
+            {
+                static float at(float pStep, int pK)
+                {
+                    return pStep * (float)pK;
+                }
+
+                static vfloat at(vfloat pStep, vint pK, int /*pMaxK*/)
+                {
+                    return toFloat(pK) * pStep;
+                }
+
+                /** pOut[u] = the value after u + 1 steps */
+                template <class Smoothing>
+                static void ramp(float pCurrent, float pTarget, float pStep, float* pOut, size_t pNum)
+                {
+                    const float lFirstSteps[kFloatLanes] = {1.f, 2.f, 3.f, 4.f};
+                    const vfloat lCurrent = set1(pCurrent);
+                    const vfloat lTarget = set1(pTarget);
+                    const vfloat lStep = set1(pStep);
+                    const vfloat lStride = set1((float)kFloatLanes);
+                    vfloat lK = load(lFirstSteps);
+                    size_t u = 0;
+                    for ( ; u + (size_t)kFloatLanes <= pNum ; u += (size_t)kFloatLanes)
+                    {
+                        store(pOut + u, Smoothing::combine(lCurrent, lTarget, lK * lStep));
+                        lK += lStride;
+                    }
+                    const size_t lNumLeft = pNum - u;
+                    for (size_t k = 0 ; k < lNumLeft ; ++k)
+                    {
+                        pOut[u + k] = Smoothing::combine(pCurrent, pTarget, at(pStep, (int)(u + k + 1)));
+                    }
+                }
+            };
+
+            /** Progress step^k */
+            struct GeometricProgress
+            {
+                static float at(float pStep, int pK)
+                {
+                    return pK == 1 ? pStep : (float)std::pow((double)pStep, pK);
+                }
+
+                /** By squaring, pMaxK being the largest k of the lanes. */
+                static vfloat at(vfloat pStep, vint pK, int pMaxK)
+                {
+                    vfloat lPower = set1(1.f);
+                    vfloat lBase = pStep;
+                    for (int b = 0 ; (pMaxK >> b) != 0 ; ++b)
+                    {
+                        const vint lBit = set1Int(1 << b);
+                        lPower = select((pK & lBit) == lBit, lPower * lBase, lPower);
+                        lBase *= lBase;
+                    }
+                    return lPower;
+                }
+
+                /**
+                 pOut[u] = the value after u + 1 steps. The powers are
+                 multiplied by step^4 from vector to vector, and recomputed
+                 every kAnchorInterval values so that the rounding errors do
+                 not pile up.
+                 */
+                template <class Smoothing>
+                static void ramp(float pCurrent, float pTarget, float pStep, float* pOut, size_t pNum)
+                {
+                    const size_t kAnchorInterval = 64;
+                    const double lStep = (double)pStep;
+                    const float lFirstPowers[kFloatLanes] = {pStep, (float)(lStep * lStep), (float)(lStep * lStep * lStep), (float)(lStep * lStep * lStep * lStep)};
+                    const vfloat lFirstPowersV = load(lFirstPowers);
+                    const vfloat lStride = set1(lFirstPowers[kFloatLanes - 1]);
+                    const vfloat lCurrent = set1(pCurrent);
+                    const vfloat lTarget = set1(pTarget);
+                    size_t u = 0;
+                    while (u + (size_t)kFloatLanes <= pNum)
+                    {
+                        const size_t lEnd = std::min(pNum, u + kAnchorInterval);
+                        vfloat lPowers = set1(at(pStep, (int)u)) * lFirstPowersV;
+                        for ( ; u + (size_t)kFloatLanes <= lEnd ; u += (size_t)kFloatLanes)
+                        {
+                            store(pOut + u, Smoothing::combine(lCurrent, lTarget, lPowers));
+                            lPowers *= lStride;
+                        }
+                    }
+                    const size_t lNumLeft = pNum - u;
+                    for (size_t k = 0 ; k < lNumLeft ; ++k)
+                    {
+                        pOut[u + k] = Smoothing::combine(pCurrent, pTarget, at(pStep, (int)(u + k + 1)));
+                    }
+                }
+            };
+        }
+
+        //==============================================================================
+        /**
+         Linear ramps, of setRampLength() steps.
+         */
+        struct Linear
+        {
+            typedef detail::ArithmeticProgress Progress;
+
+            static float normalize(float pValue)
+            {
+                return pValue;
+            }
+
+            static float start(float pCurrent)
+            {
+                return pCurrent;
+            }
+
+            static float step(float pCurrent, float pTarget, int pRampLength)
+            {
+                return (pTarget - pCurrent) / (float)pRampLength;
+            }
+
+            static int numSteps(float /*pCurrent*/, float /*pTarget*/, float /*pStep*/, int pRampLength)
+            {
+                return pRampLength;
+            }
+
+            template <typename V>
+            static V combine(V pCurrent, V /*pTarget*/, V pProgress)
+            {
+                return pCurrent + pProgress;
+            }
+        };
+
+        //==============================================================================
+        /**
+         Exponential ramps, of setRampLength() steps: linear in dB, for gains.
+         The values are >= 0, and the ramps start from or aim at kMinimum
+         (-120 dB) instead of 0.
+         */
+        struct Multiplicative
+        {
+            typedef detail::GeometricProgress Progress;
+
+            static constexpr float kMinimum = 1e-6f;
+
+            static float normalize(float pValue)
+            {
+                assert(pValue >= 0.f);
+                return pValue;
+            }
+
+            static float start(float pCurrent)
+            {
+                return pCurrent > kMinimum ? pCurrent : kMinimum;
+            }
+
+            static float step(float pCurrent, float pTarget, int pRampLength)
+            {
+                return (float)std::pow((double)(pTarget > kMinimum ? pTarget : kMinimum) / (double)pCurrent, 1. / (double)pRampLength);
+            }
+
+            static int numSteps(float /*pCurrent*/, float /*pTarget*/, float /*pStep*/, int pRampLength)
+            {
+                return pRampLength;
+            }
+
+            template <typename V>
+            static V combine(V pCurrent, V /*pTarget*/, V pProgress)
+            {
+                return pCurrent * pProgress;
+            }
+        };
+
+        //==============================================================================
+        /**
+         One-pole smoothing, y += (1 - step) (target - y), the ramp length
+         being the time constant in samples (see mu::ExponentialMovingAverage).
+         It settles when the distance to the target is below kTolerance
+         (1 + |target|).
+         */
+        struct OnePole
+        {
+            typedef detail::GeometricProgress Progress;
+
+            static constexpr float kTolerance = 1e-5f;
+
+            static float normalize(float pValue)
+            {
+                return pValue;
+            }
+
+            static float start(float pCurrent)
+            {
+                return pCurrent;
+            }
+
+            static float step(float /*pCurrent*/, float /*pTarget*/, int pRampLength)
+            {
+                return (float)std::exp(-1. / (double)pRampLength);
+            }
+
+            static int numSteps(float pCurrent, float pTarget, float pStep, int /*pRampLength*/)
+            {
+                const double lDistance = std::abs((double)pCurrent - (double)pTarget);
+                const double lTolerance = (double)kTolerance * (1. + std::abs((double)pTarget));
+                if (lDistance <= lTolerance)
+                {
+                    return 0;
+                }
+                const double lNumSteps = std::ceil(std::log(lTolerance / lDistance) / std::log((double)pStep));
+                return lNumSteps < 1. ? 1 : (int)std::min(lNumSteps, (double)(std::numeric_limits<int32_t>::max() / 2));
+            }
+
+            template <typename V>
+            static V combine(V pCurrent, V pTarget, V pProgress)
+            {
+                return pTarget + (pCurrent - pTarget) * pProgress;
+            }
+        };
+
+        //==============================================================================
+        /**
+         Linear ramps of angles in radians, along the shortest arc, of
+         setRampLength() steps. The values are in )-π,π), as mu::domainAngle().
+         */
+        struct Angle
+        {
+            typedef detail::ArithmeticProgress Progress;
+
+            static float normalize(float pValue)
+            {
+                return mu::domainAngle(pValue);
+            }
+
+            static float start(float pCurrent)
+            {
+                return pCurrent;
+            }
+
+            static float step(float pCurrent, float pTarget, int pRampLength)
+            {
+                return mu::domainAngle(pTarget - pCurrent) / (float)pRampLength;
+            }
+
+            static int numSteps(float /*pCurrent*/, float /*pTarget*/, float /*pStep*/, int pRampLength)
+            {
+                return pRampLength;
+            }
+
+            static float combine(float pCurrent, float /*pTarget*/, float pProgress)
+            {
+                return mu::domainAngleSimple(pCurrent + pProgress);
+            }
+
+            static simd::vfloat combine(simd::vfloat pCurrent, simd::vfloat /*pTarget*/, simd::vfloat pProgress)
+            {
+                using namespace fbu::simd;
+                const vfloat lPi = set1(M_PIf);
+                const vfloat lTwoPi = set1(2.f * M_PIf);
+                const vfloat lAngle = pCurrent + pProgress;
+                return select(lAngle > lPi, lAngle - lTwoPi, select(lAngle <= -lPi, lAngle + lTwoPi, lAngle));
+            }
+        };
+    }
+
+    //==============================================================================
+    /**
+     @class SmoothedValue
+     @brief A value smoothed toward its target, sample by sample or by blocks.
+
+     Smoothing is one of the structs of fbu::smoothing. The ramp length is 0
+     by default: the targets are then reached immediately.
+     */
+    template <class Smoothing = smoothing::Linear>
+    class SmoothedValue
+    {
+    public:
+        explicit SmoothedValue(float pInitialValue = 0.f)
+        : mCurrent(Smoothing::normalize(pInitialValue))
+        , mTarget(mCurrent)
+        {
+        }
+
+        /**
+         The length of the next ramps, in samples. The ongoing ramp is not
+         changed.
+         */
+        void setRampLength(int pNumSamples)
+        {
+            assert(pNumSamples >= 0);
+            mRampLength = pNumSamples;
+        }
+
+        void setRampLength(double pSeconds, double pSampleRate)
+        {
+            setRampLength((int)std::lround(pSeconds * pSampleRate));
+        }
+
+        int getRampLength() const
+        {
+            return mRampLength;
+        }
+
+        /**
+         Starts a ramp from the current value.
+         */
+        void setTarget(float pTarget)
+        {
+            mTarget = Smoothing::normalize(pTarget);
+            mRemaining = 0;
+            if (mTarget != mCurrent && mRampLength > 0)
+            {
+                mCurrent = Smoothing::start(mCurrent);
+                mStep = Smoothing::step(mCurrent, mTarget, mRampLength);
+                mRemaining = Smoothing::numSteps(mCurrent, mTarget, mStep, mRampLength);
+            }
+            if (mRemaining == 0)
+            {
+                mCurrent = mTarget;
+            }
+        }
+
+        /**
+         For gains.
+         */
+        void setTargetDB(float pTargetDB)
+        {
+            setTarget(mu::dBToGain(pTargetDB));
+        }
+
+        /**
+         Jumps to the value.
+         */
+        void setCurrentAndTarget(float pValue)
+        {
+            mTarget = Smoothing::normalize(pValue);
+            mCurrent = mTarget;
+            mRemaining = 0;
+        }
+
+        float getCurrent() const
+        {
+            return mCurrent;
+        }
+
+        float getTarget() const
+        {
+            return mTarget;
+        }
+
+        bool isSmoothing() const
+        {
+            return mRemaining != 0;
+        }
+
+        int getNumRemainingSteps() const
+        {
+            return mRemaining;
+        }
+
+        float getNextValue()
+        {
+            skip(1);
+            return mCurrent;
+        }
+
+        void skip(size_t pNumSamples)
+        {
+            if (mRemaining == 0)
+            {
+                return;
+            }
+            if (pNumSamples >= (size_t)mRemaining)
+            {
+                mCurrent = mTarget;
+                mRemaining = 0;
+                return;
+            }
+            const int k = (int)pNumSamples;
+            mCurrent = Smoothing::combine(mCurrent, mTarget, Smoothing::Progress::at(mStep, k));
+            mRemaining -= k;
+        }
+
+        /**
+         The next pNumSamples values.
+         */
+        void getNextValues(float* pOut, size_t pNumSamples)
+        {
+            const size_t lNumRamp = std::min(pNumSamples, (size_t)mRemaining);
+            if (lNumRamp != 0)
+            {
+                Smoothing::Progress::template ramp<Smoothing>(mCurrent, mTarget, mStep, pOut, lNumRamp);
+                mRemaining -= (int)lNumRamp;
+                mCurrent = mRemaining == 0 ? mTarget : pOut[lNumRamp - 1];
+                pOut[lNumRamp - 1] = mCurrent;
+            }
+            std::fill(pOut + lNumRamp, pOut + pNumSamples, mTarget);
+        }
+
+        /**
+         Multiplies the samples by the next pNumSamples values, for gains.
+         Nothing is done once settled at 1.
+         */
+        void applyGain(float* pInOut, size_t pNumSamples)
+        {
+            using namespace fbu::simd;
+            const size_t kChunkSize = 256;
+            float lGains[kChunkSize];
+            size_t u = 0;
+            while (u != pNumSamples && mRemaining != 0)
+            {
+                const size_t lNum = std::min(pNumSamples - u, std::min(kChunkSize, (size_t)mRemaining));
+                getNextValues(lGains, lNum);
+                multiply(pInOut + u, lGains, lNum);
+                u += lNum;
+            }
+            if (u != pNumSamples && mTarget != 1.f)
+            {
+                const vfloat lGain = set1(mTarget);
+                for ( ; u + (size_t)kFloatLanes <= pNumSamples ; u += (size_t)kFloatLanes)
+                {
+                    store(pInOut + u, load(pInOut + u) * lGain);
+                }
+                const size_t lNumLeft = pNumSamples - u;
+                for (size_t k = 0 ; k < lNumLeft ; ++k)
+                {
+                    pInOut[u + k] *= mTarget;
+                }
+            }
+        }
+
+    private:
+        static void multiply(float* pInOut, const float* pGains, size_t pNum)
+        {
+            using namespace fbu::simd;
+            size_t u = 0;
+            for ( ; u + (size_t)kFloatLanes <= pNum ; u += (size_t)kFloatLanes)
+            {
+                store(pInOut + u, load(pInOut + u) * load(pGains + u));
+            }
+            const size_t lNumLeft = pNum - u;
+            for (size_t k = 0 ; k < lNumLeft ; ++k)
+            {
+                pInOut[u + k] *= pGains[u + k];
+            }
+        }
+
+        float mCurrent;
+        float mTarget;
+        float mStep = 0.f;
+        int mRemaining = 0;
+        int mRampLength = 0;
+    };
+
+    //==============================================================================
+    /**
+     @class SmoothedValueBank
+     @brief Many SmoothedValue, stored as arrays (SoA).
+
+     Per block: getRamp() for the values that are smoothing and need one, then
+     advance() all of them at once. The values that only change per block
+     (e.g. azimuths of sources updated once per block) can be read with
+     getCurrentValues() after advance().
+     */
+    template <class Smoothing = smoothing::Linear>
+    class SmoothedValueBank
+    {
+    public:
+        explicit SmoothedValueBank(size_t pNumValues = 0, float pInitialValue = 0.f)
+        {
+            resize(pNumValues, pInitialValue);
+        }
+
+        /**
+         The new values are set to pInitialValue.
+         */
+        void resize(size_t pNumValues, float pInitialValue = 0.f)
+        {
+            // padded to whole vectors, the padding being settled at 0
+            const size_t lLanes = (size_t)simd::kFloatLanes;
+            const size_t lPaddedSize = (pNumValues + lLanes - 1) / lLanes * lLanes;
+            const size_t lOldSize = mSize;
+            mCurrent.resize(lPaddedSize, 0.f);
+            mTarget.resize(lPaddedSize, 0.f);
+            mStep.resize(lPaddedSize, 0.f);
+            mRemaining.resize(lPaddedSize, 0);
+            mSize = pNumValues;
+            for (size_t i = lOldSize ; i < mSize ; ++i)
+            {
+                mCurrent[i] = mTarget[i] = Smoothing::normalize(pInitialValue);
+                mRemaining[i] = 0;
+            }
+            // also when shrinking: the removed values may have been smoothing
+            for (size_t i = mSize ; i < lPaddedSize ; ++i)
+            {
+                mCurrent[i] = mTarget[i] = mStep[i] = 0.f;
+                mRemaining[i] = 0;
+            }
+        }
+
+        size_t size() const
+        {
+            return mSize;
+        }
+
+        /**
+         The length of the next ramps of all the values, in samples.
+         */
+        void setRampLength(int pNumSamples)
+        {
+            assert(pNumSamples >= 0);
+            mRampLength = pNumSamples;
+        }
+
+        void setRampLength(double pSeconds, double pSampleRate)
+        {
+            setRampLength((int)std::lround(pSeconds * pSampleRate));
+        }
+
+        void setTarget(size_t pIndex, float pTarget)
+        {
+            assert(pIndex < mSize);
+            const float lTarget = Smoothing::normalize(pTarget);
+            float& lCurrent = mCurrent[pIndex];
+            mTarget[pIndex] = lTarget;
+            mRemaining[pIndex] = 0;
+            if (lTarget != lCurrent && mRampLength > 0)
+            {
+                lCurrent = Smoothing::start(lCurrent);
+                mStep[pIndex] = Smoothing::step(lCurrent, lTarget, mRampLength);
+                mRemaining[pIndex] = Smoothing::numSteps(lCurrent, lTarget, mStep[pIndex], mRampLength);
+            }
+            if (mRemaining[pIndex] == 0)
+            {
+                lCurrent = lTarget;
+            }
+        }
+
+        void setCurrentAndTarget(size_t pIndex, float pValue)
+        {
+            assert(pIndex < mSize);
+            mTarget[pIndex] = Smoothing::normalize(pValue);
+            mCurrent[pIndex] = mTarget[pIndex];
+            mRemaining[pIndex] = 0;
+        }
+
+        float getCurrent(size_t pIndex) const
+        {
+            return mCurrent[pIndex];
+        }
+
+        float getTarget(size_t pIndex) const
+        {
+            return mTarget[pIndex];
+        }
+
+        /**
+         size() values.
+         */
+        const float* getCurrentValues() const
+        {
+            return mCurrent.data();
+        }
+
+        bool isSmoothing(size_t pIndex) const
+        {
+            return mRemaining[pIndex] != 0;
+        }
+
+        bool isAnySmoothing() const
+        {
+            return std::any_of(mRemaining.begin(), mRemaining.end(), [](int32_t r) { return r != 0; });
+        }
+
+        /**
+         The next pNumSamples values of pIndex, without advancing.
+         */
+        void getRamp(size_t pIndex, float* pOut, size_t pNumSamples) const
+        {
+            assert(pIndex < mSize);
+            const size_t lNumRamp = std::min(pNumSamples, (size_t)mRemaining[pIndex]);
+            if (lNumRamp != 0)
+            {
+                Smoothing::Progress::template ramp<Smoothing>(mCurrent[pIndex], mTarget[pIndex], mStep[pIndex], pOut, lNumRamp);
+                if (lNumRamp == (size_t)mRemaining[pIndex])
+                {
+                    pOut[lNumRamp - 1] = mTarget[pIndex];
+                }
+            }
+            std::fill(pOut + lNumRamp, pOut + pNumSamples, mTarget[pIndex]);
+        }
+
+        /**
+         Advances all the values by pNumSamples, by vectors of values. The
+         vectors of settled values are skipped.
+         */
+        void advance(int pNumSamples)
+        {
+            using namespace fbu::simd;
+            assert(pNumSamples >= 0);
+            const vint lNumSamples = set1Int(pNumSamples);
+            const vint lZero = set1Int(0);
+            for (size_t i = 0 ; i != mCurrent.size() ; i += (size_t)kFloatLanes)
+            {
+                const vint lRemaining = loadInt(mRemaining.data() + i);
+                const vint lK = min(lRemaining, lNumSamples);
+                if (!any(lK > lZero))
+                {
+                    continue;
+                }
+                const vfloat lTarget = load(mTarget.data() + i);
+                const vfloat lProgress = Smoothing::Progress::at(load(mStep.data() + i), lK, pNumSamples);
+                const vfloat lValue = Smoothing::combine(load(mCurrent.data() + i), lTarget, lProgress);
+                const vint lNewRemaining = lRemaining - lK;
+                store(mCurrent.data() + i, select(lNewRemaining == lZero, lTarget, lValue));
+                storeInt(mRemaining.data() + i, lNewRemaining);
+            }
+        }
+
+    private:
+        std::vector<float> mCurrent;
+        std::vector<float> mTarget;
+        std::vector<float> mStep;
+        std::vector<int32_t> mRemaining;
+        size_t mSize = 0;
+        int mRampLength = 0;
+    };
+}
+
+#endif // FBU_SMOOTHED_VALUE_HPP_INCLUDED
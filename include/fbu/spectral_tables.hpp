@@ -0,0 +1,230 @@
+#ifndef FBU_SPECTRAL_TABLES_HPP_INCLUDED
+#define FBU_SPECTRAL_TABLES_HPP_INCLUDED
+
+/**
+ @file spectral_tables.hpp
+ @author François Becker
+
+MIT License
+
+Copyright (c) 2018 François Becker
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "fbu/complex.hpp"
+#include "fbu/constexpr_math.hpp"
+#include "fbu/simd.hpp"
+#include "fbu/singleton.hpp"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <typeindex>
+#include <cassert>
+
+namespace fbu
+{
+    /**
+     Periodic windows, i.e. of period N rather than symmetric over N samples,
+     as used for spectral analysis and overlap-add.
+     */
+    enum class WindowKind
+    {
+        hann,
+        sqrtHann,
+        blackman
+    };
+
+    /**
+     Sample n of the window of size N.
+     */
+    constexpr double windowSample(WindowKind pKind, int n, int N)
+    {
+        return pKind == WindowKind::hann
+               ? 0.5 - 0.5 * cx::cos(2. * cx::kPi * n / N)
+               : pKind == WindowKind::sqrtHann
+               ? cx::sqrt(0.5 - 0.5 * cx::cos(2. * cx::kPi * n / N))
+               : 0.42 - 0.5 * cx::cos(2. * cx::kPi * n / N) + 0.08 * cx::cos(4. * cx::kPi * n / N);
+    }
+
+    /**
+     Twiddle factor k of the forward FFT of size N: e^(-j 2π k / N).
+     */
+    template <typename T>
+    constexpr Complex<T> twiddle(int k, int N)
+    {
+        return Complex<T>{(T)cx::cos(2. * cx::kPi * k / N), (T)-cx::sin(2. * cx::kPi * k / N)};
+    }
+
+    //==============================================================================
+    /*
+     Compile-time tables, for small sizes (the generation depth grows with N):
+        constexpr auto kWindow = fbu::makeWindow<float, 64, fbu::WindowKind::hann>();
+     */
+
+    template <int N, WindowKind Kind>
+    struct WindowGenerator
+    {
+        static constexpr double value(int n)
+        {
+            return windowSample(Kind, n, N);
+        }
+    };
+
+    template <typename T, int N>
+    struct TwiddleGenerator
+    {
+        static constexpr Complex<T> value(int k)
+        {
+            return twiddle<T>(k, N);
+        }
+    };
+
+    template <typename T, int N, WindowKind Kind>
+    constexpr cx::Table<T, N> makeWindow()
+    {
+        return cx::makeTable< T, N, WindowGenerator<N, Kind> >();
+    }
+
+    /**
+     The N/2 twiddle factors of the FFT of size N.
+     */
+    template <typename T, int N>
+    constexpr cx::Table<Complex<T>, N / 2> makeTwiddles()
+    {
+        return cx::makeTable< Complex<T>, N / 2, TwiddleGenerator<T, N> >();
+    }
+
+    //==============================================================================
+    /**
+     @class SpectralTableCache
+     @brief Process-wide cache of windows and twiddle factors.
+
+     The tables are computed once, on first request, and shared as immutable
+     aligned arrays between all the users, e.g. all the instances of a plugin.
+     Thread-safe. A table stays alive as long as a user holds it, even after
+     clear().
+     */
+    class SpectralTableCache : public Singleton<SpectralTableCache>
+    {
+        friend class Singleton<SpectralTableCache>;
+
+    public:
+        template <typename T>
+        using Window = simd::AlignedVector<T>;
+
+        template <typename T>
+        using Twiddles = simd::AlignedVector< Complex<T> >;
+
+        /**
+         The window of size pSize.
+         */
+        template <typename T>
+        std::shared_ptr< const Window<T> > getWindow(WindowKind pKind, int pSize)
+        {
+            return getOrCreate< Window<T> >(Key{(int)pKind, pSize, typeid(T)}, [=](Window<T>& pTable){
+                pTable.resize((size_t)pSize);
+                for (int n = 0 ; n != pSize ; ++n)
+                {
+                    pTable[(size_t)n] = (T)windowSample(pKind, n, pSize);
+                }
+            });
+        }
+
+        /**
+         The pFftSize / 2 twiddle factors of the forward FFT of size pFftSize.
+         */
+        template <typename T>
+        std::shared_ptr< const Twiddles<T> > getTwiddles(int pFftSize)
+        {
+            return getOrCreate< Twiddles<T> >(Key{kTwiddlesKind, pFftSize, typeid(T)}, [=](Twiddles<T>& pTable){
+                pTable.resize((size_t)(pFftSize / 2));
+                for (int k = 0 ; k != pFftSize / 2 ; ++k)
+                {
+                    // libm is faster and as accurate as the constexpr series here
+                    double lAngle = - 2. * M_PI * (double)k / (double)pFftSize;
+                    pTable[(size_t)k] = {(T)std::cos(lAngle), (T)std::sin(lAngle)};
+                }
+            });
+        }
+
+        size_t getNumTables()
+        {
+            std::lock_guard<std::mutex> lGuard(mMutex);
+            return mTables.size();
+        }
+
+        /**
+         Forget all the tables. Those still in use are released by their last
+         user.
+         */
+        void clear()
+        {
+            std::lock_guard<std::mutex> lGuard(mMutex);
+            mTables.clear();
+        }
+
+    private:
+        SpectralTableCache() = default;
+
+        static constexpr int kTwiddlesKind = -1;
+
+        struct Key
+        {
+            int             mKind;
+            int             mSize;
+            std::type_index mType;
+
+            bool operator<(const Key& pOther) const
+            {
+                if (mKind != pOther.mKind)
+                {
+                    return mKind < pOther.mKind;
+                }
+                if (mSize != pOther.mSize)
+                {
+                    return mSize < pOther.mSize;
+                }
+                return mType < pOther.mType;
+            }
+        };
+
+        template <typename Table, typename Fill>
+        std::shared_ptr<const Table> getOrCreate(const Key& pKey, Fill pFill)
+        {
+            assert(pKey.mSize > 0);
+            std::lock_guard<std::mutex> lGuard(mMutex);
+            auto lIt = mTables.find(pKey);
+            if (lIt != mTables.end())
+            {
+                return std::static_pointer_cast<const Table>(lIt->second);
+            }
+            std::shared_ptr<Table> lTable = std::make_shared<Table>();
+            pFill(*lTable);
+            mTables.insert(std::make_pair(pKey, std::shared_ptr<const void>(lTable)));
+            return lTable;
+        }
+
+        std::mutex                                   mMutex;
+        std::map< Key, std::shared_ptr<const void> > mTables;
+    };
+}
+
+#endif
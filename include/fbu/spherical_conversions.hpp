@@ -0,0 +1,311 @@
+#ifndef FBU_SPHERICAL_CONVERSIONS_HPP_INCLUDED
+#define FBU_SPHERICAL_CONVERSIONS_HPP_INCLUDED
+
+/**
+ @file spherical_conversions.hpp
+ @author François Becker
+
+MIT License
+
+Copyright (c) 2018 François Becker
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "fbu/math_approx.hpp"
+#include "fbu/simd.hpp"
+#include "fbu/vector3.hpp"
+#include "fbu/vector3_array.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+/*
+ Batch versions of the conversions of vector3.hpp between Cartesian
+ coordinates and azimuth/elevation(/magnitude), for many moving sources at
+ once. The Cartesian side is a Vector3Array<float>, the spherical side is one
+ float array per coordinate, of the same size. The angles are in radians,
+ with the conventions of AE, AEM and AEMr.
+ */
+
+namespace fbu
+{
+    /**
+     Precision of the batch conversions.
+     */
+    enum class SphericalPrecision
+    {
+        exact,  ///< the scalar conversions of vector3.hpp, element by element (libm unless FBU_VECTOR3_FAST_TRIG)
+        coarse, ///< vectorized mu::approx, the unit vectors and the angles within 5e-4 (rad)
+        medium, ///< the same within 5e-6
+        high    ///< the same within 1e-6, about the error of the exact conversions near the poles
+    };
+
+    namespace detail
+    {
+        using simd::vfloat;
+
+        /**
+         Runs pOp on the vectors of NumIn input and NumOut output arrays of pSize
+         values. The tail goes through zero-padded copies.
+         */
+        template <size_t NumIn, size_t NumOut, class Op>
+        inline void forEachVector(const float* const (&pIn)[NumIn], float* const (&pOut)[NumOut], size_t pSize, Op pOp)
+        {
+            using namespace fbu::simd;
+            vfloat lIn[NumIn];
+            vfloat lOut[NumOut];
+            size_t u = 0;
+            for ( ; u + (size_t)kFloatLanes <= pSize ; u += (size_t)kFloatLanes)
+            {
+                for (size_t i = 0 ; i != NumIn ; ++i) lIn[i] = load(pIn[i] + u);
+                pOp(lIn, lOut);
+                for (size_t i = 0 ; i != NumOut ; ++i) store(pOut[i] + u, lOut[i]);
+            }
+            if (u != pSize)
+            {
+                const size_t lNum = pSize - u;
+                float lTail[kFloatLanes] = {};
+                for (size_t i = 0 ; i != NumIn ; ++i)
+                {
+                    std::copy(pIn[i] + u, pIn[i] + pSize, lTail);
+                    lIn[i] = load(lTail);
+                }
+                pOp(lIn, lOut);
+                for (size_t i = 0 ; i != NumOut ; ++i)
+                {
+                    store(lTail, lOut[i]);
+                    std::copy(lTail, lTail + lNum, pOut[i] + u);
+                }
+            }
+        }
+
+        // the Cartesian coordinates of the unit vectors, pSignY = -1 for AEMr
+        template <mu::Accuracy A>
+        inline void directions(const float* pAzimuths, const float* pElevations, const float* pMagnitudes,
+                               size_t pSize, float pSignY, Vector3Array<float>& pOut)
+        {
+            using namespace fbu::simd;
+            const vfloat lSignY = set1(pSignY);
+            const float* const lIn[] = {pAzimuths, pElevations, pMagnitudes != nullptr ? pMagnitudes : pAzimuths};
+            float* const lOut[] = {pOut.x(), pOut.y(), pOut.z()};
+            const bool lHasMagnitudes = pMagnitudes != nullptr;
+            forEachVector(lIn, lOut, pSize, [&](const vfloat (&pV)[3], vfloat (&pR)[3])
+            {
+                vfloat lSinA, lCosA, lSinE, lCosE;
+                mu::approx::sincos<A>(pV[0], lSinA, lCosA);
+                mu::approx::sincos<A>(pV[1], lSinE, lCosE);
+                const vfloat m = lHasMagnitudes ? pV[2] : set1(1.f);
+                const vfloat lHorizontal = m * lCosE;
+                pR[0] = lHorizontal * lCosA;
+                pR[1] = lSignY * lHorizontal * lSinA;
+                pR[2] = m * lSinE;
+            });
+        }
+
+        template <mu::Accuracy A>
+        inline void toAEM(const Vector3Array<float>& pIn, float* pAzimuths, float* pElevations, float* pMagnitudes)
+        {
+            using namespace fbu::simd;
+            const float* const lIn[] = {pIn.x(), pIn.y(), pIn.z()};
+            float* const lOut[] = {pAzimuths, pElevations, pMagnitudes};
+            forEachVector(lIn, lOut, pIn.size(), [&](const vfloat (&pV)[3], vfloat (&pR)[3])
+            {
+                const vfloat lSqrLength2D = mulAdd(pV[0], pV[0], pV[1] * pV[1]);
+                const vfloat lLength2D = sqrt(lSqrLength2D);
+                pR[0] = mu::approx::atan2<A>(pV[1], pV[0]);
+                pR[1] = mu::approx::atan2<A>(pV[2], lLength2D);
+                pR[2] = sqrt(mulAdd(pV[2], pV[2], lSqrLength2D));
+            });
+        }
+
+        template <mu::Accuracy A>
+        inline void normalizedToAE(const Vector3Array<float>& pIn, float* pAzimuths, float* pElevations)
+        {
+            using namespace fbu::simd;
+            const float* const lIn[] = {pIn.x(), pIn.y(), pIn.z()};
+            float* const lOut[] = {pAzimuths, pElevations};
+            forEachVector(lIn, lOut, pIn.size(), [&](const vfloat (&pV)[3], vfloat (&pR)[2])
+            {
+                pR[0] = mu::approx::atan2<A>(pV[1], pV[0]);
+                pR[1] = mu::approx::asin<A>(min(max(pV[2], set1(-1.f)), set1(1.f)));
+            });
+        }
+
+        // as Vector3_to_AEMr(): the azimuth from acos, and 0 within half a
+        // degree of the poles
+        template <mu::Accuracy A>
+        inline void toAEMr(const Vector3Array<float>& pIn, float* pAzimuths, float* pElevations, float* pMagnitudes)
+        {
+            using namespace fbu::simd;
+            const float* const lIn[] = {pIn.x(), pIn.y(), pIn.z()};
+            float* const lOut[] = {pAzimuths, pElevations, pMagnitudes};
+            const vfloat lOne = set1(1.f);
+            const vfloat lPoleLimit = set1(M_PI_2f - (0.5f * DEG2RADf));
+            forEachVector(lIn, lOut, pIn.size(), [&](const vfloat (&pV)[3], vfloat (&pR)[3])
+            {
+                const vfloat lSqrLength2D = mulAdd(pV[0], pV[0], pV[1] * pV[1]);
+                const vfloat lLength2D = sqrt(lSqrLength2D);
+                const vfloat lMagnitude = sqrt(mulAdd(pV[2], pV[2], lSqrLength2D));
+                const vmask lIsZero = lMagnitude == zero();
+                const vfloat lSinElevation = min(max(pV[2] / lMagnitude, -lOne), lOne);
+                const vfloat lElevation = mu::approx::asin<A>(lSinElevation);
+                const vfloat lCosAzimuth = min(max(pV[0] / lLength2D, -lOne), lOne);
+                vfloat lAzimuth = mu::approx::acos<A>(lCosAzimuth);
+                lAzimuth = select(pV[1] > zero(), -lAzimuth, lAzimuth);
+                lAzimuth = select(abs(lElevation) <= lPoleLimit, lAzimuth, zero());
+                pR[0] = select(lIsZero, zero(), lAzimuth);
+                pR[1] = select(lIsZero, zero(), lElevation);
+                pR[2] = lMagnitude;
+            });
+        }
+
+#define FBU_SPHERICAL_DISPATCH(NAME, ARGS) \
+        switch (pPrecision) \
+        { \
+            case SphericalPrecision::coarse: detail::NAME<mu::Accuracy::coarse> ARGS; break; \
+            case SphericalPrecision::medium: detail::NAME<mu::Accuracy::medium> ARGS; break; \
+            case SphericalPrecision::high:   detail::NAME<mu::Accuracy::high> ARGS; break; \
+            case SphericalPrecision::exact:  break; \
+        }
+    }
+
+    //==============================================================================
+    /**
+     Vector3::fromAE() of all the elements: pOut is resized to pSize.
+     */
+    inline void aeToVector3(const float* pAzimuths, const float* pElevations, size_t pSize,
+                            Vector3Array<float>& pOut, SphericalPrecision pPrecision = SphericalPrecision::high)
+    {
+        pOut.resize(pSize);
+        if (pPrecision == SphericalPrecision::exact)
+        {
+            for (size_t i = 0 ; i != pSize ; ++i)
+            {
+                pOut[i] = Vector3f::fromAE(AEf::ae(pAzimuths[i], pElevations[i]));
+            }
+            return;
+        }
+        FBU_SPHERICAL_DISPATCH(directions, (pAzimuths, pElevations, nullptr, pSize, 1.f, pOut))
+    }
+
+    /**
+     Vector3::fromAEM() of all the elements: pOut is resized to pSize.
+     */
+    inline void aemToVector3(const float* pAzimuths, const float* pElevations, const float* pMagnitudes, size_t pSize,
+                             Vector3Array<float>& pOut, SphericalPrecision pPrecision = SphericalPrecision::high)
+    {
+        pOut.resize(pSize);
+        if (pPrecision == SphericalPrecision::exact)
+        {
+            for (size_t i = 0 ; i != pSize ; ++i)
+            {
+                pOut[i] = Vector3f::fromAEM(AEMf::aem(pAzimuths[i], pElevations[i], pMagnitudes[i]));
+            }
+            return;
+        }
+        FBU_SPHERICAL_DISPATCH(directions, (pAzimuths, pElevations, pMagnitudes, pSize, 1.f, pOut))
+    }
+
+    /**
+     Vector3::fromAEMr() of all the elements: pOut is resized to pSize.
+     */
+    inline void aemrToVector3(const float* pAzimuths, const float* pElevations, const float* pMagnitudes, size_t pSize,
+                              Vector3Array<float>& pOut, SphericalPrecision pPrecision = SphericalPrecision::high)
+    {
+        pOut.resize(pSize);
+        if (pPrecision == SphericalPrecision::exact)
+        {
+            for (size_t i = 0 ; i != pSize ; ++i)
+            {
+                pOut[i] = Vector3f::fromAEMr(AEMrf(pAzimuths[i], pElevations[i], pMagnitudes[i]));
+            }
+            return;
+        }
+        FBU_SPHERICAL_DISPATCH(directions, (pAzimuths, pElevations, pMagnitudes, pSize, -1.f, pOut))
+    }
+
+    /**
+     AEM::fromVector3() of all the elements, the outputs holding pIn.size()
+     values.
+     */
+    inline void vector3ToAEM(const Vector3Array<float>& pIn, float* pAzimuths, float* pElevations, float* pMagnitudes,
+                             SphericalPrecision pPrecision = SphericalPrecision::high)
+    {
+        if (pPrecision == SphericalPrecision::exact)
+        {
+            for (size_t i = 0 ; i != pIn.size() ; ++i)
+            {
+                const AEMf lAEM = AEMf::fromVector3(pIn[i]);
+                pAzimuths[i] = lAEM.mAzimuth;
+                pElevations[i] = lAEM.mElevation;
+                pMagnitudes[i] = lAEM.mMagnitude;
+            }
+            return;
+        }
+        FBU_SPHERICAL_DISPATCH(toAEM, (pIn, pAzimuths, pElevations, pMagnitudes))
+    }
+
+    /**
+     AE::fromNormalizedVector3() of all the elements, the outputs holding
+     pIn.size() values.
+     */
+    inline void normalizedVector3ToAE(const Vector3Array<float>& pIn, float* pAzimuths, float* pElevations,
+                                      SphericalPrecision pPrecision = SphericalPrecision::high)
+    {
+        if (pPrecision == SphericalPrecision::exact)
+        {
+            for (size_t i = 0 ; i != pIn.size() ; ++i)
+            {
+                const AEf lAE = AEf::fromNormalizedVector3(pIn[i]);
+                pAzimuths[i] = lAE.mAzimuth;
+                pElevations[i] = lAE.mElevation;
+            }
+            return;
+        }
+        FBU_SPHERICAL_DISPATCH(normalizedToAE, (pIn, pAzimuths, pElevations))
+    }
+
+    /**
+     Vector3_to_AEMr() of all the elements, the outputs holding pIn.size()
+     values. As there, the azimuths come from acos(), which loses up to 3e-4 rad
+     near 0 and pi whatever the precision.
+     */
+    inline void vector3ToAEMr(const Vector3Array<float>& pIn, float* pAzimuths, float* pElevations, float* pMagnitudes,
+                              SphericalPrecision pPrecision = SphericalPrecision::high)
+    {
+        if (pPrecision == SphericalPrecision::exact)
+        {
+            for (size_t i = 0 ; i != pIn.size() ; ++i)
+            {
+                AEMrf lAEM;
+                Vector3_to_AEMr(pIn[i], lAEM);
+                pAzimuths[i] = lAEM.mAzimuth;
+                pElevations[i] = lAEM.mElevation;
+                pMagnitudes[i] = lAEM.mMagnitude;
+            }
+            return;
+        }
+        FBU_SPHERICAL_DISPATCH(toAEMr, (pIn, pAzimuths, pElevations, pMagnitudes))
+    }
+
+#undef FBU_SPHERICAL_DISPATCH
+}
+
+#endif // FBU_SPHERICAL_CONVERSIONS_HPP_INCLUDED
@@ -0,0 +1,256 @@
+#ifndef FBU_STFT_HPP_INCLUDED
+#define FBU_STFT_HPP_INCLUDED
+
+/**
+ @file stft.hpp
+ @author François Becker
+
+MIT License
+
+Copyright (c) 2018 François Becker
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "fbu/complex.hpp"
+#include "fbu/fft.hpp"
+#include "fbu/math_utils.hpp"
+#include "fbu/sad.hpp"
+#include "fbu/spectral_tables.hpp"
+#include "fbu/thread_pool.hpp"
+
+#include <functional>
+#include <vector>
+#include <cassert>
+
+namespace fbu
+{
+    /**
+     @class Stft
+     @brief Short-time Fourier transform with overlap-add resynthesis.
+
+     Input blocks of any size are accumulated per channel; every hop a frame of
+     the last N samples is windowed (periodic sqrt-Hann, shared through the
+     SpectralTableCache), transformed, handed to the spectral callback,
+     transformed back, windowed again and overlap-added to the output. The
+     analysis/synthesis window pair is normalized so that an identity callback
+     gives back the input delayed by getLatency() samples.
+
+     All the buffers are allocated at construction: process() does not
+     allocate when no ThreadPool is used. With a ThreadPool, each channel is
+     processed as one job; the job submission goes through
+     ThreadPool::addJob(), whose queue may allocate.
+     */
+    template <typename T>
+    class Stft
+    {
+    public:
+        /**
+         Called once per frame with the N bins of the spectrum of a channel,
+         which may be modified in place. With a ThreadPool, it is called
+         concurrently for different channels.
+         */
+        typedef std::function<void(ChannelCount pChannel, Complex<T>* pSpectrum, int pFftSize)> SpectralCallback;
+
+        /**
+         Constructor.
+         @param pNumChannels The number of channels.
+         @param pFrameSize The frame size, rounded up to a power of 2.
+         @param pOverlap The number of frames overlapping a sample, a power of 2
+                         greater or equal to 2. The hop size is N / pOverlap.
+         @param pCallback The spectral callback.
+         @param pThreadPool An optional ThreadPool for dispatching the channels.
+         */
+        Stft(ChannelCount pNumChannels,
+             int pFrameSize,
+             int pOverlap,
+             SpectralCallback pCallback,
+             ThreadPool* pThreadPool = nullptr)
+        : mFft(mu::fftOrderFor(pFrameSize))
+        , mHopSize(mFft.getSize() / pOverlap)
+        , mWindow(SpectralTableCache::getInstance().getWindow<T>(WindowKind::sqrtHann, mFft.getSize()))
+        , mChannels(pNumChannels)
+        , mCallback(pCallback)
+        , mThreadPool(pThreadPool)
+        {
+            assert(mu::isPowerOf2((unsigned)pOverlap) && pOverlap >= 2);
+            assert(mHopSize >= 1);
+            const int lSize = mFft.getSize();
+            const SpectralTableCache::Window<T>& lWindow = *mWindow;
+            // analysis * synthesis summed over the overlapping frames
+            double lOverlapSum = 0.;
+            for (int n = 0 ; n != lSize ; ++n)
+            {
+                lOverlapSum += (double)lWindow[(size_t)n] * (double)lWindow[(size_t)n];
+            }
+            mSynthesisGain = (T)((double)mHopSize / lOverlapSum);
+            for (Channel& lChannel : mChannels)
+            {
+                lChannel.mInputRing.assign((size_t)lSize, (T)0);
+                lChannel.mOutputRing.assign((size_t)lSize, (T)0);
+                lChannel.mFrame.assign((size_t)lSize, {(T)0, (T)0});
+            }
+        }
+
+        /**
+         Clear all the buffers.
+         */
+        void reset()
+        {
+            for (Channel& lChannel : mChannels)
+            {
+                std::fill(lChannel.mInputRing.begin(), lChannel.mInputRing.end(), (T)0);
+                std::fill(lChannel.mOutputRing.begin(), lChannel.mOutputRing.end(), (T)0);
+                lChannel.mPosition = 0;
+                lChannel.mHopCount = 0;
+            }
+        }
+
+        /**
+         Process a block. pIn and pOut may point to the same buffers.
+         @param pIn pNumChannels input channel pointers.
+         @param pOut pNumChannels output channel pointers.
+         @param pNumSamples Any number of samples.
+         */
+        void process(const T* const* pIn, T* const* pOut, SampleCount pNumSamples)
+        {
+            if (mThreadPool == nullptr || mChannels.size() < 2)
+            {
+                for (size_t c = 0 ; c != mChannels.size() ; ++c)
+                {
+                    processChannel((ChannelCount)c, pIn[c], pOut[c], pNumSamples);
+                }
+            }
+            else
+            {
+                mBlockIn = pIn;
+                mBlockOut = pOut;
+                mBlockNumSamples = pNumSamples;
+                for (size_t c = 0 ; c != mChannels.size() ; ++c)
+                {
+                    mJobCounter.increment();
+                    ChannelCount lChannel = (ChannelCount)c;
+                    mThreadPool->addJob([this, lChannel]{
+                        processChannel(lChannel, mBlockIn[lChannel], mBlockOut[lChannel], mBlockNumSamples);
+                        mJobCounter.decrement();
+                    });
+                }
+                mJobCounter.waitForCompletion();
+            }
+        }
+
+        int getFftSize() const
+        {
+            return mFft.getSize();
+        }
+
+        int getHopSize() const
+        {
+            return mHopSize;
+        }
+
+        /**
+         Delay between the input and the output, in samples.
+         */
+        SampleCount getLatency() const
+        {
+            return (SampleCount)mFft.getSize();
+        }
+
+        ChannelCount getNumChannels() const
+        {
+            return (ChannelCount)mChannels.size();
+        }
+
+    private:
+        struct Channel
+        {
+            std::vector<T>            mInputRing;
+            std::vector<T>            mOutputRing;
+            std::vector< Complex<T> > mFrame;
+            int                       mPosition = 0;  ///< shared by both rings
+            int                       mHopCount = 0;
+        };
+
+        void processChannel(ChannelCount pChannel, const T* pIn, T* pOut, SampleCount pNumSamples)
+        {
+            Channel& lChannel = mChannels[pChannel];
+            const int lSize = mFft.getSize();
+            SampleCount n = 0;
+            while (n != pNumSamples)
+            {
+                // up to the next hop boundary
+                SampleCount lChunk = std::min(pNumSamples - n, (SampleCount)(mHopSize - lChannel.mHopCount));
+                for (SampleCount lEnd = n + lChunk ; n != lEnd ; ++n)
+                {
+                    size_t u = (size_t)lChannel.mPosition;
+                    T lInput = pIn[n];
+                    pOut[n] = lChannel.mOutputRing[u];
+                    lChannel.mOutputRing[u] = (T)0;
+                    lChannel.mInputRing[u] = lInput;
+                    if (++lChannel.mPosition == lSize)
+                    {
+                        lChannel.mPosition = 0;
+                    }
+                }
+                lChannel.mHopCount += (int)lChunk;
+                if (lChannel.mHopCount == mHopSize)
+                {
+                    lChannel.mHopCount = 0;
+                    processFrame(pChannel, lChannel);
+                }
+            }
+        }
+
+        void processFrame(ChannelCount pChannel, Channel& pState)
+        {
+            const int lSize = mFft.getSize();
+            const SpectralTableCache::Window<T>& lWindow = *mWindow;
+            // the oldest sample is at the current position
+            for (int p = 0 ; p != lSize ; ++p)
+            {
+                size_t u = (size_t)((pState.mPosition + p) & (lSize - 1));
+                pState.mFrame[(size_t)p] = {pState.mInputRing[u] * lWindow[(size_t)p], (T)0};
+            }
+            mFft.perform(pState.mFrame.data());
+            mCallback(pChannel, pState.mFrame.data(), lSize);
+            mFft.perform(pState.mFrame.data(), true);
+            // the output ring is read from the current position onwards
+            for (int p = 0 ; p != lSize ; ++p)
+            {
+                size_t u = (size_t)((pState.mPosition + p) & (lSize - 1));
+                pState.mOutputRing[u] += mSynthesisGain * lWindow[(size_t)p] * pState.mFrame[(size_t)p].re;
+            }
+        }
+
+        Fft<T>               mFft;
+        int                  mHopSize;
+        std::shared_ptr< const SpectralTableCache::Window<T> > mWindow;
+        T                    mSynthesisGain;
+        std::vector<Channel> mChannels;
+        SpectralCallback     mCallback;
+        ThreadPool*          mThreadPool;
+        JobCounter           mJobCounter;
+        const T* const*      mBlockIn = nullptr;
+        T* const*            mBlockOut = nullptr;
+        SampleCount          mBlockNumSamples = 0;
+    };
+}
+
+#endif
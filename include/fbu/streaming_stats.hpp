@@ -0,0 +1,470 @@
+#ifndef FBU_STREAMING_STATS_HPP_INCLUDED
+#define FBU_STREAMING_STATS_HPP_INCLUDED
+
+/**
+ @file streaming_stats.hpp
+ @author François Becker
+
+MIT License
+
+Copyright (c) 2018 François Becker
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "fbu/simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+/*
+ Streaming statistics, O(1) per value: for load monitoring and signal
+ analysis. RunningStats can be merged, so that the partial states computed
+ per thread (e.g. jobs of a fbu::ThreadPool) combine into the state of the
+ whole stream. The array pushes of the float versions are vectorized.
+ */
+
+namespace mu
+{
+    template <typename T> class RunningStats;
+
+    namespace detail
+    {
+        template <typename T>
+        void pushArray(RunningStats<T>& pStats, const T* pValues, size_t pNum);
+        inline void pushArray(RunningStats<float>& pStats, const float* pValues, size_t pNum);
+    }
+
+    //==============================================================================
+    /**
+     @class RunningStats
+     @brief Count, mean, variance, min and max of a stream, with the Welford
+            update, which stays accurate when the mean is large compared to
+            the deviations, unlike the sum of squares.
+     */
+    template <typename T = float>
+    class RunningStats
+    {
+        static_assert(std::is_floating_point<T>::value, "RunningStats needs floating point values");
+
+    public:
+        RunningStats() {}
+
+        /**
+         The state of pCount values with the given mean, sum of squared
+         deviations from the mean, min and max.
+         */
+        static RunningStats fromMoments(int64_t pCount, T pMean, T pSumOfSquaredDeviations, T pMin, T pMax)
+        {
+            RunningStats lStats;
+            if (pCount > 0)
+            {
+                lStats.mCount = pCount;
+                lStats.mMean = pMean;
+                lStats.mM2 = pSumOfSquaredDeviations;
+                lStats.mMin = pMin;
+                lStats.mMax = pMax;
+            }
+            return lStats;
+        }
+
+        void push(T pValue)
+        {
+            ++mCount;
+            const T lDelta = pValue - mMean;
+            mMean += lDelta / (T)mCount;
+            mM2 += lDelta * (pValue - mMean);
+            mMin = std::min(mMin, pValue);
+            mMax = std::max(mMax, pValue);
+        }
+
+        void push(const T* pValues, size_t pNum)
+        {
+            detail::pushArray(*this, pValues, pNum);
+        }
+
+        /**
+         Add the values pushed to pOther (Chan et al. pairwise update).
+         */
+        void merge(const RunningStats& pOther)
+        {
+            if (pOther.mCount == 0)
+            {
+                return;
+            }
+            if (mCount == 0)
+            {
+                *this = pOther;
+                return;
+            }
+            const int64_t lCount = mCount + pOther.mCount;
+            const T lDelta = pOther.mMean - mMean;
+            const T lOtherWeight = (T)pOther.mCount / (T)lCount;
+            mMean += lDelta * lOtherWeight;
+            mM2 += pOther.mM2 + lDelta * lDelta * (T)mCount * lOtherWeight;
+            mMin = std::min(mMin, pOther.mMin);
+            mMax = std::max(mMax, pOther.mMax);
+            mCount = lCount;
+        }
+
+        void reset()
+        {
+            *this = RunningStats();
+        }
+
+        int64_t getCount() const
+        {
+            return mCount;
+        }
+
+        /**
+         0 when empty.
+         */
+        T getMean() const
+        {
+            return mMean;
+        }
+
+        /**
+         Population variance, i.e. divided by the count; 0 when empty.
+         */
+        T getVariance() const
+        {
+            return mCount != 0 ? mM2 / (T)mCount : (T)0;
+        }
+
+        /**
+         Unbiased estimate, i.e. divided by the count - 1; 0 below 2 values.
+         */
+        T getSampleVariance() const
+        {
+            return mCount > 1 ? mM2 / (T)(mCount - 1) : (T)0;
+        }
+
+        T getStandardDeviation() const
+        {
+            return std::sqrt(getVariance());
+        }
+
+        /**
+         +inf and -inf when empty.
+         */
+        T getMin() const
+        {
+            return mMin;
+        }
+
+        T getMax() const
+        {
+            return mMax;
+        }
+
+    private:
+        int64_t mCount = 0;
+        T mMean = (T)0;
+        T mM2 = (T)0;
+        T mMin = std::numeric_limits<T>::infinity();
+        T mMax = -std::numeric_limits<T>::infinity();
+    };
+
+    namespace detail
+    {
+        template <typename T>
+        void pushArray(RunningStats<T>& pStats, const T* pValues, size_t pNum)
+        {
+            for (size_t u = 0 ; u != pNum ; ++u)
+            {
+                pStats.push(pValues[u]);
+            }
+        }
+
+        /*
+         By blocks that stay in cache: the sum, min and max in a first pass,
+         the squared deviations from the block mean in a second one, then a
+         merge, which is as stable as the Welford update.
+         */
+        inline void pushArray(RunningStats<float>& pStats, const float* pValues, size_t pNum)
+        {
+            using namespace fbu::simd;
+            const size_t lBlockSize = 1024;
+            const size_t lNumPerIteration = (size_t)kFloatLanes;
+            for (size_t lStart = 0 ; lStart < pNum ; lStart += lBlockSize)
+            {
+                const float* lBlock = pValues + lStart;
+                const size_t lNum = std::min(lBlockSize, pNum - lStart);
+                // summed relative to the first value, which keeps the terms small
+                const float lShift = lBlock[0];
+                const vfloat lShifts = set1(lShift);
+                vfloat lSums = zero();
+                vfloat lMins = set1(std::numeric_limits<float>::infinity());
+                vfloat lMaxs = set1(-std::numeric_limits<float>::infinity());
+                size_t u = 0;
+                for ( ; u + lNumPerIteration <= lNum ; u += lNumPerIteration)
+                {
+                    const vfloat x = load(lBlock + u);
+                    lSums += x - lShifts;
+                    lMins = min(lMins, x);
+                    lMaxs = max(lMaxs, x);
+                }
+                float lSum = hsum(lSums);
+                float lMin = hmin(lMins);
+                float lMax = hmax(lMaxs);
+                for (size_t k = u ; k != lNum ; ++k)
+                {
+                    lSum += lBlock[k] - lShift;
+                    lMin = std::min(lMin, lBlock[k]);
+                    lMax = std::max(lMax, lBlock[k]);
+                }
+                const float lMean = lShift + lSum / (float)lNum;
+
+                const vfloat lMeans = set1(lMean);
+                vfloat lSquares = zero();
+                for (u = 0 ; u + lNumPerIteration <= lNum ; u += lNumPerIteration)
+                {
+                    const vfloat d = load(lBlock + u) - lMeans;
+                    lSquares = mulAdd(d, d, lSquares);
+                }
+                float lM2 = hsum(lSquares);
+                for (size_t k = u ; k != lNum ; ++k)
+                {
+                    const float d = lBlock[k] - lMean;
+                    lM2 += d * d;
+                }
+                pStats.merge(RunningStats<float>::fromMoments((int64_t)lNum, lMean, lM2, lMin, lMax));
+            }
+        }
+    }
+
+    //==============================================================================
+    /**
+     @class ExponentialMovingAverage
+     @brief One-pole smoothing: y += alpha (x - y).
+     */
+    template <typename T = float>
+    class ExponentialMovingAverage
+    {
+    public:
+        explicit ExponentialMovingAverage(T pAlpha = (T)1, T pInitialValue = (T)0)
+        : mAlpha(pAlpha)
+        , mValue(pInitialValue)
+        {
+        }
+
+        /**
+         The alpha for which a step reaches 1 - 1/e of its height after
+         pTimeConstant seconds.
+         */
+        static T alphaForTimeConstant(T pTimeConstant, T pSampleRate)
+        {
+            return (T)1 - std::exp((T)-1 / (pTimeConstant * pSampleRate));
+        }
+
+        void setAlpha(T pAlpha)
+        {
+            mAlpha = pAlpha;
+        }
+
+        T getAlpha() const
+        {
+            return mAlpha;
+        }
+
+        void push(T pValue)
+        {
+            mValue += mAlpha * (pValue - mValue);
+        }
+
+        /**
+         Same as pushing the values one by one, up to the rounding. For float,
+         the recursion is unrolled by vectors: lane j accumulates the weights
+         alpha (1 - alpha)^(3 - j), and the lanes decay by (1 - alpha)^4.
+         */
+        void push(const T* pValues, size_t pNum)
+        {
+            size_t u = 0;
+            pushVectorized(pValues, pNum, u);
+            for ( ; u != pNum ; ++u)
+            {
+                push(pValues[u]);
+            }
+        }
+
+        T get() const
+        {
+            return mValue;
+        }
+
+        void reset(T pValue = (T)0)
+        {
+            mValue = pValue;
+        }
+
+    private:
+        template <typename U>
+        void pushVectorized(const U*, size_t, size_t&)
+        {
+        }
+
+        void pushVectorized(const float* pValues, size_t pNum, size_t& u)
+        {
+            using namespace fbu::simd;
+            const size_t lNumPerIteration = (size_t)kFloatLanes;
+            const float lDecay = 1.f - mAlpha;
+            const float lDecay2 = lDecay * lDecay;
+            const float lWeights[kFloatLanes] = {mAlpha * lDecay2 * lDecay, mAlpha * lDecay2, mAlpha * lDecay, mAlpha};
+            const vfloat lWeightsV = load(lWeights);
+            const vfloat lDecay4 = set1(lDecay2 * lDecay2);
+            vfloat lSums = zero();
+            size_t lNumBlocks = 0;
+            for ( ; u + lNumPerIteration <= pNum ; u += lNumPerIteration, ++lNumBlocks)
+            {
+                lSums = mulAdd(lSums, lDecay4, lWeightsV * load(pValues + u));
+            }
+            if (lNumBlocks != 0)
+            {
+                mValue = mValue * std::pow(lDecay, (float)(4 * lNumBlocks)) + hsum(lSums);
+            }
+        }
+
+        T mAlpha;
+        T mValue;
+    };
+
+    //==============================================================================
+    /**
+     @class WindowedRMS
+     @brief Root mean square over the last N values, O(1) per value. The
+            window starts filled with zeros. The running sum is recomputed
+            once per window, which cancels its rounding drift, so that the
+            RMS of silence after a loud passage is 0.
+     */
+    template <typename T = float>
+    class WindowedRMS
+    {
+    public:
+        explicit WindowedRMS(int pWindowLength)
+        : mSquares((size_t)std::max(pWindowLength, 1), (T)0)
+        {
+        }
+
+        int getWindowLength() const
+        {
+            return (int)mSquares.size();
+        }
+
+        void push(T pValue)
+        {
+            const T lSquare = pValue * pValue;
+            mSum += (double)lSquare - (double)mSquares[mIndex];
+            mSquares[mIndex] = lSquare;
+            if (++mIndex == mSquares.size())
+            {
+                wrap();
+            }
+        }
+
+        void push(const T* pValues, size_t pNum)
+        {
+            while (pNum != 0)
+            {
+                // up to the end of the circular buffer
+                const size_t lNum = std::min(pNum, mSquares.size() - mIndex);
+                mSum += pushSegment(pValues, mSquares.data() + mIndex, lNum);
+                pValues += lNum;
+                pNum -= lNum;
+                mIndex += lNum;
+                if (mIndex == mSquares.size())
+                {
+                    wrap();
+                }
+            }
+        }
+
+        T get() const
+        {
+            return (T)std::sqrt(std::max(mSum, 0.) / (double)mSquares.size());
+        }
+
+        void reset()
+        {
+            std::fill(mSquares.begin(), mSquares.end(), (T)0);
+            mIndex = 0;
+            mSum = 0.;
+        }
+
+    private:
+        void wrap()
+        {
+            mIndex = 0;
+            mSum = 0.;
+            for (T lSquare : mSquares)
+            {
+                mSum += (double)lSquare;
+            }
+        }
+
+        // stores the squares, returns the sum of the new ones minus the old ones
+        template <typename U>
+        static double pushSegment(const U* pValues, U* pSquares, size_t pNum)
+        {
+            double lDifference = 0.;
+            for (size_t u = 0 ; u != pNum ; ++u)
+            {
+                const U lSquare = pValues[u] * pValues[u];
+                lDifference += (double)lSquare - (double)pSquares[u];
+                pSquares[u] = lSquare;
+            }
+            return lDifference;
+        }
+
+        static double pushSegment(const float* pValues, float* pSquares, size_t pNum)
+        {
+            using namespace fbu::simd;
+            const size_t lNumPerIteration = (size_t)kFloatLanes;
+            vfloat lDifferences = zero();
+            size_t u = 0;
+            for ( ; u + lNumPerIteration <= pNum ; u += lNumPerIteration)
+            {
+                const vfloat x = load(pValues + u);
+                const vfloat lSquares = x * x;
+                lDifferences += lSquares - load(pSquares + u);
+                store(pSquares + u, lSquares);
+            }
+            double lDifference = (double)hsum(lDifferences);
+            for ( ; u != pNum ; ++u)
+            {
+                const float lSquare = pValues[u] * pValues[u];
+                lDifference += (double)lSquare - (double)pSquares[u];
+                pSquares[u] = lSquare;
+            }
+            return lDifference;
+        }
+
+        std::vector<T> mSquares;
+        size_t mIndex = 0;
+        double mSum = 0.;
+    };
+}
+
+#endif
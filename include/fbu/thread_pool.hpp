@@ -29,12 +29,15 @@ SOFTWARE.
 */
 
 #include <thread>
+#include <mutex>
+#include <functional>
 #include <vector>
 #include <queue>
 #include <atomic>
 #include <condition_variable>
 #include <string>
 #include <type_traits>
+#include <cassert>
 #if __APPLE__
 #include <pthread.h>
 #endif
@@ -0,0 +1,553 @@
+#ifndef FBU_VBAP_HPP_INCLUDED
+#define FBU_VBAP_HPP_INCLUDED
+
+/**
+ @file vbap.hpp
+ @author François Becker
+
+MIT License
+
+Copyright (c) 2018 François Becker
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "fbu/bits.hpp"
+#include "fbu/math_utils.hpp"
+#include "fbu/simd.hpp"
+#include "fbu/vector3.hpp"
+#include "fbu/vector3_array.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace fbu
+{
+    //==============================================================================
+    /**
+     @class Vbap
+     @brief Vector-base amplitude panning over a 3D speaker layout.
+
+     setSpeakers() triangulates the layout as the convex hull of the speaker
+     directions, and keeps the inverse of the matrix of each triangle, so that
+     the gains of a source are the products of its direction with the three
+     columns of the inverse, for the triangle where all three are positive.
+     The triangles are searched 4 at a time. The gains are normalized to a
+     constant power.
+
+     The faces of the hull that the centre of the layout does not see from
+     inside, e.g. below a layout of the upper hemisphere, are not triangles:
+     the sources in the direction of such a hole are panned with the negative
+     gains at 0, on the triangle that brings them the nearest. A
+     layout with all the speakers in a plane through the centre has no
+     triangles, and pans each source to the nearest speaker.
+     */
+    class Vbap
+    {
+    public:
+        /**
+         The speakers of a source, and their gains.
+         */
+        struct Gains
+        {
+            size_t mSpeakers[3];
+            float mGains[3];
+        };
+
+        struct Triangle
+        {
+            size_t mSpeakers[3];
+        };
+
+        Vbap() = default;
+
+        explicit Vbap(const std::vector<Vector3f>& pSpeakers)
+        {
+            setSpeakers(pSpeakers);
+        }
+
+        /**
+         The directions of the speakers, which must not be zero.
+         */
+        void setSpeakers(const std::vector<Vector3f>& pSpeakers)
+        {
+            mSpeakers.resize(pSpeakers.size());
+            for (size_t i = 0 ; i != pSpeakers.size() ; ++i)
+            {
+                assert(! pSpeakers[i].isZero());
+                mSpeakers[i] = pSpeakers[i].normalized();
+            }
+            triangulate();
+            computeInverses();
+            computeCells();
+        }
+
+        size_t getNumSpeakers() const
+        {
+            return mSpeakers.size();
+        }
+
+        size_t getNumTriangles() const
+        {
+            return mTriangles.size();
+        }
+
+        const Triangle& getTriangle(size_t pIndex) const
+        {
+            return mTriangles[pIndex];
+        }
+
+        /**
+         The gains of a source in pDirection, which need not be normalized. The
+         layout must not be empty.
+         */
+        Gains computeGains(const Vector3f& pDirection) const
+        {
+            assert(! mSpeakers.empty());
+            const Vector3f lDirection = pDirection.isZero() ? Vector3f::cartesian(1.f, 0.f, 0.f) : pDirection;
+            Gains lGains;
+            if (mTriangles.empty())
+            {
+                const size_t lNearest = findNearestSpeaker(lDirection);
+                lGains = {{lNearest, lNearest, lNearest}, {1.f, 0.f, 0.f}};
+                return lGains;
+            }
+            const size_t lTriangle = findTriangle(lDirection, lGains.mGains);
+            float lPower = 0.f;
+            for (size_t k = 0 ; k != 3 ; ++k)
+            {
+                lGains.mSpeakers[k] = mTriangles[lTriangle].mSpeakers[k];
+                lGains.mGains[k] = std::max(0.f, lGains.mGains[k]);
+                lPower += lGains.mGains[k] * lGains.mGains[k];
+            }
+            const float lNormalization = 1.f / std::sqrt(lPower);
+            for (float& g : lGains.mGains)
+            {
+                g *= lNormalization;
+            }
+            return lGains;
+        }
+
+        Gains computeGains(const AE<float>& pDirection) const
+        {
+            return computeGains(Vector3f::fromAE(pDirection));
+        }
+
+        /**
+         The gains of the sources in pDirections, pOut holding
+         pDirections.size() values.
+         */
+        void computeGains(const Vector3Array<float>& pDirections, Gains* pOut) const
+        {
+            for (size_t i = 0 ; i != pDirections.size() ; ++i)
+            {
+                pOut[i] = computeGains(pDirections[i]);
+            }
+        }
+
+        /**
+         The gains of the sources in pDirections for all the speakers:
+         pGains[i * getNumSpeakers() + s] for the speaker s of the source i.
+         */
+        void computeGains(const Vector3Array<float>& pDirections, float* pGains) const
+        {
+            const size_t lNumSpeakers = mSpeakers.size();
+            std::fill(pGains, pGains + pDirections.size() * lNumSpeakers, 0.f);
+            for (size_t i = 0 ; i != pDirections.size() ; ++i)
+            {
+                const Gains lGains = computeGains(pDirections[i]);
+                for (size_t k = 0 ; k != 3 ; ++k)
+                {
+                    pGains[i * lNumSpeakers + lGains.mSpeakers[k]] += lGains.mGains[k];
+                }
+            }
+        }
+
+    private:
+        /// of the distances to the planes of the triangles, for unit vectors
+        static constexpr float kPlaneTolerance = 1e-5f;
+        /// of the gains of the sources on the edges of the triangles
+        static constexpr float kInsideTolerance = 1e-5f;
+        /// the triangles that nearly span half the sphere are holes
+        static constexpr float kMinPlaneDistance = 1e-3f;
+        /// of the faces of the cube of the cells, see computeCells()
+        static constexpr int kCellsPerEdge = 8;
+
+        // the faces of the convex hull seen from inside by the centre: the
+        // coplanar speakers, which lie on a circle, are triangulated as a fan
+        // from the lowest index
+        void triangulate()
+        {
+            mTriangles.clear();
+            const size_t n = mSpeakers.size();
+            for (size_t i = 0 ; i < n ; ++i)
+            {
+                for (size_t j = i + 1 ; j < n ; ++j)
+                {
+                    for (size_t k = j + 1 ; k < n ; ++k)
+                    {
+                        if (isFace(i, j, k))
+                        {
+                            mTriangles.push_back({{i, j, k}});
+                        }
+                    }
+                }
+            }
+        }
+
+        bool isFace(size_t i, size_t j, size_t k) const
+        {
+            const Vector3f& a = mSpeakers[i];
+            const Vector3f& b = mSpeakers[j];
+            const Vector3f& c = mSpeakers[k];
+            Vector3f lNormal = (b - a).cross(c - a);
+            if (lNormal.sqrLength() < kPlaneTolerance * kPlaneTolerance)
+            {
+                return false;
+            }
+            lNormal.normalize();
+            float lDistance = lNormal.dot(a);
+            if (lDistance < 0.f)
+            {
+                lNormal = -1.f * lNormal;
+                lDistance = -lDistance;
+            }
+            if (lDistance < kMinPlaneDistance)
+            {
+                return false;
+            }
+            const float lSideOfA = lNormal.dot((c - b).cross(a - b));
+            for (size_t m = 0 ; m != mSpeakers.size() ; ++m)
+            {
+                if (m == i || m == j || m == k)
+                {
+                    continue;
+                }
+                const float lOffset = lNormal.dot(mSpeakers[m]) - lDistance;
+                if (lOffset > kPlaneTolerance)
+                {
+                    return false;
+                }
+                // coplanar: i is the lowest index, and (j, k) an edge
+                if (lOffset >= -kPlaneTolerance
+                    && (m < i || lNormal.dot((c - b).cross(mSpeakers[m] - b)) * lSideOfA < 0.f))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // the columns of the inverses, by groups of kFloatLanes triangles:
+        // mInverses[(group * 9 + 3 * gain + coordinate) * kFloatLanes + lane],
+        // padded with the last triangle
+        void computeInverses()
+        {
+            const size_t lNumLanes = (size_t)simd::kFloatLanes;
+            const size_t lNumGroups = (mTriangles.size() + lNumLanes - 1) / lNumLanes;
+            mInverses.resize(lNumGroups * 9 * lNumLanes);
+            for (size_t t = 0 ; t != lNumGroups * lNumLanes ; ++t)
+            {
+                const Triangle& lTriangle = mTriangles[std::min(t, mTriangles.size() - 1)];
+                const Vector3f& a = mSpeakers[lTriangle.mSpeakers[0]];
+                const Vector3f& b = mSpeakers[lTriangle.mSpeakers[1]];
+                const Vector3f& c = mSpeakers[lTriangle.mSpeakers[2]];
+                const float lInvDeterminant = 1.f / a.dot(b.cross(c));
+                const Vector3f lColumns[3] = {lInvDeterminant * b.cross(c), lInvDeterminant * c.cross(a), lInvDeterminant * a.cross(b)};
+                float* lGroup = mInverses.data() + (t / lNumLanes) * 9 * lNumLanes + t % lNumLanes;
+                for (size_t k = 0 ; k != 3 ; ++k)
+                {
+                    lGroup[(3 * k) * lNumLanes] = lColumns[k].mX;
+                    lGroup[(3 * k + 1) * lNumLanes] = lColumns[k].mY;
+                    lGroup[(3 * k + 2) * lNumLanes] = lColumns[k].mZ;
+                }
+            }
+        }
+
+        float gain(size_t pTriangle, size_t pGain, const Vector3f& pDirection) const
+        {
+            const size_t lNumLanes = (size_t)simd::kFloatLanes;
+            const float* lColumn = mInverses.data() + ((pTriangle / lNumLanes) * 9 + 3 * pGain) * lNumLanes + pTriangle % lNumLanes;
+            return lColumn[0] * pDirection.mX + lColumn[lNumLanes] * pDirection.mY + lColumn[2 * lNumLanes] * pDirection.mZ;
+        }
+
+        // the inverses of the triangles pTriangles[0..3] in pGroup, as one
+        // group of computeInverses()
+        void copyInverses(const size_t* pTriangles, float* pGroup) const
+        {
+            const size_t lNumLanes = (size_t)simd::kFloatLanes;
+            for (size_t lLane = 0 ; lLane != lNumLanes ; ++lLane)
+            {
+                const size_t t = pTriangles[lLane];
+                const float* lFrom = mInverses.data() + (t / lNumLanes) * 9 * lNumLanes + t % lNumLanes;
+                for (size_t c = 0 ; c != 9 ; ++c)
+                {
+                    pGroup[c * lNumLanes + lLane] = lFrom[c * lNumLanes];
+                }
+            }
+        }
+
+        // the direction is split between the cells of the faces of a cube, and
+        // each cell keeps the triangles found at its corners, its centre and
+        // the middles of its edges, which are searched first
+        void computeCells()
+        {
+            const size_t lNumLanes = (size_t)simd::kFloatLanes;
+            const size_t lNumCells = 6 * kCellsPerEdge * kCellsPerEdge;
+            mCellTriangles.clear();
+            mCellInverses.clear();
+            if (mTriangles.empty())
+            {
+                return;
+            }
+            mCellTriangles.resize(lNumCells * lNumLanes);
+            mCellInverses.resize(lNumCells * 9 * lNumLanes);
+            for (size_t lCell = 0 ; lCell != lNumCells ; ++lCell)
+            {
+                const int lFace = (int)lCell / (kCellsPerEdge * kCellsPerEdge);
+                const int lRow = ((int)lCell / kCellsPerEdge) % kCellsPerEdge;
+                const int lColumn = (int)lCell % kCellsPerEdge;
+                size_t* lTriangles = mCellTriangles.data() + lCell * lNumLanes;
+                size_t lNumTriangles = 0;
+                for (int i = 0 ; i != 9 ; ++i)
+                {
+                    const float u = ((float)lColumn + 0.5f * (float)(i % 3)) * 2.f / (float)kCellsPerEdge - 1.f;
+                    const float v = ((float)lRow + 0.5f * (float)(i / 3)) * 2.f / (float)kCellsPerEdge - 1.f;
+                    const float w = lFace % 2 == 0 ? 1.f : -1.f;
+                    const Vector3f lDirection = lFace < 2 ? Vector3f::cartesian(w, u, v)
+                                              : (lFace < 4 ? Vector3f::cartesian(u, w, v) : Vector3f::cartesian(u, v, w));
+                    float lGains[3];
+                    const size_t t = searchTriangles(lDirection, lGains);
+                    if (lNumTriangles < lNumLanes && std::find(lTriangles, lTriangles + lNumTriangles, t) == lTriangles + lNumTriangles)
+                    {
+                        lTriangles[lNumTriangles++] = t;
+                    }
+                }
+                std::fill(lTriangles + lNumTriangles, lTriangles + lNumLanes, lTriangles[0]);
+                copyInverses(lTriangles, mCellInverses.data() + lCell * 9 * lNumLanes);
+            }
+        }
+
+        static size_t cellIndex(const Vector3f& pDirection)
+        {
+            const float ax = std::abs(pDirection.mX), ay = std::abs(pDirection.mY), az = std::abs(pDirection.mZ);
+            int lFace;
+            float u, v, lInvMax;
+            if (ax >= ay && ax >= az)
+            {
+                lFace = pDirection.mX >= 0.f ? 0 : 1;
+                lInvMax = 1.f / ax;
+                u = pDirection.mY;
+                v = pDirection.mZ;
+            }
+            else if (ay >= az)
+            {
+                lFace = pDirection.mY >= 0.f ? 2 : 3;
+                lInvMax = 1.f / ay;
+                u = pDirection.mX;
+                v = pDirection.mZ;
+            }
+            else
+            {
+                lFace = pDirection.mZ >= 0.f ? 4 : 5;
+                lInvMax = 1.f / az;
+                u = pDirection.mX;
+                v = pDirection.mY;
+            }
+            const float lScale = 0.5f * (float)kCellsPerEdge * lInvMax;
+            const int lColumn = std::min((int)(u * lScale + 0.5f * (float)kCellsPerEdge), kCellsPerEdge - 1);
+            const int lRow = std::min((int)(v * lScale + 0.5f * (float)kCellsPerEdge), kCellsPerEdge - 1);
+            return (size_t)((lFace * kCellsPerEdge + lRow) * kCellsPerEdge + lColumn);
+        }
+
+        // the first lane of the group of 4 triangles pGroup where pDirection
+        // is, with its gains before normalization, or -1
+        static int searchGroup(const float* pGroup, simd::vfloat x, simd::vfloat y, simd::vfloat z,
+                               simd::vfloat pThreshold, float (&pGains)[3])
+        {
+            using namespace fbu::simd;
+            vfloat lGains[3];
+            for (int k = 0 ; k != 3 ; ++k)
+            {
+                const float* lColumn = pGroup + 3 * k * kFloatLanes;
+                lGains[k] = mulAdd(x, load(lColumn), mulAdd(y, load(lColumn + kFloatLanes), z * load(lColumn + 2 * kFloatLanes)));
+            }
+            const int lInside = moveMask(min(lGains[0], min(lGains[1], lGains[2])) >= pThreshold);
+            if (lInside == 0)
+            {
+                return -1;
+            }
+            const int lLane = bits::ctz((uint32_t)lInside);
+            float lLanes[kFloatLanes];
+            for (int k = 0 ; k != 3 ; ++k)
+            {
+                store(lLanes, lGains[k]);
+                pGains[k] = lLanes[lLane];
+            }
+            return lLane;
+        }
+
+        // the triangle of pDirection, and its gains before normalization
+        size_t findTriangle(const Vector3f& pDirection, float (&pGains)[3]) const
+        {
+            using namespace fbu::simd;
+            const size_t lCell = cellIndex(pDirection);
+            const int lLane = searchGroup(mCellInverses.data() + lCell * 9 * kFloatLanes,
+                                          set1(pDirection.mX), set1(pDirection.mY), set1(pDirection.mZ),
+                                          set1(-kInsideTolerance * pDirection.length()), pGains);
+            if (lLane >= 0)
+            {
+                return mCellTriangles[lCell * kFloatLanes + (size_t)lLane];
+            }
+            return searchTriangles(pDirection, pGains);
+        }
+
+        size_t searchTriangles(const Vector3f& pDirection, float (&pGains)[3]) const
+        {
+            using namespace fbu::simd;
+            const vfloat x = set1(pDirection.mX);
+            const vfloat y = set1(pDirection.mY);
+            const vfloat z = set1(pDirection.mZ);
+            const vfloat lThreshold = set1(-kInsideTolerance * pDirection.length());
+            const float* const lEnd = mInverses.data() + mInverses.size();
+            for (const float* lGroup = mInverses.data() ; lGroup != lEnd ; lGroup += 9 * kFloatLanes)
+            {
+                const int lLane = searchGroup(lGroup, x, y, z, lThreshold, pGains);
+                if (lLane >= 0)
+                {
+                    const size_t lTriangle = (size_t)(lGroup - mInverses.data()) / 9 + (size_t)lLane;
+                    return std::min(lTriangle, mTriangles.size() - 1);
+                }
+            }
+            // in a hole of the layout: the triangle whose gains, the negative
+            // ones at 0, pan the nearest to pDirection
+            size_t lBest = 0;
+            float lBestCosine = -std::numeric_limits<float>::infinity();
+            for (size_t t = 0 ; t != mTriangles.size() ; ++t)
+            {
+                Vector3f lPanned = Vector3f::cartesian(0.f, 0.f, 0.f);
+                for (size_t k = 0 ; k != 3 ; ++k)
+                {
+                    lPanned += std::max(0.f, gain(t, k, pDirection)) * mSpeakers[mTriangles[t].mSpeakers[k]];
+                }
+                if (! lPanned.isZero())
+                {
+                    const float lCosine = lPanned.dot(pDirection) / lPanned.length();
+                    if (lCosine > lBestCosine)
+                    {
+                        lBestCosine = lCosine;
+                        lBest = t;
+                    }
+                }
+            }
+            for (size_t k = 0 ; k != 3 ; ++k)
+            {
+                pGains[k] = gain(lBest, k, pDirection);
+            }
+            return lBest;
+        }
+
+        size_t findNearestSpeaker(const Vector3f& pDirection) const
+        {
+            size_t lNearest = 0;
+            for (size_t i = 1 ; i != mSpeakers.size() ; ++i)
+            {
+                if (mSpeakers[i].dot(pDirection) > mSpeakers[lNearest].dot(pDirection))
+                {
+                    lNearest = i;
+                }
+            }
+            return lNearest;
+        }
+
+        std::vector<Vector3f> mSpeakers;
+        std::vector<Triangle> mTriangles;
+        simd::AlignedVector<float> mInverses;
+        std::vector<size_t> mCellTriangles;         ///< 4 per cell
+        simd::AlignedVector<float> mCellInverses;   ///< of mCellTriangles, as mInverses
+    };
+
+    //==============================================================================
+    /**
+     @class VbapGainCache
+     @brief The gains of a Vbap on a grid of directions, for the static sources.
+
+     The directions are rounded to the grid, whose cells are computed at their
+     first use. The cache must be cleared when the speakers of the Vbap change.
+     */
+    class VbapGainCache
+    {
+    public:
+        /**
+         pResolution is the step of the grid, in radians.
+         */
+        explicit VbapGainCache(const Vbap& pVbap, float pResolution = DEG2RADf)
+        : mVbap(pVbap)
+        , mNumAzimuths(std::max(1, (int)std::lround(2.f * M_PIf / pResolution)))
+        , mNumElevations((int)std::lround(M_PIf / pResolution) + 1)
+        , mAzimuthStep(2.f * M_PIf / (float)mNumAzimuths)
+        , mElevationStep(M_PIf / (float)std::max(1, mNumElevations - 1))
+        , mGains((size_t)(mNumAzimuths * mNumElevations))
+        , mIsComputed((size_t)(mNumAzimuths * mNumElevations), false)
+        {
+        }
+
+        const Vbap::Gains& getGains(const AE<float>& pDirection)
+        {
+            const float lAzimuth = mu::domainAngle(pDirection.mAzimuth) + M_PIf;
+            const float lElevation = std::min(std::max(pDirection.mElevation, -M_PI_2f), M_PI_2f) + M_PI_2f;
+            const int lAzimuthIndex = (int)std::lround(lAzimuth / mAzimuthStep) % mNumAzimuths;
+            const int lElevationIndex = std::min((int)std::lround(lElevation / mElevationStep), mNumElevations - 1);
+            const size_t lCell = (size_t)(lElevationIndex * mNumAzimuths + lAzimuthIndex);
+            if (! mIsComputed[lCell])
+            {
+                mGains[lCell] = mVbap.computeGains(AE<float>::ae((float)lAzimuthIndex * mAzimuthStep - M_PIf,
+                                                                 (float)lElevationIndex * mElevationStep - M_PI_2f));
+                mIsComputed[lCell] = true;
+            }
+            return mGains[lCell];
+        }
+
+        const Vbap::Gains& getGains(const AEM<float>& pDirection)
+        {
+            return getGains(AE<float>::fromAEM(pDirection));
+        }
+
+        void clear()
+        {
+            std::fill(mIsComputed.begin(), mIsComputed.end(), false);
+        }
+
+    private:
+        const Vbap& mVbap;
+        const int mNumAzimuths;
+        const int mNumElevations;
+        const float mAzimuthStep;
+        const float mElevationStep;
+        std::vector<Vbap::Gains> mGains;
+        std::vector<bool> mIsComputed;
+    };
+}
+
+#endif // FBU_VBAP_HPP_INCLUDED
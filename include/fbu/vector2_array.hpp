@@ -0,0 +1,453 @@
+#ifndef FBU_VECTOR2_ARRAY_HPP_INCLUDED
+#define FBU_VECTOR2_ARRAY_HPP_INCLUDED
+
+/**
+ @file vector2_array.hpp
+ @author François Becker
+
+MIT License
+
+Copyright (c) 2018 François Becker
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "fbu/math_approx.hpp"
+#include "fbu/math_vect.hpp"
+#include "fbu/simd.hpp"
+#include "fbu/vector2.hpp"
+#include "fbu/vector3_array.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+/*
+ Batches of Vector2 stored as structure of arrays, as Vector3Array: the X and
+ Y of all the vectors in two aligned arrays, zero-padded to whole SIMD
+ vectors. The float operations are vectorized, the others run the Vector2
+ code. The polar conversions use the approximations of math_approx.hpp.
+ */
+
+namespace fbu
+{
+    //==============================================================================
+    /**
+     @class Vector2Array
+     @brief A batch of Vector2 in structure of arrays layout.
+
+     The elements are read and written through proxies that have the mX and
+     mY members of Vector2 and convert from and to Vector2.
+     */
+    template <typename T>
+    class Vector2Array
+    {
+    public:
+        /**
+         An element of the array, with the members of a Vector2.
+         */
+        struct Reference
+        {
+            T& mX;
+            T& mY;
+
+            operator Vector2<T>() const
+            {
+                return Vector2<T>(mX, mY);
+            }
+
+            Reference& operator=(const Vector2<T>& pVect)
+            {
+                mX = pVect.mX;
+                mY = pVect.mY;
+                return *this;
+            }
+
+            Reference& operator=(const Reference& pOther)
+            {
+                return *this = (Vector2<T>)pOther;
+            }
+        };
+
+        /// the arrays are padded to a multiple of kPadding elements
+        static constexpr size_t kPadding = (size_t)simd::kFloatLanes;
+
+        Vector2Array() = default;
+
+        explicit Vector2Array(size_t pSize)
+        {
+            resize(pSize);
+        }
+
+        explicit Vector2Array(const std::vector< Vector2<T> >& pVectors)
+        {
+            assign(pVectors.data(), pVectors.size());
+        }
+
+        void assign(const Vector2<T>* pVectors, size_t pSize)
+        {
+            resize(pSize);
+            for (size_t i = 0 ; i != pSize ; ++i)
+            {
+                (*this)[i] = pVectors[i];
+            }
+        }
+
+        void copyTo(Vector2<T>* pVectors) const
+        {
+            for (size_t i = 0 ; i != mSize ; ++i)
+            {
+                pVectors[i] = (*this)[i];
+            }
+        }
+
+        size_t size() const
+        {
+            return mSize;
+        }
+
+        bool empty() const
+        {
+            return mSize == 0;
+        }
+
+        /**
+         size() rounded up to kPadding: the length of the arrays.
+         */
+        size_t paddedSize() const
+        {
+            return mX.size();
+        }
+
+        /**
+         The new elements are zero.
+         */
+        void resize(size_t pSize)
+        {
+            const size_t lPaddedSize = (pSize + kPadding - 1) / kPadding * kPadding;
+            mX.resize(std::max(lPaddedSize, mX.size()), (T)0);
+            mY.resize(std::max(lPaddedSize, mY.size()), (T)0);
+            mSize = std::min(mSize, pSize);
+            clearPadding();
+            mX.resize(lPaddedSize);
+            mY.resize(lPaddedSize);
+            mSize = pSize;
+        }
+
+        void clear()
+        {
+            resize(0);
+        }
+
+        void push_back(const Vector2<T>& pVect)
+        {
+            resize(mSize + 1);
+            (*this)[mSize - 1] = pVect;
+        }
+
+        Reference operator[](size_t pIndex)
+        {
+            assert(pIndex < mSize);
+            return Reference{mX[pIndex], mY[pIndex]};
+        }
+
+        Vector2<T> operator[](size_t pIndex) const
+        {
+            assert(pIndex < mSize);
+            return Vector2<T>(mX[pIndex], mY[pIndex]);
+        }
+
+        T* x() { return mX.data(); }
+        T* y() { return mY.data(); }
+        const T* x() const { return mX.data(); }
+        const T* y() const { return mY.data(); }
+
+        /**
+         Vector2::normalize() of all the elements, with the zero vectors left
+         at zero. For float, 1/length is mu::vectRsqrt() at pAccuracy.
+         */
+        void normalize(mu::Accuracy pAccuracy = mu::Accuracy::high)
+        {
+            normalize(pAccuracy, IsFloat());
+        }
+
+    private:
+        typedef typename std::is_same<T, float>::type IsFloat;
+
+        // zeros after the mSize elements
+        void clearPadding()
+        {
+            std::fill(mX.begin() + (ptrdiff_t)mSize, mX.end(), (T)0);
+            std::fill(mY.begin() + (ptrdiff_t)mSize, mY.end(), (T)0);
+        }
+
+        void normalize(mu::Accuracy, std::false_type)
+        {
+            for (size_t i = 0 ; i != mSize ; ++i)
+            {
+                Vector2<T> lVect = (*this)[i];
+                if (lVect.sqrLength() != (T)0)
+                {
+                    lVect.normalize();
+                }
+                (*this)[i] = lVect;
+            }
+        }
+
+        void normalize(mu::Accuracy pAccuracy, std::true_type)
+        {
+            switch (pAccuracy)
+            {
+                case mu::Accuracy::coarse: normalize<mu::Accuracy::coarse>(); break;
+                case mu::Accuracy::medium: normalize<mu::Accuracy::medium>(); break;
+                case mu::Accuracy::high:   normalize<mu::Accuracy::high>(); break;
+            }
+        }
+
+        template <mu::Accuracy A>
+        void normalize()
+        {
+            using namespace fbu::simd;
+            for (size_t u = 0 ; u != paddedSize() ; u += (size_t)kFloatLanes)
+            {
+                const vfloat x = load(mX.data() + u);
+                const vfloat y = load(mY.data() + u);
+                const vfloat lSqrLength = mulAdd(x, x, y * y);
+                const vfloat lInvLength = mu::detail::rsqrt<A>(lSqrLength);
+                const vmask lIsZero = lSqrLength == zero();
+                store(mX.data() + u, select(lIsZero, x, x * lInvLength));
+                store(mY.data() + u, select(lIsZero, y, y * lInvLength));
+            }
+        }
+
+        simd::AlignedVector<T> mX;
+        simd::AlignedVector<T> mY;
+        size_t mSize = 0;
+    };
+
+    //==============================================================================
+    namespace detail
+    {
+        // the values u to u + 3 of pIn, which holds pSize values, zero-padded
+        inline simd::vfloat loadPadded(const float* pIn, size_t pSize, size_t u)
+        {
+            using namespace fbu::simd;
+            if (u + (size_t)kFloatLanes <= pSize)
+            {
+                return load(pIn + u);
+            }
+            float lTail[kFloatLanes] = {};
+            std::copy(pIn + u, pIn + pSize, lTail);
+            return load(lTail);
+        }
+
+        template <typename T>
+        inline void dot(const Vector2Array<T>& pA, const Vector2Array<T>& pB, T* pOut, std::false_type)
+        {
+            for (size_t i = 0 ; i != pA.size() ; ++i)
+            {
+                pOut[i] = pA[i].dot(pB[i]);
+            }
+        }
+
+        inline void dot(const Vector2Array<float>& pA, const Vector2Array<float>& pB, float* pOut, std::true_type)
+        {
+            using namespace fbu::simd;
+            storeEach(pOut, pA.size(), [&](size_t u)
+            {
+                return mulAdd(load(pA.x() + u), load(pB.x() + u), load(pA.y() + u) * load(pB.y() + u));
+            });
+        }
+
+        template <typename T>
+        inline void dot(const Vector2Array<T>& pA, const Vector2<T>& pB, T* pOut, std::false_type)
+        {
+            for (size_t i = 0 ; i != pA.size() ; ++i)
+            {
+                pOut[i] = pA[i].dot(pB);
+            }
+        }
+
+        inline void dot(const Vector2Array<float>& pA, const Vector2<float>& pB, float* pOut, std::true_type)
+        {
+            using namespace fbu::simd;
+            const vfloat lX = set1(pB.mX);
+            const vfloat lY = set1(pB.mY);
+            storeEach(pOut, pA.size(), [&](size_t u)
+            {
+                return mulAdd(load(pA.x() + u), lX, load(pA.y() + u) * lY);
+            });
+        }
+
+        template <typename T>
+        inline void lengths(const Vector2Array<T>& pA, T* pOut, std::false_type)
+        {
+            for (size_t i = 0 ; i != pA.size() ; ++i)
+            {
+                pOut[i] = pA[i].length();
+            }
+        }
+
+        // sqrt(x^2 + y^2) rather than the hypot() of Vector2::length(), for
+        // the vectors of less than about 1e19
+        inline void lengths(const Vector2Array<float>& pA, float* pOut, std::true_type)
+        {
+            using namespace fbu::simd;
+            storeEach(pOut, pA.size(), [&](size_t u)
+            {
+                const vfloat x = load(pA.x() + u), y = load(pA.y() + u);
+                return sqrt(mulAdd(x, x, y * y));
+            });
+        }
+
+        template <typename T>
+        inline void rotate(const Vector2Array<T>& pIn, T pSin, T pCos, Vector2Array<T>& pOut, std::false_type)
+        {
+            for (size_t i = 0 ; i != pIn.size() ; ++i)
+            {
+                const Vector2<T> v = pIn[i];
+                pOut[i] = Vector2<T>(pCos * v.mX - pSin * v.mY, pSin * v.mX + pCos * v.mY);
+            }
+        }
+
+        inline void rotate(const Vector2Array<float>& pIn, float pSin, float pCos, Vector2Array<float>& pOut, std::true_type)
+        {
+            using namespace fbu::simd;
+            const vfloat s = set1(pSin);
+            const vfloat c = set1(pCos);
+            for (size_t u = 0 ; u != pIn.paddedSize() ; u += (size_t)kFloatLanes)
+            {
+                const vfloat x = load(pIn.x() + u), y = load(pIn.y() + u);
+                store(pOut.x() + u, c * x - s * y);
+                store(pOut.y() + u, mulAdd(s, x, c * y));
+            }
+        }
+
+        template <mu::Accuracy A>
+        inline void polarToVector2(const float* pAngles, const float* pMagnitudes, size_t pSize, Vector2Array<float>& pOut)
+        {
+            using namespace fbu::simd;
+            const float lIndices[kFloatLanes] = {0.f, 1.f, 2.f, 3.f};
+            for (size_t u = 0 ; u < pSize ; u += (size_t)kFloatLanes)
+            {
+                vfloat s, c;
+                mu::approx::sincos<A>(loadPadded(pAngles, pSize, u), s, c);
+                vfloat m = pMagnitudes != nullptr ? loadPadded(pMagnitudes, pSize, u) : set1(1.f);
+                if (u + (size_t)kFloatLanes > pSize)
+                {
+                    // the padding stays zero
+                    m = select(load(lIndices) < set1((float)(pSize - u)), m, zero());
+                }
+                store(pOut.x() + u, m * c);
+                store(pOut.y() + u, m * s);
+            }
+        }
+
+        template <mu::Accuracy A>
+        inline void vector2ToPolar(const Vector2Array<float>& pIn, float* pAngles, float* pMagnitudes)
+        {
+            using namespace fbu::simd;
+            storeEach(pAngles, pIn.size(), [&](size_t u)
+            {
+                return mu::approx::atan2<A>(load(pIn.y() + u), load(pIn.x() + u));
+            });
+            if (pMagnitudes != nullptr)
+            {
+                lengths(pIn, pMagnitudes, std::true_type());
+            }
+        }
+    }
+
+    /**
+     pOut[i] = pA[i].dot(pB[i]), pOut holding pA.size() values.
+     */
+    template <typename T>
+    void dot(const Vector2Array<T>& pA, const Vector2Array<T>& pB, T* pOut)
+    {
+        assert(pA.size() == pB.size());
+        detail::dot(pA, pB, pOut, typename std::is_same<T, float>::type());
+    }
+
+    /**
+     pOut[i] = pA[i].dot(pB), e.g. the projections of points on an axis.
+     */
+    template <typename T>
+    void dot(const Vector2Array<T>& pA, const Vector2<T>& pB, T* pOut)
+    {
+        detail::dot(pA, pB, pOut, typename std::is_same<T, float>::type());
+    }
+
+    /**
+     pOut[i] = pA[i].length(), pOut holding pA.size() values.
+     */
+    template <typename T>
+    void lengths(const Vector2Array<T>& pA, T* pOut)
+    {
+        detail::lengths(pA, pOut, typename std::is_same<T, float>::type());
+    }
+
+    /**
+     pOut[i] = pIn[i].rotated(pAngle), pOut being resized. pOut may be pIn.
+     */
+    template <typename T>
+    void rotate(const Vector2Array<T>& pIn, T pAngle, Vector2Array<T>& pOut)
+    {
+        pOut.resize(pIn.size());
+        detail::rotate(pIn, std::sin(pAngle), std::cos(pAngle), pOut, typename std::is_same<T, float>::type());
+    }
+
+    /**
+     The vectors of angles pAngles (rad, from X to Y) and magnitudes
+     pMagnitudes, or 1 when nullptr: pOut is resized to pSize. Max error of
+     the unit vectors: 4e-4 (coarse), 1.5e-6 (medium), 1e-7 (high), for
+     |angle| <= 65536.
+     */
+    inline void polarToVector2(const float* pAngles, const float* pMagnitudes, size_t pSize,
+                               Vector2Array<float>& pOut, mu::Accuracy pAccuracy = mu::Accuracy::high)
+    {
+        pOut.resize(pSize);
+        switch (pAccuracy)
+        {
+            case mu::Accuracy::coarse: detail::polarToVector2<mu::Accuracy::coarse>(pAngles, pMagnitudes, pSize, pOut); break;
+            case mu::Accuracy::medium: detail::polarToVector2<mu::Accuracy::medium>(pAngles, pMagnitudes, pSize, pOut); break;
+            case mu::Accuracy::high:   detail::polarToVector2<mu::Accuracy::high>(pAngles, pMagnitudes, pSize, pOut); break;
+        }
+    }
+
+    /**
+     The angles in [-π, π], as atan2(y, x), and the lengths of the vectors,
+     pMagnitudes being optional. Max error of the angles: 1.5e-4 (coarse),
+     7e-7 (medium), 3e-7 (high).
+     */
+    inline void vector2ToPolar(const Vector2Array<float>& pIn, float* pAngles, float* pMagnitudes = nullptr,
+                               mu::Accuracy pAccuracy = mu::Accuracy::high)
+    {
+        switch (pAccuracy)
+        {
+            case mu::Accuracy::coarse: detail::vector2ToPolar<mu::Accuracy::coarse>(pIn, pAngles, pMagnitudes); break;
+            case mu::Accuracy::medium: detail::vector2ToPolar<mu::Accuracy::medium>(pIn, pAngles, pMagnitudes); break;
+            case mu::Accuracy::high:   detail::vector2ToPolar<mu::Accuracy::high>(pIn, pAngles, pMagnitudes); break;
+        }
+    }
+}
+
+#endif // FBU_VECTOR2_ARRAY_HPP_INCLUDED
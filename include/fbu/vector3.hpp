@@ -34,6 +34,20 @@ SOFTWARE.
 #include <cmath>
 #include <cassert>
 
+/**
+ 1 for the fast trigonometric approximations of math_utils.hpp in the
+ conversions between Vector3 and AE/AEM/AEMr, instead of libm: the default
+ with Emscripten. fbu/spherical_conversions.hpp has the batch versions, with
+ a runtime choice of precision.
+ */
+#ifndef FBU_VECTOR3_FAST_TRIG
+#ifdef __EMSCRIPTEN__
+#define FBU_VECTOR3_FAST_TRIG 1
+#else
+#define FBU_VECTOR3_FAST_TRIG 0
+#endif
+#endif
+
 template <typename T> struct AE;
 template <typename T> struct AEM;
 template <typename T> struct AEMr;
@@ -67,13 +81,13 @@ struct Vector3
         return mX == (T)0.f && mY == (T)0.f && mZ == (T)0.f;
     }
     
+    /**
+     With mu::mulAdd(), in the order of the Vector3Array kernels, which give
+     the same results.
+     */
     T dot(const Vector3<T>& pOther) const
     {
-        T lResult;
-        lResult = mX * pOther.mX;
-        lResult += mY * pOther.mY;
-        lResult += mZ * pOther.mZ;
-        return lResult;
+        return mu::mulAdd(mX, pOther.mX, mu::mulAdd(mY, pOther.mY, mZ * pOther.mZ));
     }
     
     Vector3<T> cross(const Vector3<T>& pOther) const
@@ -87,13 +101,13 @@ struct Vector3
     
     T length() const
     {
-        return std::sqrt(mX * mX + mY * mY + mZ * mZ);
+        return std::sqrt(sqrLength());
         // or? return std::hypot(mZ, std::hypot(mX, mY));
     }
     
     T sqrLength() const
     {
-        return mX * mX + mY * mY + mZ * mZ;
+        return dot(*this);
     }
     
     void lengthes(T& pLength3D, T& pLength2D) const
@@ -176,7 +190,7 @@ Vector3<T> operator *(T pS, const Vector3<T>& pV)
 }
 
 template <typename T>
-Vector3<T> operator *=(Vector3<T>& pV, T pS)
+Vector3<T>& operator *=(Vector3<T>& pV, T pS)
 {
     pV.mX *= pS;
     pV.mY *= pS;
@@ -185,7 +199,7 @@ Vector3<T> operator *=(Vector3<T>& pV, T pS)
 }
 
 template <typename T>
-Vector3<T> operator +=(Vector3<T>& pV, const Vector3<T>& pA)
+Vector3<T>& operator +=(Vector3<T>& pV, const Vector3<T>& pA)
 {
     pV.mX += pA.mX;
     pV.mY += pA.mY;
@@ -193,6 +207,26 @@ Vector3<T> operator +=(Vector3<T>& pV, const Vector3<T>& pA)
     return pV;
 }
 
+/**
+ pA * pX + pY, fused with mu::mulAdd().
+ */
+template <typename T>
+Vector3<T> axpy(T pA, const Vector3<T>& pX, const Vector3<T>& pY)
+{
+    return Vector3<T>::cartesian(mu::mulAdd(pA, pX.mX, pY.mX),
+                                 mu::mulAdd(pA, pX.mY, pY.mY),
+                                 mu::mulAdd(pA, pX.mZ, pY.mZ));
+}
+
+/**
+ pA + pT * (pB - pA): pA at 0 and pB at 1.
+ */
+template <typename T>
+Vector3<T> lerp(const Vector3<T>& pA, const Vector3<T>& pB, T pT)
+{
+    return axpy(pT, pB - pA, pA);
+}
+
 template <typename T>
 bool operator <(const Vector3<T>& pA, const Vector3<T>& pB)
 {
@@ -241,8 +275,8 @@ struct AE
         AE lAE;
         lAE.mAzimuth = std::atan2(pVect.mY, pVect.mX);
         assert(mu::inRange(pVect.mZ, (T)(-1), (T)1));
-#ifdef __EMSCRIPTEN__
-        lAE.mElevation = mu::fast_asin4_3(pVect.mZ);
+#if FBU_VECTOR3_FAST_TRIG
+        lAE.mElevation = (T)mu::fast_asin4_3((float)pVect.mZ);
 #else
         lAE.mElevation = std::asin(pVect.mZ);
 #endif
@@ -279,7 +313,7 @@ struct AEM
     static AEM<T> fromVector3(const Vector3<T>& pVect)
     {
         AEM lAEM;
-        float lNorm2D;
+        T lNorm2D;
         pVect.lengthes(lAEM.mMagnitude, lNorm2D);
         lAEM.mAzimuth = std::atan2(pVect.mY, pVect.mX);
         lAEM.mElevation = std::atan2(pVect.mZ, lNorm2D);
@@ -291,8 +325,8 @@ struct AEM
         AEM lAEM;
         lAEM.mAzimuth = std::atan2(pVect.mY, pVect.mX);
         assert(mu::inRange(pVect.mZ, (T)(-1), (T)1));
-#ifdef __EMSCRIPTEN__
-        lAEM.mElevation = mu::fast_asin4_3(pVect.mZ);
+#if FBU_VECTOR3_FAST_TRIG
+        lAEM.mElevation = (T)mu::fast_asin4_3((float)pVect.mZ);
 #else
         lAEM.mElevation = std::asin(pVect.mZ);
 #endif
@@ -357,25 +391,25 @@ typedef AEMr<float> AEMrf;
 template <typename T>
 void Vector3_to_AEMr(const Vector3<T>& pVect, AEMr<T>& pAEM)
 {
-    pAEM.mAzimuth = 0.f;
-    pAEM.mElevation = 0.f;
-    float lMagnitude2D = std::hypot(pVect.mX, pVect.mY);
+    pAEM.mAzimuth = (T)0;
+    pAEM.mElevation = (T)0;
+    T lMagnitude2D = std::hypot(pVect.mX, pVect.mY);
     pAEM.mMagnitude = std::hypot(lMagnitude2D, pVect.mZ);
-    if (pAEM.mMagnitude != 0.f)
+    if (pAEM.mMagnitude != (T)0)
     {
         T lSinElevation = pVect.mZ / pAEM.mMagnitude;
-        assert(inRange(lSinElevation, (T)(-1), (T)1));
-#ifdef __EMSCRIPTEN__
-        pAEM.mElevation = mu::fast_asin4_3(lSinElevation);
+        assert(mu::inRange(lSinElevation, (T)(-1), (T)1));
+#if FBU_VECTOR3_FAST_TRIG
+        pAEM.mElevation = (T)mu::fast_asin4_3((float)lSinElevation);
 #else
         pAEM.mElevation = std::asin(lSinElevation);
 #endif
-        if (std::abs(pAEM.mElevation) <= M_PI_2f - (0.5f * DEG2RADf))
+        if (std::abs(pAEM.mElevation) <= (T)(M_PI_2f - (0.5f * DEG2RADf)))
         {
             T lCosAzimuth = pVect.mX / lMagnitude2D;
-            assert(inRange(lCosAzimuth, (T)(-1), (T)1));
+            assert(mu::inRange(lCosAzimuth, (T)(-1), (T)1));
             pAEM.mAzimuth = std::acos(lCosAzimuth);
-            if (pVect.mY > 0.f)
+            if (pVect.mY > (T)0)
             {
                 pAEM.mAzimuth = -pAEM.mAzimuth;
             }
@@ -388,10 +422,10 @@ template <typename T>
 Vector3<T> Vector3<T>::fromAEMr(const AEMr<T>& pAEM)
 {
     Vector3<T> lVect;
-    float lCosAzimuth = std::cos(pAEM.mAzimuth);
-    float lSinAzimuth = std::sin(pAEM.mAzimuth);
-    float lCosElevation = std::cos(pAEM.mElevation);
-    float lSinElevation = std::sin(pAEM.mElevation);
+    T lCosAzimuth = std::cos(pAEM.mAzimuth);
+    T lSinAzimuth = std::sin(pAEM.mAzimuth);
+    T lCosElevation = std::cos(pAEM.mElevation);
+    T lSinElevation = std::sin(pAEM.mElevation);
     lVect.mX = pAEM.mMagnitude * lCosElevation * lCosAzimuth;
     lVect.mY = - pAEM.mMagnitude * lCosElevation * lSinAzimuth;
     lVect.mZ = pAEM.mMagnitude * lSinElevation;
@@ -403,16 +437,17 @@ template <typename T>
 Vector3<T> Vector3<T>::fromAEM(const AEM<T>& pAEM)
 {
     Vector3<T> lVect;
-#ifdef __EMSCRIPTEN__
-    float lCosAzimuth = mu::fastCos8(pAEM.mAzimuth);
-    float lSinAzimuth = mu::fastSin9(pAEM.mAzimuth);
-    float lCosElevation = mu::fastCos8(pAEM.mElevation);
-    float lSinElevation = mu::fastSin9(pAEM.mElevation);
+#if FBU_VECTOR3_FAST_TRIG
+    // the approximations are in float
+    T lCosAzimuth = (T)mu::fastCos8((float)pAEM.mAzimuth);
+    T lSinAzimuth = (T)mu::fastSin9((float)pAEM.mAzimuth);
+    T lCosElevation = (T)mu::fastCos8((float)pAEM.mElevation);
+    T lSinElevation = (T)mu::fastSin9((float)pAEM.mElevation);
 #else
-    float lCosAzimuth = std::cos(pAEM.mAzimuth);
-    float lSinAzimuth = std::sin(pAEM.mAzimuth);
-    float lCosElevation = std::cos(pAEM.mElevation);
-    float lSinElevation = std::sin(pAEM.mElevation);
+    T lCosAzimuth = std::cos(pAEM.mAzimuth);
+    T lSinAzimuth = std::sin(pAEM.mAzimuth);
+    T lCosElevation = std::cos(pAEM.mElevation);
+    T lSinElevation = std::sin(pAEM.mElevation);
 #endif
     lVect.mX = pAEM.mMagnitude * lCosElevation * lCosAzimuth;
     lVect.mY = pAEM.mMagnitude * lCosElevation * lSinAzimuth;
@@ -425,16 +460,17 @@ template <typename T>
 Vector3<T> Vector3<T>::fromAE(const AE<T>& pAE)
 {
     Vector3<T> lVect;
-#ifdef __EMSCRIPTEN__
-    float lCosAzimuth = mu::fastCos8(pAE.mAzimuth);
-    float lSinAzimuth = mu::fastSin9(pAE.mAzimuth);
-    float lCosElevation = mu::fastCos8(pAE.mElevation);
-    float lSinElevation = mu::fastSin9(pAE.mElevation);
+#if FBU_VECTOR3_FAST_TRIG
+    // the approximations are in float
+    T lCosAzimuth = (T)mu::fastCos8((float)pAE.mAzimuth);
+    T lSinAzimuth = (T)mu::fastSin9((float)pAE.mAzimuth);
+    T lCosElevation = (T)mu::fastCos8((float)pAE.mElevation);
+    T lSinElevation = (T)mu::fastSin9((float)pAE.mElevation);
 #else
-    float lCosAzimuth = std::cos(pAE.mAzimuth);
-    float lSinAzimuth = std::sin(pAE.mAzimuth);
-    float lCosElevation = std::cos(pAE.mElevation);
-    float lSinElevation = std::sin(pAE.mElevation);
+    T lCosAzimuth = std::cos(pAE.mAzimuth);
+    T lSinAzimuth = std::sin(pAE.mAzimuth);
+    T lCosElevation = std::cos(pAE.mElevation);
+    T lSinElevation = std::sin(pAE.mElevation);
 #endif
     lVect.mX = lCosElevation * lCosAzimuth;
     lVect.mY = lCosElevation * lSinAzimuth;
@@ -0,0 +1,767 @@
+#ifndef FBU_VECTOR3_ARRAY_HPP_INCLUDED
+#define FBU_VECTOR3_ARRAY_HPP_INCLUDED
+
+/**
+ @file vector3_array.hpp
+ @author François Becker
+
+MIT License
+
+Copyright (c) 2018 François Becker
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "fbu/math_vect.hpp"
+#include "fbu/simd.hpp"
+#include "fbu/vector3.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+/*
+ Batches of Vector3 stored as structure of arrays: the X, Y and Z of all the
+ vectors in three aligned arrays, zero-padded to whole SIMD vectors, so that
+ the bulk operations load 4 vectors at a time and have no scalar tails. The
+ float operations are vectorized, the others run the Vector3 code.
+ */
+
+namespace fbu
+{
+    template <typename T> class Vector3Array;
+
+    namespace detail
+    {
+        /**
+         Calls pOp(u) for the vectors of elements u..u+3, and stores the result
+         to pOut, which holds only pSize values: the last partial vector goes
+         through a scratch buffer, never stored whole to pOut.
+         */
+        template <class Op>
+        inline void storeEach(float* pOut, size_t pSize, Op pOp)
+        {
+            using namespace fbu::simd;
+            const size_t lNumWhole = pSize - pSize % (size_t)kFloatLanes;
+            for (size_t u = 0 ; u < lNumWhole ; u += (size_t)kFloatLanes)
+            {
+                store(pOut + u, pOp(u));
+            }
+            if (lNumWhole != pSize)
+            {
+                float lTail[kFloatLanes] = {};
+                store(lTail, pOp(lNumWhole));
+                std::copy(lTail, lTail + (pSize - lNumWhole), pOut + lNumWhole);
+            }
+        }
+
+        template <mu::Accuracy A>
+        inline void normalize(float* pX, float* pY, float* pZ, size_t pPaddedSize,
+                              bool pUseDefault, const Vector3<float>& pDefault)
+        {
+            using namespace fbu::simd;
+            const vfloat lZero = zero();
+            const vfloat lDefaultX = set1(pDefault.mX);
+            const vfloat lDefaultY = set1(pDefault.mY);
+            const vfloat lDefaultZ = set1(pDefault.mZ);
+            for (size_t u = 0 ; u != pPaddedSize ; u += (size_t)kFloatLanes)
+            {
+                const vfloat x = load(pX + u);
+                const vfloat y = load(pY + u);
+                const vfloat z = load(pZ + u);
+                const vfloat lSqrLength = mulAdd(x, x, mulAdd(y, y, z * z));
+                const vfloat lInvLength = mu::detail::rsqrt<A>(lSqrLength);
+                const vmask lIsZero = lSqrLength == lZero;
+                store(pX + u, select(lIsZero, pUseDefault ? lDefaultX : x, x * lInvLength));
+                store(pY + u, select(lIsZero, pUseDefault ? lDefaultY : y, y * lInvLength));
+                store(pZ + u, select(lIsZero, pUseDefault ? lDefaultZ : z, z * lInvLength));
+            }
+        }
+
+        //==========================================================================
+        // The expressions of Vector3Array, such as a + s * b - c, evaluated on
+        // assignment: get<C, V>(u) is the coordinate C (0 for X, 1 for Y, 2 for
+        // Z) of the elements from u, V being the scalar type or simd::vfloat.
+
+        template <typename T>
+        inline T loadAs(const T* p, T)
+        {
+            return *p;
+        }
+
+        inline simd::vfloat loadAs(const float* p, simd::vfloat)
+        {
+            return simd::load(p);
+        }
+
+        template <typename T>
+        inline T broadcastAs(T pS, T)
+        {
+            return pS;
+        }
+
+        inline simd::vfloat broadcastAs(float pS, simd::vfloat)
+        {
+            return simd::set1(pS);
+        }
+
+        template <typename T>
+        inline T fusedMulAdd(T a, T b, T c)
+        {
+            return mu::mulAdd(a, b, c);
+        }
+
+        inline simd::vfloat fusedMulAdd(simd::vfloat a, simd::vfloat b, simd::vfloat c)
+        {
+            return simd::mulAdd(a, b, c);
+        }
+
+        template <int C, typename T>
+        inline const T* coordinate(const Vector3Array<T>& pArray)
+        {
+            return C == 0 ? pArray.x() : (C == 1 ? pArray.y() : pArray.z());
+        }
+
+        template <typename T>
+        struct Vector3Leaf
+        {
+            typedef T Scalar;
+
+            explicit Vector3Leaf(const Vector3Array<T>& pArray)
+            : mArray(pArray)
+            {
+            }
+
+            size_t size() const
+            {
+                return mArray.size();
+            }
+
+            template <int C, typename V>
+            V get(size_t u) const
+            {
+                return loadAs(coordinate<C>(mArray) + u, V());
+            }
+
+            // get() + pSum
+            template <int C, typename V>
+            V addTo(size_t u, V pSum) const
+            {
+                return get<C, V>(u) + pSum;
+            }
+
+            const Vector3Array<T>& mArray;
+        };
+
+        template <class E>
+        struct Vector3Scaled
+        {
+            typedef typename E::Scalar Scalar;
+
+            Vector3Scaled(Scalar pScale, const E& pExpression)
+            : mScale(pScale)
+            , mExpression(pExpression)
+            {
+            }
+
+            size_t size() const
+            {
+                return mExpression.size();
+            }
+
+            template <int C, typename V>
+            V get(size_t u) const
+            {
+                return broadcastAs(mScale, V()) * mExpression.template get<C, V>(u);
+            }
+
+            // fused
+            template <int C, typename V>
+            V addTo(size_t u, V pSum) const
+            {
+                return fusedMulAdd(broadcastAs(mScale, V()), mExpression.template get<C, V>(u), pSum);
+            }
+
+            Scalar mScale;
+            E mExpression;
+        };
+
+        template <class L, class R, bool IsSum>
+        struct Vector3Binary
+        {
+            typedef typename L::Scalar Scalar;
+
+            Vector3Binary(const L& pLeft, const R& pRight)
+            : mLeft(pLeft)
+            , mRight(pRight)
+            {
+                assert(pLeft.size() == pRight.size());
+            }
+
+            size_t size() const
+            {
+                return mLeft.size();
+            }
+
+            // a scaled right operand of a sum is fused
+            template <int C, typename V>
+            V get(size_t u) const
+            {
+                return IsSum ? mRight.template addTo<C, V>(u, mLeft.template get<C, V>(u))
+                             : mLeft.template get<C, V>(u) - mRight.template get<C, V>(u);
+            }
+
+            template <int C, typename V>
+            V addTo(size_t u, V pSum) const
+            {
+                return get<C, V>(u) + pSum;
+            }
+
+            L mLeft;
+            R mRight;
+        };
+
+        /**
+         The expression node of an operand, as type, made by make(), or no type
+         for the other types.
+         */
+        template <class A> struct Vector3ExpressionOf {};
+
+        template <typename T> struct Vector3ExpressionOf< Vector3Array<T> >
+        {
+            typedef Vector3Leaf<T> type;
+            static type make(const Vector3Array<T>& pArray) { return type(pArray); }
+        };
+
+        template <typename T> struct Vector3ExpressionOf< Vector3Leaf<T> >
+        {
+            typedef Vector3Leaf<T> type;
+            static const type& make(const type& pExpression) { return pExpression; }
+        };
+
+        template <class E> struct Vector3ExpressionOf< Vector3Scaled<E> >
+        {
+            typedef Vector3Scaled<E> type;
+            static const type& make(const type& pExpression) { return pExpression; }
+        };
+
+        template <class L, class R, bool IsSum> struct Vector3ExpressionOf< Vector3Binary<L, R, IsSum> >
+        {
+            typedef Vector3Binary<L, R, IsSum> type;
+            static const type& make(const type& pExpression) { return pExpression; }
+        };
+    }
+
+    //==============================================================================
+    /**
+     @class Vector3Array
+     @brief A batch of Vector3 in structure of arrays layout.
+
+     The elements are read and written through proxies that have the mX, mY
+     and mZ members of Vector3 and convert from and to Vector3.
+     */
+    template <typename T>
+    class Vector3Array
+    {
+    public:
+        /**
+         An element of the array, with the members of a Vector3.
+         */
+        struct Reference
+        {
+            T& mX;
+            T& mY;
+            T& mZ;
+
+            operator Vector3<T>() const
+            {
+                return Vector3<T>::cartesian(mX, mY, mZ);
+            }
+
+            Reference& operator=(const Vector3<T>& pVect)
+            {
+                mX = pVect.mX;
+                mY = pVect.mY;
+                mZ = pVect.mZ;
+                return *this;
+            }
+
+            Reference& operator=(const Reference& pOther)
+            {
+                return *this = (Vector3<T>)pOther;
+            }
+        };
+
+        /// the arrays are padded to a multiple of kPadding elements
+        static constexpr size_t kPadding = (size_t)simd::kFloatLanes;
+
+        Vector3Array() = default;
+
+        explicit Vector3Array(size_t pSize)
+        {
+            resize(pSize);
+        }
+
+        explicit Vector3Array(const std::vector< Vector3<T> >& pVectors)
+        {
+            assign(pVectors.data(), pVectors.size());
+        }
+
+        /**
+         The value of an expression of arrays of the same size, see operator=().
+         */
+        template <class E, typename = typename detail::Vector3ExpressionOf<E>::type>
+        Vector3Array(const E& pExpression)
+        {
+            *this = pExpression;
+        }
+
+        Vector3Array(const Vector3Array<T>&) = default;
+        Vector3Array(Vector3Array<T>&&) = default;
+        Vector3Array<T>& operator=(const Vector3Array<T>&) = default;
+        Vector3Array<T>& operator=(Vector3Array<T>&&) = default;
+
+        /**
+         Evaluates an expression of arrays of the same size with +, - and
+         the product by a scalar, such as a + s * b - c, in one pass per
+         coordinate, without temporary arrays, and with a fused multiply-add
+         for a scaled term on the right of a +. The arrays of the expression
+         may include this one. The expression holds references to the
+         arrays: it is meant to be assigned in the same statement.
+         */
+        template <class E, typename = typename detail::Vector3ExpressionOf<E>::type>
+        Vector3Array<T>& operator=(const E& pExpression)
+        {
+            typedef detail::Vector3ExpressionOf<E> Expression;
+            resize(pExpression.size());
+            evaluate<0>(Expression::make(pExpression), IsFloat());
+            evaluate<1>(Expression::make(pExpression), IsFloat());
+            evaluate<2>(Expression::make(pExpression), IsFloat());
+            return *this;
+        }
+
+        void assign(const Vector3<T>* pVectors, size_t pSize)
+        {
+            resize(pSize);
+            for (size_t i = 0 ; i != pSize ; ++i)
+            {
+                (*this)[i] = pVectors[i];
+            }
+        }
+
+        void copyTo(Vector3<T>* pVectors) const
+        {
+            for (size_t i = 0 ; i != mSize ; ++i)
+            {
+                pVectors[i] = (*this)[i];
+            }
+        }
+
+        size_t size() const
+        {
+            return mSize;
+        }
+
+        bool empty() const
+        {
+            return mSize == 0;
+        }
+
+        /**
+         size() rounded up to kPadding: the length of the arrays.
+         */
+        size_t paddedSize() const
+        {
+            return mX.size();
+        }
+
+        /**
+         The new elements are zero.
+         */
+        void resize(size_t pSize)
+        {
+            const size_t lPaddedSize = (pSize + kPadding - 1) / kPadding * kPadding;
+            mX.resize(std::max(lPaddedSize, mX.size()), (T)0);
+            mY.resize(std::max(lPaddedSize, mY.size()), (T)0);
+            mZ.resize(std::max(lPaddedSize, mZ.size()), (T)0);
+            mSize = std::min(mSize, pSize);
+            clearPadding();
+            mX.resize(lPaddedSize);
+            mY.resize(lPaddedSize);
+            mZ.resize(lPaddedSize);
+            mSize = pSize;
+        }
+
+        void clear()
+        {
+            resize(0);
+        }
+
+        void push_back(const Vector3<T>& pVect)
+        {
+            resize(mSize + 1);
+            (*this)[mSize - 1] = pVect;
+        }
+
+        Reference operator[](size_t pIndex)
+        {
+            assert(pIndex < mSize);
+            return Reference{mX[pIndex], mY[pIndex], mZ[pIndex]};
+        }
+
+        Vector3<T> operator[](size_t pIndex) const
+        {
+            assert(pIndex < mSize);
+            return Vector3<T>::cartesian(mX[pIndex], mY[pIndex], mZ[pIndex]);
+        }
+
+        T* x() { return mX.data(); }
+        T* y() { return mY.data(); }
+        T* z() { return mZ.data(); }
+        const T* x() const { return mX.data(); }
+        const T* y() const { return mY.data(); }
+        const T* z() const { return mZ.data(); }
+
+        /**
+         Vector3::normalize() of all the elements, with the zero vectors left
+         at zero. For float, 1/length is mu::vectRsqrt() at pAccuracy.
+         */
+        void normalize(mu::Accuracy pAccuracy = mu::Accuracy::high)
+        {
+            normalize(false, Vector3<T>(), pAccuracy, IsFloat());
+        }
+
+        /**
+         Vector3::normalizeWithDefault() of all the elements.
+         */
+        void normalizeWithDefault(const Vector3<T>& pDefault, mu::Accuracy pAccuracy = mu::Accuracy::high)
+        {
+            normalize(true, pDefault, pAccuracy, IsFloat());
+        }
+
+        Vector3Array<T>& operator+=(const Vector3Array<T>& pOther)
+        {
+            assert(pOther.mSize == mSize);
+            add(mX.data(), pOther.mX.data(), paddedSize(), IsFloat());
+            add(mY.data(), pOther.mY.data(), paddedSize(), IsFloat());
+            add(mZ.data(), pOther.mZ.data(), paddedSize(), IsFloat());
+            return *this;
+        }
+
+        /**
+         Translation of all the elements.
+         */
+        Vector3Array<T>& operator+=(const Vector3<T>& pVect)
+        {
+            // the padding stays zero
+            affine(mX.data(), (T)1, pVect.mX, mSize, IsFloat());
+            affine(mY.data(), (T)1, pVect.mY, mSize, IsFloat());
+            affine(mZ.data(), (T)1, pVect.mZ, mSize, IsFloat());
+            return *this;
+        }
+
+        Vector3Array<T>& operator*=(T pS)
+        {
+            affine(mX.data(), pS, (T)0, paddedSize(), IsFloat());
+            affine(mY.data(), pS, (T)0, paddedSize(), IsFloat());
+            affine(mZ.data(), pS, (T)0, paddedSize(), IsFloat());
+            return *this;
+        }
+
+    private:
+        typedef typename std::is_same<T, float>::type IsFloat;
+
+        // zeros after the mSize elements
+        void clearPadding()
+        {
+            std::fill(mX.begin() + (ptrdiff_t)mSize, mX.end(), (T)0);
+            std::fill(mY.begin() + (ptrdiff_t)mSize, mY.end(), (T)0);
+            std::fill(mZ.begin() + (ptrdiff_t)mSize, mZ.end(), (T)0);
+        }
+
+        void normalize(bool pUseDefault, const Vector3<T>& pDefault, mu::Accuracy, std::false_type)
+        {
+            for (size_t i = 0 ; i != mSize ; ++i)
+            {
+                Vector3<T> lVect = (*this)[i];
+                if (pUseDefault || ! lVect.isZero())
+                {
+                    lVect.normalizeWithDefault(pDefault);
+                }
+                (*this)[i] = lVect;
+            }
+        }
+
+        void normalize(bool pUseDefault, const Vector3<T>& pDefault, mu::Accuracy pAccuracy, std::true_type)
+        {
+            switch (pAccuracy)
+            {
+                case mu::Accuracy::coarse:
+                    detail::normalize<mu::Accuracy::coarse>(x(), y(), z(), paddedSize(), pUseDefault, pDefault);
+                    break;
+                case mu::Accuracy::medium:
+                    detail::normalize<mu::Accuracy::medium>(x(), y(), z(), paddedSize(), pUseDefault, pDefault);
+                    break;
+                case mu::Accuracy::high:
+                    detail::normalize<mu::Accuracy::high>(x(), y(), z(), paddedSize(), pUseDefault, pDefault);
+                    break;
+            }
+            if (pUseDefault)
+            {
+                clearPadding();
+            }
+        }
+
+        template <int C, class E>
+        void evaluate(const E& pExpression, std::false_type)
+        {
+            T* lOut = C == 0 ? x() : (C == 1 ? y() : z());
+            for (size_t i = 0 ; i != mSize ; ++i)
+            {
+                lOut[i] = pExpression.template get<C, T>(i);
+            }
+        }
+
+        // the padding stays zero
+        template <int C, class E>
+        void evaluate(const E& pExpression, std::true_type)
+        {
+            using namespace fbu::simd;
+            float* lOut = C == 0 ? x() : (C == 1 ? y() : z());
+            for (size_t u = 0 ; u != paddedSize() ; u += (size_t)kFloatLanes)
+            {
+                store(lOut + u, pExpression.template get<C, vfloat>(u));
+            }
+        }
+
+        static void add(T* pInOut, const T* pIn, size_t pSize, std::false_type)
+        {
+            for (size_t u = 0 ; u != pSize ; ++u)
+            {
+                pInOut[u] += pIn[u];
+            }
+        }
+
+        static void add(float* pInOut, const float* pIn, size_t pPaddedSize, std::true_type)
+        {
+            using namespace fbu::simd;
+            for (size_t u = 0 ; u != pPaddedSize ; u += (size_t)kFloatLanes)
+            {
+                store(pInOut + u, load(pInOut + u) + load(pIn + u));
+            }
+        }
+
+        // a x + b
+        static void affine(T* pInOut, T a, T b, size_t pSize, std::false_type)
+        {
+            for (size_t u = 0 ; u != pSize ; ++u)
+            {
+                pInOut[u] = a * pInOut[u] + b;
+            }
+        }
+
+        static void affine(float* pInOut, float a, float b, size_t pSize, std::true_type)
+        {
+            using namespace fbu::simd;
+            const vfloat lA = set1(a);
+            const vfloat lB = set1(b);
+            size_t u = 0;
+            for ( ; u + (size_t)kFloatLanes <= pSize ; u += (size_t)kFloatLanes)
+            {
+                store(pInOut + u, lA * load(pInOut + u) + lB);
+            }
+            affine(pInOut + u, a, b, pSize - u, std::false_type());
+        }
+
+        simd::AlignedVector<T> mX;
+        simd::AlignedVector<T> mY;
+        simd::AlignedVector<T> mZ;
+        size_t mSize = 0;
+    };
+
+    //==============================================================================
+    namespace detail
+    {
+        template <typename T>
+        inline void dot(const Vector3Array<T>& pA, const Vector3Array<T>& pB, T* pOut, std::false_type)
+        {
+            for (size_t i = 0 ; i != pA.size() ; ++i)
+            {
+                pOut[i] = pA[i].dot(pB[i]);
+            }
+        }
+
+        inline void dot(const Vector3Array<float>& pA, const Vector3Array<float>& pB, float* pOut, std::true_type)
+        {
+            using namespace fbu::simd;
+            storeEach(pOut, pA.size(), [&](size_t u)
+            {
+                return mulAdd(load(pA.x() + u), load(pB.x() + u),
+                              mulAdd(load(pA.y() + u), load(pB.y() + u), load(pA.z() + u) * load(pB.z() + u)));
+            });
+        }
+
+        template <typename T>
+        inline void dot(const Vector3Array<T>& pA, const Vector3<T>& pB, T* pOut, std::false_type)
+        {
+            for (size_t i = 0 ; i != pA.size() ; ++i)
+            {
+                pOut[i] = pA[i].dot(pB);
+            }
+        }
+
+        inline void dot(const Vector3Array<float>& pA, const Vector3<float>& pB, float* pOut, std::true_type)
+        {
+            using namespace fbu::simd;
+            const vfloat lX = set1(pB.mX);
+            const vfloat lY = set1(pB.mY);
+            const vfloat lZ = set1(pB.mZ);
+            storeEach(pOut, pA.size(), [&](size_t u)
+            {
+                return mulAdd(load(pA.x() + u), lX, mulAdd(load(pA.y() + u), lY, load(pA.z() + u) * lZ));
+            });
+        }
+
+        template <typename T>
+        inline void cross(const Vector3Array<T>& pA, const Vector3Array<T>& pB, Vector3Array<T>& pOut, std::false_type)
+        {
+            for (size_t i = 0 ; i != pA.size() ; ++i)
+            {
+                pOut[i] = pA[i].cross(pB[i]);
+            }
+        }
+
+        inline void cross(const Vector3Array<float>& pA, const Vector3Array<float>& pB, Vector3Array<float>& pOut, std::true_type)
+        {
+            using namespace fbu::simd;
+            for (size_t u = 0 ; u != pA.paddedSize() ; u += (size_t)kFloatLanes)
+            {
+                const vfloat ax = load(pA.x() + u), ay = load(pA.y() + u), az = load(pA.z() + u);
+                const vfloat bx = load(pB.x() + u), by = load(pB.y() + u), bz = load(pB.z() + u);
+                store(pOut.x() + u, ay * bz - az * by);
+                store(pOut.y() + u, az * bx - ax * bz);
+                store(pOut.z() + u, ax * by - ay * bx);
+            }
+        }
+
+        template <typename T>
+        inline void lengths(const Vector3Array<T>& pA, T* pOut, std::false_type)
+        {
+            for (size_t i = 0 ; i != pA.size() ; ++i)
+            {
+                pOut[i] = pA[i].length();
+            }
+        }
+
+        inline void lengths(const Vector3Array<float>& pA, float* pOut, std::true_type)
+        {
+            using namespace fbu::simd;
+            storeEach(pOut, pA.size(), [&](size_t u)
+            {
+                const vfloat x = load(pA.x() + u), y = load(pA.y() + u), z = load(pA.z() + u);
+                return sqrt(mulAdd(x, x, mulAdd(y, y, z * z)));
+            });
+        }
+    }
+
+    /**
+     pOut[i] = pA[i].dot(pB[i]), pOut holding pA.size() values.
+     */
+    template <typename T>
+    void dot(const Vector3Array<T>& pA, const Vector3Array<T>& pB, T* pOut)
+    {
+        assert(pA.size() == pB.size());
+        detail::dot(pA, pB, pOut, typename std::is_same<T, float>::type());
+    }
+
+    /**
+     pOut[i] = pA[i].dot(pB), e.g. the cosines between sources and a direction.
+     */
+    template <typename T>
+    void dot(const Vector3Array<T>& pA, const Vector3<T>& pB, T* pOut)
+    {
+        detail::dot(pA, pB, pOut, typename std::is_same<T, float>::type());
+    }
+
+    /**
+     pOut[i] = pA[i].cross(pB[i]), pOut being resized. pOut may be pA or pB.
+     */
+    template <typename T>
+    void cross(const Vector3Array<T>& pA, const Vector3Array<T>& pB, Vector3Array<T>& pOut)
+    {
+        assert(pA.size() == pB.size());
+        pOut.resize(pA.size());
+        detail::cross(pA, pB, pOut, typename std::is_same<T, float>::type());
+    }
+
+    /**
+     pOut[i] = pA[i].length(), pOut holding pA.size() values.
+     */
+    template <typename T>
+    void lengths(const Vector3Array<T>& pA, T* pOut)
+    {
+        detail::lengths(pA, pOut, typename std::is_same<T, float>::type());
+    }
+
+    //==============================================================================
+    // The expressions of Vector3Array, see Vector3Array::operator=().
+
+    template <class A, class B>
+    auto operator+(const A& pA, const B& pB)
+        -> detail::Vector3Binary<typename detail::Vector3ExpressionOf<A>::type, typename detail::Vector3ExpressionOf<B>::type, true>
+    {
+        return {detail::Vector3ExpressionOf<A>::make(pA), detail::Vector3ExpressionOf<B>::make(pB)};
+    }
+
+    template <class A, class B>
+    auto operator-(const A& pA, const B& pB)
+        -> detail::Vector3Binary<typename detail::Vector3ExpressionOf<A>::type, typename detail::Vector3ExpressionOf<B>::type, false>
+    {
+        return {detail::Vector3ExpressionOf<A>::make(pA), detail::Vector3ExpressionOf<B>::make(pB)};
+    }
+
+    template <class B>
+    auto operator*(typename detail::Vector3ExpressionOf<B>::type::Scalar pS, const B& pB)
+        -> detail::Vector3Scaled<typename detail::Vector3ExpressionOf<B>::type>
+    {
+        return {pS, detail::Vector3ExpressionOf<B>::make(pB)};
+    }
+
+    /**
+     pY = pA * pX + pY in one pass, fused.
+     */
+    template <typename T>
+    void axpy(T pA, const Vector3Array<T>& pX, Vector3Array<T>& pY)
+    {
+        pY = pY + pA * pX;
+    }
+
+    /**
+     pOut = pA + pT * (pB - pA) in one pass. pOut may be pA or pB.
+     */
+    template <typename T>
+    void lerp(const Vector3Array<T>& pA, const Vector3Array<T>& pB, T pT, Vector3Array<T>& pOut)
+    {
+        pOut = pA + pT * (pB - pA);
+    }
+}
+
+#endif // FBU_VECTOR3_ARRAY_HPP_INCLUDED
@@ -0,0 +1,385 @@
+#include "fbu/ambisonics.hpp"
+#include "fbu/stopwatch.hpp"
+
+#include "tests_common.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace fbu;
+
+namespace
+{
+    std::vector<Vector3f> randomDirections(size_t pSize, unsigned pSeed)
+    {
+        std::mt19937 lRandomGenerator(pSeed);
+        std::normal_distribution<float> lDistribution;
+        std::vector<Vector3f> lDirections(pSize);
+        for (Vector3f& v : lDirections)
+        {
+            v = Vector3f::cartesian(lDistribution(lRandomGenerator), lDistribution(lRandomGenerator), lDistribution(lRandomGenerator));
+            v.normalize();
+        }
+        return lDirections;
+    }
+
+    // the Legendre polynomial of degree l
+    double legendre(int l, double x)
+    {
+        double lPrevious = 1., lValue = x;
+        if (l == 0)
+        {
+            return lPrevious;
+        }
+        for (int k = 2 ; k <= l ; ++k)
+        {
+            const double lNext = ((2. * k - 1.) * x * lValue - (k - 1.) * lPrevious) / k;
+            lPrevious = lValue;
+            lValue = lNext;
+        }
+        return lValue;
+    }
+}
+
+CASE("Ambisonics: spherical harmonics")
+{
+    const int kNumChannels = ambisonicNumChannels(kMaxAmbisonicOrder);
+    EXPECT(kNumChannels == 64);
+    EXPECT(ambisonicChannel(1, -1) == 1);
+    EXPECT(ambisonicChannel(7, 7) == 63);
+
+    // the first and second orders of AmbiX
+    std::vector<float> lValues((size_t)kNumChannels);
+    for (float a : {-2.f, 0.f, 0.4f, 3.f})
+    {
+        for (float e : {-1.2f, 0.f, 0.3f})
+        {
+            sphericalHarmonics(AEf::ae(a, e), 2, lValues.data());
+            const float lSqrt3Over2 = std::sqrt(3.f) / 2.f;
+            const float lExpected[] = {1.f, std::sin(a) * std::cos(e), std::sin(e), std::cos(a) * std::cos(e),
+                                       lSqrt3Over2 * std::sin(2.f * a) * std::cos(e) * std::cos(e),
+                                       lSqrt3Over2 * std::sin(a) * std::sin(2.f * e),
+                                       0.5f * (3.f * std::sin(e) * std::sin(e) - 1.f),
+                                       lSqrt3Over2 * std::cos(a) * std::sin(2.f * e),
+                                       lSqrt3Over2 * std::cos(2.f * a) * std::cos(e) * std::cos(e)};
+            for (size_t c = 0 ; c != 9 ; ++c)
+            {
+                EXPECT(std::abs(lValues[c] - lExpected[c]) < 1e-5f);
+            }
+        }
+    }
+
+    // the addition theorem: the sum over m of Y(l, m)(a) Y(l, m)(b) in N3D
+    // is (2l + 1) P(l)(a.b), and SN3D is N3D / sqrt(2l + 1)
+    const std::vector<Vector3f> lDirections = randomDirections(50, 1);
+    std::vector<double> lA((size_t)kNumChannels), lB((size_t)kNumChannels), lSn3d((size_t)kNumChannels);
+    for (size_t i = 0 ; i + 1 < lDirections.size() ; ++i)
+    {
+        const Vector3<double> a = Vector3<double>::cartesian(lDirections[i].mX, lDirections[i].mY, lDirections[i].mZ).normalized();
+        const Vector3<double> b = Vector3<double>::cartesian(lDirections[i + 1].mX, lDirections[i + 1].mY, lDirections[i + 1].mZ);
+        sphericalHarmonics(a, kMaxAmbisonicOrder, lA.data(), AmbisonicNormalization::n3d);
+        sphericalHarmonics(2. * b, kMaxAmbisonicOrder, lB.data(), AmbisonicNormalization::n3d);
+        sphericalHarmonics(a, kMaxAmbisonicOrder, lSn3d.data());
+        sphericalHarmonics(lDirections[i], kMaxAmbisonicOrder, lValues.data());
+        const double lCosine = a.dot(b.normalized());
+        for (int l = 0 ; l <= kMaxAmbisonicOrder ; ++l)
+        {
+            double lSum = 0.;
+            for (int m = -l ; m <= l ; ++m)
+            {
+                const size_t c = (size_t)ambisonicChannel(l, m);
+                lSum += lA[c] * lB[c];
+                EXPECT(std::abs(lSn3d[c] * std::sqrt(2. * l + 1.) - lA[c]) < 1e-12);
+                EXPECT(std::abs(lSn3d[c]) <= 1. + 1e-12);
+                EXPECT(std::abs(lValues[c] - lSn3d[c]) < 5e-6);
+            }
+            EXPECT(std::abs(lSum - (2. * l + 1.) * legendre(l, lCosine)) < 1e-10);
+        }
+    }
+
+    // the poles, and zero is the front
+    sphericalHarmonics(Vector3f::cartesian(0.f, 0.f, 3.f), kMaxAmbisonicOrder, lValues.data());
+    for (int l = 1 ; l <= kMaxAmbisonicOrder ; ++l)
+    {
+        EXPECT(std::abs(lValues[(size_t)ambisonicChannel(l, 0)] - 1.f) < 1e-6f);
+        EXPECT(lValues[(size_t)ambisonicChannel(l, l)] == 0.f);
+    }
+    std::vector<float> lFront((size_t)kNumChannels);
+    sphericalHarmonics(Vector3f::cartesian(1.f, 0.f, 0.f), kMaxAmbisonicOrder, lFront.data());
+    sphericalHarmonics(Vector3f::cartesian(0.f, 0.f, 0.f), kMaxAmbisonicOrder, lValues.data());
+    EXPECT(lValues == lFront);
+}
+
+CASE("Ambisonics: batches")
+{
+    for (size_t lSize : {0u, 1u, 5u, 1001u})
+    {
+        const std::vector<Vector3f> lDirections = randomDirections(lSize, (unsigned)lSize);
+        const Vector3Array<float> lBatch(lDirections);
+        for (AmbisonicNormalization lNormalization : {AmbisonicNormalization::sn3d, AmbisonicNormalization::n3d})
+        {
+            const int lOrder = lSize == 5 ? 3 : kMaxAmbisonicOrder;
+            const size_t lNumChannels = (size_t)ambisonicNumChannels(lOrder);
+            const size_t lStride = lBatch.paddedSize() + 4;
+            std::vector<float> lValues(lNumChannels * lStride);
+            std::vector<float> lExpected(lNumChannels);
+            sphericalHarmonics(lBatch, lOrder, lValues.data(), lStride, lNormalization);
+            float lMaxError = 0.f;
+            for (size_t i = 0 ; i != lSize ; ++i)
+            {
+                sphericalHarmonics(lDirections[i], lOrder, lExpected.data(), lNormalization);
+                for (size_t c = 0 ; c != lNumChannels ; ++c)
+                {
+                    lMaxError = std::max(lMaxError, std::abs(lValues[c * lStride + i] - lExpected[c]));
+                }
+            }
+            // N3D is SN3D times up to sqrt(15)
+            EXPECT(lMaxError < (lNormalization == AmbisonicNormalization::n3d ? 2e-5f : 5e-6f));
+        }
+    }
+}
+
+CASE("Ambisonics: encoder")
+{
+    const SampleCount kNumSamples = 67;
+    const size_t kNumSources = 3;
+    AmbisonicEncoder lEncoder(3, 5);
+    const int lNumChannels = lEncoder.getNumChannels();
+    EXPECT(lNumChannels == 16);
+    EXPECT(lEncoder.getMaxNumSources() >= 5u);
+
+    std::vector< std::vector<float> > lSources(kNumSources, std::vector<float>(kNumSamples));
+    for (size_t s = 0 ; s != kNumSources ; ++s)
+    {
+        for (SampleCount n = 0 ; n != kNumSamples ; ++n)
+        {
+            lSources[s][n] = std::sin(0.1f * (float)(n * (s + 1)));
+        }
+    }
+    std::vector< std::vector<float> > lChannels((size_t)lNumChannels, std::vector<float>(kNumSamples));
+    std::vector<const float*> lIn;
+    std::vector<float*> lOut;
+    for (const std::vector<float>& v : lSources) lIn.push_back(v.data());
+    for (std::vector<float>& v : lChannels) lOut.push_back(v.data());
+
+    const float lAzimuths[] = {0.f, 1.f, -2.f};
+    const float lElevations[] = {0.f, 0.5f, -0.2f};
+    lEncoder.setDirections(lAzimuths, lElevations, kNumSources);
+    EXPECT(lEncoder.getNumSources() == kNumSources);
+    lEncoder.process(lIn.data(), lOut.data(), kNumSamples);
+    std::vector<float> lBefore((size_t)lNumChannels * kNumSources);
+    std::vector<float> lHarmonics((size_t)lNumChannels);
+    for (size_t s = 0 ; s != kNumSources ; ++s)
+    {
+        sphericalHarmonics(AEf::ae(lAzimuths[s], lElevations[s]), 3, lHarmonics.data());
+        for (int c = 0 ; c != lNumChannels ; ++c)
+        {
+            lBefore[(size_t)c * kNumSources + s] = lHarmonics[(size_t)c];
+            EXPECT(std::abs(lEncoder.getGain(c, s) - lHarmonics[(size_t)c]) < 1e-6f);
+        }
+    }
+    // without a ramp the first time
+    float lMaxError = 0.f;
+    for (int c = 0 ; c != lNumChannels ; ++c)
+    {
+        for (SampleCount n = 0 ; n != kNumSamples ; ++n)
+        {
+            float lExpected = 0.f;
+            for (size_t s = 0 ; s != kNumSources ; ++s)
+            {
+                lExpected += lBefore[(size_t)c * kNumSources + s] * lSources[s][n];
+            }
+            lMaxError = std::max(lMaxError, std::abs(lChannels[(size_t)c][n] - lExpected));
+        }
+    }
+    EXPECT(lMaxError < 1e-5f);
+
+    // then ramps to the new directions
+    Vector3Array<float> lDirections;
+    lDirections.push_back(Vector3f::cartesian(0.f, 0.f, 2.f));
+    lDirections.push_back(Vector3f::cartesian(0.f, 0.f, 0.f));
+    lDirections.push_back(Vector3f::cartesian(-1.f, -1.f, 0.f));
+    lEncoder.setDirections(lDirections);
+    lEncoder.process(lIn.data(), lOut.data(), kNumSamples);
+    lMaxError = 0.f;
+    for (int c = 0 ; c != lNumChannels ; ++c)
+    {
+        for (SampleCount n = 0 ; n != kNumSamples ; ++n)
+        {
+            const float t = (float)(n + 1) / (float)kNumSamples;
+            float lExpected = 0.f;
+            for (size_t s = 0 ; s != kNumSources ; ++s)
+            {
+                sphericalHarmonics((Vector3f)lDirections[s], 3, lHarmonics.data());
+                const float lGain = lBefore[(size_t)c * kNumSources + s];
+                lExpected += (lGain + t * (lHarmonics[(size_t)c] - lGain)) * lSources[s][n];
+            }
+            lMaxError = std::max(lMaxError, std::abs(lChannels[(size_t)c][n] - lExpected));
+        }
+    }
+    EXPECT(lMaxError < 1e-5f);
+}
+
+CASE("Ambisonics: decoder")
+{
+    // an icosahedron
+    const float lPhi = (1.f + std::sqrt(5.f)) / 2.f;
+    std::vector<Vector3f> lSpeakers;
+    for (float a : {-1.f, 1.f})
+    {
+        for (float b : {-lPhi, lPhi})
+        {
+            lSpeakers.push_back(Vector3f::cartesian(0.f, a, b).normalized());
+            lSpeakers.push_back(Vector3f::cartesian(a, b, 0.f).normalized());
+            lSpeakers.push_back(Vector3f::cartesian(b, 0.f, a).normalized());
+        }
+    }
+    for (AmbisonicNormalization lNormalization : {AmbisonicNormalization::sn3d, AmbisonicNormalization::n3d})
+    {
+        AmbisonicEncoder lEncoder(2, 1, lNormalization);
+        AmbisonicDecoder lDecoder(2, lNormalization);
+        lDecoder.setSpeakers(lSpeakers);
+        EXPECT(lDecoder.getNumSpeakers() == 12u);
+
+        const SampleCount kNumSamples = 13;
+        std::vector<float> lSource(kNumSamples, 1.f);
+        std::vector< std::vector<float> > lChannels(9, std::vector<float>(kNumSamples));
+        std::vector< std::vector<float> > lOutputs(12, std::vector<float>(kNumSamples));
+        const float* lIn = lSource.data();
+        std::vector<const float*> lChannelsIn;
+        std::vector<float*> lChannelsOut, lSpeakersOut;
+        for (std::vector<float>& v : lChannels)
+        {
+            lChannelsIn.push_back(v.data());
+            lChannelsOut.push_back(v.data());
+        }
+        for (std::vector<float>& v : lOutputs) lSpeakersOut.push_back(v.data());
+
+        for (size_t lSpeaker : {0u, 7u})
+        {
+            // on a speaker: (1 + 3 + 5) / 12 there, and the same energy as
+            // on the other directions since the layout is a 5-design
+            Vector3Array<float> lDirection;
+            lDirection.push_back(lSpeakers[lSpeaker]);
+            lEncoder.setDirections(lDirection);
+            lEncoder.reset();
+            lEncoder.setDirections(lDirection);
+            lEncoder.process(&lIn, lChannelsOut.data(), kNumSamples);
+            lDecoder.process(lChannelsIn.data(), lSpeakersOut.data(), kNumSamples);
+            float lEnergy = 0.f;
+            for (size_t s = 0 ; s != 12 ; ++s)
+            {
+                EXPECT(lOutputs[s][kNumSamples - 1] <= lOutputs[lSpeaker][kNumSamples - 1]);
+                lEnergy += lOutputs[s][kNumSamples - 1] * lOutputs[s][kNumSamples - 1];
+            }
+            EXPECT(std::abs(lOutputs[lSpeaker][0] - 0.75f) < 1e-5f);
+            EXPECT(std::abs(lOutputs[lSpeaker][kNumSamples - 1] - 0.75f) < 1e-5f);
+            EXPECT(std::abs(lEnergy - 0.75f) < 1e-5f);
+        }
+
+        // a matrix
+        std::vector<float> lMatrix(2 * 9, 0.f);
+        lMatrix[0] = 0.5f;
+        lMatrix[9 + 3] = -2.f;
+        lDecoder.setMatrix(lMatrix.data(), 2);
+        EXPECT(lDecoder.getNumSpeakers() == 2u);
+        EXPECT(lDecoder.getGain(1, 3) == -2.f);
+        lDecoder.process(lChannelsIn.data(), lSpeakersOut.data(), kNumSamples);
+        EXPECT(lOutputs[0][5] == 0.5f * lChannels[0][5]);
+        EXPECT(lOutputs[1][5] == -2.f * lChannels[3][5]);
+    }
+}
+
+CASE("Ambisonics: benchmark [.bench]")
+{
+    const size_t kNumSources = 1000;
+    const int kNumIterations = 100;
+    const int kOrder = 5;
+    const size_t kNumChannels = (size_t)ambisonicNumChannels(kOrder);
+    const std::vector<Vector3f> lDirections = randomDirections(kNumSources, 2);
+    std::vector<AEf> lAE;
+    for (const Vector3f& v : lDirections)
+    {
+        lAE.push_back(AEf::fromNormalizedVector3(v));
+    }
+    const Vector3Array<float> lBatch(lDirections);
+    std::vector<float> lValues(kNumChannels * lBatch.paddedSize());
+    float lSum = 0.f;
+
+    // the cost of the evaluation from the angles: the products of the sines
+    // and cosines of the multiples of the angles, without the normalization
+    StopWatch lStopWatch("libm trigonometry");
+    lStopWatch.start();
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        for (size_t u = 0 ; u != kNumSources ; ++u)
+        {
+            float* lOut = lValues.data() + u * kNumChannels;
+            const float a = lAE[u].mAzimuth;
+            const float lSinE = std::sin(lAE[u].mElevation);
+            const float lCosE = std::cos(lAE[u].mElevation);
+            for (int m = 0 ; m <= kOrder ; ++m)
+            {
+                const float lCos = std::cos((float)m * a);
+                const float lSin = std::sin((float)m * a);
+                const float lPow = std::pow(lCosE, (float)m);
+                for (int l = m ; l <= kOrder ; ++l)
+                {
+                    const float lLegendre = lPow * std::pow(lSinE, (float)(l - m));
+                    lOut[ambisonicChannel(l, m)] = lLegendre * lCos;
+                    lOut[ambisonicChannel(l, -m)] = lLegendre * lSin;
+                }
+            }
+        }
+        lSum += lValues[(size_t)i];
+    }
+    lStopWatch.stopAndDisplay();
+
+    lStopWatch.renameAndStart("recurrences, one by one");
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        for (size_t u = 0 ; u != kNumSources ; ++u)
+        {
+            sphericalHarmonics(lDirections[u], kOrder, lValues.data() + u * kNumChannels);
+        }
+        lSum += lValues[(size_t)i];
+    }
+    lStopWatch.stopAndDisplay();
+
+    lStopWatch.renameAndStart("recurrences, batch");
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        sphericalHarmonics(lBatch, kOrder, lValues.data(), lBatch.paddedSize());
+        lSum += lValues[(size_t)i];
+    }
+    lStopWatch.stopAndDisplay();
+
+    // 64 sources to order 3 and back to 24 speakers, 1000 blocks of 256
+    const SampleCount kBlockSize = 256;
+    const size_t kNumEncoded = 64;
+    AmbisonicEncoder lEncoder(3, kNumEncoded);
+    AmbisonicDecoder lDecoder(3);
+    lDecoder.setSpeakers(randomDirections(24, 3));
+    std::vector<float> lSignals((kNumEncoded + 16 + 24) * kBlockSize, 0.5f);
+    std::vector<const float*> lSources, lChannelsIn;
+    std::vector<float*> lChannelsOut, lSpeakers;
+    for (size_t s = 0 ; s != kNumEncoded ; ++s) lSources.push_back(lSignals.data() + s * kBlockSize);
+    for (size_t c = 0 ; c != 16 ; ++c)
+    {
+        lChannelsOut.push_back(lSignals.data() + (kNumEncoded + c) * kBlockSize);
+        lChannelsIn.push_back(lChannelsOut.back());
+    }
+    for (size_t s = 0 ; s != 24 ; ++s) lSpeakers.push_back(lSignals.data() + (kNumEncoded + 16 + s) * kBlockSize);
+    const Vector3Array<float> lEncoded(randomDirections(kNumEncoded, 4));
+    lStopWatch.renameAndStart("encode and decode");
+    for (int i = 0 ; i != 1000 ; ++i)
+    {
+        lEncoder.setDirections(lEncoded);
+        lEncoder.process(lSources.data(), lChannelsOut.data(), kBlockSize);
+        lDecoder.process(lChannelsIn.data(), lSpeakers.data(), kBlockSize);
+        lSum += lSpeakers[0][i % kBlockSize];
+    }
+    lStopWatch.stopAndDisplay();
+    EXPECT(lSum != 0.f);
+}
@@ -0,0 +1,207 @@
+#include "fbu/bits.hpp"
+#include "fbu/math_utils.hpp"
+#include "fbu/stopwatch.hpp"
+
+#include "tests_common.hpp"
+
+#include <random>
+#include <vector>
+
+using namespace fbu;
+
+namespace
+{
+    // bit by bit references
+    template <typename T>
+    int clzReference(T x)
+    {
+        const int lWidth = (int)sizeof(T) * 8;
+        int n = 0;
+        for (int b = lWidth - 1 ; b >= 0 && ((x >> b) & 1u) == 0 ; --b) ++n;
+        return n;
+    }
+
+    template <typename T>
+    int ctzReference(T x)
+    {
+        const int lWidth = (int)sizeof(T) * 8;
+        int n = 0;
+        for (int b = 0 ; b != lWidth && ((x >> b) & 1u) == 0 ; ++b) ++n;
+        return n;
+    }
+
+    template <typename T>
+    int popcountReference(T x)
+    {
+        int n = 0;
+        for ( ; x != 0 ; x >>= 1) n += (int)(x & 1u);
+        return n;
+    }
+
+    template <typename T>
+    T bitReverseReference(T x)
+    {
+        const int lWidth = (int)sizeof(T) * 8;
+        T r = 0;
+        for (int b = 0 ; b != lWidth ; ++b) r |= (T)((x >> b) & 1u) << (lWidth - 1 - b);
+        return r;
+    }
+
+    template <typename T>
+    T nextPowerOf2Reference(T x)
+    {
+        T p = 1;
+        while (p < x && p != 0) p <<= 1;
+        return p;
+    }
+
+    // the number of mismatches with the references
+    template <typename T>
+    int check(T x)
+    {
+        int lNumErrors = 0;
+        lNumErrors += bits::clz(x) != clzReference(x) ? 1 : 0;
+        lNumErrors += bits::ctz(x) != ctzReference(x) ? 1 : 0;
+        lNumErrors += bits::popcount(x) != popcountReference(x) ? 1 : 0;
+        lNumErrors += bits::bitReverse(x) != bitReverseReference(x) ? 1 : 0;
+        lNumErrors += bits::isPowerOf2(x) != (popcountReference(x) == 1) ? 1 : 0;
+        if (x != 0)
+        {
+            const int lWidth = (int)sizeof(T) * 8;
+            const int lFloor = lWidth - 1 - clzReference(x);
+            lNumErrors += bits::log2floor(x) != lFloor ? 1 : 0;
+            lNumErrors += bits::log2ceil(x) != lFloor + (popcountReference(x) == 1 ? 0 : 1) ? 1 : 0;
+            lNumErrors += bits::nextPowerOf2(x) != nextPowerOf2Reference(x) ? 1 : 0;
+        }
+        return lNumErrors;
+    }
+
+    int check32(uint64_t pStride)
+    {
+        int lNumErrors = 0;
+        for (uint64_t x = 0 ; x <= 0xffffffffull ; x += pStride)
+        {
+            lNumErrors += check((uint32_t)x);
+        }
+        return lNumErrors;
+    }
+}
+
+CASE("Bits: constexpr")
+{
+    static_assert(bits::clz(1u) == 31 && bits::clz(0u) == 32, "clz");
+    static_assert(bits::clz((uint64_t)1) == 63 && bits::clz((uint64_t)0) == 64, "clz 64");
+    static_assert(bits::ctz(8u) == 3 && bits::ctz(0u) == 32, "ctz");
+    static_assert(bits::popcount(0xf0f0u) == 8, "popcount");
+    static_assert(bits::log2floor(1000u) == 9 && bits::log2ceil(1000u) == 10 && bits::log2floor(0u) == -1, "log2");
+    static_assert(bits::nextPowerOf2(1000u) == 1024u && bits::nextPowerOf2(1024u) == 1024u, "nextPowerOf2");
+    static_assert(bits::nextPowerOf2(0x80000001u) == 0u, "nextPowerOf2 overflow");
+    static_assert(bits::bitReverse(1u) == 0x80000000u && bits::bitReverse(6u, 3) == 3u, "bitReverse");
+    static_assert(bits::bitReverse((uint64_t)1) == 0x8000000000000000ull, "bitReverse 64");
+    static_assert(bits::detail::popcountPortable(0xffffffffu) == 32, "portable popcount");
+    static_assert(bits::detail::clzPortable<uint32_t>(0x00010000u, 0) == 15, "portable clz");
+
+    // the math_utils functions on top
+    EXPECT(mu::nextPowerOf2(0) == 0);
+    EXPECT(mu::nextPowerOf2(1) == 1);
+    EXPECT(mu::nextPowerOf2(1000) == 1024);
+    EXPECT(mu::fftOrderFor(1) == 0);
+    EXPECT(mu::fftOrderFor(1025) == 11);
+    EXPECT(mu::fftOrderFor(0) == 0);
+    EXPECT(mu::fftOrderFor(-5) == 0);
+    EXPECT(mu::isPowerOf2(4096u));
+    EXPECT(!mu::isPowerOf2(0u));
+}
+
+CASE("Bits: 32-bit values against bit by bit references")
+{
+    // a prime stride over the whole range, and all the 16-bit values
+    EXPECT(check32(65521) == 0);
+    int lNumErrors = 0;
+    for (uint32_t x = 0 ; x != 65536 ; ++x)
+    {
+        lNumErrors += check(x) + check(~x) + check(x << 16);
+    }
+    EXPECT(lNumErrors == 0);
+}
+
+CASE("Bits: exhaustive 32-bit check [.exhaustive]")
+{
+    EXPECT(check32(1) == 0);
+}
+
+CASE("Bits: random 64-bit values")
+{
+    std::mt19937_64 lRandomGenerator(38);
+    int lNumErrors = 0;
+    for (int i = 0 ; i != 100000 ; ++i)
+    {
+        const uint64_t x = lRandomGenerator();
+        // and with runs of zeros at both ends
+        lNumErrors += check(x) + check(x >> (i % 64)) + check(x << (i % 64));
+    }
+    for (int b = 0 ; b != 64 ; ++b)
+    {
+        const uint64_t lPower = (uint64_t)1 << b;
+        lNumErrors += check(lPower) + check(lPower - 1) + check(lPower + 1);
+    }
+    EXPECT(lNumErrors == 0);
+}
+
+CASE("Bits: bit-reversal permutation")
+{
+    for (int lOrder = 0 ; lOrder <= 12 ; ++lOrder)
+    {
+        const size_t lSize = (size_t)1 << lOrder;
+        std::vector<uint32_t> lIndices(lSize);
+        bits::bitReverseIndices(lIndices.data(), lOrder);
+        std::vector<int> lData(lSize), lPermuted(lSize);
+        int lNumErrors = 0;
+        for (size_t i = 0 ; i != lSize ; ++i)
+        {
+            // in 64 bits, the shift is by 32 at order 0
+            const uint64_t lExpected = (uint64_t)bitReverseReference((uint32_t)i) >> (32 - lOrder);
+            lNumErrors += lIndices[i] != (uint32_t)lExpected ? 1 : 0;
+            lData[i] = (int)i;
+        }
+        bits::bitReversePermute(lData.data(), lPermuted.data(), lOrder);
+        bits::bitReversePermute(lData.data(), lIndices.data(), lSize);
+        for (size_t i = 0 ; i != lSize ; ++i)
+        {
+            lNumErrors += lData[i] != (int)lIndices[i] ? 1 : 0;
+            lNumErrors += lPermuted[i] != (int)lIndices[i] ? 1 : 0;
+        }
+        EXPECT(lNumErrors == 0);
+    }
+}
+
+CASE("Bits: bit-reversal benchmark [.bench]")
+{
+    EXPECT( true ); // suppresses the compiler warning about unused parameter 'lest_env'
+    const int lOrder = 16;
+    const size_t lSize = (size_t)1 << lOrder;
+    std::vector<uint32_t> lIndices(lSize);
+    StopWatch lStopWatch("bit by bit indices");
+    lStopWatch.start();
+    for (size_t i = 0 ; i != lSize ; ++i)
+    {
+        uint32_t lReversed = 0;
+        for (int b = 0 ; b != lOrder ; ++b)
+        {
+            lReversed |= (((uint32_t)i >> b) & 1u) << (lOrder - 1 - b);
+        }
+        lIndices[i] = lReversed;
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("bitReverseIndices");
+    bits::bitReverseIndices(lIndices.data(), lOrder);
+    lStopWatch.stopAndDisplay<std::micro>();
+
+    std::vector<float> lData(lSize, 1.f), lPermuted(lSize);
+    lStopWatch.renameAndStart("in place permutation");
+    bits::bitReversePermute(lData.data(), lIndices.data(), lSize);
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("out of place permutation");
+    bits::bitReversePermute(lData.data(), lPermuted.data(), lOrder);
+    lStopWatch.stopAndDisplay<std::micro>();
+}
@@ -1 +1,233 @@
 #include "fbu/complex.hpp"
+#include "fbu/stopwatch.hpp"
+
+#include "tests_common.hpp"
+
+#include <random>
+#include <vector>
+
+CASE("Complex: arithmetic operators")
+{
+    const Complexd a = {1., 2.};
+    const Complexd b = {3., -4.};
+    EXPECT((a + b) == Complexd({4., -2.}));
+    EXPECT((a - b) == Complexd({-2., 6.}));
+    EXPECT((a * b) == Complexd({11., 2.}));
+    EXPECT((2. * a) == Complexd({2., 4.}));
+    EXPECT((a * 2.) == Complexd({2., 4.}));
+    EXPECT(a.conj() == Complexd({1., -2.}));
+    EXPECT(b.sqrmag() == 25.);
+    EXPECT(b.mag() == 5.);
+    EXPECT(a.dot(b) == -5.);
+    EXPECT(a != b);
+    EXPECT(std::abs(Complexd({0., 1.}).arg() - M_PI_2) < 1e-15);
+    EXPECT((Complexd::polar(2., M_PI_2) - Complexd({0., 2.})).mag() < 1e-15);
+}
+
+CASE("Complex: division operators")
+{
+    const Complexd a = {1., 2.};
+    const Complexd b = {3., -4.};
+    const Complexd lQuotient = {-0.2, 0.4}; // (1+2i)/(3-4i)
+    EXPECT(((a / b) - lQuotient).mag() < 1e-15);
+    EXPECT(((a / 4.) - Complexd({0.25, 0.5})).mag() < 1e-15);
+    EXPECT(((b.inverse() * b) - Complexd({1., 0.})).mag() < 1e-15);
+
+    Complexd c = a;
+    c /= b;
+    EXPECT((c - lQuotient).mag() < 1e-15);
+
+    // the reciprocal must be computed in double precision
+    Complexd d = {1., 1.};
+    d /= 3.;
+    EXPECT(d.re == 1. / 3.);
+    EXPECT(d.im == 1. / 3.);
+
+    c *= b;
+    EXPECT((c - a).mag() < 1e-15);
+    c = 5;
+    EXPECT(c == Complexd({5., 0.}));
+}
+
+CASE("Complex: vectDivide and vectDivideRegularized")
+{
+    std::mt19937 lRandomGenerator;
+    std::uniform_real_distribution<float> lDistribution(-10.f, 10.f);
+    const size_t lSize = 37; // SIMD body and scalar tail
+    std::vector<Complexf> lNum(lSize), lDen(lSize), lOut(lSize);
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lNum[u] = {lDistribution(lRandomGenerator), lDistribution(lRandomGenerator)};
+        lDen[u] = {lDistribution(lRandomGenerator), lDistribution(lRandomGenerator)};
+    }
+
+    vectDivide(lNum.data(), lDen.data(), lOut.data(), lSize);
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        Complexf lExpected = lNum[u] / lDen[u];
+        EXPECT((lOut[u] - lExpected).mag() <= 1e-6f * lExpected.mag());
+    }
+
+    const float lEpsilon = 0.5f;
+    vectDivideRegularized(lNum.data(), lDen.data(), lOut.data(), lSize, lEpsilon);
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        Complexf lExpected = (1.f / (lDen[u].sqrmag() + lEpsilon)) * (lNum[u] * lDen[u].conj());
+        EXPECT((lOut[u] - lExpected).mag() <= 1e-6f * lExpected.mag());
+    }
+
+    // in place, and a vanishing denominator stays finite when regularized
+    lDen[3] = {0.f, 0.f};
+    vectDivideRegularized(lNum.data(), lDen.data(), lNum.data(), lSize, 1e-6f);
+    EXPECT(lNum[3] == Complexf({0.f, 0.f}));
+
+    // subnormal |b|², in the SIMD body and the tail: finite, as the scalar version
+    std::vector<Complexf> lTinyNum(5, Complexf({0.5e-19f, -1e-19f})), lTinyDen(5, Complexf({0.5e-19f, 0.25e-19f}));
+    std::vector<Complexf> lTinyOut(5);
+    vectDivide(lTinyNum.data(), lTinyDen.data(), lTinyOut.data(), lTinyOut.size());
+    const Complexd lTinyExpected = Complexd({1., -2.}) / Complexd({1., 0.5});
+    for (const Complexf& c : lTinyOut)
+    {
+        EXPECT(std::isfinite(c.re));
+        EXPECT(std::isfinite(c.im));
+        EXPECT(std::abs(c.re - lTinyExpected.re) < 1e-5);
+        EXPECT(std::abs(c.im - lTinyExpected.im) < 1e-5);
+    }
+
+    std::vector<Complexd> lNumD = {{1., 2.}, {3., 4.}};
+    std::vector<Complexd> lDenD = {{3., -4.}, {0., 1.}};
+    vectDivide(lNumD.data(), lDenD.data(), lNumD.data(), 2);
+    EXPECT((lNumD[0] - Complexd({-0.2, 0.4})).mag() < 1e-15);
+    EXPECT((lNumD[1] - Complexd({4., -3.})).mag() < 1e-15);
+}
+
+namespace
+{
+    std::vector< std::vector<Complexf> > randomSpectra(size_t pNumSources, size_t pSize)
+    {
+        std::mt19937 lRandomGenerator;
+        std::uniform_real_distribution<float> lDistribution(-1.f, 1.f);
+        std::vector< std::vector<Complexf> > lSpectra(pNumSources, std::vector<Complexf>(pSize));
+        for (std::vector<Complexf>& lSpectrum : lSpectra)
+        {
+            for (Complexf& c : lSpectrum)
+            {
+                c = {lDistribution(lRandomGenerator), lDistribution(lRandomGenerator)};
+            }
+        }
+        return lSpectra;
+    }
+}
+
+CASE("Complex: hypot of aligned phases is the power sum")
+{
+    Complexd h = Complexd::hypot({3., 0.}, {4., 0.});
+    EXPECT((h - Complexd({5., 0.})).mag() < 1e-15);
+    EXPECT(Complexd::hypot({0., 0.}, {0., 0.}) == Complexd({0., 0.}));
+
+    // associative, |h| h being the sum of the |x| x
+    const Complexd a = {1., -2.}, b = {-0.5, 3.}, c = {2., 0.25};
+    EXPECT((Complexd::hypot(Complexd::hypot(a, b), c) - Complexd::hypot(a, Complexd::hypot(b, c))).mag() < 1e-14);
+    const Complexd h2 = Complexd::hypot(a, b);
+    EXPECT((h2.mag() * h2 - (a.mag() * a + b.mag() * b)).mag() < 1e-14);
+}
+
+CASE("Complex: vectHypot matches folded scalar hypot, documented accuracy")
+{
+    const size_t lSize = 67;
+    for (size_t lNumSources : {1u, 2u, 3u, 8u, 32u})
+    {
+        std::vector< std::vector<Complexf> > lSpectra = randomSpectra(lNumSources, lSize);
+        for (std::vector<Complexf>& lSpectrum : lSpectra)
+        {
+            // all zero bin
+            lSpectrum[5] = {0.f, 0.f};
+        }
+        std::vector<const Complexf*> lSources;
+        for (const std::vector<Complexf>& lSpectrum : lSpectra)
+        {
+            lSources.push_back(lSpectrum.data());
+        }
+
+        std::vector<Complexd> lExpected(lSize);
+        std::vector<double> lScale(lSize, 0.);
+        for (size_t u = 0 ; u != lSize ; ++u)
+        {
+            for (size_t s = 0 ; s != lNumSources ; ++s)
+            {
+                lScale[u] += (double)lSpectra[s][u].sqrmag();
+            }
+            lScale[u] = std::sqrt(lScale[u]);
+            lExpected[u] = {lSpectra[0][u].re, lSpectra[0][u].im};
+            lExpected[u] = Complexd::hypot(lExpected[u], {0., 0.});
+            for (size_t s = 1 ; s != lNumSources ; ++s)
+            {
+                lExpected[u] = Complexd::hypot(lExpected[u], {lSpectra[s][u].re, lSpectra[s][u].im});
+            }
+        }
+
+        const std::pair<HypotPrecision, double> lPrecisions[] = {
+            {HypotPrecision::exact, 1e-6}, {HypotPrecision::fast, 2e-6}, {HypotPrecision::coarse, 2e-3}
+        };
+        for (const auto& lPrecision : lPrecisions)
+        {
+            std::vector<Complexf> lOut(lSize);
+            vectHypot(lSources.data(), lNumSources, lOut.data(), lSize, lPrecision.first);
+            for (size_t u = 0 ; u != lSize ; ++u)
+            {
+                Complexd lError = Complexd({lOut[u].re, lOut[u].im}) - lExpected[u];
+                EXPECT(lError.mag() <= lPrecision.second * lScale[u]);
+            }
+            EXPECT(lOut[5] == Complexf({0.f, 0.f}));
+        }
+    }
+
+    std::vector<Complexd> a = {{3., 0.}, {1., 1.}};
+    std::vector<Complexd> b = {{4., 0.}, {-1., -1.}};
+    const Complexd* lSourcesD[] = {a.data(), b.data()};
+    vectHypot(lSourcesD, 2, a.data(), 2);
+    EXPECT((a[0] - Complexd({5., 0.})).mag() < 1e-15);
+    EXPECT(a[1] == Complexd({0., 0.}));
+}
+
+CASE("Complex: vectHypot benchmark vs scalar hypot [.bench]")
+{
+    EXPECT( true ); // suppresses the compiler warning about unused parameter 'lest_env'
+    const size_t lSize = 4096;
+    const int lNumRepeats = 20;
+    for (size_t lNumSources : {2u, 4u, 8u, 16u, 32u})
+    {
+        std::vector< std::vector<Complexf> > lSpectra = randomSpectra(lNumSources, lSize);
+        std::vector<const Complexf*> lSources;
+        for (const std::vector<Complexf>& lSpectrum : lSpectra)
+        {
+            lSources.push_back(lSpectrum.data());
+        }
+        std::vector<Complexf> lOut(lSize);
+        StopWatch lStopWatch("scalar hypot, " + std::to_string(lNumSources) + " sources");
+        lStopWatch.start();
+        for (int r = 0 ; r != lNumRepeats ; ++r)
+        {
+            for (size_t u = 0 ; u != lSize ; ++u)
+            {
+                Complexf lSum = lSpectra[0][u];
+                for (size_t s = 1 ; s != lNumSources ; ++s)
+                {
+                    lSum = Complexf::hypot(lSum, lSpectra[s][u]);
+                }
+                lOut[u] = lSum;
+            }
+        }
+        lStopWatch.stopAndDisplay<std::micro>();
+        for (HypotPrecision lPrecision : {HypotPrecision::exact, HypotPrecision::fast, HypotPrecision::coarse})
+        {
+            lStopWatch.renameAndStart("vectHypot precision " + std::to_string((int)lPrecision) + ", "
+                                      + std::to_string(lNumSources) + " sources");
+            for (int r = 0 ; r != lNumRepeats ; ++r)
+            {
+                vectHypot(lSources.data(), lNumSources, lOut.data(), lSize, lPrecision);
+            }
+            lStopWatch.stopAndDisplay<std::micro>();
+        }
+    }
+}
@@ -0,0 +1,178 @@
+#include "fbu/direction_index.hpp"
+#include "fbu/stopwatch.hpp"
+
+#include "tests_common.hpp"
+
+#include <random>
+#include <vector>
+
+using namespace fbu;
+
+namespace
+{
+    template <typename T>
+    std::vector< Vector3<T> > randomDirections(size_t pSize, unsigned pSeed)
+    {
+        std::mt19937 lRandomGenerator(pSeed);
+        std::normal_distribution<T> lDistribution;
+        std::vector< Vector3<T> > lDirections(pSize);
+        for (Vector3<T>& v : lDirections)
+        {
+            v = Vector3<T>::cartesian(lDistribution(lRandomGenerator), lDistribution(lRandomGenerator), lDistribution(lRandomGenerator));
+        }
+        return lDirections;
+    }
+
+    // the linear scan, with the same ties as the index
+    template <typename T>
+    std::vector<size_t> bruteForce(const std::vector< Vector3<T> >& pDirections, const Vector3<T>& pDirection)
+    {
+        std::vector<size_t> lOrder(pDirections.size());
+        std::vector<T> lDistances(pDirections.size());
+        for (size_t i = 0 ; i != pDirections.size() ; ++i)
+        {
+            lOrder[i] = i;
+            lDistances[i] = (pDirections[i].normalized() - pDirection.normalized()).sqrLength();
+        }
+        std::sort(lOrder.begin(), lOrder.end(), [&](size_t a, size_t b)
+        {
+            return lDistances[a] < lDistances[b] || (lDistances[a] == lDistances[b] && a < b);
+        });
+        return lOrder;
+    }
+
+    template <typename T>
+    T angle(const Vector3<T>& pA, const Vector3<T>& pB)
+    {
+        return std::acos(std::max((T)-1, std::min((T)1, pA.normalized().dot(pB.normalized()))));
+    }
+}
+
+CASE("DirectionIndex: matches the linear scan")
+{
+    for (size_t lSize : {1u, 2u, 8u, 9u, 100u, 2000u})
+    {
+        const std::vector<Vector3f> lDirections = randomDirections<float>(lSize, (unsigned)lSize);
+        const std::vector<Vector3f> lQueries = randomDirections<float>(200, 1);
+        const DirectionIndex<float> lIndex(lDirections);
+        EXPECT(lIndex.size() == lSize);
+        std::vector<size_t> lNearest, lWithin;
+        for (const Vector3f& q : lQueries)
+        {
+            const std::vector<size_t> lExpected = bruteForce(lDirections, q);
+            EXPECT(lIndex.nearest(q) == lExpected[0]);
+
+            lIndex.nearest(q, 5, lNearest);
+            EXPECT(lNearest.size() == std::min<size_t>(5, lSize));
+            EXPECT(std::equal(lNearest.begin(), lNearest.end(), lExpected.begin()));
+
+            const float lAngle = 0.5f;
+            lIndex.withinAngle(q, lAngle, lWithin);
+            size_t lNumWithin = 0;
+            while (lNumWithin != lSize && angle(lDirections[lExpected[lNumWithin]], q) <= lAngle)
+            {
+                ++lNumWithin;
+            }
+            EXPECT(lWithin.size() == lNumWithin);
+            EXPECT(std::equal(lWithin.begin(), lWithin.end(), lExpected.begin()));
+        }
+
+        // batches
+        std::vector<size_t> lBatch(lQueries.size());
+        lIndex.nearest(Vector3Array<float>(lQueries), lBatch.data());
+        for (size_t i = 0 ; i != lQueries.size() ; ++i)
+        {
+            EXPECT(lBatch[i] == lIndex.nearest(lQueries[i]));
+        }
+    }
+}
+
+CASE("DirectionIndex: edge cases")
+{
+    const Vector3f lFront = Vector3f::cartesian(1.f, 0.f, 0.f);
+    const Vector3f lLeft = Vector3f::cartesian(0.f, 2.f, 0.f);
+    std::vector<Vector3f> lDirections(20, lLeft);
+    lDirections[7] = lFront;
+    const DirectionIndex<float> lIndex(lDirections);
+    // the lowest index among equal directions
+    EXPECT(lIndex.nearest(Vector3f::cartesian(0.f, 1.f, 0.1f)) == 0u);
+    EXPECT(lIndex.nearest(AEf::ae(0.1f, -0.2f)) == 7u);
+    // zero is the front
+    EXPECT(lIndex.nearest(Vector3f::cartesian(0.f, 0.f, 0.f)) == 7u);
+
+    std::vector<size_t> lOut;
+    lIndex.nearest(lFront, 0, lOut);
+    EXPECT(lOut.empty());
+    lIndex.nearest(lFront, 30, lOut);
+    EXPECT(lOut.size() == 20u);
+    EXPECT(lOut[0] == 7u);
+    EXPECT(lOut[1] == 0u);
+    // exactly at the angle
+    lIndex.withinAngle(lFront, M_PI_2f, lOut);
+    EXPECT(lOut.size() == 20u);
+    lIndex.withinAngle(lFront, 1.5f, lOut);
+    EXPECT(lOut.size() == 1u);
+    lIndex.withinAngle(lFront, -1.f, lOut);
+    EXPECT(lOut.empty());
+
+    DirectionIndex<float> lEmpty;
+    EXPECT(lEmpty.empty());
+    lEmpty.withinAngle(Vector3f::cartesian(1.f, 0.f, 0.f), 1.f, lOut);
+    EXPECT(lOut.empty());
+}
+
+CASE("DirectionIndex: benchmark vs linear scan [.bench]")
+{
+    const size_t kNumQueries = 100000;
+    for (size_t lSize : {100u, 2000u, 20000u})
+    {
+        const std::vector<Vector3f> lDirections = randomDirections<float>(lSize, 2);
+        const std::vector<Vector3f> lQueries = randomDirections<float>(kNumQueries, 3);
+        std::vector<Vector3f> lNormalized(lDirections);
+        for (Vector3f& v : lNormalized)
+        {
+            v.normalize();
+        }
+        std::vector<size_t> lResults(kNumQueries);
+        size_t lSum = 0;
+
+        StopWatch lStopWatch("linear scan of " + std::to_string(lSize));
+        lStopWatch.start();
+        for (size_t u = 0 ; u != kNumQueries ; ++u)
+        {
+            size_t lBest = 0;
+            float lBestDot = -2.f;
+            for (size_t i = 0 ; i != lSize ; ++i)
+            {
+                const float lDot = lNormalized[i].dot(lQueries[u]);
+                if (lDot > lBestDot)
+                {
+                    lBestDot = lDot;
+                    lBest = i;
+                }
+            }
+            lResults[u] = lBest;
+        }
+        lStopWatch.stopAndDisplay();
+        lSum += lResults.back();
+
+        lStopWatch.renameAndStart("build");
+        const DirectionIndex<float> lIndex(lDirections);
+        lStopWatch.stopAndDisplay();
+
+        lStopWatch.renameAndStart("nearest");
+        for (size_t u = 0 ; u != kNumQueries ; ++u)
+        {
+            lResults[u] = lIndex.nearest(lQueries[u]);
+        }
+        lStopWatch.stopAndDisplay();
+        lSum += lResults.back();
+
+        const Vector3Array<float> lBatch(lQueries);
+        lStopWatch.renameAndStart("nearest, batch");
+        lIndex.nearest(lBatch, lResults.data());
+        lStopWatch.stopAndDisplay();
+        lSum += lResults.back();
+        EXPECT(lSum == 3 * lResults.back());
+    }
+}
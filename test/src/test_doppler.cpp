@@ -0,0 +1,227 @@
+#include "fbu/doppler.hpp"
+#include "fbu/stopwatch.hpp"
+
+#include "tests_common.hpp"
+
+#include <random>
+#include <vector>
+
+using namespace fbu;
+
+namespace
+{
+    std::vector<Vector3f> randomPositions(size_t pSize, unsigned pSeed)
+    {
+        std::mt19937 lRandomGenerator(pSeed);
+        std::uniform_real_distribution<float> lDistribution(-20.f, 20.f);
+        std::vector<Vector3f> lPositions(pSize);
+        for (Vector3f& v : lPositions)
+        {
+            v = Vector3f::cartesian(lDistribution(lRandomGenerator), lDistribution(lRandomGenerator), lDistribution(lRandomGenerator));
+        }
+        return lPositions;
+    }
+
+    struct Ramps
+    {
+        explicit Ramps(size_t pSize)
+        : mGains(pSize), mGainSteps(pSize), mDelays(pSize), mDelaySteps(pSize)
+        {
+        }
+
+        PropagationRamps get()
+        {
+            return {mGains.data(), mGainSteps.data(), mDelays.data(), mDelaySteps.data()};
+        }
+
+        std::vector<float> mGains, mGainSteps, mDelays, mDelaySteps;
+    };
+
+    const FractionalDelay kInterpolations[] = {FractionalDelay::linear, FractionalDelay::lagrange, FractionalDelay::thiran};
+}
+
+CASE("Doppler: propagation ramps")
+{
+    PropagationSettings lSettings;
+    lSettings.mReferenceDistance = 2.f;
+    lSettings.mRolloff = 0.5f;
+    lSettings.mMaxDelay = 4000.f;
+    const Vector3f lListenerStart = Vector3f::cartesian(1.f, 0.f, 0.f);
+    const Vector3f lListenerEnd = Vector3f::cartesian(1.f, 1.f, 0.f);
+    const SampleCount kNumSamples = 100;
+    for (size_t lSize : {0u, 1u, 5u, 1001u})
+    {
+        const std::vector<Vector3f> lStart = randomPositions(lSize, 1);
+        const std::vector<Vector3f> lEnd = randomPositions(lSize, 2);
+        Ramps lRamps(lSize);
+        computePropagation(Vector3Array<float>(lStart), Vector3Array<float>(lEnd), lListenerStart, lListenerEnd,
+                           lSettings, kNumSamples, lRamps.get());
+        float lMaxError = 0.f;
+        for (size_t i = 0 ; i != lSize ; ++i)
+        {
+            const float lDistanceStart = (lStart[i] - lListenerStart).length();
+            const float lDistanceEnd = (lEnd[i] - lListenerEnd).length();
+            const float lGainEnd = lRamps.mGains[i] + (float)kNumSamples * lRamps.mGainSteps[i];
+            const float lDelayEnd = lRamps.mDelays[i] + (float)kNumSamples * lRamps.mDelaySteps[i];
+            lMaxError = std::max(lMaxError, std::abs(lRamps.mGains[i] - propagationGain(lDistanceStart, lSettings)));
+            lMaxError = std::max(lMaxError, std::abs(lGainEnd - propagationGain(lDistanceEnd, lSettings)));
+            lMaxError = std::max(lMaxError, std::abs(lRamps.mDelays[i] / propagationDelay(lDistanceStart, lSettings) - 1.f));
+            lMaxError = std::max(lMaxError, std::abs(lDelayEnd / propagationDelay(lDistanceEnd, lSettings) - 1.f));
+        }
+        EXPECT(lMaxError < 1e-5f);
+    }
+
+    // the reference distance, the rolloff and the maximum delay
+    EXPECT(propagationGain(1.f, lSettings) == 1.f);
+    EXPECT(std::abs(propagationGain(6.f, lSettings) - 0.5f) < 1e-7f);
+    EXPECT(std::abs(propagationDelay(3.43f, lSettings) - 480.f) < 1e-3f);
+    EXPECT(propagationDelay(100.f, lSettings) == 4000.f);
+    lSettings.mRolloff = 0.f;
+    EXPECT(propagationGain(100.f, lSettings) == 1.f);
+}
+
+CASE("Doppler: fractional delay line")
+{
+    const SampleCount kBlockSize = 64;
+    const int kNumBlocks = 20;
+    // a ramp, exact through the linear and Lagrange interpolations, and a
+    // low sine
+    for (int lSignal = 0 ; lSignal != 2 ; ++lSignal)
+    {
+        for (FractionalDelay lInterpolation : kInterpolations)
+        {
+            for (float lDelay : {5.f, 7.25f, 30.6f})
+            {
+                FractionalDelayLine lLine(100.f, kBlockSize);
+                std::vector<float> lIn(kBlockSize), lOut(kBlockSize);
+                float lMaxError = 0.f;
+                for (int b = 0 ; b != kNumBlocks ; ++b)
+                {
+                    for (SampleCount n = 0 ; n != kBlockSize ; ++n)
+                    {
+                        const float t = (float)(b * (int)kBlockSize + (int)n);
+                        lIn[n] = lSignal == 0 ? 0.01f * t : std::sin(0.05f * t);
+                    }
+                    lLine.write(lIn.data(), kBlockSize);
+                    lLine.read(lOut.data(), kBlockSize, lDelay, 0.f, 0.5f, 0.f, lInterpolation);
+                    // after the history and the transient of the allpass
+                    for (SampleCount n = 0 ; b >= 2 && n != kBlockSize ; ++n)
+                    {
+                        const float t = (float)(b * (int)kBlockSize + (int)n) - lDelay;
+                        const float lExpected = lSignal == 0 ? 0.01f * t : std::sin(0.05f * t);
+                        lMaxError = std::max(lMaxError, std::abs(lOut[n] - 0.5f * lExpected));
+                    }
+                }
+                const bool lIsInteger = lDelay == std::floor(lDelay);
+                const float lTolerance = lSignal == 0 ? 2e-5f
+                                         : lIsInteger ? 1e-6f
+                                         : lInterpolation == FractionalDelay::linear ? 2e-4f
+                                         : lInterpolation == FractionalDelay::lagrange ? 2e-6f : 2e-5f;
+                EXPECT(lMaxError < lTolerance);
+            }
+        }
+    }
+}
+
+CASE("Doppler: moving source")
+{
+    // a source moving away at 1/10 of the speed of sound: the delay grows
+    // by 0.1 sample per sample, and a sine goes down by 1/1.1
+    PropagationSettings lSettings;
+    lSettings.mSampleRate = 1000.f;
+    lSettings.mSpeedOfSound = 100.f;
+    lSettings.mRolloff = 0.f;
+    lSettings.mMaxDelay = 1000.f;
+    const SampleCount kBlockSize = 50;
+    const Vector3f lListener = Vector3f::cartesian(0.f, 0.f, 0.f);
+    for (FractionalDelay lInterpolation : kInterpolations)
+    {
+        FractionalDelayLine lLine(lSettings.mMaxDelay, kBlockSize);
+        Ramps lRamps(1);
+        std::vector<float> lIn(kBlockSize), lOut(kBlockSize);
+        float lMaxError = 0.f;
+        for (int b = 0 ; b != 40 ; ++b)
+        {
+            const float lTime = (float)(b * (int)kBlockSize);
+            Vector3Array<float> lStart, lEnd;
+            lStart.push_back(Vector3f::cartesian(1.f + 0.01f * lTime, 0.f, 0.f));
+            lEnd.push_back(Vector3f::cartesian(1.f + 0.01f * (lTime + (float)kBlockSize), 0.f, 0.f));
+            computePropagation(lStart, lEnd, lListener, lListener, lSettings, kBlockSize, lRamps.get());
+            EXPECT(std::abs(lRamps.mDelaySteps[0] - 0.1f) < 1e-4f);
+            for (SampleCount n = 0 ; n != kBlockSize ; ++n)
+            {
+                lIn[n] = std::sin(0.05f * (lTime + (float)n));
+            }
+            lLine.write(lIn.data(), kBlockSize);
+            lLine.read(lOut.data(), kBlockSize, lRamps.get(), 0, lInterpolation);
+            for (SampleCount n = 0 ; b >= 2 && n != kBlockSize ; ++n)
+            {
+                // emitted at t - delay(t), delay(t) = 10 + 0.1 t
+                const float t = lTime + (float)n;
+                lMaxError = std::max(lMaxError, std::abs(lOut[n] - std::sin(0.05f * (t - (10.f + 0.1f * t)))));
+            }
+        }
+        // the allpass state does not follow the jumps of the integer tap
+        EXPECT(lMaxError < (lInterpolation == FractionalDelay::lagrange ? 1e-4f
+                            : lInterpolation == FractionalDelay::linear ? 5e-4f : 5e-3f));
+    }
+}
+
+CASE("Doppler: benchmark [.bench]")
+{
+    const size_t kNumSources = 1000;
+    const int kNumBlocks = 10000;
+    const SampleCount kBlockSize = 256;
+    PropagationSettings lSettings;
+    const std::vector<Vector3f> lStart = randomPositions(kNumSources, 1);
+    const std::vector<Vector3f> lEnd = randomPositions(kNumSources, 2);
+    const Vector3Array<float> lStartArray(lStart), lEndArray(lEnd);
+    const Vector3f lListener = Vector3f::cartesian(0.f, 0.f, 0.f);
+    Ramps lRamps(kNumSources);
+    float lSum = 0.f;
+
+    StopWatch lStopWatch("ramps, one by one");
+    lStopWatch.start();
+    for (int b = 0 ; b != kNumBlocks ; ++b)
+    {
+        for (size_t i = 0 ; i != kNumSources ; ++i)
+        {
+            const float lDistanceStart = (lStart[i] - lListener).length();
+            const float lDistanceEnd = (lEnd[i] - lListener).length();
+            lRamps.mGains[i] = propagationGain(lDistanceStart, lSettings);
+            lRamps.mGainSteps[i] = (propagationGain(lDistanceEnd, lSettings) - lRamps.mGains[i]) / (float)kBlockSize;
+            lRamps.mDelays[i] = propagationDelay(lDistanceStart, lSettings);
+            lRamps.mDelaySteps[i] = (propagationDelay(lDistanceEnd, lSettings) - lRamps.mDelays[i]) / (float)kBlockSize;
+        }
+        lSum += lRamps.mDelays[(size_t)b % kNumSources];
+    }
+    lStopWatch.stopAndDisplay();
+
+    lStopWatch.renameAndStart("ramps, batch");
+    for (int b = 0 ; b != kNumBlocks ; ++b)
+    {
+        computePropagation(lStartArray, lEndArray, lListener, lListener, lSettings, kBlockSize, lRamps.get());
+        lSum += lRamps.mDelays[(size_t)b % kNumSources];
+    }
+    lStopWatch.stopAndDisplay();
+
+    // 64 sources, 1000 blocks
+    std::vector<float> lIn(kBlockSize, 0.5f), lOut(kBlockSize);
+    std::vector<FractionalDelayLine> lLines(64, FractionalDelayLine(lSettings.mMaxDelay, kBlockSize));
+    for (FractionalDelay lInterpolation : kInterpolations)
+    {
+        lStopWatch.renameAndStart(lInterpolation == FractionalDelay::linear ? "linear read"
+                                  : lInterpolation == FractionalDelay::lagrange ? "Lagrange read" : "Thiran read");
+        for (int b = 0 ; b != 1000 ; ++b)
+        {
+            for (size_t s = 0 ; s != lLines.size() ; ++s)
+            {
+                lLines[s].write(lIn.data(), kBlockSize);
+                lLines[s].read(lOut.data(), kBlockSize, lRamps.get(), s, lInterpolation);
+                lSum += lOut[(size_t)b % kBlockSize];
+            }
+        }
+        lStopWatch.stopAndDisplay();
+    }
+    EXPECT(lSum == lSum);
+}
@@ -0,0 +1,50 @@
+#include "fbu/fft.hpp"
+
+#include "tests_common.hpp"
+
+#include <random>
+
+CASE("FFT: forward transform matches the DFT definition")
+{
+    const int lOrder = 5;
+    const int lSize = 1 << lOrder;
+    std::mt19937 lRandomGenerator;
+    std::uniform_real_distribution<double> lDistribution(-1., 1.);
+    std::vector<Complexd> lSignal((size_t)lSize);
+    for (Complexd& c : lSignal)
+    {
+        c = {lDistribution(lRandomGenerator), lDistribution(lRandomGenerator)};
+    }
+    std::vector<Complexd> lSpectrum(lSignal);
+    fbu::Fft<double>(lOrder).perform(lSpectrum.data());
+    for (int k = 0 ; k != lSize ; ++k)
+    {
+        Complexd lExpected = {0., 0.};
+        for (int n = 0 ; n != lSize ; ++n)
+        {
+            lExpected += lSignal[(size_t)n] * Complexd::polar(1., -2. * M_PI * k * n / lSize);
+        }
+        EXPECT((lSpectrum[(size_t)k] - lExpected).mag() < 1e-9);
+    }
+}
+
+CASE("FFT: inverse of forward is the identity")
+{
+    const int lOrder = 10;
+    std::mt19937 lRandomGenerator;
+    std::uniform_real_distribution<float> lDistribution(-1.f, 1.f);
+    fbu::Fft<float> lFft(lOrder);
+    EXPECT(lFft.getSize() == 1024);
+    std::vector<Complexf> lSignal((size_t)lFft.getSize());
+    for (Complexf& c : lSignal)
+    {
+        c = {lDistribution(lRandomGenerator), lDistribution(lRandomGenerator)};
+    }
+    std::vector<Complexf> lRoundTrip(lSignal);
+    lFft.perform(lRoundTrip.data());
+    lFft.perform(lRoundTrip.data(), true);
+    for (size_t u = 0 ; u != lSignal.size() ; ++u)
+    {
+        EXPECT((lRoundTrip[u] - lSignal[u]).mag() < 1e-5f);
+    }
+}
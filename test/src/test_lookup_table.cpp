@@ -0,0 +1,194 @@
+#include "fbu/lookup_table.hpp"
+#include "fbu/math_utils.hpp"
+#include "fbu/stopwatch.hpp"
+
+#include "tests_common.hpp"
+
+#include <cfloat>
+#include <limits>
+#include <vector>
+
+using namespace fbu;
+
+namespace
+{
+    // the curve of SimpleMeterComponent
+    struct MeterSkew
+    {
+        static constexpr double min() { return 0.; }
+        static constexpr double max() { return 1.; }
+        static constexpr double value(double x) { return cx::ipow(x, 4); }
+    };
+
+    double relativeError(double pResult, double pExpected)
+    {
+        return std::abs(pResult - pExpected) / std::abs(pExpected);
+    }
+}
+
+CASE("Lookup table: constexpr exp, log and pow")
+{
+    static_assert(cx::exp(0.) == 1., "exp(0)");
+    static_assert(cx::log(1.) == 0., "log(1)");
+    static_assert(cx::log2(1024.) == 10., "log2 of a power of 2");
+    static_assert(cx::log2(0.125) == -3., "log2 of a power of 2");
+    static_assert(cx::ipow(3., 4) == 81., "integer power");
+    static_assert(cx::ipow(2., -2) == 0.25, "negative integer power");
+    static_assert(cx::abs(cx::dBToGain(-6.0205999132796239) - 0.5) < 1e-15, "constexpr dBToGain");
+    static_assert(cx::abs(cx::gainToDB(10.) - 20.) < 1e-13, "constexpr gainToDB");
+    static_assert(cx::log(0.) == -std::numeric_limits<double>::infinity(), "log(0)");
+
+    double lMaxExpError = 0., lMaxLogError = 0., lMaxPowError = 0.;
+    for (double x = -700. ; x <= 700. ; x += 0.37)
+    {
+        lMaxExpError = std::max(lMaxExpError, relativeError(cx::exp(x), std::exp(x)));
+    }
+    for (double x = 1e-300 ; x < 1e300 ; x *= 1.37)
+    {
+        lMaxLogError = std::max(lMaxLogError, std::abs(cx::log(x) - std::log(x)) / std::max(1., std::abs(std::log(x))));
+        lMaxPowError = std::max(lMaxPowError, relativeError(cx::pow(x, 0.3), std::pow(x, 0.3)));
+    }
+    EXPECT(lMaxExpError < 1e-14);
+    EXPECT(lMaxLogError < 1e-15);
+    EXPECT(lMaxPowError < 1e-13);
+    EXPECT(std::isnan(cx::log(-1.)));
+}
+
+CASE("Lookup table: compile-time curve and interpolation")
+{
+    constexpr LookupTable<float, 64> kSkew = makeLookupTable<float, 64, MeterSkew>();
+    static_assert(kSkew.size() == 65, "N + 1 samples");
+    static_assert(kSkew[0] == 0.f && kSkew[64] == 1.f, "end points");
+    static_assert(kSkew[32] == 0.0625f, "sample at 1/2");
+
+    float lMaxError = 0.f;
+    for (float x = 0.f ; x <= 1.f ; x += 1.f / 1000.f)
+    {
+        lMaxError = std::max(lMaxError, std::abs(kSkew.lookupLinear(x) - x * x * x * x));
+    }
+    // h^2 / 8 max|f''|
+    EXPECT(lMaxError < 4e-4f);
+    // the samples themselves are exact, and the input is clamped
+    EXPECT(kSkew.lookupLinear(0.5f) == 0.0625f);
+    EXPECT(kSkew.lookupLinear(-2.f) == 0.f);
+    EXPECT(kSkew.lookupLinear(3.f) == 1.f);
+    EXPECT(kSkew.lookupLinear(std::numeric_limits<float>::quiet_NaN()) == 0.f);
+    EXPECT(kSkew.lookupNearest(0.505f) == 0.0625f);
+    EXPECT(kSkew.lookupNearest(2.f) == 1.f);
+
+    // thousands of samples: the index sequence has a logarithmic depth
+    constexpr LookupTable<double, 4096> kLarge = makeLookupTable<double, 4096, MeterSkew>();
+    static_assert(kLarge[2048] == 0.0625, "large table");
+    EXPECT(kLarge.lookupLinear(1.f) == 1.);
+}
+
+CASE("Lookup table: dB, gain, sine and cosine")
+{
+    double lMaxDBError = 0.;
+    for (float g = 1e-8f ; g < 1e4f ; g *= 1.0137f)
+    {
+        lMaxDBError = std::max(lMaxDBError, std::abs((double)mu::lookupGainToDB(g) - 20. * std::log10((double)g)));
+    }
+    // plus the rounding of results up to 160 dB
+    EXPECT(lMaxDBError < 2e-5 + 160. * std::ldexp(1., -24));
+    EXPECT(mu::lookupGainToDB(1.f) == 0.f);
+    EXPECT(mu::lookupGainToDB(0.f) == -std::numeric_limits<float>::infinity());
+    EXPECT(mu::lookupGainToDB(-1.f) == -std::numeric_limits<float>::infinity());
+    EXPECT(mu::lookupGainToDB(std::numeric_limits<float>::quiet_NaN()) == -std::numeric_limits<float>::infinity());
+    EXPECT(mu::lookupGainToDB(std::numeric_limits<float>::infinity()) == std::numeric_limits<float>::infinity());
+
+    double lMaxGainError = 0.;
+    for (float lDB = -200.f ; lDB <= 200.f ; lDB += 0.0173f)
+    {
+        lMaxGainError = std::max(lMaxGainError, relativeError(mu::lookupDBToGain(lDB), std::pow(10., (double)lDB / 20.)));
+    }
+    EXPECT(lMaxGainError < 3e-6);
+    EXPECT(mu::lookupDBToGain(0.f) == 1.f);
+    EXPECT(mu::lookupDBToGain(-1000.f) == 0.f);
+    EXPECT(mu::lookupDBToGain(1000.f) == std::numeric_limits<float>::infinity());
+    EXPECT(std::isnan(mu::lookupDBToGain(std::numeric_limits<float>::quiet_NaN())));
+
+    double lMaxSinError = 0., lMaxSinErrorWide = 0.;
+    for (float x = -100.f ; x <= 100.f ; x += 0.00731f)
+    {
+        const double lError = std::max(std::abs((double)mu::lookupSin(x) - std::sin((double)x)),
+                                       std::abs((double)mu::lookupCos(x) - std::cos((double)x)));
+        lMaxSinErrorWide = std::max(lMaxSinErrorWide, lError);
+        if (std::abs(x) <= 2.f * (float)cx::kPi)
+        {
+            lMaxSinError = std::max(lMaxSinError, lError);
+        }
+    }
+    EXPECT(lMaxSinError < 5e-6);
+    EXPECT(lMaxSinErrorWide < 2e-5);
+}
+
+CASE("Lookup table: benchmark vs libm [.bench]")
+{
+    EXPECT( true ); // suppresses the compiler warning about unused parameter 'lest_env'
+    const size_t lSize = 1 << 20;
+    std::vector<float> lIn(lSize), lOut(lSize);
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lIn[u] = (float)(u + 1) / (float)lSize;
+    }
+    StopWatch lStopWatch("libm 20 log10");
+    lStopWatch.start();
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lOut[u] = 20.f * std::log10(lIn[u]);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("lookupGainToDB");
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lOut[u] = mu::lookupGainToDB(lIn[u]);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+
+    lStopWatch.renameAndStart("mu::dBToGain");
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lOut[u] = mu::dBToGain(-144.f * lIn[u]);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("lookupDBToGain");
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lOut[u] = mu::lookupDBToGain(-144.f * lIn[u]);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+
+    lStopWatch.renameAndStart("libm sin");
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lOut[u] = std::sin(6.f * lIn[u]);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("lookupSin");
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lOut[u] = mu::lookupSin(6.f * lIn[u]);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+
+    constexpr LookupTable<float, 64> kSkew = makeLookupTable<float, 64, MeterSkew>();
+    lStopWatch.renameAndStart("libm pow(x, 4)");
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lOut[u] = std::pow(lIn[u], 4.f);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("meter skew table");
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lOut[u] = kSkew.lookupLinear(lIn[u]);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("square(square(x))");
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lOut[u] = mu::square(mu::square(lIn[u]));
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+}
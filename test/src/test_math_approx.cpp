@@ -0,0 +1,286 @@
+#include "fbu/math_approx.hpp"
+#include "fbu/stopwatch.hpp"
+
+#include "tests_common.hpp"
+
+#include <iostream>
+#include <limits>
+#include <vector>
+
+using namespace mu;
+
+namespace
+{
+    enum class ErrorKind
+    {
+        absolute,
+        relative,
+        relativeAboveOne    ///< relative to max(1, |expected|)
+    };
+
+    /**
+     A documented contract: the max error of an approximation over a domain,
+     for the three accuracies.
+     */
+    struct Contract
+    {
+        const char* mName;
+        double      mMin;
+        double      mMax;
+        ErrorKind   mKind;
+        double      mMaxErrors[3];
+        double      mMaxMagnitude; ///< samples where |expected| is larger are skipped
+    };
+
+    template <Accuracy A>
+    float evaluate(const char* pName, float x)
+    {
+        const std::string lName = pName;
+        return lName == "sin"  ? approx::sin<A>(x)
+             : lName == "cos"  ? approx::cos<A>(x)
+             : lName == "tan"  ? approx::tan<A>(x)
+             : lName == "atan" ? approx::atan<A>(x)
+             : lName == "asin" ? approx::asin<A>(x)
+             : lName == "acos" ? approx::acos<A>(x)
+             : lName == "exp"  ? approx::exp<A>(x)
+             :                   approx::tanh<A>(x);
+    }
+
+    double reference(const char* pName, double x)
+    {
+        const std::string lName = pName;
+        return lName == "sin"  ? std::sin(x)
+             : lName == "cos"  ? std::cos(x)
+             : lName == "tan"  ? std::tan(x)
+             : lName == "atan" ? std::atan(x)
+             : lName == "asin" ? std::asin(x)
+             : lName == "acos" ? std::acos(x)
+             : lName == "exp"  ? std::exp(x)
+             :                   std::tanh(x);
+    }
+
+    template <Accuracy A>
+    double measure(const Contract& pContract, int pNumSamples, float& pWorstInput)
+    {
+        double lMaxError = 0.;
+        for (int i = 0 ; i <= pNumSamples ; ++i)
+        {
+            const float x = (float)(pContract.mMin + (pContract.mMax - pContract.mMin) * i / pNumSamples);
+            const double lExpected = reference(pContract.mName, (double)x);
+            if (std::abs(lExpected) > pContract.mMaxMagnitude)
+            {
+                continue;
+            }
+            double lError = std::abs((double)evaluate<A>(pContract.mName, x) - lExpected);
+            if (pContract.mKind == ErrorKind::relative)
+            {
+                lError /= std::abs(lExpected);
+            }
+            else if (pContract.mKind == ErrorKind::relativeAboveOne)
+            {
+                lError /= std::max(1., std::abs(lExpected));
+            }
+            if (! (lError <= lMaxError))
+            {
+                lMaxError = lError;
+                pWorstInput = x;
+            }
+        }
+        return lMaxError;
+    }
+
+    const double kHuge = std::numeric_limits<double>::max();
+
+    // the errors documented in math_approx.hpp
+    const Contract kContracts[] = {
+        {"sin",  -65536., 65536., ErrorKind::absolute,         {4e-4, 1.5e-6, 1e-7},   kHuge},
+        {"cos",  -65536., 65536., ErrorKind::absolute,         {4e-4, 1.5e-6, 1e-7},   kHuge},
+        {"tan",  -1.5707, 1.5707, ErrorKind::relative,         {7e-4, 3e-6, 3e-7},     kHuge},
+        {"tan",  -65536., 65536., ErrorKind::relativeAboveOne, {7e-4, 4e-6, 4e-6},     1000.},
+        {"atan", -1000.,  1000.,  ErrorKind::absolute,         {1.5e-4, 5e-7, 2e-7},   kHuge},
+        {"asin", -1.,     1.,     ErrorKind::absolute,         {5e-5, 2.5e-6, 2e-7},   kHuge},
+        {"acos", -1.,     1.,     ErrorKind::absolute,         {5e-5, 2.5e-6, 3.5e-7}, kHuge},
+        {"exp",  -87.,    88.,    ErrorKind::relative,         {2e-3, 3e-6, 2.5e-7},   kHuge},
+        {"tanh", -20.,    20.,    ErrorKind::absolute,         {1e-3, 2e-6, 2e-7},     kHuge},
+    };
+
+    template <Accuracy A>
+    double measureAtan2(int pNumSamplesPerSide)
+    {
+        double lMaxError = 0.;
+        for (int i = 0 ; i <= pNumSamplesPerSide ; ++i)
+        {
+            for (int j = 0 ; j <= pNumSamplesPerSide ; ++j)
+            {
+                const float y = (float)(-2. + 4. * i / pNumSamplesPerSide);
+                const float x = (float)(-2. + 4. * j / pNumSamplesPerSide);
+                double lError = std::abs((double)approx::atan2<A>(y, x) - std::atan2((double)y, (double)x));
+                // -π and π are the same angle
+                lError = std::min(lError, std::abs(lError - 2. * M_PI));
+                lMaxError = std::max(lMaxError, lError);
+            }
+        }
+        return lMaxError;
+    }
+
+    template <Accuracy A>
+    void checkContracts(lest::env& lest_env, int pNumSamples)
+    {
+        for (const Contract& lContract : kContracts)
+        {
+            float lWorstInput = 0.f;
+            const double lMaxError = measure<A>(lContract, pNumSamples, lWorstInput);
+            EXPECT(lMaxError <= lContract.mMaxErrors[(int)A]);
+        }
+        const double lAtan2Errors[] = {1.5e-4, 7e-7, 3e-7};
+        EXPECT(measureAtan2<A>(pNumSamples / 500) <= lAtan2Errors[(int)A]);
+    }
+}
+
+CASE("Math approx: documented accuracy")
+{
+    checkContracts<Accuracy::coarse>(lest_env, 100000);
+    checkContracts<Accuracy::medium>(lest_env, 100000);
+    checkContracts<Accuracy::high>(lest_env, 100000);
+}
+
+CASE("Math approx: special values")
+{
+    const float lInfinity = std::numeric_limits<float>::infinity();
+    const float lNaN = std::numeric_limits<float>::quiet_NaN();
+    EXPECT(approx::sin(0.f) == 0.f);
+    EXPECT(approx::cos(0.f) == 1.f);
+    EXPECT(std::isnan(approx::sin(lInfinity)));
+    EXPECT(std::isnan(approx::cos(-lInfinity)));
+    EXPECT(std::isnan(approx::tan(lNaN)));
+    EXPECT(std::abs(approx::atan(lInfinity) - M_PI_2f) < 1e-7f);
+    EXPECT(std::abs(approx::atan(-lInfinity) + M_PI_2f) < 1e-7f);
+    EXPECT(std::isnan(approx::asin(1.5f)));
+    EXPECT(std::isnan(approx::acos(-1.5f)));
+    EXPECT(std::abs(approx::asin(1.f) - M_PI_2f) < 1e-7f);
+    EXPECT(approx::acos(1.f) == 0.f);
+    EXPECT(std::abs(approx::acos(-1.f) - M_PIf) < 1e-7f);
+    EXPECT(approx::exp(0.f) == 1.f);
+    EXPECT(approx::exp(100.f) == lInfinity);
+    EXPECT(approx::exp(-200.f) == 0.f);
+    EXPECT(approx::exp(-lInfinity) == 0.f);
+    EXPECT(std::isnan(approx::exp(lNaN)));
+    EXPECT(approx::tanh(lInfinity) == 1.f);
+    EXPECT(approx::tanh(-100.f) == -1.f);
+    EXPECT(std::isnan(approx::tanh(lNaN)));
+
+    // the quadrants and signed zeros of std::atan2
+    EXPECT(approx::atan2(0.f, 1.f) == 0.f);
+    EXPECT(std::signbit(approx::atan2(-0.f, 1.f)));
+    EXPECT(approx::atan2(0.f, 0.f) == 0.f);
+    EXPECT(std::abs(approx::atan2(0.f, -0.f) - M_PIf) < 1e-7f);
+    EXPECT(std::abs(approx::atan2(-0.f, -1.f) + M_PIf) < 1e-7f);
+    EXPECT(std::abs(approx::atan2(1.f, 0.f) - M_PI_2f) < 1e-7f);
+    EXPECT(std::abs(approx::atan2(-1.f, -1.f) + 3.f * M_PI_4f) < 3e-7f);
+    EXPECT(std::abs(approx::atan2(lInfinity, 1.f) - M_PI_2f) < 1e-7f);
+    EXPECT(std::isnan(approx::atan2(lNaN, 1.f)));
+}
+
+CASE("Math approx: scalar and vector versions agree")
+{
+    using namespace fbu::simd;
+    const float lIn[kFloatLanes] = {-3.f, -0.25f, 0.75f, 100.f};
+    const float lOther[kFloatLanes] = {1.f, -2.f, 0.5f, -0.1f};
+    float lSin[kFloatLanes], lCos[kFloatLanes], lTan[kFloatLanes], lAtan2[kFloatLanes], lTanh[kFloatLanes];
+    vfloat s, c;
+    approx::sincos<Accuracy::medium>(load(lIn), s, c);
+    store(lSin, s);
+    store(lCos, c);
+    store(lTan, approx::tan<Accuracy::coarse>(load(lIn)));
+    store(lAtan2, approx::atan2(load(lIn), load(lOther)));
+    store(lTanh, approx::tanh(load(lIn)));
+    for (int i = 0 ; i != kFloatLanes ; ++i)
+    {
+        float lScalarSin, lScalarCos;
+        approx::sincos<Accuracy::medium>(lIn[i], lScalarSin, lScalarCos);
+        EXPECT(lScalarSin == lSin[i]);
+        EXPECT(lScalarCos == lCos[i]);
+        EXPECT(approx::sin<Accuracy::medium>(lIn[i]) == lSin[i]);
+        EXPECT(approx::tan<Accuracy::coarse>(lIn[i]) == lTan[i]);
+        EXPECT(approx::atan2(lIn[i], lOther[i]) == lAtan2[i]);
+        EXPECT(approx::tanh(lIn[i]) == lTanh[i]);
+    }
+}
+
+CASE("Math approx: accuracy report [.accuracy]")
+{
+    EXPECT( true ); // suppresses the compiler warning about unused parameter 'lest_env'
+    const int lNumSamples = 20000000;
+    for (const Contract& lContract : kContracts)
+    {
+        float lWorstInputs[3];
+        const double lErrors[3] = {
+            measure<Accuracy::coarse>(lContract, lNumSamples, lWorstInputs[0]),
+            measure<Accuracy::medium>(lContract, lNumSamples, lWorstInputs[1]),
+            measure<Accuracy::high>(lContract, lNumSamples, lWorstInputs[2])
+        };
+        std::cout << lContract.mName << " on [" << lContract.mMin << ", " << lContract.mMax << "]:";
+        for (int a = 0 ; a != 3 ; ++a)
+        {
+            std::cout << " " << lErrors[a] << " (x = " << lWorstInputs[a] << ", documented " << lContract.mMaxErrors[a] << ")";
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "atan2: " << measureAtan2<Accuracy::coarse>(4000) << " " << measureAtan2<Accuracy::medium>(4000)
+              << " " << measureAtan2<Accuracy::high>(4000) << std::endl;
+}
+
+CASE("Math approx: benchmark vs libm [.bench]")
+{
+    EXPECT( true ); // suppresses the compiler warning about unused parameter 'lest_env'
+    using namespace fbu::simd;
+    const int lSize = 1 << 20;
+    std::vector<float> lIn((size_t)lSize), lOut((size_t)lSize);
+    for (int i = 0 ; i != lSize ; ++i)
+    {
+        lIn[(size_t)i] = -10.f + 20.f * (float)i / (float)lSize;
+    }
+    StopWatch lStopWatch("std::sin");
+    lStopWatch.start();
+    for (size_t u = 0 ; u != lIn.size() ; ++u)
+    {
+        lOut[u] = std::sin(lIn[u]);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("approx::sin coarse");
+    for (int i = 0 ; i != lSize ; i += kFloatLanes)
+    {
+        store(&lOut[(size_t)i], approx::sin<Accuracy::coarse>(load(&lIn[(size_t)i])));
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("approx::sin high");
+    for (int i = 0 ; i != lSize ; i += kFloatLanes)
+    {
+        store(&lOut[(size_t)i], approx::sin<Accuracy::high>(load(&lIn[(size_t)i])));
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("std::atan2");
+    for (size_t u = 1 ; u != lIn.size() ; ++u)
+    {
+        lOut[u] = std::atan2(lIn[u], lIn[u - 1]);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("approx::atan2 high");
+    for (int i = kFloatLanes ; i != lSize ; i += kFloatLanes)
+    {
+        store(&lOut[(size_t)i], approx::atan2(load(&lIn[(size_t)i]), load(&lIn[(size_t)i - 1])));
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("std::tanh");
+    for (size_t u = 0 ; u != lIn.size() ; ++u)
+    {
+        lOut[u] = std::tanh(lIn[u]);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("approx::tanh medium");
+    for (int i = 0 ; i != lSize ; i += kFloatLanes)
+    {
+        store(&lOut[(size_t)i], approx::tanh<Accuracy::medium>(load(&lIn[(size_t)i])));
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+}
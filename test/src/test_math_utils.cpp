@@ -1,2 +1,159 @@
 #include "fbu/math_utils.hpp"
+#include "fbu/stopwatch.hpp"
 
+#include "tests_common.hpp"
+
+#include <cfloat>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace
+{
+    const float kInfinity = std::numeric_limits<float>::infinity();
+    const float kNaN = std::numeric_limits<float>::quiet_NaN();
+    const float kDenormal = FLT_MIN / 4.f;
+
+    std::vector<float> randomBlock(int pNumSamples, int pNumBad, std::mt19937& pRandomGenerator)
+    {
+        std::uniform_real_distribution<float> lDistribution(-1.f, 1.f);
+        std::vector<float> lBlock((size_t)pNumSamples);
+        for (float& x : lBlock)
+        {
+            x = lDistribution(pRandomGenerator);
+        }
+        const float lBadValues[] = {kInfinity, -kInfinity, kNaN, kDenormal, -kDenormal};
+        std::uniform_int_distribution<int> lPosition(0, pNumSamples - 1);
+        for (int b = 0 ; b != pNumBad ; ++b)
+        {
+            lBlock[(size_t)lPosition(pRandomGenerator)] = lBadValues[b % 5];
+        }
+        return lBlock;
+    }
+}
+
+CASE("Math utils: boundsSafeGuard and manualFTZ")
+{
+    std::vector<float> lBlock = {1.f, kInfinity, -kInfinity, kNaN, kDenormal, -kDenormal, 0.f, -0.f, FLT_MIN, -2.f};
+    std::vector<float> lCopy = lBlock;
+    EXPECT(mu::boundsSafeGuard(lCopy.data(), (int)lCopy.size()) == 3);
+    EXPECT(lCopy[0] == 1.f);
+    EXPECT(lCopy[1] == 0.f);
+    EXPECT(lCopy[3] == 0.f);
+    EXPECT(lCopy[4] == kDenormal);
+    EXPECT(lCopy[9] == -2.f);
+
+    lCopy = lBlock;
+    EXPECT(mu::manualFTZ(lCopy.data(), (int)lCopy.size()) == 5);
+    EXPECT(lCopy[4] == 0.f);
+    EXPECT(lCopy[5] == 0.f);
+    EXPECT(std::signbit(lCopy[7]));
+    EXPECT(lCopy[8] == FLT_MIN);
+
+    std::vector<double> lDoubles = {1., std::numeric_limits<double>::quiet_NaN(), DBL_MIN / 2., 0.};
+    EXPECT(mu::boundsSafeGuard(lDoubles.data(), 4) == 1);
+    EXPECT(mu::manualFTZ(lDoubles.data(), 4) == 1);
+    EXPECT(lDoubles[2] == 0.);
+}
+
+CASE("Math utils: vectorized boundsSafeGuard and manualFTZ match the scalar checks")
+{
+    std::mt19937 lRandomGenerator;
+    for (int lNumSamples : {1, 15, 16, 17, 64, 100, 1027})
+    {
+        for (int lNumBad : {0, 1, 3, 20})
+        {
+            const std::vector<float> lBlock = randomBlock(lNumSamples, lNumBad, lRandomGenerator);
+            std::vector<float> lGuarded = lBlock;
+            std::vector<float> lFlushed = lBlock;
+            const int lNumNonFinite = mu::boundsSafeGuard(lGuarded.data(), lNumSamples);
+            const int lNumNonNormal = mu::manualFTZ(lFlushed.data(), lNumSamples);
+            int lExpectedNonFinite = 0;
+            int lExpectedNonNormal = 0;
+            for (size_t u = 0 ; u != lBlock.size() ; ++u)
+            {
+                const float x = lBlock[u];
+                const bool lFinite = std::isfinite(x);
+                const bool lNormalOrZero = std::isnormal(x) || x == 0.f;
+                lExpectedNonFinite += lFinite ? 0 : 1;
+                lExpectedNonNormal += lNormalOrZero ? 0 : 1;
+                EXPECT((lFinite ? x == lGuarded[u] : lGuarded[u] == 0.f));
+                EXPECT((lNormalOrZero ? x == lFlushed[u] : lFlushed[u] == 0.f));
+            }
+            EXPECT(lNumNonFinite == lExpectedNonFinite);
+            EXPECT(lNumNonNormal == lExpectedNonNormal);
+        }
+    }
+}
+
+CASE("Math utils: fastRoundToInt rounds to nearest")
+{
+    EXPECT(mu::fastRoundToInt(2.) == 2);
+    EXPECT(mu::fastRoundToInt(2.4) == 2);
+    EXPECT(mu::fastRoundToInt(2.6) == 3);
+    EXPECT(mu::fastRoundToInt(-2.6) == -3);
+    EXPECT(mu::fastRoundToInt(1000000.2) == 1000000);
+}
+
+
+CASE("Math utils: boundsSafeGuard and manualFTZ benchmark [.bench]")
+{
+    std::mt19937 lRandomGenerator;
+    const int lNumSamplesPerRun = 1 << 22;
+    for (int lNumSamples : {64, 256, 1024, 4096})
+    {
+        for (int lPercentBad : {0, 1})
+        {
+            const std::vector<float> lBlock = randomBlock(lNumSamples, lNumSamples * lPercentBad / 100, lRandomGenerator);
+            std::vector<float> lWork = lBlock;
+            const int lNumRuns = lNumSamplesPerRun / lNumSamples;
+            const std::string lSuffix = std::to_string(lNumSamples) + " samples, "
+                                        + std::to_string(lPercentBad) + "% bad";
+            int lCount = 0;
+            StopWatch lStopWatch("scalar isfinite " + lSuffix);
+            lStopWatch.start();
+            for (int r = 0 ; r != lNumRuns ; ++r)
+            {
+                lWork = lBlock;
+                for (float& x : lWork)
+                {
+                    if (! std::isfinite(x))
+                    {
+                        x = 0.f;
+                        ++lCount;
+                    }
+                }
+            }
+            lStopWatch.stopAndDisplay<std::micro>();
+            lStopWatch.renameAndStart("boundsSafeGuard " + lSuffix);
+            for (int r = 0 ; r != lNumRuns ; ++r)
+            {
+                lWork = lBlock;
+                lCount += mu::boundsSafeGuard(lWork.data(), lNumSamples);
+            }
+            lStopWatch.stopAndDisplay<std::micro>();
+            lStopWatch.renameAndStart("scalar isnormal " + lSuffix);
+            for (int r = 0 ; r != lNumRuns ; ++r)
+            {
+                lWork = lBlock;
+                for (float& x : lWork)
+                {
+                    if (! std::isnormal(x) && x != 0.f)
+                    {
+                        x = 0.f;
+                        ++lCount;
+                    }
+                }
+            }
+            lStopWatch.stopAndDisplay<std::micro>();
+            lStopWatch.renameAndStart("manualFTZ " + lSuffix);
+            for (int r = 0 ; r != lNumRuns ; ++r)
+            {
+                lWork = lBlock;
+                lCount += mu::manualFTZ(lWork.data(), lNumSamples);
+            }
+            lStopWatch.stopAndDisplay<std::micro>();
+            EXPECT(lCount >= 0);
+        }
+    }
+}
@@ -0,0 +1,674 @@
+#include "fbu/math_vect.hpp"
+#include "fbu/stopwatch.hpp"
+
+#include "tests_common.hpp"
+
+#include <cfloat>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+using namespace mu;
+
+namespace
+{
+    typedef void (*VectFunction)(const float*, float*, size_t, Accuracy);
+
+    struct ErrorStats
+    {
+        double mMaxAbsolute = 0.;
+        double mMaxRelative = 0.;
+        float  mWorstAbsoluteInput = 0.f;
+        float  mWorstRelativeInput = 0.f;
+        bool   mSpecialValuesMatch = true;
+    };
+
+    /**
+     Run pFunction over every pStride-th float bit pattern, and compare to
+     pReference computed in double. The relative error is measured on the
+     normal results only. The absolute error includes the rounding of the
+     float result, up to 2^-24 |result| per operation.
+     */
+    template <class Reference>
+    ErrorStats measure(VectFunction pFunction, Reference pReference, Accuracy pAccuracy, uint32_t pStride)
+    {
+        ErrorStats lStats;
+        const size_t lBlockSize = 4099;
+        std::vector<float> lIn, lOut(lBlockSize);
+        lIn.reserve(lBlockSize);
+        uint64_t lBits = 0;
+        while (lBits <= 0xffffffffull)
+        {
+            lIn.clear();
+            for ( ; lBits <= 0xffffffffull && lIn.size() != lBlockSize ; lBits += pStride)
+            {
+                uint32_t lBits32 = (uint32_t)lBits;
+                float x;
+                std::memcpy(&x, &lBits32, sizeof(x));
+                lIn.push_back(x);
+            }
+            pFunction(lIn.data(), lOut.data(), lIn.size(), pAccuracy);
+            for (size_t u = 0 ; u != lIn.size() ; ++u)
+            {
+                const double lExpected = pReference((double)lIn[u]);
+                const float  lExpectedFloat = (float)lExpected;
+                double lResult = (double)lOut[u];
+                if (! std::isfinite(lExpectedFloat) || lExpectedFloat == 0.f)
+                {
+                    bool lMatch = (std::isnan(lExpectedFloat) && std::isnan(lResult))
+                                  || lExpectedFloat == (float)lResult
+                                  || (lExpectedFloat == 0.f && std::abs(lResult) < (double)FLT_MIN);
+                    lStats.mSpecialValuesMatch = lStats.mSpecialValuesMatch && lMatch;
+                    continue;
+                }
+                if (std::isinf(lResult))
+                {
+                    // overflow at the edge of the range
+                    lResult = std::copysign((double)FLT_MAX, lResult);
+                }
+                const double lAbsolute = std::abs(lResult - lExpected);
+                if (lAbsolute > lStats.mMaxAbsolute)
+                {
+                    lStats.mMaxAbsolute = lAbsolute;
+                    lStats.mWorstAbsoluteInput = lIn[u];
+                }
+                if (std::abs(lExpected) >= (double)FLT_MIN)
+                {
+                    const double lRelative = lAbsolute / std::abs(lExpected);
+                    if (lRelative > lStats.mMaxRelative)
+                    {
+                        lStats.mMaxRelative = lRelative;
+                        lStats.mWorstRelativeInput = lIn[u];
+                    }
+                }
+            }
+        }
+        return lStats;
+    }
+
+    void report(const char* pName, Accuracy pAccuracy, const ErrorStats& pStats)
+    {
+        std::cout << pName << " accuracy " << (int)pAccuracy
+                  << ": max abs error " << pStats.mMaxAbsolute << " (x = " << pStats.mWorstAbsoluteInput << ")"
+                  << ", max rel error " << pStats.mMaxRelative << " (x = " << pStats.mWorstRelativeInput << ")"
+                  << (pStats.mSpecialValuesMatch ? "" : ", special values differ") << std::endl;
+    }
+
+    double log2Reference(double x)
+    {
+        return std::log2(x);
+    }
+
+    double exp2Reference(double x)
+    {
+        return std::exp2(x);
+    }
+
+    double gainToDBReference(double x)
+    {
+        return 20. * std::log10(x);
+    }
+
+    double rsqrtReference(double x)
+    {
+        return 1. / std::sqrt(x);
+    }
+
+    double dBToGainReference(double x)
+    {
+        return std::pow(10., x / 20.);
+    }
+
+    // only the dB range where the argument rounding is documented
+    double dBToGainReferenceLimited(double x)
+    {
+        return std::abs(x) <= 200. ? dBToGainReference(x) : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    void vectDBToGainLimited(const float* pIn, float* pOut, size_t pSize, Accuracy pAccuracy)
+    {
+        vectDBToGain(pIn, pOut, pSize, pAccuracy);
+        for (size_t u = 0 ; u != pSize ; ++u)
+        {
+            if (std::abs(pIn[u]) > 200.f)
+            {
+                pOut[u] = std::numeric_limits<float>::quiet_NaN();
+            }
+        }
+    }
+
+    const Accuracy kAccuracies[] = {Accuracy::coarse, Accuracy::medium, Accuracy::high};
+}
+
+CASE("Math vect: documented accuracy over the float range")
+{
+    // a prime stride goes through all the exponents and mantissa patterns
+    const uint32_t lStride = 4093;
+    const double lLog2Errors[]     = {9e-4, 2e-5, 2e-7};
+    const double lExp2Errors[]     = {2e-3, 3e-6, 2e-7};
+    const double lGainToDBErrors[] = {6e-3, 1e-4, 2e-6};
+    const double lDBToGainErrors[] = {2e-3, 5e-6, 2e-6};
+    const double lRsqrtErrors[]    = {4e-4, 5e-7, 2.5e-7};
+    // rounding of log2(x) up to 128, and of 20 log10(x) up to 770 dB
+    const double lLog2Rounding = 128. * std::ldexp(1., -24);
+    const double lGainToDBRounding = 770. * std::ldexp(1., -23);
+    for (int a = 0 ; a != 3 ; ++a)
+    {
+        const Accuracy lAccuracy = kAccuracies[a];
+        ErrorStats lLog2 = measure(&vectLog2, &log2Reference, lAccuracy, lStride);
+        EXPECT(lLog2.mMaxAbsolute <= lLog2Errors[a] + lLog2Rounding);
+        EXPECT(lLog2.mSpecialValuesMatch);
+
+        ErrorStats lExp2 = measure(&vectExp2, &exp2Reference, lAccuracy, lStride);
+        EXPECT(lExp2.mMaxRelative <= lExp2Errors[a]);
+        EXPECT(lExp2.mSpecialValuesMatch);
+
+        ErrorStats lGainToDB = measure(&vectGainToDB, &gainToDBReference, lAccuracy, lStride);
+        EXPECT(lGainToDB.mMaxAbsolute <= lGainToDBErrors[a] + lGainToDBRounding);
+        EXPECT(lGainToDB.mSpecialValuesMatch);
+
+        ErrorStats lDBToGain = measure(&vectDBToGainLimited, &dBToGainReferenceLimited, lAccuracy, lStride);
+        EXPECT(lDBToGain.mMaxRelative <= lDBToGainErrors[a]);
+        EXPECT(lDBToGain.mSpecialValuesMatch);
+
+        ErrorStats lRsqrt = measure(&vectRsqrt, &rsqrtReference, lAccuracy, lStride);
+        EXPECT(lRsqrt.mMaxRelative <= lRsqrtErrors[a]);
+        EXPECT(lRsqrt.mSpecialValuesMatch);
+        EXPECT(std::abs(rsqrt(0.25f, lAccuracy) - 2.f) <= 2.f * (float)lRsqrtErrors[a]);
+    }
+}
+
+CASE("Math vect: special values and tails")
+{
+    const float lInfinity = std::numeric_limits<float>::infinity();
+    const float lNaN = std::numeric_limits<float>::quiet_NaN();
+    std::vector<float> lIn = {0.f, -0.f, -1.f, lInfinity, -lInfinity, lNaN, 1.f, 2.f, 0.5f, FLT_MIN / 8.f, 1024.f};
+    std::vector<float> lOut(lIn.size());
+    vectLog2(lIn.data(), lOut.data(), lIn.size());
+    EXPECT(lOut[0] == -lInfinity);
+    EXPECT(lOut[1] == -lInfinity);
+    EXPECT(std::isnan(lOut[2]));
+    EXPECT(lOut[3] == lInfinity);
+    EXPECT(std::isnan(lOut[4]));
+    EXPECT(std::isnan(lOut[5]));
+    EXPECT(lOut[6] == 0.f);
+    EXPECT(lOut[7] == 1.f);
+    EXPECT(lOut[8] == -1.f);
+    EXPECT(std::abs(lOut[9] + 129.f) < 1e-5f);
+    EXPECT(lOut[10] == 10.f);
+
+    lIn = {0.f, 1.f, -1.f, 10.f, 200.f, -200.f, lInfinity, -lInfinity, lNaN};
+    lOut.resize(lIn.size());
+    vectExp2(lIn.data(), lOut.data(), lIn.size());
+    EXPECT(lOut[0] == 1.f);
+    EXPECT(lOut[1] == 2.f);
+    EXPECT(lOut[2] == 0.5f);
+    EXPECT(lOut[3] == 1024.f);
+    EXPECT(lOut[4] == lInfinity);
+    EXPECT(lOut[5] == 0.f);
+    EXPECT(lOut[6] == lInfinity);
+    EXPECT(lOut[7] == 0.f);
+    EXPECT(std::isnan(lOut[8]));
+
+    lIn = {0.f, -0.f, -1.f, lInfinity, lNaN, 1.f, 4.f, FLT_MIN / 16.f};
+    lOut.resize(lIn.size());
+    vectRsqrt(lIn.data(), lOut.data(), lIn.size());
+    EXPECT(lOut[0] == lInfinity);
+    EXPECT(lOut[1] == -lInfinity);
+    EXPECT(std::isnan(lOut[2]));
+    EXPECT(lOut[3] == 0.f);
+    EXPECT(std::isnan(lOut[4]));
+    EXPECT(std::abs(lOut[5] - 1.f) < 2e-7f);
+    EXPECT(std::abs(lOut[6] - 0.5f) < 1e-7f);
+    EXPECT(std::abs(lOut[7] / 4.f / std::sqrt(1.f / FLT_MIN) - 1.f) < 2e-7f);
+    EXPECT(rsqrt(-0.f, Accuracy::coarse) == -lInfinity);
+
+    // in place, odd sizes: the tail gets the same approximation as the body
+    std::vector<float> lGains(13, 0.5f);
+    vectGainToDB(lGains.data(), lGains.data(), lGains.size(), Accuracy::coarse);
+    for (float lDB : lGains)
+    {
+        EXPECT(lDB == lGains[0]);
+        EXPECT(std::abs(lDB + 6.0206f) < 6e-3f);
+    }
+    vectDBToGain(lGains.data(), lGains.data(), lGains.size());
+    for (float lGain : lGains)
+    {
+        EXPECT(std::abs(lGain - 0.5f) < 2e-3f);
+    }
+}
+
+CASE("Math vect: saturating 8/16-bit arithmetics match the scalar versions")
+{
+    // all the uint8 pairs, in an odd size for the scalar tail
+    std::vector<uint8_t> lA, lB;
+    for (int a = 0 ; a != 256 ; ++a)
+    {
+        for (int b = 0 ; b != 256 ; ++b)
+        {
+            lA.push_back((uint8_t)a);
+            lB.push_back((uint8_t)b);
+        }
+    }
+    lA.push_back(255);
+    lB.push_back(255);
+    std::vector<uint8_t> lOut(lA.size());
+    size_t lNumMismatches = 0;
+    vectSaturatingAdd(lA.data(), lB.data(), lOut.data(), lA.size());
+    for (size_t u = 0 ; u != lA.size() ; ++u) lNumMismatches += lOut[u] != saturating_add(lA[u], lB[u]) ? 1 : 0;
+    vectSaturatingSubtract(lA.data(), lB.data(), lOut.data(), lA.size());
+    for (size_t u = 0 ; u != lA.size() ; ++u) lNumMismatches += lOut[u] != saturating_subtract(lA[u], lB[u]) ? 1 : 0;
+    vectDBSum0_2(lA.data(), lB.data(), lOut.data(), lA.size());
+    for (size_t u = 0 ; u != lA.size() ; ++u) lNumMismatches += lOut[u] != fast_dBSum0_2(lA[u], lB[u]) ? 1 : 0;
+    vectDBSum0_5(lA.data(), lB.data(), lOut.data(), lA.size());
+    for (size_t u = 0 ; u != lA.size() ; ++u) lNumMismatches += lOut[u] != fast_dBSum0_5(lA[u], lB[u]) ? 1 : 0;
+    EXPECT(lNumMismatches == 0u);
+    // +3 dB for equal levels, saturated at the top
+    EXPECT(fast_dBSum0_2(100, 100) == 103);
+    EXPECT(fast_dBSum0_2(255, 255) == 255);
+    EXPECT(fast_dBSum0_5(100, 0) == 100);
+
+    // in place
+    std::vector<uint8_t> lLevels(37, 250);
+    vectSaturatingAdd(lLevels.data(), lLevels.data(), lLevels.data(), lLevels.size());
+    for (uint8_t lLevel : lLevels) EXPECT(lLevel == 255);
+
+    // int16: the edges, and a sweep over the range
+    std::vector<int16_t> lA16, lB16;
+    const int16_t lEdges[] = {-32768, -32767, -1, 0, 1, 32766, 32767};
+    for (int16_t a : lEdges)
+    {
+        for (int16_t b : lEdges)
+        {
+            lA16.push_back(a);
+            lB16.push_back(b);
+        }
+    }
+    for (int i = -32768 ; i < 32768 ; i += 97)
+    {
+        lA16.push_back((int16_t)i);
+        lB16.push_back((int16_t)(i * 7 / 3 % 32768));
+    }
+    std::vector<int16_t> lOut16(lA16.size());
+    lNumMismatches = 0;
+    vectSaturatingAdd(lA16.data(), lB16.data(), lOut16.data(), lA16.size());
+    for (size_t u = 0 ; u != lA16.size() ; ++u) lNumMismatches += lOut16[u] != saturating_add(lA16[u], lB16[u]) ? 1 : 0;
+    vectSaturatingSubtract(lA16.data(), lB16.data(), lOut16.data(), lA16.size());
+    for (size_t u = 0 ; u != lA16.size() ; ++u) lNumMismatches += lOut16[u] != saturating_subtract(lA16[u], lB16[u]) ? 1 : 0;
+    EXPECT(lNumMismatches == 0u);
+    EXPECT(saturating_add((int16_t)32000, (int16_t)1000) == 32767);
+    EXPECT(saturating_subtract((int16_t)-32000, (int16_t)1000) == -32768);
+}
+
+CASE("Math vect: clamp and affine maps match the scalar versions")
+{
+    const float lNaN = std::numeric_limits<float>::quiet_NaN();
+    std::vector<float> lIn;
+    for (int i = 0 ; i != 103 ; ++i)
+    {
+        lIn.push_back((float)i * 0.37f - 15.f);
+    }
+    lIn[5] = lNaN;
+    std::vector<float> lOut(lIn.size());
+    vectLimitedRange(lIn.data(), lOut.data(), lIn.size(), -2.f, 10.f);
+    for (size_t u = 0 ; u != lIn.size() ; ++u)
+    {
+        const float lExpected = limitedRange(lIn[u], -2.f, 10.f);
+        EXPECT((lOut[u] == lExpected || (std::isnan(lOut[u]) && std::isnan(lExpected))));
+    }
+
+    std::vector<float> lInPlace = lIn;
+    vectAffineTransform(lInPlace.data(), lInPlace.size(), -15.f, 23.f, 1.f, 0.f);
+    for (size_t u = 0 ; u != lIn.size() ; ++u)
+    {
+        if (u != 5)
+        {
+            EXPECT(std::abs(lInPlace[u] - affineTransform(-15.f, 23.f, 1.f, 0.f, lIn[u])) < 1e-6f);
+        }
+    }
+    EXPECT(std::isnan(lInPlace[5]));
+
+    // a reversed destination range is clamped between its bounds
+    vectAffineTransformLimited(lIn.data(), lOut.data(), lIn.size(), 0.f, 10.f, 1.f, 0.f);
+    for (size_t u = 0 ; u != lIn.size() ; ++u)
+    {
+        if (u != 5)
+        {
+            const float lExpected = limitedRange(affineTransform(0.f, 10.f, 1.f, 0.f, lIn[u]), 0.f, 1.f);
+            EXPECT(std::abs(lOut[u] - lExpected) < 1e-6f);
+        }
+    }
+
+    std::vector<double> lInDouble(lIn.begin(), lIn.end()), lOutDouble(lIn.size());
+    lInDouble[5] = 0.;
+    vectAffineTransformLimited(lInDouble.data(), lOutDouble.data(), lInDouble.size(), -5., 5., -1., 1.);
+    for (size_t u = 0 ; u != lInDouble.size() ; ++u)
+    {
+        EXPECT(std::abs(lOutDouble[u] - affineTransformLimited(-5., 5., -1., 1., lInDouble[u])) < 1e-15);
+    }
+
+    std::vector<int32_t> lInInt, lOutInt;
+    for (int i = -1000 ; i <= 1000 ; i += 7)
+    {
+        lInInt.push_back(i);
+    }
+    lOutInt.resize(lInInt.size());
+    size_t lNumMismatches = 0;
+    vectLimitedRange(lInInt.data(), lOutInt.data(), lInInt.size(), -100, 300);
+    for (size_t u = 0 ; u != lInInt.size() ; ++u) lNumMismatches += lOutInt[u] != limitedRange(lInInt[u], -100, 300) ? 1 : 0;
+    vectAffineTransform(lInInt.data(), lOutInt.data(), lInInt.size(), -1000, 1000, 0, 127);
+    for (size_t u = 0 ; u != lInInt.size() ; ++u) lNumMismatches += lOutInt[u] != affineTransform(-1000, 1000, 0, 127, lInInt[u]) ? 1 : 0;
+    vectAffineTransformLimited(lInInt.data(), lOutInt.data(), lInInt.size(), -500, 500, 0, 127);
+    for (size_t u = 0 ; u != lInInt.size() ; ++u) lNumMismatches += lOutInt[u] != affineTransformLimited(-500, 500, 0, 127, lInInt[u]) ? 1 : 0;
+    EXPECT(lNumMismatches == 0u);
+
+    // other types take the scalar path
+    std::vector<int16_t> lShorts = {-300, 0, 300};
+    vectLimitRange(lShorts.data(), lShorts.size(), (int16_t)-100, (int16_t)100);
+    EXPECT(lShorts[0] == -100);
+    EXPECT(lShorts[1] == 0);
+    EXPECT(lShorts[2] == 100);
+}
+
+namespace
+{
+    // the same value, with the sign of the zeros
+    template <typename T>
+    bool sameAngle(T a, T b)
+    {
+        return a == b && std::signbit(a) == std::signbit(b);
+    }
+
+    // the edges of the domain, multiples of π, the zeros and the limit of
+    // the SIMD path, among random angles
+    template <typename T>
+    std::vector<T> edgeAngles(T pPi)
+    {
+        std::vector<T> lAngles;
+        for (int k = -9 ; k <= 9 ; ++k)
+        {
+            const T a = (T)k * pPi;
+            lAngles.push_back(a);
+            lAngles.push_back(std::nextafter(a, (T)100));
+            lAngles.push_back(std::nextafter(a, (T)-100));
+            lAngles.push_back(pPi + (T)k * ((T)2 * pPi));
+        }
+        lAngles.push_back((T)0);
+        lAngles.push_back(-(T)0);
+        lAngles.push_back(std::numeric_limits<T>::denorm_min());
+        lAngles.push_back((T)1e5);
+        lAngles.push_back((T)-16383.9);
+        lAngles.push_back((T)3e8);
+        uint32_t lSeed = 1;
+        for (int i = 0 ; i != 3000 ; ++i)
+        {
+            lSeed = lSeed * 1664525u + 1013904223u;
+            lAngles.push_back(((T)lSeed / (T)4294967296. - (T)0.5) * (i < 2000 ? (T)40 : (T)30000));
+        }
+        return lAngles;
+    }
+
+    template <typename T>
+    size_t angleMismatches(T pPi)
+    {
+        const std::vector<T> lAngles = edgeAngles(pPi);
+        const size_t lSize = lAngles.size();
+        std::vector<T> lOut(lSize);
+        size_t lNumMismatches = 0;
+
+        vectDomainAngle(lAngles.data(), lOut.data(), lSize);
+        for (size_t u = 0 ; u != lSize ; ++u) lNumMismatches += sameAngle(lOut[u], domainAngle(lAngles[u])) ? 0 : 1;
+
+        // in )-3π,3π)
+        std::vector<T> lSums;
+        for (T a : lAngles)
+        {
+            if (a > (T)-3 * pPi && a < (T)3 * pPi) lSums.push_back(a);
+        }
+        lSums.push_back((T)3 * pPi);
+        vectDomainAngleSimple(lSums.data(), lOut.data(), lSums.size());
+        for (size_t u = 0 ; u != lSums.size() ; ++u) lNumMismatches += sameAngle(lOut[u], domainAngleSimple(lSums[u])) ? 0 : 1;
+
+        // the angles against themselves shifted
+        std::vector<T> lTo(lAngles.begin() + 7, lAngles.end());
+        lTo.insert(lTo.end(), lAngles.begin(), lAngles.begin() + 7);
+        vectAngleDifference(lAngles.data(), lTo.data(), lOut.data(), lSize);
+        for (size_t u = 0 ; u != lSize ; ++u) lNumMismatches += sameAngle(lOut[u], angleDifference(lAngles[u], lTo[u])) ? 0 : 1;
+        for (T t : {(T)0, (T)0.3, (T)0.5, (T)1, (T)-2})
+        {
+            vectInterpolateAngle(lAngles.data(), lTo.data(), t, lOut.data(), lSize);
+            for (size_t u = 0 ; u != lSize ; ++u) lNumMismatches += sameAngle(lOut[u], interpolateAngle(lAngles[u], lTo[u], t)) ? 0 : 1;
+        }
+
+        // in place
+        lOut = lAngles;
+        vectDomainAngle(lOut.data(), lOut.data(), lSize);
+        for (size_t u = 0 ; u != lSize ; ++u) lNumMismatches += sameAngle(lOut[u], domainAngle(lAngles[u])) ? 0 : 1;
+        lNumMismatches += vectIsDomainAngle(lOut.data(), lSize) ? 0 : 1;
+        lNumMismatches += vectIsDomainAngle(lAngles.data(), lSize) ? 1 : 0;
+        return lNumMismatches;
+    }
+}
+
+CASE("Math vect: angles match the scalar versions")
+{
+    EXPECT(angleMismatches(M_PIf) == 0u);
+    EXPECT(angleMismatches(M_PI) == 0u);
+
+    // ±π
+    EXPECT(domainAngle(M_PIf) == M_PIf);
+    EXPECT(domainAngle(-M_PIf) == M_PIf);
+    EXPECT(domainAngle(-M_PI) == M_PI);
+    EXPECT(domainAngleSimple(-M_PI) == M_PI);
+    EXPECT(std::abs(angleDifference(3.f, -3.f) - (2.f * M_PIf - 6.f)) < 1e-6f);
+    EXPECT(std::abs(angleDifference(-3., 3.) + (2. * M_PI - 6.)) < 1e-15);
+    EXPECT(std::abs(interpolateAngle(3.f, -3.f, 0.75f) - (-3.f - 0.25f * (2.f * M_PIf - 6.f))) < 1e-6f);
+
+    std::vector<float> lAngles(11, M_PIf);
+    EXPECT(vectIsDomainAngle(lAngles.data(), lAngles.size()));
+    for (size_t u : {0u, 5u, 10u})
+    {
+        lAngles[u] = -M_PIf;
+        EXPECT(! vectIsDomainAngle(lAngles.data(), lAngles.size()));
+        lAngles[u] = std::nextafter(-M_PIf, 0.f);
+        EXPECT(vectIsDomainAngle(lAngles.data(), lAngles.size()));
+    }
+    EXPECT(vectIsDomainAngle(lAngles.data(), 0));
+}
+
+CASE("Math vect: exhaustive accuracy report [.accuracy]")
+{
+    EXPECT( true ); // suppresses the compiler warning about unused parameter 'lest_env'
+    // all the 2^32 inputs: takes minutes
+    for (Accuracy lAccuracy : kAccuracies)
+    {
+        report("vectLog2", lAccuracy, measure(&vectLog2, &log2Reference, lAccuracy, 1));
+        report("vectExp2", lAccuracy, measure(&vectExp2, &exp2Reference, lAccuracy, 1));
+        report("vectGainToDB", lAccuracy, measure(&vectGainToDB, &gainToDBReference, lAccuracy, 1));
+        report("vectDBToGain", lAccuracy, measure(&vectDBToGain, &dBToGainReference, lAccuracy, 1));
+        report("vectDBToGain |dB| <= 200", lAccuracy, measure(&vectDBToGainLimited, &dBToGainReferenceLimited, lAccuracy, 1));
+        report("vectRsqrt", lAccuracy, measure(&vectRsqrt, &rsqrtReference, lAccuracy, 1));
+    }
+}
+
+CASE("Math vect: benchmark vs libm [.bench]")
+{
+    const size_t lSize = 1 << 20;
+    std::vector<float> lIn(lSize), lOut(lSize);
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lIn[u] = (float)(u + 1) / (float)lSize;
+    }
+    StopWatch lStopWatch("libm 20 log10");
+    lStopWatch.start();
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lOut[u] = 20.f * std::log10(lIn[u]);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    for (Accuracy lAccuracy : kAccuracies)
+    {
+        lStopWatch.renameAndStart("vectGainToDB accuracy " + std::to_string((int)lAccuracy));
+        vectGainToDB(lIn.data(), lOut.data(), lSize, lAccuracy);
+        lStopWatch.stopAndDisplay<std::micro>();
+    }
+    lStopWatch.renameAndStart("libm pow(10, dB / 20)");
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lOut[u] = std::pow(10.f, lIn[u] / 20.f);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    for (Accuracy lAccuracy : kAccuracies)
+    {
+        lStopWatch.renameAndStart("vectDBToGain accuracy " + std::to_string((int)lAccuracy));
+        vectDBToGain(lIn.data(), lOut.data(), lSize, lAccuracy);
+        lStopWatch.stopAndDisplay<std::micro>();
+    }
+
+    std::vector<uint8_t> lLevelsA(lSize), lLevelsB(lSize), lLevelsOut(lSize);
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lLevelsA[u] = (uint8_t)(u * 7);
+        lLevelsB[u] = (uint8_t)(u * 13 + 5);
+    }
+    lStopWatch.renameAndStart("scalar fast_dBSum0_2");
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lLevelsOut[u] = fast_dBSum0_2(lLevelsA[u], lLevelsB[u]);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("vectDBSum0_2");
+    vectDBSum0_2(lLevelsA.data(), lLevelsB.data(), lLevelsOut.data(), lSize);
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("scalar saturating_add");
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lLevelsOut[u] = saturating_add(lLevelsA[u], lLevelsB[u]);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("vectSaturatingAdd");
+    vectSaturatingAdd(lLevelsA.data(), lLevelsB.data(), lLevelsOut.data(), lSize);
+    lStopWatch.stopAndDisplay<std::micro>();
+
+    std::vector<float> lSigned(lSize);
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lSigned[u] = 4.f * lIn[u] - 2.f;
+    }
+    lStopWatch.renameAndStart("scalar limitedRange");
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lOut[u] = limitedRange(lSigned[u], -1.f, 1.f);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("vectLimitedRange");
+    vectLimitedRange(lSigned.data(), lOut.data(), lSize, -1.f, 1.f);
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("scalar affineTransformLimited");
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lOut[u] = affineTransformLimited(-1.f, 1.f, 0.f, 127.f, lSigned[u]);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("vectAffineTransformLimited");
+    vectAffineTransformLimited(lSigned.data(), lOut.data(), lSize, -1.f, 1.f, 0.f, 127.f);
+    lStopWatch.stopAndDisplay<std::micro>();
+    std::vector<double> lDoubles(lSigned.begin(), lSigned.end()), lDoublesOut(lSize);
+    lStopWatch.renameAndStart("scalar affineTransformLimited double");
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lDoublesOut[u] = affineTransformLimited(-1., 1., 0., 127., lDoubles[u]);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("vectAffineTransformLimited double");
+    vectAffineTransformLimited(lDoubles.data(), lDoublesOut.data(), lSize, -1., 1., 0., 127.);
+    lStopWatch.stopAndDisplay<std::micro>();
+
+    // angles of about ±10 turns
+    std::vector<float> lAngles(lSize), lTargets(lSize);
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lAngles[u] = 30.f * lSigned[u];
+        lTargets[u] = 20.f * lIn[u];
+    }
+    lStopWatch.renameAndStart("scalar domainAngle");
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lOut[u] = domainAngle(lAngles[u]);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("vectDomainAngle");
+    vectDomainAngle(lAngles.data(), lOut.data(), lSize);
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("scalar interpolateAngle");
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lOut[u] = interpolateAngle(lAngles[u], lTargets[u], 0.3f);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("vectInterpolateAngle");
+    vectInterpolateAngle(lAngles.data(), lTargets.data(), 0.3f, lOut.data(), lSize);
+    lStopWatch.stopAndDisplay<std::micro>();
+    std::vector<double> lDoubleAngles(lAngles.begin(), lAngles.end());
+    lStopWatch.renameAndStart("scalar domainAngle double");
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lDoublesOut[u] = domainAngle(lDoubleAngles[u]);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("vectDomainAngle double");
+    vectDomainAngle(lDoubleAngles.data(), lDoublesOut.data(), lSize);
+    lStopWatch.stopAndDisplay<std::micro>();
+
+    lStopWatch.renameAndStart("libm 1 / sqrt");
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        lOut[u] = 1.f / std::sqrt(lIn[u]);
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    for (Accuracy lAccuracy : kAccuracies)
+    {
+        lStopWatch.renameAndStart("vectRsqrt accuracy " + std::to_string((int)lAccuracy));
+        vectRsqrt(lIn.data(), lOut.data(), lSize, lAccuracy);
+        lStopWatch.stopAndDisplay<std::micro>();
+    }
+
+    // normalization of 3D vectors, in SoA arrays
+    std::vector<float> lX(lSigned), lY(lIn), lZ(lSize, 0.5f), lScales(lSize);
+    lStopWatch.renameAndStart("normalize with finvsqrt");
+    for (size_t u = 0 ; u != lSize ; ++u)
+    {
+        const float lScale = finvsqrt(lX[u] * lX[u] + lY[u] * lY[u] + lZ[u] * lZ[u]);
+        lX[u] *= lScale;
+        lY[u] *= lScale;
+        lZ[u] *= lScale;
+    }
+    lStopWatch.stopAndDisplay<std::micro>();
+    for (Accuracy lAccuracy : kAccuracies)
+    {
+        lStopWatch.renameAndStart("normalize with rsqrt accuracy " + std::to_string((int)lAccuracy));
+        for (size_t u = 0 ; u != lSize ; ++u)
+        {
+            const float lScale = rsqrt(lX[u] * lX[u] + lY[u] * lY[u] + lZ[u] * lZ[u], lAccuracy);
+            lX[u] *= lScale;
+            lY[u] *= lScale;
+            lZ[u] *= lScale;
+        }
+        lStopWatch.stopAndDisplay<std::micro>();
+        lStopWatch.renameAndStart("normalize with vectRsqrt accuracy " + std::to_string((int)lAccuracy));
+        for (size_t u = 0 ; u != lSize ; ++u)
+        {
+            lScales[u] = lX[u] * lX[u] + lY[u] * lY[u] + lZ[u] * lZ[u];
+        }
+        vectRsqrt(lScales.data(), lScales.data(), lSize, lAccuracy);
+        for (size_t u = 0 ; u != lSize ; ++u)
+        {
+            lX[u] *= lScales[u];
+            lY[u] *= lScales[u];
+            lZ[u] *= lScales[u];
+        }
+        lStopWatch.stopAndDisplay<std::micro>();
+    }
+    EXPECT(std::abs(lX[lSize / 3] * lX[lSize / 3] + lY[lSize / 3] * lY[lSize / 3] + lZ[lSize / 3] * lZ[lSize / 3] - 1.f) < 1e-3f);
+}
@@ -0,0 +1,225 @@
+#include "fbu/rotation.hpp"
+#include "fbu/stopwatch.hpp"
+
+#include "tests_common.hpp"
+
+#include <random>
+#include <vector>
+
+using namespace fbu;
+
+namespace
+{
+    template <typename T>
+    T distance(const Vector3<T>& pA, const Vector3<T>& pB)
+    {
+        return (pA - pB).length();
+    }
+
+    // the largest difference between the matrices
+    template <typename T>
+    T distance(const Matrix3<T>& pA, const Matrix3<T>& pB)
+    {
+        T lMaxError = (T)0;
+        for (int i = 0 ; i != 3 ; ++i)
+        {
+            for (int j = 0 ; j != 3 ; ++j)
+            {
+                lMaxError = std::max(lMaxError, std::abs(pA.mValues[i][j] - pB.mValues[i][j]));
+            }
+        }
+        return lMaxError;
+    }
+
+    // of the rotations, q and -q being the same
+    template <typename T>
+    T distance(const Quaternion<T>& pA, const Quaternion<T>& pB)
+    {
+        return (T)1 - std::abs(pA.dot(pB));
+    }
+
+    struct Random
+    {
+        Random()
+        : mGenerator(43)
+        , mDistribution(-3.f, 3.f)
+        {
+        }
+
+        float operator()()
+        {
+            return mDistribution(mGenerator);
+        }
+
+        Vector3f vector()
+        {
+            return Vector3f::cartesian((*this)(), (*this)(), (*this)());
+        }
+
+        Quaternionf rotation()
+        {
+            return Quaternionf::fromYawPitchRoll((*this)(), (*this)(), (*this)());
+        }
+
+        std::mt19937 mGenerator;
+        std::uniform_real_distribution<float> mDistribution;
+    };
+}
+
+CASE("Rotation: conventions")
+{
+    const Vector3f lFront = Vector3f::cartesian(1.f, 0.f, 0.f);
+    const Vector3f lLeft = Vector3f::cartesian(0.f, 1.f, 0.f);
+    const Vector3f lTop = Vector3f::cartesian(0.f, 0.f, 1.f);
+    for (float lYaw : {-2.5f, 0.f, 0.3f, 1.f})
+    {
+        for (float lPitch : {-1.f, 0.f, 0.7f})
+        {
+            const Vector3f lExpected = Vector3f::fromAE(AEf::ae(lYaw, lPitch));
+            EXPECT(distance(Quaternionf::fromYawPitchRoll(lYaw, lPitch, 0.5f).rotate(lFront), lExpected) < 1e-6f);
+            EXPECT(distance(Matrix3f::fromYawPitchRoll(lYaw, lPitch, -2.f).rotate(lFront), lExpected) < 1e-6f);
+        }
+    }
+    EXPECT(distance(Matrix3f::fromYawPitchRoll(0.f, 0.f, M_PI_2f) * lLeft, lTop) < 1e-6f);
+    EXPECT(distance(Matrix3f::fromYawPitchRoll(M_PI_2f, 0.f, 0.f) * lFront, lLeft) < 1e-6f);
+    EXPECT(distance(Matrix3f::fromYawPitchRoll(0.f, M_PI_2f, 0.f) * lFront, lTop) < 1e-6f);
+    EXPECT(distance(Matrix3f::identity() * lLeft, lLeft) == 0.f);
+
+    const AEMf lRotated = Quaternionf::fromYawPitchRoll(0.5f, 0.f, 0.f).rotate(AEMf::aem(0.25f, 0.1f, 2.f));
+    EXPECT(std::abs(lRotated.mAzimuth - 0.75f) < 1e-6f);
+    EXPECT(std::abs(lRotated.mElevation - 0.1f) < 1e-6f);
+    EXPECT(std::abs(lRotated.mMagnitude - 2.f) < 1e-6f);
+}
+
+CASE("Rotation: quaternions and matrices agree")
+{
+    Random lRandom;
+    for (int i = 0 ; i != 1000 ; ++i)
+    {
+        const Quaternionf q1 = lRandom.rotation();
+        const Quaternionf q2 = lRandom.rotation();
+        const Matrix3f m1 = Matrix3f::fromQuaternion(q1);
+        const Matrix3f m2 = Matrix3f::fromQuaternion(q2);
+        const Vector3f v = lRandom.vector();
+        EXPECT(distance(q1.rotate(v), m1 * v) < 1e-5f);
+        EXPECT(distance(Matrix3f::fromQuaternion(q1 * q2), m1 * m2) < 1e-6f);
+        EXPECT(distance(Quaternionf::fromMatrix(m1), q1) < 1e-6f);
+        EXPECT(distance(m1.transposed() * m1, Matrix3f::identity()) < 1e-6f);
+        EXPECT(distance(q1.conjugate().rotate(q1.rotate(v)), v) < 1e-5f);
+    }
+}
+
+CASE("Rotation: slerp")
+{
+    const Vector3f lTop = Vector3f::cartesian(0.f, 0.f, 1.f);
+    const Quaternionf a = Quaternionf::fromAxisAngle(lTop, 0.2f);
+    const Quaternionf b = Quaternionf::fromAxisAngle(lTop, 1.4f);
+    EXPECT(distance(slerp(a, b, 0.f), a) < 1e-6f);
+    EXPECT(distance(slerp(a, b, 1.f), b) < 1e-6f);
+    // constant angular speed
+    for (float t : {0.1f, 0.25f, 0.5f, 0.9f})
+    {
+        EXPECT(distance(slerp(a, b, t), Quaternionf::fromAxisAngle(lTop, 0.2f + t * 1.2f)) < 1e-6f);
+    }
+    // q and -q are the same rotation: the shortest path
+    const Quaternionf lMinusB = Quaternionf::wxyz(-b.mW, -b.mX, -b.mY, -b.mZ);
+    EXPECT(distance(slerp(a, lMinusB, 0.5f), Quaternionf::fromAxisAngle(lTop, 0.8f)) < 1e-6f);
+    // close rotations
+    const Quaternionf c = Quaternionf::fromAxisAngle(lTop, 0.2001f);
+    EXPECT(distance(slerp(a, c, 0.5f), Quaternionf::fromAxisAngle(lTop, 0.20005f)) < 1e-6f);
+    EXPECT(std::abs(slerp(a, c, 0.5f).dot(slerp(a, c, 0.5f)) - 1.f) < 1e-6f);
+}
+
+CASE("Rotation: Vector3Array")
+{
+    Random lRandom;
+    for (size_t lSize : {0u, 1u, 4u, 7u, 1001u})
+    {
+        std::vector<Vector3f> lVectors(lSize);
+        for (Vector3f& v : lVectors)
+        {
+            v = lRandom.vector();
+        }
+        const Quaternionf q = lRandom.rotation();
+        const Matrix3f m = Matrix3f::fromQuaternion(q);
+        const Vector3Array<float> lIn(lVectors);
+        Vector3Array<float> lOut(3), lInPlace(lIn);
+        rotate(m, lIn, lOut);
+        rotate(q, lInPlace);
+        Vector3Array<double> lDoubles(lSize);
+        for (size_t i = 0 ; i != lSize ; ++i)
+        {
+            lDoubles[i] = Vector3<double>::cartesian(lVectors[i].mX, lVectors[i].mY, lVectors[i].mZ);
+        }
+        rotate(Matrix3<double>::fromQuaternion(Quaternion<double>::wxyz(q.mW, q.mX, q.mY, q.mZ)), lDoubles);
+        EXPECT(lOut.size() == lSize);
+        float lMaxError = 0.f;
+        for (size_t i = 0 ; i != lSize ; ++i)
+        {
+            const Vector3f lExpected = m * lVectors[i];
+            const Vector3<double> lDouble = lDoubles[i];
+            lMaxError = std::max(lMaxError, distance<float>(lOut[i], lExpected));
+            lMaxError = std::max(lMaxError, distance<float>(lInPlace[i], lExpected));
+            lMaxError = std::max(lMaxError, distance(Vector3f::cartesian((float)lDouble.mX, (float)lDouble.mY, (float)lDouble.mZ), lExpected));
+        }
+        EXPECT(lMaxError < 1e-5f);
+        for (size_t u = lSize ; u != lOut.paddedSize() ; ++u)
+        {
+            EXPECT(lOut.x()[u] == 0.f);
+            EXPECT(lOut.y()[u] == 0.f);
+            EXPECT(lOut.z()[u] == 0.f);
+        }
+    }
+}
+
+CASE("Rotation: benchmark [.bench]")
+{
+    const size_t kNumVectors = 100000;
+    const int kNumIterations = 1000;
+    Random lRandom;
+    std::vector<Vector3f> lVectors(kNumVectors);
+    for (Vector3f& v : lVectors)
+    {
+        v = lRandom.vector();
+    }
+    const Vector3Array<float> lSoA(lVectors);
+    std::vector<Vector3f> lAoSOut(kNumVectors);
+    Vector3Array<float> lSoAOut;
+    const Matrix3f m = Matrix3f::fromYawPitchRoll(0.3f, 0.2f, 0.1f);
+    float lSum = 0.f;
+
+    // the yaw only, and 10 times fewer calls
+    StopWatch lStopWatch("AEM round trip / 10");
+    lStopWatch.start();
+    for (int i = 0 ; i != kNumIterations / 10 ; ++i)
+    {
+        for (size_t u = 0 ; u != kNumVectors ; ++u)
+        {
+            AEMf lAEM = AEMf::fromVector3(lVectors[u]);
+            lAEM.mAzimuth += 0.3f;
+            lAoSOut[u] = Vector3f::fromAEM(lAEM);
+        }
+        lSum += lAoSOut[(size_t)i].mX;
+    }
+    lStopWatch.stopAndDisplay();
+
+    lStopWatch.renameAndStart("Matrix3 on Vector3");
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        for (size_t u = 0 ; u != kNumVectors ; ++u)
+        {
+            lAoSOut[u] = m * lVectors[u];
+        }
+        lSum += lAoSOut[(size_t)i].mX;
+    }
+    lStopWatch.stopAndDisplay();
+
+    lStopWatch.renameAndStart("Matrix3 on Vector3Array");
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        rotate(m, lSoA, lSoAOut);
+        lSum += lSoAOut.x()[i];
+    }
+    lStopWatch.stopAndDisplay();
+    EXPECT(lSum != 0.f);
+}
@@ -0,0 +1,114 @@
+#include "fbu/simd.hpp"
+
+#include "tests_common.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace fbu;
+
+CASE("SIMD: arithmetics and comparisons")
+{
+    const float lA[] = {1.f, -2.f, 3.f, -4.f, 5.f, -6.f, 7.f, -8.f};
+    const float lB[] = {2.f, 2.f, 2.f, 2.f, 2.f, 2.f, 2.f, 2.f};
+    float lOut[simd::kFloatLanes];
+    simd::vfloat a = simd::load(lA);
+    simd::vfloat b = simd::load(lB);
+
+    simd::store(lOut, simd::mulAdd(a, b, b));
+    for (int i = 0 ; i != simd::kFloatLanes ; ++i)
+    {
+        EXPECT(lOut[i] == lA[i] * 2.f + 2.f);
+    }
+
+    simd::store(lOut, simd::select(a < simd::zero(), simd::abs(a), a / b));
+    for (int i = 0 ; i != simd::kFloatLanes ; ++i)
+    {
+        EXPECT(lOut[i] == (lA[i] < 0.f ? -lA[i] : lA[i] / 2.f));
+    }
+
+    EXPECT(simd::any(a < simd::zero()));
+    EXPECT(!simd::all(a < simd::zero()));
+    EXPECT(simd::moveMask(a < simd::zero()) == 0xAA >> (8 - simd::kFloatLanes));
+}
+
+CASE("SIMD: integer conversions and bit reinterpretation")
+{
+    const float lA[] = {1.4f, -1.6f, 2.5f, -100.2f, 3.5f, 0.f, -0.5f, 1e6f};
+    int32_t lOut[simd::kFloatLanes];
+    simd::vfloat a = simd::load(lA);
+
+    simd::storeInt(lOut, simd::toIntRound(a));
+    for (int i = 0 ; i != simd::kFloatLanes ; ++i)
+    {
+        EXPECT(lOut[i] == (int32_t)std::nearbyint(lA[i]));
+    }
+
+    simd::storeInt(lOut, simd::toIntTrunc(a));
+    for (int i = 0 ; i != simd::kFloatLanes ; ++i)
+    {
+        EXPECT(lOut[i] == (int32_t)lA[i]);
+    }
+
+    simd::storeInt(lOut, simd::shiftRightLogical<23>(simd::asInt(simd::abs(a))) & simd::set1Int(0xFF));
+    for (int i = 0 ; i != simd::kFloatLanes ; ++i)
+    {
+        int lExponent;
+        std::frexp(lA[i], &lExponent);
+        EXPECT((lA[i] == 0.f ? 0 : lOut[i] - 126) == lExponent);
+    }
+}
+
+CASE("SIMD: horizontal reductions")
+{
+    const float lA[] = {1.f, -2.f, 3.f, 4.f, 5.f, -6.f, 7.f, 8.f};
+    simd::vfloat a = simd::load(lA);
+    float lSum = 0.f, lMin = lA[0], lMax = lA[0];
+    for (int i = 0 ; i != simd::kFloatLanes ; ++i)
+    {
+        lSum += lA[i];
+        lMin = std::min(lMin, lA[i]);
+        lMax = std::max(lMax, lA[i]);
+    }
+    EXPECT(simd::hsum(a) == lSum);
+    EXPECT(simd::hmin(a) == lMin);
+    EXPECT(simd::hmax(a) == lMax);
+}
+
+CASE("SIMD: doubles, integer min/max and the NaN operand of min/max")
+{
+    const double lA[] = {1.5, -2.5};
+    const double lB[] = {-3., 4.};
+    double lOut[simd::kDoubleLanes];
+    simd::vdouble a = simd::load(lA);
+    simd::vdouble b = simd::load(lB);
+    simd::store(lOut, simd::mulAdd(a, b, simd::set1Double(1.)));
+    EXPECT(lOut[0] == -3.5);
+    EXPECT(lOut[1] == -9.);
+    simd::store(lOut, simd::min(a, b) / simd::max(a, b));
+    EXPECT(lOut[0] == -2.);
+    EXPECT(lOut[1] == -2.5 / 4.);
+    EXPECT(simd::moveMask(a < b) == 2);
+    EXPECT(simd::moveMask(a >= b) == 1);
+    EXPECT(simd::moveMask(a == a) == 3);
+    simd::store(lOut, simd::select(a > b, simd::abs(b), simd::abs(a)));
+    EXPECT(lOut[0] == 3.);
+    EXPECT(lOut[1] == 2.5);
+
+    const int32_t lI[] = {-7, 3, 2147483647, -2147483647 - 1};
+    const int32_t lJ[] = {5, 3, 0, 0};
+    int32_t lOutInt[simd::kFloatLanes];
+    simd::storeInt(lOutInt, simd::min(simd::loadInt(lI), simd::loadInt(lJ)));
+    for (int i = 0 ; i != simd::kFloatLanes ; ++i) EXPECT(lOutInt[i] == std::min(lI[i], lJ[i]));
+    simd::storeInt(lOutInt, simd::max(simd::loadInt(lI), simd::loadInt(lJ)));
+    for (int i = 0 ; i != simd::kFloatLanes ; ++i) EXPECT(lOutInt[i] == std::max(lI[i], lJ[i]));
+
+    // SSE semantics, also in the scalar fallback: NaN as the second operand is returned
+    const float lNaN = std::numeric_limits<float>::quiet_NaN();
+    float lOutFloat[simd::kFloatLanes];
+    simd::store(lOutFloat, simd::min(simd::set1(1.f), simd::set1(lNaN)));
+    EXPECT(std::isnan(lOutFloat[0]));
+    simd::store(lOutFloat, simd::max(simd::set1(1.f), simd::set1(lNaN)));
+    EXPECT(std::isnan(lOutFloat[0]));
+}
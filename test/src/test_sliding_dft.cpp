@@ -0,0 +1,151 @@
+#include "fbu/sliding_dft.hpp"
+#include "fbu/fft.hpp"
+#include "fbu/stopwatch.hpp"
+
+#include "tests_common.hpp"
+
+#include <random>
+
+namespace
+{
+    template <typename T>
+    Complex<double> dftOfLastSamples(const std::vector<T>& pSignal, int pWindowSize, double pBin, double pDamping)
+    {
+        // X = Σ_{m=0..N-1} W^(m+1) x[n-m], W = r e^(j 2π k / N)
+        Complex<double> lResult = {0., 0.};
+        size_t lLast = pSignal.size() - 1;
+        for (int m = 0 ; m != pWindowSize ; ++m)
+        {
+            double lWeight = std::pow(pDamping, m + 1);
+            double lAngle = 2. * M_PI * pBin * (m + 1) / pWindowSize;
+            lResult += Complex<double>::polar(lWeight * (double)pSignal[lLast - (size_t)m], lAngle);
+        }
+        return lResult;
+    }
+}
+
+CASE("Sliding DFT: undamped bins match the DFT of the window")
+{
+    const int lWindowSize = 64;
+    const double lBins[] = {0., 3., 7., 10., 31., 5.5};
+    fbu::SlidingDftBank<double> lBank(lWindowSize, lBins, 6, 1.);
+    std::mt19937 lRandomGenerator;
+    std::uniform_real_distribution<double> lDistribution(-1., 1.);
+    std::vector<double> lSignal(300);
+    for (double& x : lSignal)
+    {
+        x = lDistribution(lRandomGenerator);
+    }
+    lBank.process(lSignal.data(), 100);
+    lBank.process(lSignal.data() + 100, 200);
+
+    for (int k = 0 ; k != 6 ; ++k)
+    {
+        Complexd lExpected = dftOfLastSamples(lSignal, lWindowSize, lBins[k], 1.);
+        EXPECT((lBank.getBin(k) - lExpected).mag() < 1e-9);
+    }
+
+    // integer bins are the plain DFT of the last N samples
+    std::vector<Complexd> lWindow((size_t)lWindowSize);
+    for (int n = 0 ; n != lWindowSize ; ++n)
+    {
+        lWindow[(size_t)n] = {lSignal[lSignal.size() - (size_t)lWindowSize + (size_t)n], 0.};
+    }
+    fbu::Fft<double>(6).perform(lWindow.data());
+    EXPECT((lBank.getBin(2) - lWindow[7]).mag() < 1e-9);
+}
+
+CASE("Sliding DFT: damped float bank, SIMD tail bins")
+{
+    const int lWindowSize = 128;
+    const float lBins[] = {1.f, 2.f, 4.f, 8.f, 16.f, 32.f, 63.f};
+    const float lDamping = 0.999f;
+    fbu::SlidingDftBank<float> lBank(lWindowSize, lBins, 7, lDamping);
+    EXPECT(lBank.getNumBins() == 7);
+    std::vector<float> lSignal(1000);
+    for (size_t u = 0 ; u != lSignal.size() ; ++u)
+    {
+        lSignal[u] = std::sin(2.f * M_PIf * 8.f * (float)u / (float)lWindowSize) + 0.25f;
+    }
+    lBank.process(lSignal.data(), (SampleCount)lSignal.size());
+    for (int k = 0 ; k != 7 ; ++k)
+    {
+        Complexd lExpected = dftOfLastSamples(lSignal, lWindowSize, lBins[k], lDamping);
+        EXPECT((Complexd({lBank.getBin(k).re, lBank.getBin(k).im}) - lExpected).mag() < 1e-2);
+    }
+    EXPECT(lBank.getMagnitude(3) > 50.f);
+
+    lBank.reset();
+    EXPECT(lBank.getMagnitude(3) == 0.f);
+}
+
+CASE("Goertzel: block powers match the DFT")
+{
+    const int lBlockSize = 256;
+    const float lBins[] = {10.f, 20.f, 21.f, 40.f, 100.f};
+    fbu::GoertzelBank<float> lBank(lBlockSize, lBins, 5);
+    std::vector<float> lSignal((size_t)(2 * lBlockSize + 10));
+    std::mt19937 lRandomGenerator;
+    std::uniform_real_distribution<float> lDistribution(-1.f, 1.f);
+    for (float& x : lSignal)
+    {
+        x = lDistribution(lRandomGenerator);
+    }
+    lBank.process(lSignal.data(), (SampleCount)lSignal.size());
+    EXPECT(lBank.getNumCompletedBlocks() == 2);
+
+    std::vector<Complexd> lBlock((size_t)lBlockSize);
+    for (int n = 0 ; n != lBlockSize ; ++n)
+    {
+        lBlock[(size_t)n] = {lSignal[(size_t)(lBlockSize + n)], 0.};
+    }
+    fbu::Fft<double>(8).perform(lBlock.data());
+    for (int k = 0 ; k != 5 ; ++k)
+    {
+        double lExpected = lBlock[(size_t)lBins[k]].sqrmag();
+        EXPECT(std::abs(lBank.getPower(k) - lExpected) < 1e-3 * lExpected + 1e-3);
+    }
+}
+
+CASE("Sliding DFT: benchmark vs FFT per hop [.bench]")
+{
+    const int lOrder = 10;
+    const int lWindowSize = 1 << lOrder;
+    const int lNumBins = 32;
+    const SampleCount lNumSamples = 1 << 14;
+    std::vector<float> lBins(lNumBins);
+    for (int k = 0 ; k != lNumBins ; ++k)
+    {
+        lBins[(size_t)k] = (float)(4 * k + 1);
+    }
+    std::vector<float> lSignal(lNumSamples);
+    std::mt19937 lRandomGenerator;
+    std::uniform_real_distribution<float> lDistribution(-1.f, 1.f);
+    for (float& x : lSignal)
+    {
+        x = lDistribution(lRandomGenerator);
+    }
+
+    fbu::SlidingDftBank<float> lBank(lWindowSize, lBins.data(), lNumBins);
+    StopWatch lStopWatch("Sliding DFT, 32 bins, every sample");
+    lStopWatch.start();
+    lBank.process(lSignal.data(), lNumSamples);
+    lStopWatch.stopAndDisplay<std::milli>();
+    EXPECT(lBank.getMagnitude(0) >= 0.f);
+
+    fbu::Fft<float> lFft(lOrder);
+    std::vector<Complexf> lFrame((size_t)lWindowSize);
+    for (int lHop : {1, 16, 64, 256})
+    {
+        lStopWatch.renameAndStart("FFT 1024 every " + std::to_string(lHop) + " samples");
+        for (SampleCount lStart = 0 ; lStart + (SampleCount)lWindowSize <= lNumSamples ; lStart += (SampleCount)lHop)
+        {
+            for (int n = 0 ; n != lWindowSize ; ++n)
+            {
+                lFrame[(size_t)n] = {lSignal[lStart + (SampleCount)n], 0.f};
+            }
+            lFft.perform(lFrame.data());
+        }
+        lStopWatch.stopAndDisplay<std::milli>();
+    }
+}
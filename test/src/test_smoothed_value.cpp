@@ -0,0 +1,306 @@
+#include "fbu/smoothed_value.hpp"
+#include "fbu/math_utils.hpp"
+#include "fbu/stopwatch.hpp"
+
+#include "tests_common.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace fbu;
+
+namespace
+{
+    template <class Smoothing>
+    float maxRampError(float pFrom, float pTo, int pRampLength, float (*pExpected)(float, float, int, int))
+    {
+        SmoothedValue<Smoothing> lValue(pFrom);
+        lValue.setRampLength(pRampLength);
+        lValue.setTarget(pTo);
+        std::vector<float> lRamp((size_t)pRampLength + 10);
+        lValue.getNextValues(lRamp.data(), lRamp.size());
+        float lMaxError = 0.f;
+        for (int k = 1 ; k <= (int)lRamp.size() ; ++k)
+        {
+            lMaxError = std::max(lMaxError, std::abs(lRamp[(size_t)k - 1] - pExpected(pFrom, pTo, pRampLength, k)));
+        }
+        return lMaxError;
+    }
+
+    float linear(float pFrom, float pTo, int pRampLength, int k)
+    {
+        return k >= pRampLength ? pTo : pFrom + (pTo - pFrom) * (float)k / (float)pRampLength;
+    }
+
+    float exponential(float pFrom, float pTo, int pRampLength, int k)
+    {
+        return k >= pRampLength ? pTo : (float)((double)pFrom * std::pow((double)pTo / (double)pFrom, (double)k / pRampLength));
+    }
+
+    // the same values, by blocks or sample by sample, alone or in a bank: up to
+    // the rounding errors of the sample by sample steps
+    template <class Smoothing>
+    float maxBlockError(const std::vector<float>& pTargets, int pRampLength)
+    {
+        const size_t kBlockSize = 37;
+        SmoothedValue<Smoothing> lByBlock(0.5f), lBySample(0.5f);
+        SmoothedValueBank<Smoothing> lBank(3, 0.5f);
+        lByBlock.setRampLength(pRampLength);
+        lBySample.setRampLength(pRampLength);
+        lBank.setRampLength(pRampLength);
+        std::vector<float> lBlock(kBlockSize), lBankBlock(kBlockSize);
+        float lMaxError = 0.f;
+        for (size_t b = 0 ; b != pTargets.size() * 4 ; ++b)
+        {
+            if (b % 4 == 0)
+            {
+                const float lTarget = pTargets[b / 4];
+                lByBlock.setTarget(lTarget);
+                lBySample.setTarget(lTarget);
+                lBank.setTarget(1, lTarget);
+            }
+            lByBlock.getNextValues(lBlock.data(), kBlockSize);
+            lBank.getRamp(1, lBankBlock.data(), kBlockSize);
+            lBank.advance((int)kBlockSize);
+            for (size_t u = 0 ; u != kBlockSize ; ++u)
+            {
+                const float lSample = lBySample.getNextValue();
+                lMaxError = std::max(lMaxError, std::abs(lBlock[u] - lSample));
+                lMaxError = std::max(lMaxError, std::abs(lBankBlock[u] - lSample));
+            }
+            lMaxError = std::max(lMaxError, std::abs(lBank.getCurrent(1) - lBySample.getCurrent()));
+            lMaxError = std::max(lMaxError, std::abs(lBank.getCurrent(0) - 0.5f) + std::abs(lBank.getCurrent(2) - 0.5f));
+        }
+        return lMaxError;
+    }
+}
+
+CASE("SmoothedValue: linear")
+{
+    EXPECT(maxRampError<smoothing::Linear>(0.f, 1.f, 100, linear) < 1e-6f);
+    EXPECT(maxRampError<smoothing::Linear>(2.f, -3.f, 1001, linear) < 1e-5f);
+    EXPECT(maxRampError<smoothing::Linear>(1.f, 0.f, 3, linear) == 0.f);
+
+    SmoothedValue<> lValue(1.f);
+    EXPECT(!lValue.isSmoothing());
+    lValue.setTarget(2.f); // no ramp length: immediate
+    EXPECT(lValue.getCurrent() == 2.f);
+    EXPECT(!lValue.isSmoothing());
+    lValue.setRampLength(0.01, 1000.);
+    EXPECT(lValue.getRampLength() == 10);
+    lValue.setTarget(3.f);
+    EXPECT(lValue.getNumRemainingSteps() == 10);
+    lValue.skip(4);
+    EXPECT(std::abs(lValue.getCurrent() - 2.4f) < 1e-6f);
+    lValue.skip(100);
+    EXPECT(lValue.getCurrent() == 3.f);
+    EXPECT(!lValue.isSmoothing());
+    lValue.setTarget(3.f);
+    EXPECT(!lValue.isSmoothing());
+}
+
+CASE("SmoothedValue: multiplicative")
+{
+    EXPECT(maxRampError<smoothing::Multiplicative>(0.1f, 1.f, 100, exponential) < 1e-5f);
+    EXPECT(maxRampError<smoothing::Multiplicative>(2.f, 0.001f, 4800, exponential) < 2e-6f);
+
+    // linear in dB
+    SmoothedValue<smoothing::Multiplicative> lGain(1.f);
+    lGain.setRampLength(60);
+    lGain.setTargetDB(-60.f);
+    std::vector<float> lRamp(60);
+    lGain.getNextValues(lRamp.data(), lRamp.size());
+    float lMaxError = 0.f;
+    for (size_t u = 0 ; u != lRamp.size() ; ++u)
+    {
+        lMaxError = std::max(lMaxError, std::abs(20.f * std::log10(lRamp[u]) + (float)(u + 1)));
+    }
+    EXPECT(lMaxError < 1e-3f);
+
+    // from and to 0, through -120 dB
+    lGain.setTarget(0.f);
+    EXPECT(lGain.isSmoothing());
+    lGain.skip(59);
+    EXPECT(std::abs(lGain.getCurrent() / (1e-6f * std::pow(1000.f, 1.f / 60.f)) - 1.f) < 1e-4f);
+    EXPECT(lGain.getNextValue() == 0.f);
+    lGain.setTarget(1.f);
+    EXPECT(std::abs(lGain.getNextValue() - mu::dBToGain(-118.f)) < 1e-7f);
+}
+
+CASE("SmoothedValue: one-pole")
+{
+    // as the recursion y += alpha (x - y), until settled
+    const int kTimeConstant = 50;
+    const double lAlpha = 1. - std::exp(-1. / kTimeConstant);
+    SmoothedValue<smoothing::OnePole> lValue(1.f);
+    lValue.setRampLength(kTimeConstant);
+    lValue.setTarget(-1.f);
+    const int lNumSteps = lValue.getNumRemainingSteps();
+    EXPECT(std::abs(lNumSteps - (int)std::ceil(kTimeConstant * std::log(2. / 2e-5))) <= 1);
+    std::vector<float> lRamp((size_t)lNumSteps + 10);
+    lValue.getNextValues(lRamp.data(), lRamp.size());
+    double y = 1.;
+    float lMaxError = 0.f;
+    for (size_t u = 0 ; u != lRamp.size() ; ++u)
+    {
+        y += lAlpha * (-1. - y);
+        lMaxError = std::max(lMaxError, std::abs(lRamp[u] - (float)y));
+    }
+    EXPECT(lMaxError < 2e-5f);
+    EXPECT(lRamp[(size_t)lNumSteps - 1] == -1.f);
+    EXPECT(!lValue.isSmoothing());
+}
+
+CASE("SmoothedValue: angle")
+{
+    // across ±π along the shortest arc
+    SmoothedValue<smoothing::Angle> lAzimuth(3.f);
+    lAzimuth.setRampLength(10);
+    lAzimuth.setTarget(-3.f + 4.f * M_PIf);
+    EXPECT(std::abs(lAzimuth.getTarget() + 3.f) < 1e-5f);
+    std::vector<float> lRamp(13);
+    lAzimuth.getNextValues(lRamp.data(), lRamp.size());
+    const float lStep = (2.f * M_PIf - 6.f) / 10.f;
+    float lMaxError = 0.f;
+    bool lInDomain = true;
+    for (size_t u = 0 ; u != lRamp.size() ; ++u)
+    {
+        const float lExpected = u >= 9 ? lAzimuth.getTarget() : mu::domainAngle(3.f + lStep * (float)(u + 1));
+        lMaxError = std::max(lMaxError, std::abs(mu::domainAngle(lRamp[u] - lExpected)));
+        lInDomain = lInDomain && mu::isDomainAngle(lRamp[u]);
+    }
+    EXPECT(lMaxError < 1e-5f);
+    EXPECT(lInDomain);
+}
+
+CASE("SmoothedValue: by blocks, by samples and in a bank")
+{
+    std::mt19937 lRandomGenerator(39);
+    std::uniform_real_distribution<float> lDistribution(0.f, 3.f);
+    std::vector<float> lTargets(50);
+    for (float& t : lTargets)
+    {
+        t = lDistribution(lRandomGenerator);
+    }
+    for (int lRampLength : {1, 5, 100, 300})
+    {
+        EXPECT(maxBlockError<smoothing::Linear>(lTargets, lRampLength) < 3e-5f);
+        EXPECT(maxBlockError<smoothing::Multiplicative>(lTargets, lRampLength) < 3e-5f);
+        EXPECT(maxBlockError<smoothing::OnePole>(lTargets, lRampLength) < 3e-5f);
+        EXPECT(maxBlockError<smoothing::Angle>(lTargets, lRampLength) < 3e-5f);
+    }
+}
+
+CASE("SmoothedValue: bank")
+{
+    SmoothedValueBank<smoothing::Angle> lBank(6, 1.f);
+    EXPECT(lBank.size() == 6u);
+    EXPECT(!lBank.isAnySmoothing());
+    lBank.setRampLength(8);
+    lBank.setTarget(5, -1.f);
+    lBank.setCurrentAndTarget(0, 4.f);
+    EXPECT(std::abs(lBank.getCurrent(0) - (4.f - 2.f * M_PIf)) < 1e-6f);
+    EXPECT(lBank.isSmoothing(5));
+    EXPECT(!lBank.isSmoothing(4));
+    lBank.advance(4);
+    EXPECT(std::abs(lBank.getCurrentValues()[5]) < 1e-6f);
+    EXPECT(lBank.getCurrentValues()[4] == 1.f);
+    lBank.advance(4);
+    EXPECT(lBank.getCurrentValues()[5] == -1.f);
+    EXPECT(!lBank.isAnySmoothing());
+
+    // the new values are settled at their initial value
+    lBank.resize(9, 2.f);
+    EXPECT(lBank.getCurrent(5) == -1.f);
+    EXPECT(lBank.getCurrent(8) == 2.f);
+    EXPECT(lBank.getTarget(8) == 2.f);
+
+    // the removed values stop smoothing, the padding is settled at 0
+    lBank.setTarget(7, 3.f);
+    EXPECT(lBank.isAnySmoothing());
+    lBank.resize(5);
+    EXPECT(!lBank.isAnySmoothing());
+    lBank.advance(4);
+    for (size_t i = 5 ; i != 8 ; ++i)
+    {
+        EXPECT(lBank.getCurrentValues()[i] == 0.f);
+    }
+    EXPECT(lBank.getCurrent(4) == 1.f);
+}
+
+CASE("SmoothedValue: apply gain")
+{
+    SmoothedValue<smoothing::Multiplicative> lGain(1.f);
+    std::vector<float> lSamples(1000, 2.f);
+    lGain.applyGain(lSamples.data(), lSamples.size());
+    EXPECT(lSamples[999] == 2.f);
+    lGain.setRampLength(600);
+    lGain.setTarget(0.5f);
+    SmoothedValue<smoothing::Multiplicative> lReference(lGain);
+    lGain.applyGain(lSamples.data(), lSamples.size());
+    float lMaxError = 0.f;
+    for (float x : lSamples)
+    {
+        lMaxError = std::max(lMaxError, std::abs(x - 2.f * lReference.getNextValue()));
+    }
+    EXPECT(lMaxError < 1e-5f);
+    EXPECT(lSamples[999] == 1.f);
+}
+
+CASE("SmoothedValue: benchmark [.bench]")
+{
+    const size_t kNumParameters = 256;
+    const size_t kBlockSize = 256;
+    const int kNumBlocks = 1000;
+    std::vector<float> lCurrent(kNumParameters, 0.f), lTargets(kNumParameters, 1.f);
+    std::vector<float> lRamp(kBlockSize);
+    const float lAlpha = 1.f - std::exp(-1.f / 4800.f);
+    float lSum = 0.f;
+
+    // inline per sample one-pole filters
+    StopWatch lStopWatch("per sample one-poles");
+    lStopWatch.start();
+    for (int b = 0 ; b != kNumBlocks ; ++b)
+    {
+        for (size_t i = 0 ; i != kNumParameters ; ++i)
+        {
+            float y = lCurrent[i];
+            for (size_t u = 0 ; u != kBlockSize ; ++u)
+            {
+                y += lAlpha * (lTargets[i] - y);
+                lRamp[u] = y;
+            }
+            lCurrent[i] = y;
+            lSum += lRamp[kBlockSize - 1];
+        }
+    }
+    lStopWatch.stopAndDisplay();
+
+    SmoothedValueBank<smoothing::OnePole> lBank(kNumParameters, 0.f);
+    lBank.setRampLength(4800);
+    for (size_t i = 0 ; i != kNumParameters ; ++i)
+    {
+        lBank.setTarget(i, 1.f);
+    }
+    lStopWatch.renameAndStart("bank ramps");
+    for (int b = 0 ; b != kNumBlocks ; ++b)
+    {
+        for (size_t i = 0 ; i != kNumParameters ; ++i)
+        {
+            lBank.getRamp(i, lRamp.data(), kBlockSize);
+            lSum += lRamp[kBlockSize - 1];
+        }
+        lBank.advance((int)kBlockSize);
+    }
+    lStopWatch.stopAndDisplay();
+
+    lStopWatch.renameAndStart("bank advance only");
+    for (int b = 0 ; b != kNumBlocks ; ++b)
+    {
+        lBank.advance((int)kBlockSize);
+        lSum += lBank.getCurrentValues()[0];
+    }
+    lStopWatch.stopAndDisplay();
+    EXPECT(lSum > 0.f);
+}
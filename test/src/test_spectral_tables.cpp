@@ -0,0 +1,84 @@
+#include "fbu/spectral_tables.hpp"
+
+#include "tests_common.hpp"
+
+#include <thread>
+
+using namespace fbu;
+
+CASE("Spectral tables: windows are computed once and shared")
+{
+    SpectralTableCache& lCache = SpectralTableCache::getInstance();
+    auto lHann = lCache.getWindow<float>(WindowKind::hann, 512);
+    EXPECT(lHann->size() == 512u);
+    EXPECT(lCache.getWindow<float>(WindowKind::hann, 512) == lHann);
+    EXPECT(lCache.getWindow<double>(WindowKind::hann, 512).get() != (const void*)lHann.get());
+    EXPECT(lCache.getWindow<float>(WindowKind::hann, 256) != lHann);
+    EXPECT(lCache.getWindow<float>(WindowKind::blackman, 512) != lHann);
+    EXPECT((uintptr_t)lHann->data() % 64 == 0u);
+
+    for (int n = 0 ; n != 512 ; ++n)
+    {
+        EXPECT(std::abs((*lHann)[(size_t)n] - (float)(0.5 - 0.5 * std::cos(2. * M_PI * n / 512))) < 1e-7f);
+    }
+    auto lBlackman = lCache.getWindow<double>(WindowKind::blackman, 100);
+    auto lSqrtHann = lCache.getWindow<double>(WindowKind::sqrtHann, 100);
+    for (int n = 0 ; n != 100 ; ++n)
+    {
+        double lHannValue = 0.5 - 0.5 * std::cos(2. * M_PI * n / 100);
+        EXPECT(std::abs((*lSqrtHann)[(size_t)n] - std::sqrt(lHannValue)) < 1e-14);
+        EXPECT(std::abs((*lBlackman)[(size_t)n] - (0.42 - 0.5 * std::cos(2. * M_PI * n / 100) + 0.08 * std::cos(4. * M_PI * n / 100))) < 1e-14);
+    }
+
+    // a table outlives clear() while in use
+    lCache.clear();
+    EXPECT(lCache.getNumTables() == 0u);
+    EXPECT(lHann->size() == 512u);
+    EXPECT(lCache.getWindow<float>(WindowKind::hann, 512) != lHann);
+}
+
+CASE("Spectral tables: concurrent requests get the same twiddles")
+{
+    const int lNumThreads = 8;
+    std::vector< std::shared_ptr< const SpectralTableCache::Twiddles<float> > > lResults(lNumThreads);
+    std::vector<std::thread> lThreads;
+    for (int i = 0 ; i != lNumThreads ; ++i)
+    {
+        lThreads.emplace_back([&lResults, i]{
+            lResults[(size_t)i] = SpectralTableCache::getInstance().getTwiddles<float>(4096);
+        });
+    }
+    for (std::thread& t : lThreads)
+    {
+        t.join();
+    }
+    for (int i = 1 ; i != lNumThreads ; ++i)
+    {
+        EXPECT(lResults[(size_t)i] == lResults[0]);
+    }
+    EXPECT(lResults[0]->size() == 2048u);
+    EXPECT(((*lResults[0])[1024] - Complexf({0.f, -1.f})).mag() < 1e-7f);
+}
+
+CASE("Spectral tables: compile-time generation")
+{
+    constexpr cx::Table<float, 16> kHann = makeWindow<float, 16, WindowKind::hann>();
+    static_assert(kHann[0] == 0.f, "Hann starts at 0");
+    static_assert(kHann[8] == 1.f, "periodic Hann peaks at N/2");
+    static_assert(kHann.size() == 16, "size");
+    auto lHann = SpectralTableCache::getInstance().getWindow<float>(WindowKind::hann, 16);
+    for (int n = 0 ; n != 16 ; ++n)
+    {
+        EXPECT(kHann[n] == (*lHann)[(size_t)n]);
+    }
+
+    constexpr cx::Table<Complexd, 32> kTwiddles = makeTwiddles<double, 64>();
+    auto lTwiddles = SpectralTableCache::getInstance().getTwiddles<double>(64);
+    for (int k = 0 ; k != 32 ; ++k)
+    {
+        EXPECT((kTwiddles[k] - (*lTwiddles)[(size_t)k]).mag() < 1e-15);
+    }
+
+    static_assert(cx::abs(cx::sqrt(2.) - 1.4142135623730951) < 1e-15, "constexpr sqrt");
+    static_assert(cx::abs(cx::cos(cx::kPi / 3.) - 0.5) < 1e-15, "constexpr cos");
+}
@@ -0,0 +1,183 @@
+#include "fbu/spherical_conversions.hpp"
+#include "fbu/stopwatch.hpp"
+
+#include "tests_common.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace fbu;
+
+namespace
+{
+    const SphericalPrecision kFastPrecisions[] = {SphericalPrecision::coarse, SphericalPrecision::medium, SphericalPrecision::high};
+
+    // the documented bounds, in the order of kFastPrecisions
+    const float kAngleErrors[] = {5e-4f, 5e-6f, 1e-6f};
+
+    // the scalar conversions, with the approximations of FBU_VECTOR3_FAST_TRIG
+    const float kExactError = FBU_VECTOR3_FAST_TRIG ? 1e-2f : 2e-6f;
+
+    float angleDifference(float pA, float pB)
+    {
+        return std::abs(std::remainder(pA - pB, 2.f * M_PIf));
+    }
+
+    struct Directions
+    {
+        std::vector<float> mAzimuths;
+        std::vector<float> mElevations;
+        std::vector<float> mMagnitudes;
+    };
+
+    // away from the poles, where the azimuth is not defined
+    Directions randomDirections(size_t pSize)
+    {
+        std::mt19937 lRandomGenerator(42);
+        std::uniform_real_distribution<float> lAzimuths(-M_PIf, M_PIf);
+        std::uniform_real_distribution<float> lElevations(-1.5f, 1.5f);
+        std::uniform_real_distribution<float> lMagnitudes(0.1f, 10.f);
+        Directions lDirections;
+        for (size_t u = 0 ; u != pSize ; ++u)
+        {
+            lDirections.mAzimuths.push_back(lAzimuths(lRandomGenerator));
+            lDirections.mElevations.push_back(lElevations(lRandomGenerator));
+            lDirections.mMagnitudes.push_back(lMagnitudes(lRandomGenerator));
+        }
+        return lDirections;
+    }
+
+    // the largest relative or angular error of the conversions to Cartesian
+    // and back at pPrecision, compared with the original directions, but for
+    // the AEMr azimuths, whose error goes to pAEMrAzimuthError
+    float maxRoundTripError(size_t pSize, SphericalPrecision pPrecision, float& pAEMrAzimuthError)
+    {
+        const Directions lIn = randomDirections(pSize);
+        Directions lOut = lIn;
+        Vector3Array<float> lVectors;
+        float lMaxError = 0.f;
+        pAEMrAzimuthError = 0.f;
+
+        aemToVector3(lIn.mAzimuths.data(), lIn.mElevations.data(), lIn.mMagnitudes.data(), pSize, lVectors, pPrecision);
+        vector3ToAEM(lVectors, lOut.mAzimuths.data(), lOut.mElevations.data(), lOut.mMagnitudes.data(), pPrecision);
+        for (size_t u = 0 ; u != pSize ; ++u)
+        {
+            lMaxError = std::max(lMaxError, angleDifference(lOut.mAzimuths[u], lIn.mAzimuths[u]));
+            lMaxError = std::max(lMaxError, std::abs(lOut.mElevations[u] - lIn.mElevations[u]));
+            lMaxError = std::max(lMaxError, std::abs(lOut.mMagnitudes[u] / lIn.mMagnitudes[u] - 1.f));
+        }
+
+        aemrToVector3(lIn.mAzimuths.data(), lIn.mElevations.data(), lIn.mMagnitudes.data(), pSize, lVectors, pPrecision);
+        vector3ToAEMr(lVectors, lOut.mAzimuths.data(), lOut.mElevations.data(), lOut.mMagnitudes.data(), pPrecision);
+        for (size_t u = 0 ; u != pSize ; ++u)
+        {
+            pAEMrAzimuthError = std::max(pAEMrAzimuthError, angleDifference(lOut.mAzimuths[u], lIn.mAzimuths[u]));
+            lMaxError = std::max(lMaxError, std::abs(lOut.mElevations[u] - lIn.mElevations[u]));
+            lMaxError = std::max(lMaxError, std::abs(lOut.mMagnitudes[u] / lIn.mMagnitudes[u] - 1.f));
+        }
+
+        aeToVector3(lIn.mAzimuths.data(), lIn.mElevations.data(), pSize, lVectors, pPrecision);
+        normalizedVector3ToAE(lVectors, lOut.mAzimuths.data(), lOut.mElevations.data(), pPrecision);
+        for (size_t u = 0 ; u != pSize ; ++u)
+        {
+            lMaxError = std::max(lMaxError, angleDifference(lOut.mAzimuths[u], lIn.mAzimuths[u]));
+            lMaxError = std::max(lMaxError, std::abs(lOut.mElevations[u] - lIn.mElevations[u]));
+            lMaxError = std::max(lMaxError, std::abs(static_cast<Vector3f>(lVectors[u]).length() - 1.f));
+        }
+        return lMaxError;
+    }
+
+    // the largest difference between the unit vectors at pPrecision and the
+    // libm ones
+    float maxDirectionError(size_t pSize, SphericalPrecision pPrecision)
+    {
+        const Directions lIn = randomDirections(pSize);
+        Vector3Array<float> lVectors;
+        aeToVector3(lIn.mAzimuths.data(), lIn.mElevations.data(), pSize, lVectors, pPrecision);
+        float lMaxError = 0.f;
+        for (size_t u = 0 ; u != pSize ; ++u)
+        {
+            const float lCosElevation = std::cos(lIn.mElevations[u]);
+            const Vector3f lExpected = Vector3f::cartesian(lCosElevation * std::cos(lIn.mAzimuths[u]),
+                                                           lCosElevation * std::sin(lIn.mAzimuths[u]),
+                                                           std::sin(lIn.mElevations[u]));
+            lMaxError = std::max(lMaxError, (static_cast<Vector3f>(lVectors[u]) - lExpected).length());
+        }
+        return lMaxError;
+    }
+}
+
+CASE("Spherical conversions: round trips")
+{
+    // acos() loses up to 3e-4 rad of the AEMr azimuths near 0 and pi
+    const float kAEMrAzimuthError = 5e-4f;
+    float lAEMrAzimuthError;
+    for (size_t lSize : {0u, 1u, 5u, 1003u})
+    {
+        EXPECT(maxRoundTripError(lSize, SphericalPrecision::exact, lAEMrAzimuthError) < kExactError);
+        EXPECT(lAEMrAzimuthError < kAEMrAzimuthError);
+        for (size_t i = 0 ; i != 3 ; ++i)
+        {
+            EXPECT(maxRoundTripError(lSize, kFastPrecisions[i], lAEMrAzimuthError) < 2.f * kAngleErrors[i]);
+            EXPECT(lAEMrAzimuthError < kAEMrAzimuthError + kAngleErrors[i]);
+            EXPECT(maxDirectionError(lSize, kFastPrecisions[i]) < kAngleErrors[i]);
+        }
+    }
+}
+
+CASE("Spherical conversions: poles and zero")
+{
+    Vector3Array<float> lVectors;
+    lVectors.push_back(Vector3f::cartesian(0.f, 0.f, 2.f));
+    lVectors.push_back(Vector3f::cartesian(1e-3f, -1e-3f, -1.f));
+    lVectors.push_back(Vector3f::cartesian(0.f, 0.f, 0.f));
+    lVectors.push_back(Vector3f::cartesian(0.f, 1.f, 0.f));
+    lVectors.push_back(Vector3f::cartesian(-1.f, 0.f, 0.f));
+    const size_t lSize = lVectors.size();
+    for (SphericalPrecision lPrecision : {SphericalPrecision::exact, SphericalPrecision::coarse, SphericalPrecision::high})
+    {
+        std::vector<float> lAzimuths(lSize, 1.f), lElevations(lSize, 1.f), lMagnitudes(lSize, 1.f);
+        vector3ToAEMr(lVectors, lAzimuths.data(), lElevations.data(), lMagnitudes.data(), lPrecision);
+        EXPECT(lAzimuths[0] == 0.f);
+        EXPECT(std::abs(lElevations[0] - M_PI_2f) < 1e-3f + kExactError);
+        EXPECT(lMagnitudes[0] == 2.f);
+        EXPECT(lAzimuths[1] == 0.f);
+        EXPECT(lElevations[1] < -1.5f);
+        EXPECT(lAzimuths[2] == 0.f);
+        EXPECT(lElevations[2] == 0.f);
+        EXPECT(lMagnitudes[2] == 0.f);
+        EXPECT(std::abs(lAzimuths[3] + M_PI_2f) < 1e-3f);
+        EXPECT(std::abs(lAzimuths[4] - M_PIf) < 1e-3f);
+
+        vector3ToAEM(lVectors, lAzimuths.data(), lElevations.data(), lMagnitudes.data(), lPrecision);
+        EXPECT(lElevations[2] == 0.f);
+        EXPECT(lMagnitudes[2] == 0.f);
+        EXPECT(std::abs(lAzimuths[3] - M_PI_2f) < 1e-3f);
+    }
+}
+
+CASE("Spherical conversions: benchmark [.bench]")
+{
+    const size_t kNumSources = 10000;
+    const int kNumIterations = 1000;
+    const Directions lIn = randomDirections(kNumSources);
+    Directions lOut = lIn;
+    Vector3Array<float> lVectors;
+    float lSum = 0.f;
+    StopWatch lStopWatch("");
+    for (SphericalPrecision lPrecision : {SphericalPrecision::exact, SphericalPrecision::coarse, SphericalPrecision::high})
+    {
+        lStopWatch.renameAndStart(lPrecision == SphericalPrecision::exact ? "exact AEM to Vector3 and back"
+                                  : lPrecision == SphericalPrecision::coarse ? "coarse AEM to Vector3 and back"
+                                  : "high AEM to Vector3 and back");
+        for (int i = 0 ; i != kNumIterations ; ++i)
+        {
+            aemToVector3(lIn.mAzimuths.data(), lIn.mElevations.data(), lIn.mMagnitudes.data(), kNumSources, lVectors, lPrecision);
+            vector3ToAEM(lVectors, lOut.mAzimuths.data(), lOut.mElevations.data(), lOut.mMagnitudes.data(), lPrecision);
+            lSum += lOut.mAzimuths[(size_t)i];
+        }
+        lStopWatch.stopAndDisplay();
+    }
+    EXPECT(lSum != 0.f);
+}
@@ -0,0 +1,99 @@
+#include "fbu/stft.hpp"
+
+#include "tests_common.hpp"
+
+#include <atomic>
+#include <random>
+
+namespace
+{
+    std::vector< std::vector<float> > randomChannels(int pNumChannels, size_t pNumSamples)
+    {
+        std::mt19937 lRandomGenerator;
+        std::uniform_real_distribution<float> lDistribution(-1.f, 1.f);
+        std::vector< std::vector<float> > lChannels((size_t)pNumChannels, std::vector<float>(pNumSamples));
+        for (std::vector<float>& lChannel : lChannels)
+        {
+            for (float& x : lChannel)
+            {
+                x = lDistribution(lRandomGenerator);
+            }
+        }
+        return lChannels;
+    }
+
+    void processInIrregularBlocks(fbu::Stft<float>& pStft, std::vector< std::vector<float> >& pInOut)
+    {
+        const SampleCount lBlockSizes[] = {37, 1, 500, 64, 0, 129};
+        SampleCount lTotal = (SampleCount)pInOut[0].size();
+        std::vector<float*> lPointers(pInOut.size());
+        for (SampleCount n = 0, i = 0 ; n < lTotal ; ++i)
+        {
+            SampleCount lBlockSize = std::min(lBlockSizes[i % 6], lTotal - n);
+            for (size_t c = 0 ; c != pInOut.size() ; ++c)
+            {
+                lPointers[c] = pInOut[c].data() + n;
+            }
+            pStft.process(lPointers.data(), lPointers.data(), lBlockSize);
+            n += lBlockSize;
+        }
+    }
+}
+
+CASE("STFT: identity callback gives back the delayed input")
+{
+    int lNumFrames = 0;
+    fbu::Stft<float> lStft(1, 250, 4, [&](ChannelCount, Complexf*, int pFftSize){
+        EXPECT(pFftSize == 256);
+        ++lNumFrames;
+    });
+    EXPECT(lStft.getFftSize() == 256);
+    EXPECT(lStft.getHopSize() == 64);
+    EXPECT(lStft.getLatency() == 256u);
+
+    std::vector< std::vector<float> > lInput = randomChannels(1, 3000);
+    std::vector< std::vector<float> > lOutput = lInput;
+    processInIrregularBlocks(lStft, lOutput);
+    EXPECT(lNumFrames == 3000 / 64);
+    for (size_t u = 0 ; u != 256 ; ++u)
+    {
+        EXPECT(std::abs(lOutput[0][u]) < 1e-6f);
+    }
+    for (size_t u = 256 ; u != 3000 ; ++u)
+    {
+        EXPECT(std::abs(lOutput[0][u] - lInput[0][u - 256]) < 1e-5f);
+    }
+}
+
+CASE("STFT: multichannel spectral processing on a ThreadPool")
+{
+    fbu::ThreadPool lTP(2);
+    std::atomic_int lNumFrames(0);
+    fbu::Stft<float> lStft(3, 128, 2, [&](ChannelCount pChannel, Complexf* pSpectrum, int pFftSize){
+        vectProductSC_I(1.f / (float)(pChannel + 1), pSpectrum, (size_t)pFftSize);
+        ++lNumFrames;
+    }, &lTP);
+    EXPECT(lStft.getNumChannels() == 3);
+
+    std::vector< std::vector<float> > lInput = randomChannels(3, 2000);
+    std::vector< std::vector<float> > lOutput = lInput;
+    processInIrregularBlocks(lStft, lOutput);
+    EXPECT(lNumFrames == 3 * (2000 / 64));
+    for (size_t c = 0 ; c != 3 ; ++c)
+    {
+        for (size_t u = 128 ; u != 2000 ; ++u)
+        {
+            EXPECT(std::abs(lOutput[c][u] - lInput[c][u - 128] / (float)(c + 1)) < 1e-5f);
+        }
+    }
+
+    lStft.reset();
+    // one buffer per channel: the channels are processed concurrently
+    std::vector< std::vector<float> > lSilence(3, std::vector<float>(64, 0.f));
+    float* lPointers[] = {lSilence[0].data(), lSilence[1].data(), lSilence[2].data()};
+    lStft.process(lPointers, lPointers, 64);
+    for (const std::vector<float>& lChannel : lSilence)
+    {
+        EXPECT(lChannel[63] == 0.f);
+    }
+}
@@ -0,0 +1,191 @@
+#include "fbu/streaming_stats.hpp"
+#include "fbu/math_utils.hpp"
+#include "fbu/stopwatch.hpp"
+#include "fbu/thread_pool.hpp"
+
+#include "tests_common.hpp"
+
+#include <cmath>
+#include <mutex>
+#include <random>
+#include <vector>
+
+using namespace mu;
+
+namespace
+{
+    // 1e4 + uniform noise: the sum of squares would lose all the variance in float
+    std::vector<float> offsetNoise(size_t pSize)
+    {
+        std::mt19937 lRandomGenerator(7);
+        std::uniform_real_distribution<float> lDistribution(-1.f, 1.f);
+        std::vector<float> lValues(pSize);
+        for (float& x : lValues)
+        {
+            x = 10000.f + lDistribution(lRandomGenerator);
+        }
+        return lValues;
+    }
+
+    void twoPass(const std::vector<float>& pValues, double& pMean, double& pVariance)
+    {
+        pMean = 0.;
+        for (float x : pValues) pMean += (double)x;
+        pMean /= (double)pValues.size();
+        pVariance = 0.;
+        for (float x : pValues) pVariance += ((double)x - pMean) * ((double)x - pMean);
+        pVariance /= (double)pValues.size();
+    }
+}
+
+CASE("Streaming stats: running mean and variance")
+{
+    const std::vector<float> lValues = offsetNoise(100003);
+    double lMean, lVariance;
+    twoPass(lValues, lMean, lVariance);
+
+    RunningStats<float> lScalar;
+    for (float x : lValues) lScalar.push(x);
+    RunningStats<float> lArray;
+    lArray.push(lValues.data(), lValues.size());
+    RunningStats<double> lDouble;
+    for (float x : lValues) lDouble.push((double)x);
+
+    EXPECT(lScalar.getCount() == (int64_t)lValues.size());
+    EXPECT(lArray.getCount() == (int64_t)lValues.size());
+    // 1/3 for a uniform distribution over [-1, 1]
+    EXPECT(std::abs(lVariance - 1. / 3.) < 1e-2);
+    EXPECT(std::abs(lDouble.getMean() - lMean) < 1e-9);
+    EXPECT(std::abs(lDouble.getVariance() - lVariance) < 1e-9);
+    // a few float ulps of 1e4
+    EXPECT(std::abs((double)lScalar.getMean() - lMean) < 4e-3);
+    EXPECT(std::abs((double)lScalar.getVariance() - lVariance) < 1e-2 * lVariance);
+    EXPECT(std::abs((double)lArray.getMean() - lMean) < 4e-3);
+    EXPECT(std::abs((double)lArray.getVariance() - lVariance) < 1e-2 * lVariance);
+    EXPECT(lArray.getMin() == *std::min_element(lValues.begin(), lValues.end()));
+    EXPECT(lArray.getMax() == *std::max_element(lValues.begin(), lValues.end()));
+    EXPECT(lScalar.getMin() == lArray.getMin());
+    EXPECT(lScalar.getMax() == lArray.getMax());
+
+    RunningStats<double> lSmall;
+    EXPECT(lSmall.getVariance() == 0.);
+    EXPECT(lSmall.getMin() == std::numeric_limits<double>::infinity());
+    lSmall.push(2.);
+    lSmall.push(4.);
+    EXPECT(lSmall.getMean() == 3.);
+    EXPECT(lSmall.getVariance() == 1.);
+    EXPECT(lSmall.getSampleVariance() == 2.);
+    lSmall.reset();
+    EXPECT(lSmall.getCount() == 0);
+}
+
+CASE("Streaming stats: per-thread states merge into the whole stream")
+{
+    const std::vector<float> lValues = offsetNoise(40000);
+    RunningStats<float> lWhole;
+    lWhole.push(lValues.data(), lValues.size());
+
+    const size_t lNumJobs = 8;
+    const size_t lJobSize = lValues.size() / lNumJobs;
+    std::vector< RunningStats<float> > lPartials(lNumJobs);
+    {
+        fbu::ThreadPool lPool(4);
+        for (size_t j = 0 ; j != lNumJobs ; ++j)
+        {
+            lPool.addJob([&lPartials, &lValues, j, lJobSize]{
+                lPartials[j].push(lValues.data() + j * lJobSize, lJobSize);
+            });
+        }
+        lPool.waitForCompletion();
+    }
+    RunningStats<float> lMerged;
+    lMerged.merge(RunningStats<float>());
+    for (const RunningStats<float>& lPartial : lPartials)
+    {
+        lMerged.merge(lPartial);
+    }
+    EXPECT(lMerged.getCount() == lWhole.getCount());
+    EXPECT(std::abs(lMerged.getMean() - lWhole.getMean()) < 4e-3f);
+    EXPECT(std::abs(lMerged.getVariance() - lWhole.getVariance()) < 1e-3f);
+    EXPECT(lMerged.getMin() == lWhole.getMin());
+    EXPECT(lMerged.getMax() == lWhole.getMax());
+
+    CumulAverage<int> lA, lB;
+    lA.push(1);
+    lB.push(2);
+    lA.merge(lB);
+    EXPECT(lA.getCount() == 2);
+    EXPECT(lA.get() == 1.5f);
+    // T = double keeps the double precision
+    CumulAverage<double> lDoubleAverage;
+    lDoubleAverage.push(1. + 1e-12);
+    EXPECT(lDoubleAverage.get() == 1. + 1e-12);
+}
+
+CASE("Streaming stats: exponential moving average and windowed RMS")
+{
+    std::vector<float> lValues(1001);
+    for (size_t u = 0 ; u != lValues.size() ; ++u)
+    {
+        lValues[u] = std::sin(0.05f * (float)u);
+    }
+    ExponentialMovingAverage<float> lScalar(0.01f, 0.5f), lArray(0.01f, 0.5f);
+    for (float x : lValues) lScalar.push(x);
+    lArray.push(lValues.data(), lValues.size());
+    EXPECT(std::abs(lScalar.get() - lArray.get()) < 1e-5f);
+
+    // a step reaches 1 - 1/e after the time constant
+    const double lAlpha = ExponentialMovingAverage<double>::alphaForTimeConstant(0.01, 48000.);
+    ExponentialMovingAverage<double> lStep(lAlpha);
+    for (int i = 0 ; i != 480 ; ++i) lStep.push(1.);
+    EXPECT(std::abs(lStep.get() - (1. - std::exp(-1.))) < 1e-3);
+
+    WindowedRMS<float> lRMS(100), lRMSArray(100);
+    EXPECT(lRMS.getWindowLength() == 100);
+    for (float x : lValues) lRMS.push(x);
+    lRMSArray.push(lValues.data(), 37);
+    lRMSArray.push(lValues.data() + 37, lValues.size() - 37);
+    EXPECT(std::abs(lRMS.get() - lRMSArray.get()) < 1e-6f);
+    // about two periods of the sine
+    EXPECT(std::abs(lRMS.get() - std::sqrt(0.5f)) < 0.05f);
+
+    // loud, then silence: exactly 0 once the window is past
+    std::vector<float> lLoud(1000, 1000.f), lSilence(250, 0.f);
+    lRMSArray.push(lLoud.data(), lLoud.size());
+    EXPECT(std::abs(lRMSArray.get() - 1000.f) < 1e-3f);
+    lRMSArray.push(lSilence.data(), lSilence.size());
+    EXPECT(lRMSArray.get() == 0.f);
+    for (int i = 0 ; i != 50 ; ++i) lRMS.push(2.f);
+    lRMS.reset();
+    EXPECT(lRMS.get() == 0.f);
+}
+
+CASE("Streaming stats: benchmark of the array pushes [.bench]")
+{
+    const std::vector<float> lValues = offsetNoise(1 << 20);
+    RunningStats<float> lScalar, lArray;
+    StopWatch lStopWatch("RunningStats scalar push");
+    lStopWatch.start();
+    for (float x : lValues) lScalar.push(x);
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("RunningStats array push");
+    lArray.push(lValues.data(), lValues.size());
+    lStopWatch.stopAndDisplay<std::micro>();
+    EXPECT(lScalar.getCount() == lArray.getCount());
+
+    WindowedRMS<float> lRMS(4800);
+    lStopWatch.renameAndStart("WindowedRMS scalar push");
+    for (float x : lValues) lRMS.push(x);
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("WindowedRMS array push");
+    lRMS.push(lValues.data(), lValues.size());
+    lStopWatch.stopAndDisplay<std::micro>();
+
+    ExponentialMovingAverage<float> lEMA(0.001f);
+    lStopWatch.renameAndStart("ExponentialMovingAverage scalar push");
+    for (float x : lValues) lEMA.push(x);
+    lStopWatch.stopAndDisplay<std::micro>();
+    lStopWatch.renameAndStart("ExponentialMovingAverage array push");
+    lEMA.push(lValues.data(), lValues.size());
+    lStopWatch.stopAndDisplay<std::micro>();
+}
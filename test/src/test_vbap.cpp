@@ -0,0 +1,271 @@
+#include "fbu/vbap.hpp"
+#include "fbu/stopwatch.hpp"
+
+#include "tests_common.hpp"
+
+#include <random>
+#include <vector>
+
+using namespace fbu;
+
+namespace
+{
+    // rings of pNumSpeakers[i] speakers at pElevations[i] degrees
+    std::vector<Vector3f> rings(std::initializer_list<float> pElevations, std::initializer_list<int> pNumSpeakers)
+    {
+        std::vector<Vector3f> lSpeakers;
+        const int* lNumSpeakers = pNumSpeakers.begin();
+        for (float lElevation : pElevations)
+        {
+            for (int i = 0 ; i != *lNumSpeakers ; ++i)
+            {
+                const float lAzimuth = 2.f * M_PIf * (float)i / (float)*lNumSpeakers;
+                lSpeakers.push_back(Vector3f::fromAE(AEf::ae(lAzimuth, lElevation * DEG2RADf)));
+            }
+            ++lNumSpeakers;
+        }
+        return lSpeakers;
+    }
+
+    std::vector<Vector3f> randomDirections(size_t pSize)
+    {
+        std::mt19937 lRandomGenerator(44);
+        std::normal_distribution<float> lDistribution;
+        std::vector<Vector3f> lDirections(pSize);
+        for (Vector3f& v : lDirections)
+        {
+            v = Vector3f::cartesian(lDistribution(lRandomGenerator), lDistribution(lRandomGenerator), lDistribution(lRandomGenerator));
+        }
+        return lDirections;
+    }
+
+    // the largest error on the power, and on the direction of the sum of the
+    // speakers weighted by the gains
+    float maxPanningError(const std::vector<Vector3f>& pSpeakers, const std::vector<Vector3f>& pDirections)
+    {
+        const Vbap lVbap(pSpeakers);
+        float lMaxError = 0.f;
+        for (const Vector3f& lDirection : pDirections)
+        {
+            const Vbap::Gains lGains = lVbap.computeGains(lDirection);
+            Vector3f lSum = Vector3f::cartesian(0.f, 0.f, 0.f);
+            float lPower = 0.f;
+            for (size_t k = 0 ; k != 3 ; ++k)
+            {
+                lSum += lGains.mGains[k] * pSpeakers[lGains.mSpeakers[k]].normalized();
+                lPower += lGains.mGains[k] * lGains.mGains[k];
+                lMaxError = std::max(lMaxError, -lGains.mGains[k]);
+            }
+            lMaxError = std::max(lMaxError, std::abs(lPower - 1.f));
+            lMaxError = std::max(lMaxError, (lSum.normalized() - lDirection.normalized()).length());
+        }
+        return lMaxError;
+    }
+}
+
+CASE("Vbap: triangulation")
+{
+    const Vector3f lOctahedron[] = {{1.f, 0.f, 0.f}, {-1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}, {0.f, -1.f, 0.f}, {0.f, 0.f, 1.f}, {0.f, 0.f, -1.f}};
+    EXPECT(Vbap(std::vector<Vector3f>(lOctahedron, lOctahedron + 6)).getNumTriangles() == 8u);
+
+    // 2 triangles on each face
+    std::vector<Vector3f> lCube;
+    for (int i = 0 ; i != 8 ; ++i)
+    {
+        lCube.push_back(Vector3f::cartesian(i & 1 ? 1.f : -1.f, i & 2 ? 1.f : -1.f, i & 4 ? 1.f : -1.f));
+    }
+    EXPECT(Vbap(lCube).getNumTriangles() == 12u);
+
+    // closed: 2 n - 4 triangles
+    const std::vector<Vector3f> lSphere = rings({-60.f, -20.f, 20.f, 60.f}, {3, 7, 7, 3});
+    EXPECT(Vbap(lSphere).getNumTriangles() == 2 * lSphere.size() - 4);
+
+    // no triangles through the centre below a hemisphere
+    const std::vector<Vector3f> lDome = rings({0.f, 35.f, 90.f}, {8, 5, 1});
+    const Vbap lVbap(lDome);
+    EXPECT(lVbap.getNumTriangles() == 2 * lDome.size() - 4 - 6);
+    for (size_t t = 0 ; t != lVbap.getNumTriangles() ; ++t)
+    {
+        EXPECT(lDome[lVbap.getTriangle(t).mSpeakers[2]].mZ > 0.1f);
+    }
+
+    EXPECT(Vbap(rings({0.f}, {5})).getNumTriangles() == 0u);
+}
+
+CASE("Vbap: gains")
+{
+    const std::vector<Vector3f> lDirections = randomDirections(2000);
+    std::vector<Vector3f> lCube;
+    for (int i = 0 ; i != 8 ; ++i)
+    {
+        lCube.push_back(Vector3f::cartesian(i & 1 ? 2.f : -2.f, i & 2 ? 2.f : -2.f, i & 4 ? 2.f : -2.f));
+    }
+    EXPECT(maxPanningError(lCube, lDirections) < 1e-5f);
+    EXPECT(maxPanningError(rings({-60.f, -20.f, 20.f, 60.f}, {3, 7, 7, 3}), lDirections) < 1e-5f);
+    EXPECT(maxPanningError(rings({-30.f, 0.f, 30.f, 60.f, 90.f}, {6, 8, 6, 4, 1}), lDirections) < 1e-5f);
+
+    // on a speaker, and between speakers
+    const std::vector<Vector3f> lSpeakers = rings({-45.f, 0.f, 45.f}, {4, 8, 4});
+    const Vbap lVbap(lSpeakers);
+    for (size_t s = 0 ; s != lSpeakers.size() ; ++s)
+    {
+        const Vbap::Gains lGains = lVbap.computeGains(2.f * lSpeakers[s]);
+        float lGain = 0.f;
+        for (size_t k = 0 ; k != 3 ; ++k)
+        {
+            lGain += lGains.mSpeakers[k] == s ? lGains.mGains[k] : 0.f;
+        }
+        EXPECT(std::abs(lGain - 1.f) < 1e-5f);
+    }
+    std::vector<float> lDense(lSpeakers.size());
+    lVbap.computeGains(Vector3Array<float>(std::vector<Vector3f>(1, lSpeakers[8] + lSpeakers[9])), lDense.data());
+    EXPECT(std::abs(lDense[8] - M_SQRT1_2f) < 1e-5f);
+    EXPECT(std::abs(lDense[9] - M_SQRT1_2f) < 1e-5f);
+    EXPECT(lDense[0] == 0.f);
+
+    // in the hole below a dome: on the lowest speakers
+    const Vbap lDome(rings({0.f, 35.f, 90.f}, {8, 5, 1}));
+    const Vbap::Gains lBelow = lDome.computeGains(AEf::ae(0.f, -0.5f));
+    EXPECT(lBelow.mSpeakers[0] == 0u);
+    EXPECT(lBelow.mGains[0] == 1.f);
+    const Vbap::Gains lBelowPair = lDome.computeGains(AEf::ae(M_PI_4f / 2.f, -1.f));
+    float lPower = 0.f;
+    for (size_t k = 0 ; k != 3 ; ++k)
+    {
+        EXPECT(lBelowPair.mGains[k] >= 0.f);
+        if (lBelowPair.mGains[k] != 0.f)
+        {
+            EXPECT(lBelowPair.mSpeakers[k] < 2u);
+        }
+        lPower += lBelowPair.mGains[k] * lBelowPair.mGains[k];
+    }
+    EXPECT(std::abs(lPower - 1.f) < 1e-5f);
+
+    // no triangles: the nearest speaker
+    const Vbap lRing(rings({0.f}, {5}));
+    const Vbap::Gains lNearest = lRing.computeGains(AEf::ae(2.f * M_PIf / 5.f + 0.1f, 0.3f));
+    EXPECT(lNearest.mSpeakers[0] == 1u);
+    EXPECT(lNearest.mGains[0] == 1.f);
+
+    // batches
+    const Vector3Array<float> lBatch(lDirections);
+    std::vector<Vbap::Gains> lSparse(lDirections.size());
+    lVbap.computeGains(lBatch, lSparse.data());
+    lDense.resize(lDirections.size() * lSpeakers.size());
+    lVbap.computeGains(lBatch, lDense.data());
+    float lMaxError = 0.f;
+    for (size_t i = 0 ; i != lDirections.size() ; ++i)
+    {
+        const Vbap::Gains lGains = lVbap.computeGains(lDirections[i]);
+        for (size_t k = 0 ; k != 3 ; ++k)
+        {
+            lMaxError = std::max(lMaxError, std::abs(lSparse[i].mGains[k] - lGains.mGains[k]));
+            lMaxError = std::max(lMaxError, std::abs(lDense[i * lSpeakers.size() + lGains.mSpeakers[k]] - lGains.mGains[k]));
+        }
+    }
+    EXPECT(lMaxError == 0.f);
+}
+
+CASE("Vbap: gain cache")
+{
+    const Vbap lVbap(rings({-30.f, 0.f, 30.f, 60.f, 90.f}, {6, 8, 6, 4, 1}));
+    VbapGainCache lCache(lVbap);
+    for (float lAzimuth : {-3.f, -1.f, 0.f, 0.4f, 2.f, 3.1f})
+    {
+        for (float lElevation : {-1.f, 0.f, 0.2f, 1.5f})
+        {
+            const Vbap::Gains lExact = lVbap.computeGains(AEf::ae(lAzimuth, lElevation));
+            const Vbap::Gains& lCached = lCache.getGains(AEf::ae(lAzimuth, lElevation));
+            float lMaxError = 0.f;
+            for (size_t k = 0 ; k != 3 ; ++k)
+            {
+                for (size_t l = 0 ; l != 3 ; ++l)
+                {
+                    if (lExact.mSpeakers[k] == lCached.mSpeakers[l])
+                    {
+                        lMaxError = std::max(lMaxError, std::abs(lExact.mGains[k] - lCached.mGains[l]));
+                    }
+                }
+            }
+            EXPECT(lMaxError < 0.05f);
+        }
+    }
+    // the same cell
+    EXPECT(&lCache.getGains(AEf::ae(M_PIf, 0.f)) == &lCache.getGains(AEf::ae(-M_PIf, 0.f)));
+    EXPECT(&lCache.getGains(AEf::ae(3.f * M_PIf, 0.001f)) == &lCache.getGains(AEMf::aem(M_PIf, 0.f, 2.f)));
+    EXPECT(&lCache.getGains(AEf::ae(0.f, 2.f)) == &lCache.getGains(AEf::ae(0.f, M_PI_2f)));
+}
+
+CASE("Vbap: benchmark [.bench]")
+{
+    const size_t kNumSources = 1000;
+    const int kNumBlocks = 1000;
+    const std::vector<Vector3f> lSpeakers = rings({-30.f, 0.f, 30.f, 60.f, 90.f}, {6, 8, 6, 4, 1});
+    const Vbap lVbap(lSpeakers);
+    const std::vector<Vector3f> lDirections = randomDirections(kNumSources);
+    const Vector3Array<float> lBatch(lDirections);
+    std::vector<Vbap::Gains> lGains(kNumSources);
+    float lSum = 0.f;
+
+    // the triangles one at a time
+    std::vector<Vector3f> lColumns;
+    for (size_t t = 0 ; t != lVbap.getNumTriangles() ; ++t)
+    {
+        const Vector3f& a = lSpeakers[lVbap.getTriangle(t).mSpeakers[0]];
+        const Vector3f& b = lSpeakers[lVbap.getTriangle(t).mSpeakers[1]];
+        const Vector3f& c = lSpeakers[lVbap.getTriangle(t).mSpeakers[2]];
+        const float lInvDeterminant = 1.f / a.dot(b.cross(c));
+        lColumns.push_back(lInvDeterminant * b.cross(c));
+        lColumns.push_back(lInvDeterminant * c.cross(a));
+        lColumns.push_back(lInvDeterminant * a.cross(b));
+    }
+    StopWatch lStopWatch("scalar search");
+    lStopWatch.start();
+    for (int i = 0 ; i != kNumBlocks ; ++i)
+    {
+        for (size_t u = 0 ; u != kNumSources ; ++u)
+        {
+            const Vector3f lDirection = lDirections[u].normalized();
+            for (size_t t = 0 ; t != lVbap.getNumTriangles() ; ++t)
+            {
+                const float g0 = lColumns[3 * t].dot(lDirection);
+                const float g1 = lColumns[3 * t + 1].dot(lDirection);
+                const float g2 = lColumns[3 * t + 2].dot(lDirection);
+                if (g0 >= -1e-5f && g1 >= -1e-5f && g2 >= -1e-5f)
+                {
+                    const float lNormalization = 1.f / std::sqrt(g0 * g0 + g1 * g1 + g2 * g2);
+                    lGains[u] = {{t, t, t}, {g0 * lNormalization, g1 * lNormalization, g2 * lNormalization}};
+                    break;
+                }
+            }
+        }
+        lSum += lGains[(size_t)i].mGains[0];
+    }
+    lStopWatch.stopAndDisplay();
+
+    lStopWatch.renameAndStart("Vbap");
+    for (int i = 0 ; i != kNumBlocks ; ++i)
+    {
+        lVbap.computeGains(lBatch, lGains.data());
+        lSum += lGains[(size_t)i].mGains[0];
+    }
+    lStopWatch.stopAndDisplay();
+
+    std::vector<AEf> lAEs(kNumSources);
+    for (size_t u = 0 ; u != kNumSources ; ++u)
+    {
+        lAEs[u] = AEf::fromNormalizedVector3(lDirections[u].normalized());
+    }
+    VbapGainCache lCache(lVbap);
+    lStopWatch.renameAndStart("VbapGainCache");
+    for (int i = 0 ; i != kNumBlocks ; ++i)
+    {
+        for (size_t u = 0 ; u != kNumSources ; ++u)
+        {
+            lGains[u] = lCache.getGains(lAEs[u]);
+        }
+        lSum += lGains[(size_t)i].mGains[0];
+    }
+    lStopWatch.stopAndDisplay();
+    EXPECT(lSum > 0.f);
+}
@@ -0,0 +1,278 @@
+#include "fbu/vector2_array.hpp"
+#include "fbu/stopwatch.hpp"
+
+#include "tests_common.hpp"
+
+#include <random>
+#include <vector>
+
+using namespace fbu;
+
+namespace
+{
+    template <typename T>
+    std::vector< Vector2<T> > randomVectors(size_t pSize)
+    {
+        std::mt19937 lRandomGenerator(41);
+        std::uniform_real_distribution<T> lDistribution((T)-2, (T)2);
+        std::vector< Vector2<T> > lVectors(pSize);
+        for (Vector2<T>& v : lVectors)
+        {
+            v = Vector2<T>(lDistribution(lRandomGenerator), lDistribution(lRandomGenerator));
+        }
+        if (pSize > 2)
+        {
+            lVectors[2] = Vector2<T>((T)0, (T)0);
+        }
+        return lVectors;
+    }
+
+    template <typename T>
+    T distance(const Vector2<T>& pA, const Vector2<T>& pB)
+    {
+        return (pA - pB).length();
+    }
+
+    // the largest difference between the bulk operations and the Vector2 ones
+    template <typename T>
+    T maxBulkError(size_t pSize)
+    {
+        const std::vector< Vector2<T> > lA = randomVectors<T>(pSize);
+        std::vector< Vector2<T> > lB = randomVectors<T>(pSize + 1);
+        lB.erase(lB.begin());
+        const Vector2<T> lAxis((T)0.6, (T)-0.8);
+        const T lAngle = (T)2.5;
+        Vector2Array<T> lArrayA(lA), lArrayB(lB), lRotated, lNormalized(lArrayA), lInPlace(lArrayA);
+        std::vector<T> lDots(pSize), lProjections(pSize), lLengths(pSize);
+        dot(lArrayA, lArrayB, lDots.data());
+        dot(lArrayA, lAxis, lProjections.data());
+        lengths(lArrayA, lLengths.data());
+        rotate(lArrayA, lAngle, lRotated);
+        rotate(lInPlace, lAngle, lInPlace);
+        lNormalized.normalize();
+
+        T lMaxError = (T)0;
+        for (size_t i = 0 ; i != pSize ; ++i)
+        {
+            const Vector2<T> lExpectedNormalized = lA[i].sqrLength() == (T)0 ? lA[i] : lA[i].normalized();
+            const Vector2<T> lExpectedRotated(std::cos(lAngle) * lA[i].mX - std::sin(lAngle) * lA[i].mY,
+                                              std::sin(lAngle) * lA[i].mX + std::cos(lAngle) * lA[i].mY);
+            lMaxError = std::max(lMaxError, std::abs(lDots[i] - lA[i].dot(lB[i])));
+            lMaxError = std::max(lMaxError, std::abs(lProjections[i] - lA[i].dot(lAxis)));
+            lMaxError = std::max(lMaxError, std::abs(lLengths[i] - lA[i].length()));
+            lMaxError = std::max(lMaxError, distance<T>(lRotated[i], lExpectedRotated));
+            lMaxError = std::max(lMaxError, distance<T>(lInPlace[i], lExpectedRotated));
+            lMaxError = std::max(lMaxError, distance<T>(lNormalized[i], lExpectedNormalized));
+        }
+        // the padding stays zero
+        for (const Vector2Array<T>* lArray : {&lRotated, &lInPlace, &lNormalized})
+        {
+            for (size_t u = pSize ; u != lArray->paddedSize() ; ++u)
+            {
+                lMaxError = std::max(lMaxError, std::abs(lArray->x()[u]) + std::abs(lArray->y()[u]));
+            }
+        }
+        return lMaxError;
+    }
+
+    float angleDifference(float pA, float pB)
+    {
+        return std::abs(std::remainder(pA - pB, 2.f * M_PIf));
+    }
+}
+
+CASE("Vector2Array: elements")
+{
+    Vector2Array<float> lArray;
+    EXPECT(lArray.empty());
+    lArray.push_back(Vector2f(1.f, 2.f));
+    lArray.push_back(Vector2f(4.f, 5.f));
+    EXPECT(lArray.size() == 2u);
+    EXPECT(lArray.paddedSize() % Vector2Array<float>::kPadding == 0u);
+    EXPECT(lArray.x()[1] == 4.f);
+
+    lArray[0].mY = 7.f;
+    const Vector2f lFirst = lArray[0];
+    EXPECT(lFirst.mY == 7.f);
+    lArray[1] = lArray[0];
+    EXPECT(lArray.x()[1] == 1.f);
+
+    lArray.resize(1);
+    lArray.resize(3);
+    EXPECT(lArray[1].mX == 0.f);
+    EXPECT(lArray[2].mY == 0.f);
+    std::vector<Vector2f> lVectors(3);
+    lArray.copyTo(lVectors.data());
+    EXPECT(lVectors[0].mY == 7.f);
+}
+
+CASE("Vector2Array: bulk operations match Vector2")
+{
+    for (size_t lSize : {0u, 1u, 3u, 4u, 5u, 13u, 1001u})
+    {
+        EXPECT(maxBulkError<float>(lSize) < 1e-5f);
+        EXPECT(maxBulkError<double>(lSize) < 1e-12);
+    }
+    Vector2Array<float> lArray(std::vector<Vector2f>(5, Vector2f(3.f, 4.f)));
+    lArray.normalize(mu::Accuracy::coarse);
+    EXPECT(std::abs(lArray[4].mX - 0.6f) < 4e-4f);
+}
+
+CASE("Vector2Array: polar conversions")
+{
+    const mu::Accuracy kAccuracies[] = {mu::Accuracy::coarse, mu::Accuracy::medium, mu::Accuracy::high};
+    // the documented bounds of sincos and atan2
+    const float kVectorErrors[] = {4e-4f, 1.5e-6f, 1e-7f};
+    const float kAngleErrors[] = {1.5e-4f, 7e-7f, 3e-7f};
+    for (size_t lSize : {0u, 1u, 5u, 1003u})
+    {
+        std::mt19937 lRandomGenerator(42);
+        std::uniform_real_distribution<float> lAngles(-10.f, 10.f);
+        std::uniform_real_distribution<float> lMagnitudes(0.1f, 10.f);
+        std::vector<float> lAngle(lSize), lMagnitude(lSize);
+        for (size_t u = 0 ; u != lSize ; ++u)
+        {
+            lAngle[u] = lAngles(lRandomGenerator);
+            lMagnitude[u] = lMagnitudes(lRandomGenerator);
+        }
+        for (size_t a = 0 ; a != 3 ; ++a)
+        {
+            Vector2Array<float> lUnit, lVectors;
+            polarToVector2(lAngle.data(), nullptr, lSize, lUnit, kAccuracies[a]);
+            polarToVector2(lAngle.data(), lMagnitude.data(), lSize, lVectors, kAccuracies[a]);
+            EXPECT(lVectors.size() == lSize);
+            std::vector<float> lAngleOut(lSize), lMagnitudeOut(lSize), lAngleOnly(lSize);
+            vector2ToPolar(lVectors, lAngleOut.data(), lMagnitudeOut.data(), kAccuracies[a]);
+            vector2ToPolar(lUnit, lAngleOnly.data(), nullptr, kAccuracies[a]);
+            float lVectorError = 0.f, lRoundTripError = 0.f;
+            for (size_t u = 0 ; u != lSize ; ++u)
+            {
+                const Vector2f lExpected(std::cos(lAngle[u]), std::sin(lAngle[u]));
+                lVectorError = std::max(lVectorError, distance<float>(lUnit[u], lExpected));
+                lRoundTripError = std::max(lRoundTripError, angleDifference(lAngleOut[u], lAngle[u]));
+                lRoundTripError = std::max(lRoundTripError, angleDifference(lAngleOnly[u], lAngle[u]));
+                lRoundTripError = std::max(lRoundTripError, std::abs(lMagnitudeOut[u] / lMagnitude[u] - 1.f));
+            }
+            // with the float rounding of the vectors and of the reference
+            EXPECT(lVectorError < kVectorErrors[a] + 5e-7f);
+            EXPECT(lRoundTripError < kVectorErrors[a] + kAngleErrors[a] + 1e-6f);
+            for (size_t u = lSize ; u != lUnit.paddedSize() ; ++u)
+            {
+                EXPECT(lUnit.x()[u] == 0.f);
+                EXPECT(lVectors.y()[u] == 0.f);
+            }
+        }
+    }
+
+    Vector2Array<float> lAxes;
+    lAxes.push_back(Vector2f(0.f, 0.f));
+    lAxes.push_back(Vector2f(0.f, 2.f));
+    lAxes.push_back(Vector2f(-1.f, 0.f));
+    // one sentinel past the 3 outputs: the partial last vector must not be stored whole
+    float lAngles[4] = {0.f, 0.f, 0.f, 42.f}, lMagnitudes[4] = {0.f, 0.f, 0.f, 42.f};
+    vector2ToPolar(lAxes, lAngles, lMagnitudes);
+    EXPECT(lAngles[0] == 0.f);
+    EXPECT(lMagnitudes[0] == 0.f);
+    EXPECT(std::abs(lAngles[1] - M_PI_2f) < 1e-6f);
+    EXPECT(lMagnitudes[1] == 2.f);
+    EXPECT(std::abs(lAngles[2] - M_PIf) < 1e-6f);
+    EXPECT(lAngles[3] == 42.f);
+    EXPECT(lMagnitudes[3] == 42.f);
+}
+
+CASE("Vector2Array: benchmark vs AoS [.bench]")
+{
+    const size_t kNumVectors = 10000;
+    const int kNumIterations = 1000;
+    std::vector<Vector2f> lAoS = randomVectors<float>(kNumVectors);
+    lAoS[2] = Vector2f(1.f, 0.f);
+    Vector2Array<float> lSoA(lAoS);
+    const Vector2f lAxis(0.6f, 0.8f);
+    std::vector<float> lValues(kNumVectors), lAngles(kNumVectors);
+    float lSum = 0.f;
+
+    StopWatch lStopWatch("AoS normalize and dot");
+    lStopWatch.start();
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        for (size_t u = 0 ; u != kNumVectors ; ++u)
+        {
+            lAoS[u].normalize();
+            lValues[u] = lAoS[u].dot(lAxis);
+        }
+        lSum += lValues[(size_t)i];
+    }
+    lStopWatch.stopAndDisplay();
+
+    lStopWatch.renameAndStart("SoA normalize and dot");
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        lSoA.normalize();
+        dot(lSoA, lAxis, lValues.data());
+        lSum += lValues[(size_t)i];
+    }
+    lStopWatch.stopAndDisplay();
+
+    lStopWatch.renameAndStart("AoS length");
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        for (size_t u = 0 ; u != kNumVectors ; ++u)
+        {
+            lValues[u] = lAoS[u].length();
+        }
+        lSum += lValues[(size_t)i];
+    }
+    lStopWatch.stopAndDisplay();
+
+    lStopWatch.renameAndStart("SoA lengths");
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        lengths(lSoA, lValues.data());
+        lSum += lValues[(size_t)i];
+    }
+    lStopWatch.stopAndDisplay();
+
+    std::vector<Vector2f> lAoSRotated(kNumVectors);
+    lStopWatch.renameAndStart("AoS rotate");
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        for (size_t u = 0 ; u != kNumVectors ; ++u)
+        {
+            lAoSRotated[u] = lAoS[u].rotated(0.1f);
+        }
+        lSum += lAoSRotated[(size_t)i].mX;
+    }
+    lStopWatch.stopAndDisplay();
+
+    Vector2Array<float> lSoARotated;
+    lStopWatch.renameAndStart("SoA rotate");
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        rotate(lSoA, 0.1f, lSoARotated);
+        lSum += lSoARotated.x()[i];
+    }
+    lStopWatch.stopAndDisplay();
+
+    lStopWatch.renameAndStart("AoS to polar and back, libm");
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        for (size_t u = 0 ; u != kNumVectors ; ++u)
+        {
+            const float lAngle = std::atan2(lAoS[u].mY, lAoS[u].mX);
+            const float lMagnitude = lAoS[u].length();
+            lAoSRotated[u] = Vector2f(lMagnitude * std::cos(lAngle), lMagnitude * std::sin(lAngle));
+        }
+        lSum += lAoSRotated[(size_t)i].mX;
+    }
+    lStopWatch.stopAndDisplay();
+
+    lStopWatch.renameAndStart("SoA to polar and back, high");
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        vector2ToPolar(lSoA, lAngles.data(), lValues.data());
+        polarToVector2(lAngles.data(), lValues.data(), kNumVectors, lSoARotated);
+        lSum += lSoARotated.x()[i];
+    }
+    lStopWatch.stopAndDisplay();
+    EXPECT(lSum == lSum);
+}
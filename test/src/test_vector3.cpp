@@ -1 +1,85 @@
 #include "fbu/vector3.hpp"
+#include "fbu/vector3_array.hpp"
+
+#include "tests_common.hpp"
+
+CASE("Vector3: operators and fused operations")
+{
+    Vector3f v = Vector3f::cartesian(1.f, 2.f, 3.f);
+    const Vector3f w = Vector3f::cartesian(-1.f, 0.5f, 2.f);
+    // the compound assignments return the vector
+    (v *= 2.f) += w;
+    EXPECT(v.mX == 1.f);
+    EXPECT(v.mY == 4.5f);
+    EXPECT(v.mZ == 8.f);
+    Vector3f& lRef = (v += w);
+    EXPECT(&lRef == &v);
+
+    EXPECT(v.dot(w) == 0.f * 0.f + 5.f * 0.5f + 10.f * 2.f);
+    EXPECT(v.sqrLength() == 125.f);
+    const Vector3f lAxpy = axpy(2.f, v, w);
+    EXPECT(lAxpy.mX == -1.f);
+    EXPECT(lAxpy.mY == 10.5f);
+    EXPECT(lAxpy.mZ == 22.f);
+    EXPECT(lerp(v, w, 0.f).mY == v.mY);
+    EXPECT(lerp(v, w, 1.f).mZ == w.mZ);
+    EXPECT(lerp(v, w, 0.5f).mX == -0.5f);
+}
+
+CASE("Vector3: integer coordinates")
+{
+    typedef Vector3<int> Vector3i;
+    const Vector3i v = Vector3i::cartesian(1, -2, 3);
+    const Vector3i w = Vector3i::cartesian(4, 5, -6);
+    EXPECT(v.dot(w) == -24);
+    EXPECT(v.sqrLength() == 14);
+    const Vector3i lAxpy = axpy(2, v, w);
+    EXPECT(lAxpy.mX == 6);
+    EXPECT(lAxpy.mY == 1);
+    EXPECT(lAxpy.mZ == 0);
+
+    // and the fused expressions of the arrays
+    fbu::Vector3Array<int> a(std::vector<Vector3i>(5, v)), b(std::vector<Vector3i>(5, w));
+    a = a + 2 * b;
+    for (size_t i = 0 ; i != a.size() ; ++i)
+    {
+        const Vector3i lSum = a[i];
+        EXPECT(lSum.mX == 9);
+        EXPECT(lSum.mY == 8);
+        EXPECT(lSum.mZ == -9);
+    }
+}
+
+// the fast approximations are in float
+#if ! FBU_VECTOR3_FAST_TRIG
+CASE("Vector3: conversions in double")
+{
+    // to the double precision, without float temporaries
+    const double kEpsilon = 1e-14;
+    for (double a : {-3., -0.4, 0.1, 2.5})
+    {
+        for (double e : {-1.5, 0., 0.7})
+        {
+            const double m = 3.;
+            const Vector3<double> lFromAE = Vector3<double>::fromAE(AE<double>::ae(a, e));
+            const Vector3<double> lFromAEM = Vector3<double>::fromAEM(AEM<double>::aem(a, e, m));
+            const Vector3<double> lFromAEMr = Vector3<double>::fromAEMr(AEMr<double>(-a, e, m));
+            EXPECT(std::abs(lFromAE.mX - std::cos(e) * std::cos(a)) < kEpsilon);
+            EXPECT(std::abs(lFromAE.mY - std::cos(e) * std::sin(a)) < kEpsilon);
+            EXPECT(std::abs(lFromAEM.mZ - m * std::sin(e)) < kEpsilon);
+            EXPECT((lFromAEM - lFromAEMr).length() < kEpsilon);
+
+            const AEM<double> lAEM = AEM<double>::fromVector3(lFromAEM);
+            EXPECT(std::abs(lAEM.mAzimuth - a) < kEpsilon);
+            EXPECT(std::abs(lAEM.mElevation - e) < kEpsilon);
+            EXPECT(std::abs(lAEM.mMagnitude - m) < kEpsilon);
+            AEMr<double> lAEMr;
+            Vector3_to_AEMr(lFromAEMr, lAEMr);
+            // acos() loses precision near 0 and pi
+            EXPECT(std::abs(lAEMr.mAzimuth + a) < 1e-7);
+            EXPECT(std::abs(lAEMr.mElevation - e) < kEpsilon);
+            EXPECT(std::abs(lAEMr.mMagnitude - m) < kEpsilon);
+        }
+    }
+}
+#endif
@@ -0,0 +1,247 @@
+#include "fbu/vector3_array.hpp"
+#include "fbu/stopwatch.hpp"
+
+#include "tests_common.hpp"
+
+#include <random>
+#include <vector>
+
+using namespace fbu;
+
+namespace
+{
+    template <typename T>
+    std::vector< Vector3<T> > randomVectors(size_t pSize)
+    {
+        std::mt19937 lRandomGenerator(41);
+        std::uniform_real_distribution<T> lDistribution((T)-2, (T)2);
+        std::vector< Vector3<T> > lVectors(pSize);
+        for (Vector3<T>& v : lVectors)
+        {
+            v = Vector3<T>::cartesian(lDistribution(lRandomGenerator), lDistribution(lRandomGenerator), lDistribution(lRandomGenerator));
+        }
+        if (pSize > 2)
+        {
+            lVectors[2] = Vector3<T>::cartesian((T)0, (T)0, (T)0);
+        }
+        return lVectors;
+    }
+
+    template <typename T>
+    T distance(const Vector3<T>& pA, const Vector3<T>& pB)
+    {
+        return (pA - pB).length();
+    }
+
+    // the largest difference between the bulk operations and the Vector3 ones
+    template <typename T>
+    T maxBulkError(size_t pSize)
+    {
+        const std::vector< Vector3<T> > lA = randomVectors<T>(pSize);
+        std::vector< Vector3<T> > lB = randomVectors<T>(pSize + 1);
+        lB.erase(lB.begin());
+        const Vector3<T> lDefault = Vector3<T>::cartesian((T)0, (T)0, (T)1);
+        const Vector3<T> lTranslation = Vector3<T>::cartesian((T)1, (T)-2, (T)3);
+        Vector3Array<T> lArrayA(lA), lArrayB(lB), lCross;
+        std::vector<T> lDots(pSize), lDotsWithOne(pSize), lLengths(pSize);
+        dot(lArrayA, lArrayB, lDots.data());
+        dot(lArrayA, lTranslation, lDotsWithOne.data());
+        lengths(lArrayA, lLengths.data());
+        cross(lArrayA, lArrayB, lCross);
+        Vector3Array<T> lNormalized(lArrayA), lNormalizedWithDefault(lArrayA), lSum(lArrayA), lTranslated(lArrayA);
+        lNormalized.normalize();
+        lNormalizedWithDefault.normalizeWithDefault(lDefault);
+        lSum += lArrayB;
+        lSum *= (T)0.5;
+        lTranslated += lTranslation;
+        // expressions
+        Vector3Array<T> lCombined = lArrayA + (T)2 * lArrayB - lCross;
+        Vector3Array<T> lAxpy(lArrayB), lLerp, lInPlace(lArrayA);
+        axpy((T)3, lArrayA, lAxpy);
+        lerp(lArrayA, lArrayB, (T)0.25, lLerp);
+        lInPlace = lInPlace - (T)0.5 * (lArrayB + lInPlace);
+
+        T lMaxError = (T)0;
+        for (size_t i = 0 ; i != pSize ; ++i)
+        {
+            const Vector3<T> lExpectedNormalized = lA[i].isZero() ? lA[i] : lA[i].normalized();
+            lMaxError = std::max(lMaxError, std::abs(lDots[i] - lA[i].dot(lB[i])));
+            lMaxError = std::max(lMaxError, std::abs(lDotsWithOne[i] - lA[i].dot(lTranslation)));
+            lMaxError = std::max(lMaxError, std::abs(lLengths[i] - lA[i].length()));
+            lMaxError = std::max(lMaxError, distance<T>(lCross[i], lA[i].cross(lB[i])));
+            lMaxError = std::max(lMaxError, distance<T>(lNormalized[i], lExpectedNormalized));
+            lMaxError = std::max(lMaxError, distance<T>(lNormalizedWithDefault[i], lA[i].normalizedWithDefault(lDefault)));
+            lMaxError = std::max(lMaxError, distance<T>(lSum[i], (T)0.5 * (lA[i] + lB[i])));
+            lMaxError = std::max(lMaxError, distance<T>(lTranslated[i], lA[i] + lTranslation));
+            lMaxError = std::max(lMaxError, distance<T>(lCombined[i], lA[i] + (T)2 * lB[i] - lA[i].cross(lB[i])));
+            lMaxError = std::max(lMaxError, distance<T>(lAxpy[i], axpy((T)3, lA[i], lB[i])));
+            lMaxError = std::max(lMaxError, distance<T>(lLerp[i], lerp(lA[i], lB[i], (T)0.25)));
+            lMaxError = std::max(lMaxError, distance<T>(lInPlace[i], lA[i] - (T)0.5 * (lB[i] + lA[i])));
+        }
+        // the padding stays zero
+        for (const Vector3Array<T>* lArray : {&lNormalized, &lNormalizedWithDefault, &lSum, &lTranslated, &lCross,
+                                                 &lCombined, &lAxpy, &lLerp, &lInPlace})
+        {
+            for (size_t u = pSize ; u != lArray->paddedSize() ; ++u)
+            {
+                lMaxError = std::max(lMaxError, std::abs(lArray->x()[u]) + std::abs(lArray->y()[u]) + std::abs(lArray->z()[u]));
+            }
+        }
+        return lMaxError;
+    }
+}
+
+CASE("Vector3Array: elements")
+{
+    Vector3Array<float> lArray;
+    EXPECT(lArray.empty());
+    lArray.push_back(Vector3f::cartesian(1.f, 2.f, 3.f));
+    lArray.push_back(Vector3f::cartesian(4.f, 5.f, 6.f));
+    EXPECT(lArray.size() == 2u);
+    EXPECT(lArray.paddedSize() % Vector3Array<float>::kPadding == 0u);
+    EXPECT(lArray.x()[1] == 4.f);
+    EXPECT(lArray.z()[0] == 3.f);
+
+    // the proxies behave as Vector3
+    lArray[0].mY = 7.f;
+    const Vector3f lFirst = lArray[0];
+    EXPECT(lFirst.mY == 7.f);
+    lArray[1] = lArray[0];
+    EXPECT(lArray.x()[1] == 1.f);
+    EXPECT(static_cast<Vector3f>(lArray[1]).dot(Vector3f::cartesian(0.f, 1.f, 0.f)) == 7.f);
+    const Vector3Array<float>& lConstArray = lArray;
+    EXPECT(lConstArray[1].length() == std::sqrt(59.f));
+
+    // and the padding is zero after a shrink
+    lArray.resize(1);
+    lArray.resize(3);
+    EXPECT(lArray[1].mX == 0.f);
+    EXPECT(static_cast<Vector3f>(lArray[2]).isZero());
+
+    std::vector<Vector3f> lVectors(3);
+    lArray.copyTo(lVectors.data());
+    EXPECT(lVectors[0].mZ == 3.f);
+    EXPECT(lVectors[1].isZero());
+}
+
+CASE("Vector3Array: bulk operations match Vector3")
+{
+    for (size_t lSize : {0u, 1u, 3u, 4u, 5u, 13u, 1001u})
+    {
+        EXPECT(maxBulkError<float>(lSize) < 1e-5f);
+        EXPECT(maxBulkError<double>(lSize) < 1e-12);
+    }
+    Vector3Array<float> lArray(std::vector<Vector3f>(5, Vector3f::cartesian(3.f, 0.f, 4.f)));
+    lArray.normalize(mu::Accuracy::coarse);
+    EXPECT(std::abs(lArray[4].mX - 0.6f) < 4e-4f);
+}
+
+CASE("Vector3Array: benchmark vs AoS [.bench]")
+{
+    const size_t kNumVectors = 10000;
+    const int kNumIterations = 1000;
+    std::vector<Vector3f> lAoS = randomVectors<float>(kNumVectors);
+    lAoS[2] = Vector3f::cartesian(1.f, 0.f, 0.f);
+    Vector3Array<float> lSoA(lAoS);
+    const Vector3f lDirection = Vector3f::cartesian(0.f, 0.6f, 0.8f);
+    std::vector<float> lDots(kNumVectors);
+    float lSum = 0.f;
+
+    StopWatch lStopWatch("AoS normalize and dot");
+    lStopWatch.start();
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        for (size_t u = 0 ; u != kNumVectors ; ++u)
+        {
+            lAoS[u].normalize();
+            lDots[u] = lAoS[u].dot(lDirection);
+        }
+        lSum += lDots[(size_t)i];
+    }
+    lStopWatch.stopAndDisplay();
+
+    lStopWatch.renameAndStart("SoA normalize and dot");
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        lSoA.normalize();
+        dot(lSoA, lDirection, lDots.data());
+        lSum += lDots[(size_t)i];
+    }
+    lStopWatch.stopAndDisplay();
+
+    std::vector<float> lLengths(kNumVectors);
+    lStopWatch.renameAndStart("AoS length");
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        for (size_t u = 0 ; u != kNumVectors ; ++u)
+        {
+            lLengths[u] = lAoS[u].length();
+        }
+        lSum += lLengths[(size_t)i];
+    }
+    lStopWatch.stopAndDisplay();
+
+    lStopWatch.renameAndStart("SoA lengths");
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        lengths(lSoA, lLengths.data());
+        lSum += lLengths[(size_t)i];
+    }
+    lStopWatch.stopAndDisplay();
+
+    std::vector<Vector3f> lAoSCross(kNumVectors);
+    Vector3Array<float> lSoACross;
+    lStopWatch.renameAndStart("AoS cross");
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        for (size_t u = 0 ; u != kNumVectors ; ++u)
+        {
+            lAoSCross[u] = lAoS[u].cross(lDirection);
+        }
+        lSum += lAoSCross[(size_t)i].mX;
+    }
+    lStopWatch.stopAndDisplay();
+
+    Vector3Array<float> lDirections(std::vector<Vector3f>(kNumVectors, lDirection));
+    lStopWatch.renameAndStart("SoA cross");
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        cross(lSoA, lDirections, lSoACross);
+        lSum += lSoACross.x()[i];
+    }
+    lStopWatch.stopAndDisplay();
+
+    // a + s * b - c
+    lStopWatch.renameAndStart("AoS a + s * b - c");
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        for (size_t u = 0 ; u != kNumVectors ; ++u)
+        {
+            lAoSCross[u] = lAoS[u] + 0.5f * lAoSCross[u] - lDirection;
+        }
+        lSum += lAoSCross[(size_t)i].mX;
+    }
+    lStopWatch.stopAndDisplay();
+
+    Vector3Array<float> lTemporary;
+    lStopWatch.renameAndStart("SoA a + s * b - c, with a temporary");
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        lTemporary = lSoACross;
+        lTemporary *= 0.5f;
+        lTemporary += lSoA;
+        lSoACross = lTemporary;
+        lSoACross += -1.f * lDirection;
+        lSum += lSoACross.x()[i];
+    }
+    lStopWatch.stopAndDisplay();
+
+    lStopWatch.renameAndStart("SoA a + s * b - c, expression");
+    for (int i = 0 ; i != kNumIterations ; ++i)
+    {
+        lSoACross = lSoA + 0.5f * lSoACross - lDirections;
+        lSum += lSoACross.x()[i];
+    }
+    lStopWatch.stopAndDisplay();
+    EXPECT(lSum == lSum);
+}